@@ -0,0 +1,56 @@
+/**
+ * @file    adcstream.h
+ * @brief   双 ADC 同步采样流（TIM3 触发，DMA 双缓冲，过采样抽取）
+ */
+#ifndef __ADCSTREAM_H__
+#define __ADCSTREAM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * ADC1 (IN5, PA5) 与 ADC2 (IN7, PA7) 工作在双 ADC 规则同步模式，
+ * 由 TIM3 TRGO 按设定采样率触发，DMA2 Stream0 以 DMA mode 2 把每对结果
+ * （一个 32 位字）循环写入双缓冲。半满/全满中断只通知 AdcStreamTask，
+ * 抽取在任务中按块完成，之后把块指针交给订阅者（不复制，不逐样本回调）。
+ * 过采样：每 4^k 个原始样本求和后右移 k 位，有效分辨率 12 + k 位。
+ */
+
+#define ADCSTREAM_CH_NUM          2U      /* 0 = ADC1 IN5, 1 = ADC2 IN7 */
+#define ADCSTREAM_HALF_PAIRS      1024U   /* 每半缓冲的样本对数 */
+#define ADCSTREAM_OSR_LOG4_MAX    4U      /* 过采样 4^k，k <= 4（256 倍） */
+#define ADCSTREAM_MAX_SUBS        4U
+
+#define ADCSTREAM_DEFAULT_RATE_HZ 10000U
+#define ADCSTREAM_DEFAULT_OSR     1U      /* k = 1：4 倍过采样，13 位 */
+
+/* 交付给订阅者的数据块，在回调返回后、下下个块到来前保持有效 */
+typedef struct {
+    const uint16_t *ch[ADCSTREAM_CH_NUM];  /* 各通道抽取后的样本 */
+    uint16_t n;                            /* 每通道样本数 */
+    uint8_t  bits;                         /* 有效位数 */
+    uint32_t rate_hz;                      /* 抽取后的采样率 */
+    uint32_t seq;                          /* 块序号 */
+} AdcStream_Block_t;
+
+/* 订阅回调，在 AdcStreamTask 中执行 */
+typedef void (*adcstream_cb_t)(const AdcStream_Block_t *blk, void *ctx);
+
+typedef struct {
+    uint32_t blocks;       /* 已处理半缓冲数 */
+    uint32_t overruns;     /* 任务来不及处理而被 DMA 覆盖的半缓冲数 */
+    uint32_t rate_hz;      /* 原始采样率（实际值） */
+    uint8_t  osr_log4;
+} AdcStream_Stats_t;
+
+/* 注册订阅者，返回 0 成功 */
+int AdcStream_Subscribe(adcstream_cb_t cb, void *ctx);
+
+/* 请求修改采样率 (Hz) 与过采样级数 k，由 AdcStreamTask 停止后重新启动采样 */
+void AdcStream_Configure(uint32_t rate_hz, uint8_t osr_log4);
+
+void AdcStream_GetStats(AdcStream_Stats_t *stats);
+
+void AdcStreamTask(void *argument);
+
+#endif /* __ADCSTREAM_H__ */
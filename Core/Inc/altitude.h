@@ -0,0 +1,36 @@
+/**
+ * @file    altitude.h
+ * @brief   快速气压高度计算（查表 + 三次插值，替代 powf）
+ */
+#ifndef __ALTITUDE_H__
+#define __ALTITUDE_H__
+
+#include <stdint.h>
+
+/* 设置/读取海平面参考气压 (Pa)，非正值恢复为 101325 Pa */
+void  Altitude_SetSeaLevel(float sea_level_pa);
+float Altitude_GetSeaLevel(void);
+
+/* 从持久化参数 (g_config) 载入海平面参考气压 */
+void  Altitude_LoadSeaLevel(void);
+
+/* 根据气压 (Pa) 计算海拔 (m)，公式同 BMP280_CalcAltitude；
+   p/p0 在 0.25~1.25 内查表（覆盖 30~110 kPa），超出范围回退到 powf */
+float Altitude_Calc(float pressure_pa);
+
+/* 精度与性能对比结果 */
+typedef struct {
+    float    max_err_m;         /* 查表法相对双精度公式的最大误差 (m) */
+    float    max_err_powf_m;    /* powf 版本相对双精度公式的最大误差 (m) */
+    uint32_t cycles_fast;       /* 查表法每次计算的平均 CPU 周期 */
+    uint32_t cycles_powf;       /* powf 版本每次计算的平均 CPU 周期 */
+} Altitude_Bench_t;
+
+typedef uint32_t (*altitude_cycles_fn)(void);
+
+/* 在 30~110 kPa 内扫描比较查表法与 powf（使用当前海平面气压）
+   cycles 为计时函数（目标板传 DWT_GetCycles，上位机 Tools/altcalc 传纳秒时钟）
+   返回 0 = PASS（误差 < 5cm），1 = FAIL；bench 可为 NULL */
+uint8_t Altitude_Test(altitude_cycles_fn cycles, Altitude_Bench_t *bench);
+
+#endif /* __ALTITUDE_H__ */
@@ -11,6 +11,17 @@
 #define BH1750_OK          0
 #define BH1750_ERR_I2C     1
 #define BH1750_ERR_TIMEOUT 2
+#define BH1750_BUSY        3   /* 量程切换后首个有效结果尚未就绪 */
+
+/* 单次高分辨率测量的最长转换时间 (ms)，MTreg = 69 时 */
+#define BH1750_ONE_TIME_MS 180
+/* 低分辨率测量的最长转换时间 (ms)，MTreg = 69 时 */
+#define BH1750_L_RES_MS    24
+
+/* 测量时间寄存器 MTreg 范围，默认 69；灵敏度与 MTreg 成正比 */
+#define BH1750_MTREG_MIN     31
+#define BH1750_MTREG_DEFAULT 69
+#define BH1750_MTREG_MAX     254
 
 /* 初始化（上电后调用，包含开机和复位，可选） */
 int BH1750_Init(void);
@@ -30,8 +41,26 @@ int BH1750_Reset(void);
 */
 int BH1750_SetMode(uint8_t mode);
 
-/* 读取光照强度（单位 lux），使用单次高分辨率测量（one-time H-res mode）
+/* 读取光照强度（单位 lux）。连续模式下只读取 2 字节结果；
+   未启动连续模式时先启动并等待首次转换完成
    返回 BH1750_OK 成功并通过指针返回 lux，其他返回错误码 */
 int BH1750_ReadLux(float *lux);
 
+/* 拆分的单次测量：StartOneShot 触发转换，BH1750_ONE_TIME_MS 后调用 FetchLux 读取结果 */
+int BH1750_StartOneShot(void);
+int BH1750_FetchLux(float *lux);
+
+/* 连续测量模式（自动量程）：传感器自行刷新结果，FetchLux 只读取 2 字节。
+   每次读取后根据原始值调整 MTreg（31~254）及 H-res/H-res2 模式，
+   覆盖约 0.11 ~ 100000 lx；调整后的首个结果未就绪前 FetchLux 返回 BH1750_BUSY */
+int BH1750_StartContinuous(void);
+
+/* 低延迟模式：切换到连续低分辨率模式（4 lx 分辨率，约 16ms 刷新），关闭后恢复高分辨率。
+   GetDataTask 在 BH1750 采样周期短于 120 ms 时自动开启（GetData_SetPeriod） */
+int BH1750_SetLowLatency(bool enable);
+
+/* 设置/读取测量时间寄存器 */
+int BH1750_SetMTreg(uint8_t mt);
+uint8_t BH1750_GetMTreg(void);
+
 #endif /* __BH1750_H__ */
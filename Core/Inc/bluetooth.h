@@ -11,6 +11,7 @@
 
 #include "stm32f4xx_hal.h"
 #include <stdint.h>
+#include "serial.h"
 
 
 /* 默认资源（工程里已有 huart2） */
@@ -57,10 +58,10 @@ extern uint8_t bt_has_new; // 标记是否有新数据
 /* 初始化：配置 EN(推挽输出, 默认拉低) 与 STATE(输入) 并标记已初始化 */
 BT_Status_t BT_Init(BT_Handle_t *hbt);
 
-/* Bluetooth UART 接收完成回调（需在 HAL_UART_RxCpltCallback 中调用） */
-void Bluetooth_UART_RxCpltCallback(void);
+/* 蓝牙行协议（Serial 端口插件），BT_Init 时挂到 hbt->huart 对应的端口 */
+extern const Serial_Protocol_t BT_Protocol;
 
-/* 发送透传数据（EN 必须为低） */
+/* 发送透传数据（EN 必须为低），非阻塞，复制进端口发送缓冲 */
 BT_Status_t BT_Send(BT_Handle_t *hbt, const uint8_t *data, uint16_t len);
 
 /* 接收透传数据 */
@@ -3,6 +3,7 @@
 
 #include "stm32f4xx_hal.h"
 #include <stdint.h>
+#include "bmp280_comp.h"
 
 #define BMP280_I2C_ADDR    (0x76 << 1)   /* 默认 0x76，若为 0x77 请修改 */
 #define BMP280_I2C_HANDLE  hi2c1         /* 使用 I2C1 */
@@ -25,4 +26,6 @@ int BMP280_ReadPressure(float *press_pa);
 /* 根据气压计算海拔（sea_level_pa 可选，默认 101325 Pa） */
 float BMP280_CalcAltitude(float pressure_pa, float sea_level_pa);
 
+/* 补偿算法与自检 BMP280_CompTest 见 bmp280_comp.h */
+
 #endif /* __BMP280_H__ */
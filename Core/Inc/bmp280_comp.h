@@ -0,0 +1,63 @@
+/**
+ * @file    bmp280_comp.h
+ * @brief   BMP280 补偿算法（不依赖 HAL，目标板与上位机 Tools/bmpcomp 共用）
+ */
+#ifndef __BMP280_COMP_H__
+#define __BMP280_COMP_H__
+
+#include <stdint.h>
+
+/* 补偿算法实现（编译期选择，例如 -DBMP280_COMP_BACKEND=BMP280_COMP_FLOAT）
+   INT64: Bosch 64 位整数参考实现，分辨率 1/256 Pa，Cortex-M4 上需多字运算
+   INT32: 数据手册 32 位整数实现，分辨率 1 Pa，误差 ±8 Pa 以内
+   FLOAT: 单精度浮点实现，使用 FPU，误差 0.5 Pa 以内 */
+#define BMP280_COMP_INT64  0
+#define BMP280_COMP_INT32  1
+#define BMP280_COMP_FLOAT  2
+#define BMP280_COMP_NUM    3
+
+#ifndef BMP280_COMP_BACKEND
+#define BMP280_COMP_BACKEND  BMP280_COMP_INT64
+#endif
+
+/* 芯片内的校准参数（0x88~0x9F） */
+typedef struct {
+    uint16_t dig_T1;
+    int16_t  dig_T2;
+    int16_t  dig_T3;
+    uint16_t dig_P1;
+    int16_t  dig_P2;
+    int16_t  dig_P3;
+    int16_t  dig_P4;
+    int16_t  dig_P5;
+    int16_t  dig_P6;
+    int16_t  dig_P7;
+    int16_t  dig_P8;
+    int16_t  dig_P9;
+} bmp280_calib_t;
+
+/* 补偿算法对比结果，下标为 BMP280_COMP_xxx */
+typedef struct {
+    uint32_t cycles[BMP280_COMP_NUM];     /* 每次补偿(温度+气压)的平均耗时（cycles 计数单位） */
+    float    max_err_pa[BMP280_COMP_NUM]; /* 相对 INT64 实现的最大气压误差 (Pa) */
+    uint32_t samples;                     /* 参与比较的原始值组合数 */
+} BMP280_CompBench_t;
+
+typedef uint32_t (*bmp280_cycles_fn)(void);
+
+/* 温度补偿返回 0.01 degC（浮点版为 degC），并输出供气压补偿使用的 t_fine */
+int32_t  BMP280_CompTempInt64(const bmp280_calib_t *c, int32_t adc_T, int32_t *tf);
+int32_t  BMP280_CompTempInt32(const bmp280_calib_t *c, int32_t adc_T, int32_t *tf);
+float    BMP280_CompTempFloat(const bmp280_calib_t *c, int32_t adc_T, float *tf);
+
+/* 气压补偿，返回 Pa */
+float    BMP280_CompPressInt64(const bmp280_calib_t *c, int32_t adc_P, int32_t tf);
+uint32_t BMP280_CompPressInt32(const bmp280_calib_t *c, int32_t adc_P, int32_t tf);
+float    BMP280_CompPressFloat(const bmp280_calib_t *c, int32_t adc_P, float tf);
+
+/* 补偿算法自检：用数据手册参考向量校验三种实现，并在全 ADC 量程上比较误差、
+   测量耗时（不访问传感器），cycles 为计时函数（目标板传 DWT_GetCycles），bench 可为 NULL。
+   返回 0 = PASS, 1 = 参考向量错误, 2 = 扫描误差超限 */
+int BMP280_CompTest(bmp280_cycles_fn cycles, BMP280_CompBench_t *bench);
+
+#endif /* __BMP280_COMP_H__ */
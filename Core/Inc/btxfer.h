@@ -0,0 +1,68 @@
+/**
+ * @file    btxfer.h
+ * @brief   蓝牙 (JDY-31, USART2) 二进制批量下载：分块帧 + 滑动窗口选择重传 + 断线续传
+ *
+ * 本头文件不依赖 HAL，上位机接收工具 Tools/btxget 共用其中的帧定义。
+ */
+#ifndef __BTXFER_H__
+#define __BTXFER_H__
+
+#include <stdint.h>
+
+/*
+ * 帧沿用 tlmcodec 的分帧（CRC32 + COBS，0x00 结尾），类型字节取 0x20~0x2F，
+ * 同一串口上没有会话时收到的其他字节仍交给蓝牙行协议。多字节字段小端。
+ *
+ * 上位机 → 目标板
+ *   OPEN   20 src addr:u32 len:u32 from:u32    打开会话，从第 from 块开始发送（续传时为已连续收到的块数）
+ *   ACK    23 sess base:u32 map:u32            base 之前的块都已收到；map 位 i = 第 base+1+i 块已收到
+ *   CLOSE  25 sess                             结束会话
+ * 目标板 → 上位机
+ *   INFO   21 sess status window chunk:u16 chunks:u32 from:u32
+ *   DATA   22 sess idx:u32 数据 * chunk（最后一块可能较短）
+ *   DONE   24 sess chunks:u32 retx:u32          全部块已确认
+ *
+ * 发送方保留 BTX_WINDOW 块的窗口，只按 base/map 记录哪些块已确认，数据不缓存：
+ * 重传直接从 Flash 重新读出。串口按顺序送达，所以 ACK 中确认了某块时，
+ * 比它更早发出而未确认的块必定已丢失，立即重传（无需等待超时）；其余靠 BTX_RTO_MS 超时重传。
+ * STATE 引脚变低或超过 BTX_IDLE_MS 没有 ACK 时暂停发送，上位机重连后用 from 续传。
+ */
+
+#define BTX_T_OPEN          0x20U
+#define BTX_T_INFO          0x21U
+#define BTX_T_DATA          0x22U
+#define BTX_T_ACK           0x23U
+#define BTX_T_DONE          0x24U
+#define BTX_T_CLOSE         0x25U
+
+#define BTX_SRC_FLASH       0U          /* W25Q128 上的地址区间（日志、图片） */
+
+#define BTX_ST_OK           0U
+#define BTX_ST_PARAM        1U          /* 来源或区间非法 */
+
+#define BTX_DATA_HDR        6U
+#define BTX_CHUNK           228U        /* 数据帧 = 6 + 228 + CRC 4 = 238 字节，不超过 TLM_FRAME_MAX */
+#define BTX_WINDOW          32U         /* 未确认块上限（ACK 位图宽度） */
+#define BTX_RTO_MS          1000U       /* 单块超时重传 */
+#define BTX_IDLE_MS         5000U       /* 无 ACK 超过此时间暂停会话 */
+#define BTX_DONE_REPEAT     3U          /* 未收到 CLOSE 时 DONE 的重发次数（间隔 BTX_RTO_MS） */
+
+typedef struct {
+    uint32_t sessions;      /* 打开的会话数 */
+    uint32_t resumes;       /* from > 0 的续传次数 */
+    uint32_t disconnects;   /* 传输中 STATE 变低的次数 */
+    uint32_t stalls;        /* 超时无 ACK 暂停的次数 */
+    uint32_t chunks;        /* 首次发出的块 */
+    uint32_t retx_fast;     /* 由 ACK 推断丢失而重传的块 */
+    uint32_t retx_timeout;  /* 超时重传的块 */
+    uint32_t bytes;         /* 写入串口的字节（含帧开销） */
+    uint32_t payload;       /* 首次发出的数据字节 */
+    uint32_t rx_bad;        /* 校验失败或无法识别的接收帧 */
+} BtXfer_Stats_t;
+
+void BtXfer_GetStats(BtXfer_Stats_t *stats);
+
+/* 蓝牙任务：初始化 JDY-31，把传输协议挂到蓝牙串口并处理会话 */
+void BtXferTask(void *argument);
+
+#endif /* __BTXFER_H__ */
@@ -0,0 +1,139 @@
+/**
+ * @file    cannode.h
+ * @brief   CAN1 遥测与命令节点（声明式 ID 表编程硬件过滤器，中断收取入无锁队列，按 ID 优先级发送）
+ */
+#ifndef __CANNODE_H__
+#define __CANNODE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * 接收：CanNode_RxTable 中每一项编为一个硬件过滤器，按种类装入 14 个过滤器组
+ * （标准帧精确 ID 每组 4 个、标准帧掩码每组 2 个、扩展帧精确 ID 每组 2 个、扩展帧掩码每组 1 个），
+ * 全部指向 FIFO0。RX0 中断一次取空 FIFO0，连同过滤器匹配序号 (FMI) 写入单生产者/单消费者
+ * 无锁队列，CanTask 按 FMI 直接查到表项并调用处理函数，不再逐项比较 ID。
+ *
+ * 发送：TXFP = 0，三个邮箱同时挂起时由硬件先发 ID 最小的帧；邮箱满时帧进入按 ID 排序的
+ * 软件队列，邮箱空中断中依次补入 ID 最小者。
+ *
+ * 错误：SCE 中断统计进入警告/被动/离线 (bus-off) 的次数；离线后丢弃所有未发出的帧
+ * （避免恢复后发出过期快照），由硬件自动离线恢复 (ABOM) 回到总线，任务检测到恢复后计数。
+ *
+ * ID 分配参照 CANopen 预定义连接集（node 为 CANNODE_NODE_ID）：
+ *   0x080          同步：收到后立即发送一组遥测
+ *   0x180 + node   遥测 1：T1 i16 (0.01 ℃)，T2 i16 (0.01 ℃)，H u16 (0.01 %RH)，A i16 (0.1 m)
+ *   0x280 + node   遥测 2：L u32 (0.1 lux)，P u32 (0.1 Pa)
+ *   0x380 + node   遥测 3：D u16 (0.1 cm)，状态 u16（同 Modbus 输入寄存器 16），快照版本 u32
+ *   0x580 + node   命令应答
+ *   0x600 + node   命令（0x600 为广播，不应答）
+ *   0x6E0~0x6EA    ISO-TP 服务通道（cantp.h）
+ *   0x700 + node   心跳：状态 u8，TEC u8，REC u8，保留 u8，运行时间 u32 (s)
+ * 数据小端；未采到数据的字段为 0x8000 (i16) / 0xFFFF (u16) / 0xFFFFFFFF (u32)。
+ * 位速率由 MX_CAN1_Init 决定（42MHz / 6 / 16tq = 437.5 kbit/s）。
+ */
+
+#define CANNODE_NODE_ID         1U
+#define CANNODE_RXQ_LEN         64U      /* 接收队列深度（2 的幂） */
+#define CANNODE_TXQ_LEN         16U      /* 软件发送队列深度 */
+#define CANNODE_HEARTBEAT_MS    1000U
+#define CANNODE_TLM_PERIOD_MS   200U     /* 默认遥测最小间隔，0 表示每次快照都发 */
+#define CANNODE_FILTER_BANKS    14U      /* CAN1 可用过滤器组（0~13） */
+
+#define CANNODE_ID_SYNC         0x080U
+#define CANNODE_ID_TLM1         (0x180U + CANNODE_NODE_ID)
+#define CANNODE_ID_TLM2         (0x280U + CANNODE_NODE_ID)
+#define CANNODE_ID_TLM3         (0x380U + CANNODE_NODE_ID)
+#define CANNODE_ID_RESP         (0x580U + CANNODE_NODE_ID)
+#define CANNODE_ID_CMD          (0x600U + CANNODE_NODE_ID)
+#define CANNODE_ID_CMD_ALL      0x600U
+#define CANNODE_ID_HEARTBEAT    0x700U   /* + 节点号 */
+
+/* 命令（请求第 0 字节），应答为 [命令, 结果 (0 成功，1 未知命令，2 长度错误), 数据...] */
+#define CANNODE_CMD_PING        0x01U    /* 应答 快照版本 u32 */
+#define CANNODE_CMD_STATS       0x02U    /* 应答 状态 u8，TEC u8，REC u8，离线次数 u8，接收溢出 u16 */
+#define CANNODE_CMD_PERIOD      0x03U    /* 请求 间隔 u16 (ms)：设置遥测最小间隔 */
+#define CANNODE_CMD_TLM         0x04U    /* 立即发送一组遥测 */
+
+typedef enum {
+    CANNODE_ACTIVE = 0,     /* 主动错误 */
+    CANNODE_WARNING,        /* TEC 或 REC ≥ 96 */
+    CANNODE_PASSIVE,        /* TEC 或 REC > 127 */
+    CANNODE_BUSOFF          /* TEC > 255，等待自动恢复 */
+} cannode_state_t;
+
+typedef struct {
+    uint32_t id;
+    uint8_t  ext;           /* 1 = 29 位扩展帧 */
+    uint8_t  dlc;
+    uint8_t  entry;         /* 命中的 CanNode_RxTable 表项 */
+    uint8_t  rsv;
+    uint8_t  data[8];
+} CanNode_Frame_t;
+
+/* 接收表项：mask 为 0 表示精确匹配 id，否则只比较 mask 中为 1 的位。
+   表项之间不应重叠（重叠时硬件按 32 位优先于 16 位、列表优先于掩码的规则只报告其中一项）。
+   处理函数在 CanTask 中调用，可以直接发送 */
+typedef struct {
+    uint32_t id;
+    uint32_t mask;
+    uint8_t  ext;
+    void   (*handler)(const CanNode_Frame_t *f);
+} CanNode_Rx_t;
+
+#define CAN_RX_STD(i, h)            { .id = (i), .mask = 0, .ext = 0, .handler = (h) }
+#define CAN_RX_STD_MASK(i, m, h)    { .id = (i), .mask = (m), .ext = 0, .handler = (h) }
+#define CAN_RX_EXT(i, h)            { .id = (i), .mask = 0, .ext = 1, .handler = (h) }
+#define CAN_RX_EXT_MASK(i, m, h)    { .id = (i), .mask = (m), .ext = 1, .handler = (h) }
+
+typedef struct {
+    uint32_t rx_frames;       /* 进入接收队列的帧 */
+    uint32_t rx_overflow;     /* 接收队列满丢弃的帧 */
+    uint32_t rx_fifo_overrun; /* 硬件 FIFO0 溢出 */
+    uint32_t tx_frames;       /* 发送成功的帧 */
+    uint32_t tx_dropped;      /* 发送队列满或离线时丢弃的帧 */
+    uint32_t tx_errors;       /* 仲裁失败/发送错误后放弃的邮箱 */
+    uint32_t warnings;        /* 进入错误警告的次数 */
+    uint32_t passives;        /* 进入错误被动的次数 */
+    uint32_t busoffs;         /* 离线次数 */
+    uint32_t recoveries;      /* 离线后恢复的次数 */
+    uint32_t peers;           /* 最近 3 个心跳周期内收到过心跳的其他节点数 */
+    uint8_t  state;           /* cannode_state_t */
+    uint8_t  tec;             /* 发送错误计数 */
+    uint8_t  rec;             /* 接收错误计数 */
+    uint8_t  lec;             /* 最近一次错误码（ESR.LEC） */
+    uint8_t  banks;           /* 使用的过滤器组数 */
+    uint8_t  selftest;        /* 启动时 CanNode_Test 的结果：0 PASS，1 FAIL */
+} CanNode_Stats_t;
+
+/* 本节点接收表（cannode.c） */
+extern const CanNode_Rx_t CanNode_RxTable[];
+extern const uint8_t CanNode_RxTableSize;
+
+/* 按接收表编程过滤器，开启中断并启动 CAN1（正常模式）。过滤器组不够返回 1 */
+int CanNode_Start(void);
+
+/* 发送一帧（任务或中断中均可），邮箱与软件队列都满、离线或未启动时丢弃并返回 1 */
+int CanNode_Send(uint32_t id, bool ext, const uint8_t *data, uint8_t len);
+
+/* 软件队列与邮箱的空位数 */
+uint8_t CanNode_TxFree(void);
+
+void CanNode_GetStats(CanNode_Stats_t *stats);
+
+/* 设置遥测最小间隔 (ms)，0 表示每次快照发布都发送 */
+void CanNode_SetPeriod(uint16_t period_ms);
+
+/*
+ * 自检：在静默环回模式下（不驱动总线）重新初始化 CAN1，检查
+ *   1. 过滤器：表内各类 ID 都被收到且 FMI 对应正确表项，表外 ID 被滤除；
+ *   2. 发送优先级：一次提交超过三帧时，排队的帧按 ID 从小到大发出；
+ *   3. 无锁队列：中断收取的帧内容与发送一致。
+ * 结束后恢复为 Stop 状态，需再调用 CanNode_Start。返回 0 = PASS
+ */
+uint8_t CanNode_Test(void);
+
+/* CAN 任务：自检、启动，发送心跳与遥测，分发接收帧 */
+void CanTask(void *argument);
+
+#endif /* __CANNODE_H__ */
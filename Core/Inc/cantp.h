@@ -0,0 +1,59 @@
+/**
+ * @file    cantp.h
+ * @brief   CAN1 上的 ISO-TP 服务通道（回显、Flash 读出、Flash 写入）
+ */
+#ifndef __CANTP_H__
+#define __CANTP_H__
+
+#include <stdint.h>
+#include "isotp.h"
+#include "cannode.h"
+
+/*
+ * 每个通道是一条 ISO-TP 链路：本节点接收 0x6E0 + ch，发送 0x6E8 + ch，
+ * 在 CanNode_RxTable 中占一个标准帧掩码过滤器 (0x6E0/0x7FC)。
+ * 收发都在 CanTask 中进行：CanNode 分发收到的帧，CanTask 每轮调用 CanTp_Poll。
+ * 接收通告 BS = CANTP_BS、STmin = 0，一个块不超过 CanNode 接收队列深度；
+ * 发送只在 CanNode 发送队列留有 CANTP_TX_RESERVE 个空位时进行，遥测与心跳不会被连续帧挤掉。
+ *
+ *   ch0 回显：收到的消息（≤ CANTP_ECHO_MAX）原样发回
+ *   ch1 Flash 读出：请求 [地址 u24，长度 u24]（单帧），
+ *       应答 [状态 u8] + 数据，状态非 0 时没有数据；数据经 256 字节缓冲边读边发
+ *   ch2 Flash 写入：消息 [地址 u24] + 数据，地址须 4KB 对齐，
+ *       每进入一个扇区先整扇区擦除再写入（覆盖写，不保留扇区内其余内容）；
+ *       数据经 256 字节缓冲边收边写，结束后应答 [状态 u8，已写字节 u24]（单帧）
+ * 状态：0 成功，1 参数错误（越界/未对齐/长度），2 传输失败。多字节数据小端。
+ */
+
+#define CANTP_CHANNELS      3U
+#define CANTP_ID_RX_BASE    0x6E0U
+#define CANTP_ID_TX_BASE    0x6E8U
+#define CANTP_ID_MASK       0x7FCU
+#define CANTP_BS            16U
+#define CANTP_TX_RESERVE    6U          /* 给其他发送者保留的 CanNode 发送队列空位 */
+#define CANTP_ECHO_MAX      512U
+#define CANTP_CHUNK         256U
+
+enum {
+    CANTP_CH_ECHO = 0,
+    CANTP_CH_FLASH_READ,
+    CANTP_CH_FLASH_WRITE,
+};
+
+enum {
+    CANTP_ST_OK = 0,
+    CANTP_ST_PARAM,
+    CANTP_ST_XFER,
+};
+
+void CanTp_Init(void);
+
+/* CanNode_RxTable 中 0x6E0/0x7FC 表项的处理函数 */
+void CanTp_OnFrame(const CanNode_Frame_t *f);
+
+/* 推进所有通道，返回距下一次需要调用的时间 (ms)，空闲时返回 UINT32_MAX */
+uint32_t CanTp_Poll(void);
+
+void CanTp_GetStats(uint8_t ch, IsoTp_Stats_t *stats);
+
+#endif /* __CANTP_H__ */
@@ -0,0 +1,53 @@
+/**
+ * @file    config.h
+ * @brief   系统参数的持久化存储（保存在 AT24C02 EEPROM 中）
+ */
+#ifndef __CONFIG_H__
+#define __CONFIG_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CONFIG_EEPROM_ADDR   0x00      /* 参数区在 EEPROM 中的起始地址 */
+#define CONFIG_MAGIC         0x5443    /* "TC" */
+#define CONFIG_VERSION       1
+
+/* 参数结构（字段增删时需递增 CONFIG_VERSION） */
+typedef struct {
+    uint16_t magic;
+    uint8_t  version;
+    uint8_t  size;              /* sizeof(SysConfig_t) */
+    float    sea_level_pa;      /* 海拔计算使用的海平面气压 (Pa) */
+    uint8_t  modbus_addr;       /* Modbus 从站地址，0 = 默认 MODBUS_SLAVE_ADDR（原保留字节，旧参数读出为 0） */
+    uint8_t  reserved[2];
+    uint8_t  crc;               /* 前面所有字节的 CRC8，必须是最后一个字段 */
+} SysConfig_t;
+
+/* 海平面气压的允许范围 (Pa) */
+#define CONFIG_SEA_LEVEL_MIN 80000.0f
+#define CONFIG_SEA_LEVEL_MAX 120000.0f
+
+/* 参数区结束地址（不含），EEPROM 自检跳过 [CONFIG_EEPROM_ADDR, CONFIG_EEPROM_END) 所在的页 */
+#define CONFIG_EEPROM_END    (CONFIG_EEPROM_ADDR + sizeof(SysConfig_t))
+
+/* 当前生效的参数（上电后由 Config_Load 填充） */
+extern SysConfig_t g_config;
+
+/* 恢复默认值（不写入 EEPROM） */
+void Config_Default(void);
+
+/* 以下两个函数在内部持有 I2C1 总线锁，可在任意任务中调用 */
+
+/* 从 EEPROM 读取参数；返回 0 成功，1 数据无效（含海平面气压越界）已使用默认值，2 I2C 错误已使用默认值 */
+int Config_Load(void);
+
+/* 将 g_config 写入 EEPROM；返回 0 成功 */
+int Config_Save(void);
+
+/* 参数已由 Config_Load 载入（或已恢复默认值），其他任务据此等待采集任务完成载入 */
+bool Config_IsLoaded(void);
+
+/* 设置海平面气压并立即用于海拔计算（不写入 EEPROM），超出范围返回 1；可在中断中调用 */
+int Config_SetSeaLevel(float pa);
+
+#endif /* __CONFIG_H__ */
@@ -0,0 +1,111 @@
+/**
+ * @file    console.h
+ * @brief   串口命令行控制台（原地分词、有序命令表二分查找、非阻塞分段输出）
+ */
+#ifndef __CONSOLE_H__
+#define __CONSOLE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "uartrx.h"
+#include "fmt.h"
+
+/*
+ * 控制台是一个 Serial 协议，可以挂到任意端口（USART1、USART2（蓝牙或 ZigBee）、USART3、USART6），
+ * 每个端口独立一份行缓冲与命令状态，挂上后替换该端口原有的协议。
+ *
+ * 输入：串口中断中逐字节行编辑（退格、回显），回车后把整行交给 ConsoleTask，
+ * 命令执行期间忽略其他输入，Ctrl-C 中止正在输出的命令。
+ *
+ * 执行：ConsoleTask 在行缓冲内原地分词（空格分隔，双引号可包含空格，不复制不分配），
+ * 在按名字排序的 Console_Cmds 表中二分查找命令。
+ *
+ * 输出：命令函数每次调用只向 c->out 写一段（≤ CONSOLE_OUT_MAX），返回 CONSOLE_MORE 表示还有后续，
+ * 任务只在发送缓冲放得下一整段时才调用，写入后由 DMA 发出；缓冲不够（或被同一端口的遥测抢先占用）时
+ * 保留这一段，等待发送完成再写。
+ * 因此长输出（任务列表、Flash 转储）不会阻塞任务，也不会因发送缓冲满而丢字。
+ * 续写所需的状态放在 c->cursor / c->arg 中（命令开始时清零），分词结果在命令结束前保持有效。
+ *
+ * 默认挂在 USART1，该口同时输出二进制遥测与日志帧。为免二进制帧混进终端，收到键入后该端口进入会话：
+ * 会话期间（命令执行中，或距最后一次键入不到 CONSOLE_IDLE_MS）遥测与日志任务暂停向此端口发帧
+ * （Console_Active），quit 命令或空闲超时结束会话后恢复；也可用 route 命令把它们长期移到其他端口。
+ */
+
+#define CONSOLE_DEFAULT_PORT    UARTRX_PORT1
+#define CONSOLE_LINE_MAX        96U      /* 一行输入（含结尾 0） */
+#define CONSOLE_ARGS_MAX        8U
+#define CONSOLE_OUT_MAX         192U     /* 一次调用的最大输出 */
+#define CONSOLE_PROMPT          "> "
+#define CONSOLE_IDLE_MS         60000U   /* 无键入超过此时间会话结束 */
+
+/* 命令函数返回值 */
+#define CONSOLE_DONE            0
+#define CONSOLE_MORE            1
+#define CONSOLE_USAGE           (-1)     /* 参数错误：打印该命令的用法 */
+
+typedef struct Console Console_t;
+
+typedef int (*console_fn)(Console_t *c, int argc, char **argv);
+
+typedef struct {
+    const char *name;
+    console_fn  fn;
+    const char *usage;      /* 参数格式，参数错误时显示 */
+    const char *help;       /* 一句说明，help 命令显示 */
+} Console_Cmd_t;
+
+struct Console {
+    UartRx_Port_t port;
+    volatile uint8_t attached;
+    volatile uint8_t busy;       /* 已提交一行，直到命令结束 */
+    volatile uint8_t abort;      /* 收到 Ctrl-C */
+    uint8_t  edit_len;
+    uint8_t  last_cr;
+    uint8_t  argc;
+    uint8_t  done;               /* 命令已结束，剩余输出发完后打印提示符 */
+    volatile uint8_t session;    /* 有人在使用，二进制帧暂停 */
+    volatile uint32_t last_input;/* 最后一次键入的时刻 (tick) */
+    char     edit[CONSOLE_LINE_MAX];     /* 中断中编辑的行 */
+    char     line[CONSOLE_LINE_MAX];     /* 提交给任务的行，原地分词 */
+    char    *argv[CONSOLE_ARGS_MAX];
+    const Console_Cmd_t *cmd;    /* 正在执行的命令 */
+    uint32_t cursor;             /* 命令续写状态 */
+    uint32_t arg;
+    Fmt_t    out;
+    char     obuf[CONSOLE_OUT_MAX + 1U];
+    uint16_t olen;               /* obuf 中尚未写入发送缓冲的字节 */
+    uint32_t lines;              /* 执行过的命令行数 */
+    uint32_t dropped;            /* 忙或超长被丢弃的输入字节 */
+};
+
+/* 内置命令表（console_cmd.c），必须按 name 的 strcmp 顺序排列 */
+extern const Console_Cmd_t Console_Cmds[];
+extern const uint8_t Console_CmdCount;
+
+/* 把控制台挂到端口（替换原协议）并输出提示符，返回 0 成功 */
+int Console_Attach(UartRx_Port_t port);
+
+/* 端口上有进行中的控制台会话；遥测与日志任务据此暂停向该端口发帧，可在任务与中断中调用 */
+bool Console_Active(UartRx_Port_t port);
+
+/* 立即结束端口上的会话（quit 命令） */
+void Console_EndSession(UartRx_Port_t port);
+
+/* 原地分词：把 line 中的分隔空格改为 '\0'，argv 指向各参数，返回参数个数；
+   参数超过 max 或引号不配对返回 -1 */
+int Console_Tokenize(char *line, char **argv, int max);
+
+/* 二分查找命令，找不到返回 NULL */
+const Console_Cmd_t *Console_Find(const char *name);
+
+/* 数字解析：十进制或 0x 十六进制 / 带小数点的十进制（不经 strtod，不分配内存），成功返回 true */
+bool Console_ParseU32(const char *s, uint32_t *v);
+bool Console_ParseFloat(const char *s, float *v);
+
+/* 自检：命令表有序且每项都能查到，分词与数字解析的边界用例。返回 0 = PASS */
+uint8_t Console_Test(void);
+
+/* 控制台任务：挂到 CONSOLE_DEFAULT_PORT，执行各端口提交的命令 */
+void ConsoleTask(void *argument);
+
+#endif /* __CONSOLE_H__ */
@@ -0,0 +1,95 @@
+/**
+ * @file    dlog.h
+ * @brief   延迟格式化二进制日志（调用处只写格式串 ID 与原始参数，低优先级任务经 USART1 DMA 发出）
+ */
+#ifndef __DLOG_H__
+#define __DLOG_H__
+
+#include <stdint.h>
+#include "uartrx.h"
+
+/*
+ * 用法：
+ *   LOG_I("adc overrun ch=%u pos=%u", ch, pos);
+ *   LOG_W("t=%f", DLOG_F(temp));          浮点参数需用 DLOG_F 按位传递
+ * 参数按 32 位整数原样存入环形缓冲（最多 DLOG_MAX_ARGS 个），不做任何格式化；
+ * 不支持 %s（目标板字符串地址在上位机无意义，会按十六进制输出）。
+ *
+ * 格式串放在不占 FLASH 的 .dlog_fmt 段（链接脚本中为 INFO 段，起始地址 0），
+ * 字符串在段内的偏移即 ID。构建后由 objcopy --dump-section 提取该段，
+ * 上位机工具 Tools/dlogdump 用它把二进制流还原为文本。
+ *
+ * 写入可在任务与中断中调用：LDREX/STREX 无锁预留空间，写完参数后最后写入
+ * 带提交位的记录头；缓冲放不下时丢弃本条并计数，调用处永不阻塞。
+ * DLogTask 把已提交的记录打包成 TLM_REC_LOG 帧（tlmcodec 的 COBS + CRC32 分帧），
+ * 与遥测帧共用同一串口与发送缓冲；该端口上有控制台会话时（Console_Active）暂停发送，记录留在环中。
+ */
+
+#define DLOG_RING_WORDS     1024U   /* 环形缓冲大小（32 位字，2 的幂） */
+#define DLOG_MAX_ARGS       8U
+#define DLOG_DRAIN_MS       20U     /* 缓冲为空时的轮询间隔 */
+#define DLOG_DEFAULT_PORT   UARTRX_PORT1
+
+typedef enum {
+    DLOG_ERROR = 0,
+    DLOG_WARN,
+    DLOG_INFO,
+    DLOG_DEBUG
+} dlog_level_t;
+
+/* 编译期过滤：高于此级别的调用不产生代码 */
+#ifndef DLOG_COMPILE_LEVEL
+#define DLOG_COMPILE_LEVEL  DLOG_DEBUG
+#endif
+
+typedef struct {
+    uint32_t dropped;      /* 缓冲满被丢弃的记录数 */
+    uint32_t records;      /* 已发出的记录数 */
+    uint32_t frames;       /* 已发出的帧数 */
+    uint32_t bytes;        /* 已发出字节数（COBS 编码后） */
+    uint32_t high_water;   /* 缓冲最高占用（字） */
+} DLog_Stats_t;
+
+static inline uint32_t DLog_FloatBits(float f)
+{
+    union { float f; uint32_t u; } v = { f };
+    return v.u;
+}
+#define DLOG_F(x)  DLog_FloatBits((float)(x))
+
+#define DLOG(level, fmt, ...) do {                                                        \
+    if ((level) <= DLOG_COMPILE_LEVEL) {                                                  \
+        static const char dlog_fmt_[] __attribute__((section(".dlog_fmt"), used)) = fmt;  \
+        const uint32_t dlog_arg_[] = { 0U, ##__VA_ARGS__ };                               \
+        DLog_Write((level), (uint32_t)(uintptr_t)dlog_fmt_, &dlog_arg_[1],                \
+                   sizeof(dlog_arg_) / sizeof(dlog_arg_[0]) - 1U);                        \
+    }                                                                                     \
+} while (0)
+
+#define LOG_E(fmt, ...)  DLOG(DLOG_ERROR, fmt, ##__VA_ARGS__)
+#define LOG_W(fmt, ...)  DLOG(DLOG_WARN,  fmt, ##__VA_ARGS__)
+#define LOG_I(fmt, ...)  DLOG(DLOG_INFO,  fmt, ##__VA_ARGS__)
+#define LOG_D(fmt, ...)  DLOG(DLOG_DEBUG, fmt, ##__VA_ARGS__)
+
+/* 写入一条记录（由 DLOG 宏调用），id 为格式串在 .dlog_fmt 段中的偏移 */
+void DLog_Write(uint8_t level, uint32_t id, const uint32_t *args, uint32_t nargs);
+
+/* 运行期过滤：高于 level 的记录直接丢弃（不计入 dropped） */
+void DLog_SetLevel(dlog_level_t level);
+
+/* 切换输出端口，下一帧生效 */
+void DLog_SetPort(UartRx_Port_t port);
+
+void DLog_GetStats(DLog_Stats_t *stats);
+
+/* 基准：同一条 3 参数日志用 DLOG 写入与 snprintf 格式化的平均周期（会写入 16 条调试记录），
+   由 SelfTestTask 启动后运行一次 */
+typedef struct {
+    uint32_t write_cycles;
+    uint32_t sprintf_cycles;
+} DLog_Bench_t;
+void DLog_Bench(DLog_Bench_t *bench);
+
+void DLogTask(void *argument);
+
+#endif /* __DLOG_H__ */
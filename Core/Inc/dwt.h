@@ -0,0 +1,26 @@
+/**
+ * @file    dwt.h
+ * @brief   DWT 周期计数器（CYCCNT），用于微秒级计时与性能测量
+ */
+#ifndef __DWT_H__
+#define __DWT_H__
+
+#include "stm32f4xx_hal.h"
+#include <stdint.h>
+
+/* 使能 CYCCNT（重复调用无副作用） */
+static inline void DWT_Init(void)
+{
+    if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) != 0U) return;
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/* 当前 CPU 周期计数（168MHz 下约 25.5s 回绕一次，差值计算不受回绕影响） */
+static inline uint32_t DWT_GetCycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+#endif /* __DWT_H__ */
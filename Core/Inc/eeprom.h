@@ -66,7 +66,7 @@ HAL_StatusTypeDef AT24C02_Write(uint8_t addr, const uint8_t *pBuf, uint16_t len)
 HAL_StatusTypeDef AT24C02_Read(uint8_t addr, uint8_t *pBuf, uint16_t len);
 
 /**
- * @brief  EEPROM 读写自检（逐页遍历全部地址空间）
+ * @brief  EEPROM 读写自检（逐页遍历地址空间，跳过参数区 CONFIG_EEPROM_ADDR 所在的页）
  * @param  testedSize 输出: 实际测试通过的字节数
  * @retval 0 = PASS, 1 = FAIL
  */
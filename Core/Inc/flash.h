@@ -62,12 +62,20 @@ extern "C" {
 #define W25Q128_CS_LOW()           HAL_GPIO_WritePin(W25Q128_CS_PORT, W25Q128_CS_PIN, GPIO_PIN_RESET)
 #define W25Q128_CS_HIGH()          HAL_GPIO_WritePin(W25Q128_CS_PORT, W25Q128_CS_PIN, GPIO_PIN_SET)
 
+/* ---------- 访问锁 -------------------------------------------------------- */
+/* CAN 传输（CanTask）、蓝牙传输（BtXferTask）、控制台与 FlashTestTask 共用本芯片，
+   下面的读写 / 擦除函数本身不加锁，调用方须把一次完整操作（如擦除 + 写入）放在锁内。
+   W25Q128_LockInit 在 MX_FREERTOS_Init 中创建互斥量；调度器启动前加锁为空操作。 */
+void     W25Q128_LockInit(void);
+void     W25Q128_Lock(void);
+void     W25Q128_Unlock(void);
+
 /* ---------- 公开 API ------------------------------------------------------ */
 void     W25Q128_Init(void);
 uint16_t W25Q128_ReadID(void);
 uint32_t W25Q128_ReadJedecID(void);
 
-void     W25Q128_Read(uint8_t *pBuf, uint32_t addr, uint32_t len);
+uint8_t  W25Q128_Read(uint8_t *pBuf, uint32_t addr, uint32_t len);   /* 0 成功，1 SPI 失败 */
 void     W25Q128_WritePage(const uint8_t *pBuf, uint32_t addr, uint16_t len);
 void     W25Q128_WriteNoCheck(const uint8_t *pBuf, uint32_t addr, uint32_t len);
 void     W25Q128_Write(const uint8_t *pBuf, uint32_t addr, uint32_t len);
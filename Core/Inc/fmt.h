@@ -0,0 +1,73 @@
+/**
+ * @file    fmt.h
+ * @brief   无堆分配的快速文本格式化（LCD 与串口文本输出）
+ *
+ * 本模块不依赖 HAL/RTOS，格式化本身不调用 printf（只有 Fmt_Bench 用 snprintf 作对照），
+ * 上位机可直接编译（Tools/fmtbench）。
+ *
+ * 用法：
+ *   char msg[40];
+ *   Fmt_t f;
+ *   Fmt_Init(&f, msg, sizeof(msg));
+ *   Fmt_Str(&f, "SRAM Test: PASS (");
+ *   Fmt_U32(&f, kb, 0, ' ');
+ *   Fmt_Str(&f, "KB)");
+ * 输出直接写入调用方缓冲（可以是显示或发送命令的载荷区），始终以 '\0' 结尾；
+ * 放不下时截断并置 overflow，后续调用不再写入。
+ * 十进制按两位一组查表转换，浮点按固定小数位在 float 内完成，不提升为 double。
+ */
+#ifndef __FMT_H__
+#define __FMT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FMT_MAX_DECIMALS   6U
+
+typedef struct {
+    char    *buf;
+    uint16_t size;       /* 缓冲总长（含结尾 0） */
+    uint16_t len;        /* 已写入字符数（不含结尾 0） */
+    bool     overflow;   /* 发生过截断 */
+} Fmt_t;
+
+/* 绑定缓冲，size 为 0 时所有写入都被忽略 */
+void Fmt_Init(Fmt_t *f, char *buf, uint16_t size);
+
+void Fmt_Char(Fmt_t *f, char c);
+void Fmt_Str(Fmt_t *f, const char *s);
+
+/* 十进制，width 为最小宽度（不足左补 pad，pad 取 ' ' 或 '0'），0 表示不限 */
+void Fmt_U32(Fmt_t *f, uint32_t v, uint8_t width, char pad);
+void Fmt_I32(Fmt_t *f, int32_t v, uint8_t width, char pad);
+
+/* 大写十六进制，固定 digits 位（1~8，高位补 0） */
+void Fmt_Hex(Fmt_t *f, uint32_t v, uint8_t digits);
+
+/* 字节序列的十六进制，如 "FE 08 91"，sep 为 0 时不加分隔符 */
+void Fmt_HexBytes(Fmt_t *f, const uint8_t *data, uint16_t len, char sep);
+
+/* 定点小数：decimals 位小数（0~FMT_MAX_DECIMALS），四舍五入；
+   NaN/无穷输出 "nan"/"inf"，绝对值超出 uint32 范围输出 "ovf" */
+void Fmt_Fixed(Fmt_t *f, float v, uint8_t decimals);
+
+/* 把无符号数转换到 out（不补 0 结尾），返回位数，out 至少 10 字节 */
+uint8_t Fmt_Utoa(uint32_t v, char *out);
+
+/* ---- 基准与自检 ---- */
+
+typedef uint32_t (*fmt_cycles_fn)(void);
+
+typedef struct {
+    uint32_t cases;          /* 对照用例数 */
+    uint32_t mismatches;     /* 与 snprintf 结果不一致的用例数 */
+    uint32_t fmt_cycles;     /* 全部用例 Fmt 的总耗时（cycles 计数单位） */
+    uint32_t printf_cycles;  /* 全部用例 snprintf 的总耗时 */
+} Fmt_Bench_t;
+
+/* 用同一组用例（测试结果消息、十六进制转储、有符号数、定点小数）对比 snprintf：
+   逐个比对输出并分别计时，cycles 为计时函数（目标板传 DWT_GetCycles）。
+   全部一致返回 0 */
+uint8_t Fmt_Bench(fmt_cycles_fn cycles, Fmt_Bench_t *bench);
+
+#endif /* __FMT_H__ */
@@ -6,15 +6,25 @@
 #include "sht30.h"
 #include "bh1750.h"
 #include "hc_sr04.h"
+#include "snapshot.h"
 
+/* 采集结果通过 snapshot.h 的快照发布（T1/T2/H/L/P/A/D 对应 SNAP_xx 字段） */
 
-extern float T1;   //from bmp280 (℃)
-extern float T2;   //from sht30 (℃)
-extern float H;    //Humidity 湿度 (%RH)
-extern float L;    //Light 光照 (lux)
-extern float P;    //Pressure 气压 (Pa)
-extern float A;    //Altitude 海拔 (m)
-extern float D;    //Distance 距离 (cm)
+/* 采集调度中的传感器编号 */
+typedef enum {
+    GETDATA_BMP280 = 0,
+    GETDATA_SHT30,
+    GETDATA_BH1750,
+    GETDATA_HCSR04,
+    GETDATA_SENSOR_NUM
+} getdata_sensor_t;
+
+/* 默认采样周期 (ms) */
+#define GETDATA_DEFAULT_PERIOD_MS  1000U
+
+/* 设置单个传感器的采样周期 (ms)，0 表示停止采样；可在任意任务中调用 */
+void GetData_SetPeriod(getdata_sensor_t sensor, uint32_t period_ms);
+uint32_t GetData_GetPeriod(getdata_sensor_t sensor);
 
 void GetDataTask(void *argument);
 
@@ -8,21 +8,67 @@ typedef enum {
     HCSR04_OK = 0,
     HCSR04_ERR_TIMEOUT_RISING = 1,
     HCSR04_ERR_TIMEOUT_FALLING = 2,
-    HCSR04_ERR_NOT_INIT = 3
+    HCSR04_ERR_NOT_INIT = 3,
+    HCSR04_ERR_BUSY = 4,
+    HCSR04_ERR_NO_RESULT = 5
 } hcsr04_status_t;
 
-/* 初始化：指定 TRIG 端口/引脚（输出）和 ECHO 端口/引脚（输入），
-   echo_pull: GPIO_NOPULL / GPIO_PULLUP / GPIO_PULLDOWN */
+/*
+ * 中断驱动测距：
+ * TIM2 以 1MHz 自由计数（32 位），CC1 比较中断负责结束 10us 触发脉冲、
+ * 回波超时以及连续测距的下一次触发；ECHO 引脚双边沿 EXTI 中断记录回波起止时刻。
+ * 等待回波期间不占用 CPU。结果经消息队列（HC_SR04_GetResult）
+ * 或回调（中断上下文）交付。
+ * 中断入口 HC_SR04_TimerIRQHandler / HC_SR04_EchoIRQHandler 在 stm32f4xx_it.c 中调用。
+ */
+
+#define HCSR04_MIN_PERIOD_MS  25U   /* 连续测距最高 40Hz */
+#define HCSR04_MEDIAN_LEN     5U    /* 中值滤波窗口 */
+#define HCSR04_QUEUE_LEN      4U    /* 结果队列深度 */
+
+typedef struct {
+    hcsr04_status_t status;
+    uint32_t pulse_us;   /* 回波脉宽（微秒） */
+    float    cm_raw;     /* 单次距离（已做声速温度补偿） */
+    float    cm;         /* 中值滤波后的距离 */
+    uint32_t tick;       /* 完成时刻 (ms) */
+} hcsr04_result_t;
+
+/* 结果回调，在中断上下文中执行，需尽快返回 */
+typedef void (*hcsr04_callback_t)(const hcsr04_result_t *res);
+
+/* 初始化：指定 TRIG 端口/引脚（输出）和 ECHO 端口/引脚（双边沿中断输入），
+   echo_pull: GPIO_NOPULL / GPIO_PULLUP / GPIO_PULLDOWN。需在任务中调用（创建队列） */
 void HC_SR04_Init(GPIO_TypeDef *trig_port, uint16_t trig_pin,
                   GPIO_TypeDef *echo_port, uint16_t echo_pin,
                   uint32_t echo_pull);
 
-/* 发起一次测距，返回状态；若成功且 us_ptr 非 NULL，返回回波脉冲宽度（微秒）；
-   若 cm_ptr 非 NULL，返回距离（厘米，浮点） */
+/* 发起一次测距（非阻塞），测量进行中返回 HCSR04_ERR_BUSY */
+hcsr04_status_t HC_SR04_Trigger(void);
+
+/* 连续测距，period_ms 不小于 HCSR04_MIN_PERIOD_MS；Stop 在当前测量结束后停止 */
+hcsr04_status_t HC_SR04_Start(uint32_t period_ms);
+void HC_SR04_Stop(void);
+
+/* 从结果队列取一个结果，timeout_ms 为等待时间（0 = 不等待），返回 HCSR04_OK 表示取到 */
+hcsr04_status_t HC_SR04_GetResult(hcsr04_result_t *res, uint32_t timeout_ms);
+
+/* 设置结果回调（NULL 取消） */
+void HC_SR04_SetCallback(hcsr04_callback_t cb);
+
+/* 空气温度（摄氏度），用于声速补偿 c = 331.3 + 0.606*T (m/s) */
+void HC_SR04_SetAirTemperature(float temp_c);
+
+/* 发起一次测距并等待结果，返回状态；若成功且 us_ptr 非 NULL，返回回波脉冲宽度（微秒）；
+   若 cm_ptr 非 NULL，返回距离（厘米，浮点）。等待期间任务阻塞在队列上，不占用 CPU。
+   不要与连续测距同时使用 */
 hcsr04_status_t HC_SR04_Measure(uint32_t *us_ptr, float *cm_ptr);
 
 /* 微调：设置测量超时（微秒），默认 30000us (30ms) */
 void HC_SR04_SetTimeoutUs(uint32_t timeout_us);
 
-#endif /* __HC_SR04_H__ */
+/* 中断入口 */
+void HC_SR04_TimerIRQHandler(void);
+void HC_SR04_EchoIRQHandler(void);
 
+#endif /* __HC_SR04_H__ */
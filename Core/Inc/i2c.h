@@ -42,6 +42,13 @@ void MX_I2C1_Init(void);
 
 /* USER CODE BEGIN Prototypes */
 
+/* I2C1 总线锁：BMP280 / SHT30 / BH1750（GetDataTask）与 AT24C02（参数存储、自检）共用 I2C1，
+   不同任务访问时每次事务（含 EEPROM 写周期等待）都须在锁内完成。
+   I2C1_LockInit 在 MX_FREERTOS_Init 中创建互斥量；调度器启动前加锁为空操作。 */
+void I2C1_LockInit(void);
+void I2C1_Lock(void);
+void I2C1_Unlock(void);
+
 /* USER CODE END Prototypes */
 
 #ifdef __cplusplus
@@ -0,0 +1,160 @@
+/**
+ * @file    isotp.h
+ * @brief   ISO 15765-2 (ISO-TP) 分段传输层（经典 CAN，正常寻址）
+ *
+ * 本模块不依赖 HAL/RTOS，只通过回调收发 CAN 帧，时间由调用方以微秒传入；
+ * 目标板经 cantp.c 接到 CAN1，上位机 Tools/isotpbench 用虚拟 CAN 总线测试吞吐与时序。
+ */
+#ifndef __ISOTP_H__
+#define __ISOTP_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * 帧格式（第 0 字节高 4 位为类型）：
+ *   SF  0L  数据 * L                    单帧，L = 1~7
+ *   FF  1H LL  数据 * 6                 首帧，12 位总长 HLL = 8~4095
+ *   FF  10 00 L3 L2 L1 L0  数据 * 2     首帧，总长 > 4095 时用 32 位长度（大端）
+ *   CF  2N  数据 * 7                    连续帧，N 为序号（首帧后从 1 开始，模 16）
+ *   FC  3S BS ST                        流控：S = 0 继续 / 1 等待 / 2 溢出，
+ *                                       BS = 块大小（0 不限），ST = STmin
+ * 所有帧都补齐到 8 字节（填充值 ISOTP_PAD）。
+ *
+ * 一条链路 (IsoTp_Link_t) 由一对 CAN ID 组成，收发各自独立，可同时进行；
+ * 多个链路互不影响，调用方按接收 ID 把帧分给对应链路。
+ *
+ * 零拷贝：发送直接从调用方缓冲取数据拼成 CAN 帧，接收直接把 CAN 帧数据写进调用方缓冲，
+ * 不经过整条消息的中间缓冲。消息比缓冲大时用分段回调流式处理：
+ *   发送缓冲的数据全部装入 CAN 帧后调用 tx_seg 取下一段（可重新填充同一缓冲）；
+ *   接收缓冲写满时调用 rx_seg 交出已收数据并取下一段缓冲（例如写入 Flash 后复用）。
+ * rx_seg 在处理帧的上下文中同步执行，期间对端仍按流控继续发送，
+ * 所以接收方通告的 BS 应使一个块的帧数不超过底层接收队列深度。
+ */
+
+#define ISOTP_FRAME_LEN     8U
+#define ISOTP_PAD           0xCCU
+#define ISOTP_SF_MAX        7U
+#define ISOTP_FF12_MAX      4095U       /* 12 位长度首帧的上限 */
+#define ISOTP_N_BS_US       1000000U    /* 发送方等待流控的超时 */
+#define ISOTP_N_CR_US       1000000U    /* 接收方等待连续帧的超时 */
+#define ISOTP_WFT_MAX       8U          /* 连续收到“等待”流控的上限 */
+#define ISOTP_NO_EVENT      0xFFFFFFFFU
+
+typedef enum {
+    ISOTP_OK = 0,
+    ISOTP_ERR_BUSY,          /* 本方向已有传输在进行 */
+    ISOTP_ERR_PARAM,
+    ISOTP_ERR_TIMEOUT_BS,    /* 等待流控超时 */
+    ISOTP_ERR_TIMEOUT_CR,    /* 等待连续帧超时 */
+    ISOTP_ERR_WRONG_SN,      /* 连续帧序号错误 */
+    ISOTP_ERR_OVERFLOW,      /* 接收缓冲放不下（本端）或对端回复溢出 */
+    ISOTP_ERR_UNEXP_PDU,     /* 接收中途收到新的单帧/首帧，原消息作废 */
+    ISOTP_ERR_WFT_OVRN,      /* 等待流控过多 */
+    ISOTP_ERR_ABORT          /* 分段回调终止 */
+} isotp_result_t;
+
+typedef struct IsoTp_Link IsoTp_Link_t;
+
+/* 发送一帧 CAN（len 固定为 8），底层暂时放不下返回非 0，链路稍后在 Poll 中重试 */
+typedef int (*isotp_can_tx_fn)(void *ctx, uint32_t id, const uint8_t *data, uint8_t len);
+
+/* 分段回调：done/n 为刚用完（发送）或写满（接收）的缓冲，
+   在 next/size 返回下一段缓冲；返回 false 终止本次传输 */
+typedef bool (*isotp_seg_fn)(IsoTp_Link_t *l, const uint8_t *done, uint32_t n, uint8_t **next, uint32_t *size);
+
+/* 传输结束：r 为结果，len 为本次消息实际收发的字节数。
+   接收时最后一段缓冲中的有效字节数为 len 减去此前各段之和 */
+typedef void (*isotp_done_fn)(IsoTp_Link_t *l, isotp_result_t r, uint32_t len);
+
+typedef struct {
+    uint32_t tx_id;          /* 本端发出的 CAN ID（数据帧与流控帧） */
+    uint32_t rx_id;          /* 本端接收的 CAN ID */
+    uint8_t  bs;             /* 接收时通告的块大小，0 = 不限 */
+    uint8_t  stmin;          /* 接收时通告的 STmin：0~127 ms，0xF1~0xF9 = 100~900 us */
+    isotp_can_tx_fn can_tx;
+    void    *can_ctx;
+    isotp_seg_fn  tx_seg;    /* NULL 表示消息必须一次给全 */
+    isotp_seg_fn  rx_seg;    /* NULL 表示消息必须放得下接收缓冲 */
+    isotp_done_fn tx_done;
+    isotp_done_fn rx_done;
+    void    *user;
+} IsoTp_Config_t;
+
+typedef struct {
+    uint32_t tx_msgs;
+    uint32_t rx_msgs;
+    uint32_t tx_bytes;
+    uint32_t rx_bytes;
+    uint32_t errors;         /* 以非 ISOTP_OK 结束的传输 */
+    uint32_t fc_wait;        /* 收到的“等待”流控 */
+} IsoTp_Stats_t;
+
+struct IsoTp_Link {
+    const IsoTp_Config_t *cfg;
+
+    /* 发送方向 */
+    uint8_t  tx_state;
+    uint8_t  tx_sn;
+    uint8_t  tx_bs;          /* 对端通告的块大小 */
+    uint8_t  tx_bs_left;     /* 本块剩余帧数 */
+    uint8_t  tx_wft;
+    uint32_t tx_stmin_us;
+    const uint8_t *tx_buf;
+    uint32_t tx_len;         /* 当前段长度 */
+    uint32_t tx_pos;         /* 当前段已装入帧的字节 */
+    uint32_t tx_total;
+    uint32_t tx_done_len;    /* 已装入帧的总字节 */
+    uint32_t tx_at;          /* 下一动作时刻：连续帧发送或流控超时 (us) */
+    uint8_t  tx_frame[ISOTP_FRAME_LEN];   /* 已组好但底层未接收的帧 */
+    uint8_t  tx_frame_ready;
+
+    /* 接收方向 */
+    uint8_t  rx_state;
+    uint8_t  rx_sn;
+    uint8_t  rx_bs_left;
+    uint8_t  rx_fc_pending;  /* 流控帧待发：0 无，1 继续，3 溢出 */
+    uint8_t *rx_buf;
+    uint32_t rx_size;        /* 当前段容量 */
+    uint32_t rx_pos;         /* 当前段已写入 */
+    uint32_t rx_total;
+    uint32_t rx_got;
+    uint32_t rx_at;          /* 连续帧超时时刻 (us) */
+    uint8_t *rx_base;        /* IsoTp_SetRxBuffer 给出的缓冲 */
+    uint32_t rx_base_size;
+
+    IsoTp_Stats_t stats;
+};
+
+/* 初始化链路，cfg 须在链路生命周期内有效 */
+void IsoTp_Init(IsoTp_Link_t *l, const IsoTp_Config_t *cfg);
+
+/* 设置接收缓冲（每条消息都从这里开始写），buf 为 NULL 时拒收多帧消息（回复溢出） */
+void IsoTp_SetRxBuffer(IsoTp_Link_t *l, uint8_t *buf, uint32_t size);
+
+/*
+ * 开始发送一条 total 字节的消息，第一段为 buf/len（len ≤ total，其余由 tx_seg 提供）。
+ * buf 在传输结束（tx_done）前不能改动。单帧立即发出，多帧发出首帧后等待流控。
+ */
+isotp_result_t IsoTp_Send(IsoTp_Link_t *l, const uint8_t *buf, uint32_t len, uint32_t total, uint32_t now_us);
+
+/* 收到一帧 rx_id 上的 CAN 帧 */
+void IsoTp_OnFrame(IsoTp_Link_t *l, const uint8_t *data, uint8_t len, uint32_t now_us);
+
+/* 推进发送（按 STmin 发连续帧、补发未被底层接收的帧）并检查超时，应在 NextEvent 给出的时刻前调用 */
+void IsoTp_Poll(IsoTp_Link_t *l, uint32_t now_us);
+
+/* 距下一次需要 Poll 的时间 (us)，0 表示立即，ISOTP_NO_EVENT 表示空闲 */
+uint32_t IsoTp_NextEvent(const IsoTp_Link_t *l, uint32_t now_us);
+
+bool IsoTp_TxBusy(const IsoTp_Link_t *l);
+bool IsoTp_RxBusy(const IsoTp_Link_t *l);
+
+/* 中止进行中的收发（不发送任何帧），回调以 ISOTP_ERR_ABORT 结束 */
+void IsoTp_Abort(IsoTp_Link_t *l);
+
+/* STmin 编码与微秒互换（非法编码按 127 ms 处理） */
+uint32_t IsoTp_StminToUs(uint8_t st);
+uint8_t IsoTp_UsToStmin(uint32_t us);
+
+#endif /* __ISOTP_H__ */
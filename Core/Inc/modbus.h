@@ -0,0 +1,152 @@
+/**
+ * @file    modbus.h
+ * @brief   Modbus RTU 主/从站（USART3 + RS485，DMA 收发，TIM7 判定帧间隔）
+ */
+#ifndef __MODBUS_H__
+#define __MODBUS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "uartrx.h"
+
+/*
+ * 帧边界：每收到一段字节（UartRx 的 IDLE/HT/TC 事件）重新启动 TIM7 单脉冲计时，
+ * 计满 t3.5 仍无新数据即认为一帧结束，在 TIM7 中断中直接校验并处理。
+ * IDLE 事件本身在最后一个字节之后一个字符时间才到达，定时值相应减去一个字符。
+ * 波特率高于 19200 时 t3.5 按规范固定为 1750us。
+ * 以段为单位接收无法观测字符间的 t1.5 间隔，帧内断续由 CRC 检出。
+ *
+ * 从站：请求在 TIM7 中断中查寄存器表生成应答并交给 DMA 发送，
+ * 从帧结束判定到开始发送只有几微秒，远小于 115200 下的一个字符时间 (87us)；
+ * 最大处理耗时见 Modbus_Stats_t.turnaround_max。
+ * 主站：Modbus_ReadRegs 等接口在任务中阻塞等待应答（多个任务调用时互斥）。
+ *
+ * RS485 方向由 Serial_SetDE 控制，发送期间 DE (PG8) 为高，最后一个字节移出后释放。
+ */
+
+#define MODBUS_PORT             UARTRX_PORT3
+#define MODBUS_DE_GPIO          GPIOG
+#define MODBUS_DE_PIN           GPIO_PIN_8
+#define MODBUS_SLAVE_ADDR       1U
+#define MODBUS_ADU_MAX          256U     /* 最大帧长（地址 + PDU + CRC） */
+#define MODBUS_MAX_REGS         125U     /* 单次读寄存器上限（规范） */
+#define MODBUS_MAX_WRITE        123U     /* 单次写寄存器上限（规范） */
+#define MODBUS_TIMEOUT_MS       100U     /* 主站默认应答超时 */
+#define MODBUS_IRQ_PRIORITY     6U       /* 与 UART/DMA 同级，帧处理与接收互不抢占 */
+
+typedef enum {
+    MODBUS_SLAVE = 0,
+    MODBUS_MASTER
+} modbus_role_t;
+
+/* 结果：0 成功，1~4 为对方返回的异常码，其余为本地错误 */
+typedef enum {
+    MB_OK = 0,
+    MB_EX_ILLEGAL_FUNCTION = 1,
+    MB_EX_ILLEGAL_ADDRESS = 2,
+    MB_EX_ILLEGAL_VALUE = 3,
+    MB_EX_DEVICE_FAILURE = 4,
+    MB_ERR_TIMEOUT = 0x80,
+    MB_ERR_CRC,             /* 应答 CRC 错误 */
+    MB_ERR_FRAME,           /* 应答与请求不匹配 */
+    MB_ERR_BUSY,            /* 端口不是主站或发送缓冲满 */
+    MB_ERR_PARAM
+} mb_result_t;
+
+/* ---- 寄存器表 ---- */
+
+typedef enum {
+    MB_INPUT = 0,           /* 输入寄存器（功能码 04，只读） */
+    MB_HOLDING              /* 保持寄存器（功能码 03/06/16） */
+} mb_space_t;
+
+typedef enum {
+    MB_U16 = 0,
+    MB_I16,
+    MB_U32,                 /* 32 位量占两个寄存器，高字在前 */
+    MB_I32,
+    MB_F32                  /* IEEE754 单精度，高字在前 */
+} mb_type_t;
+
+typedef enum {
+    MB_SRC_SNAP = 0,        /* 快照字段 × scale */
+    MB_SRC_VAR,             /* 变量（类型与 type 一致，F32 为 float） */
+    MB_SRC_FN               /* 读写函数 */
+} mb_src_t;
+
+/*
+ * 一项寄存器定义。表按 (space, addr) 升序排列且互不重叠（Modbus_Start 时检查），
+ * 查找用二分法。读写函数在中断中调用，必须很快；耗时操作（如写 EEPROM）应置标志
+ * 交给任务处理。写入的原始值在 [min, max] 之外时返回非法数据值异常。
+ */
+typedef struct {
+    uint16_t addr;
+    uint8_t  space;                   /* mb_space_t */
+    uint8_t  type;                    /* mb_type_t */
+    uint8_t  src;                     /* mb_src_t */
+    uint8_t  field;                   /* MB_SRC_SNAP：snap_field_t */
+    float    scale;                   /* MB_SRC_SNAP：寄存器值 = round(value * scale) */
+    void    *var;                     /* MB_SRC_VAR */
+    bool   (*get)(uint32_t *raw);     /* MB_SRC_FN，返回 false 表示设备故障 */
+    bool   (*set)(uint32_t raw);      /* MB_SRC_FN，NULL 表示只读 */
+    int32_t  min, max;                /* 写入范围（F32 按浮点值比较，均为 0 表示不限） */
+} Modbus_Reg_t;
+
+/* 声明表项的辅助宏 */
+#define MB_SNAP(sp, a, f, sc, t)         { .addr = (a), .space = (sp), .type = (t), .src = MB_SRC_SNAP, .field = (f), .scale = (sc) }
+#define MB_VAR(sp, a, v, t)              { .addr = (a), .space = (sp), .type = (t), .src = MB_SRC_VAR, .var = (void *)(v) }
+#define MB_VAR_RW(a, v, t, lo, hi)       { .addr = (a), .space = MB_HOLDING, .type = (t), .src = MB_SRC_VAR, .var = (void *)(v), .min = (lo), .max = (hi) }
+#define MB_FN(sp, a, t, g, s, lo, hi)    { .addr = (a), .space = (sp), .type = (t), .src = MB_SRC_FN, .get = (g), .set = (s), .min = (lo), .max = (hi) }
+
+/* 本板寄存器表（modbus_map.c） */
+extern const Modbus_Reg_t Modbus_Map[];
+extern const uint16_t Modbus_MapSize;
+
+/* 执行寄存器写入引起的延后操作，由 Usart3Task 周期调用：
+   站地址（g_config.modbus_addr）与当前生效的不同时重新启动从站（首次调用即以保存的地址启动），
+   有保存请求时写 EEPROM */
+void Modbus_MapService(void);
+
+/* ---- 运行 ---- */
+
+typedef struct {
+    uint32_t frames;          /* 收到的完整帧 */
+    uint32_t crc_err;
+    uint32_t overflow;        /* 超过 MODBUS_ADU_MAX 的帧 */
+    uint32_t ignored;         /* 非本站地址或无请求时收到的应答 */
+    uint32_t requests;        /* 从站：已处理请求 */
+    uint32_t exceptions;      /* 从站：返回的异常应答 */
+    uint32_t timeouts;        /* 主站：超时次数 */
+    uint32_t turnaround_max;  /* 从站：帧结束中断到应答写入发送缓冲的最大耗时 (CPU 周期) */
+} Modbus_Stats_t;
+
+/* 以 role 身份挂到 MODBUS_PORT（Serial_Attach），配置 DE 与 TIM7。
+   从站检查寄存器表，表无序或重叠返回 1 */
+int Modbus_Start(modbus_role_t role, uint8_t slave_addr);
+
+void Modbus_GetStats(Modbus_Stats_t *stats);
+
+/* 主站：读保持 (fc = 3) 或输入 (fc = 4) 寄存器 */
+mb_result_t Modbus_ReadRegs(uint8_t slave, uint8_t fc, uint16_t addr, uint16_t count, uint16_t *out, uint32_t timeout_ms);
+
+/* 主站：写单个 (06) / 多个 (16) 保持寄存器，slave 为 0 时广播（不等应答） */
+mb_result_t Modbus_WriteReg(uint8_t slave, uint16_t addr, uint16_t value, uint32_t timeout_ms);
+mb_result_t Modbus_WriteRegs(uint8_t slave, uint16_t addr, const uint16_t *values, uint16_t count, uint32_t timeout_ms);
+
+/* Modbus CRC16（多项式 0xA001 反射、初值 0xFFFF，查表），结果低字节先发 */
+uint16_t Modbus_Crc16(const uint8_t *data, uint16_t len);
+
+/* 由 TIM7 中断服务函数调用（stm32f4xx_it.c） */
+void Modbus_TimerIRQHandler(void);
+
+/*
+ * 自检：CRC 参考向量，以及本地构造的请求帧（读输入/保持寄存器、写单个/多个、各类异常、
+ * 其他站与广播）
+ * 直接驱动从站处理函数，检查应答内容并统计处理耗时，不经过串口。
+ * max_cycles 返回单帧最大处理周期数（可为 NULL），全部正确且不超过一个字符时间返回 0。
+ * 从站尚未启动时按 MODBUS_SLAVE_ADDR 测试；会把保持寄存器 0-1 原样写回，需在参数载入后调用。
+ * Usart3Task 在启动从站前运行一次并经 DLOG 输出结果
+ */
+uint8_t Modbus_Test(uint32_t *max_cycles);
+
+#endif /* __MODBUS_H__ */
@@ -0,0 +1,64 @@
+/**
+ * @file    sensorbus.h
+ * @brief   传感器数据发布/订阅总线（按通道订阅，按订阅者速率抽取/平均）
+ */
+#ifndef __SENSORBUS_H__
+#define __SENSORBUS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "snapshot.h"
+
+#define SENSORBUS_MAX_SUBS     6U   /* 最大订阅者数 */
+#define SENSORBUS_QUEUE_LEN    4U   /* 默认每个订阅者的记录队列深度 */
+
+/* 通道掩码：bit n 对应 snap_field_t n */
+#define SENSORBUS_CH(field)    (1UL << (field))
+#define SENSORBUS_CH_ALL       ((1UL << SNAP_FIELD_NUM) - 1UL)
+
+/* 一个交付周期内多个样本的合并方式 */
+typedef enum {
+    SENSORBUS_LATEST = 0,   /* 取最新值（纯抽取） */
+    SENSORBUS_AVERAGE,      /* 取平均值 */
+    SENSORBUS_MAX           /* 取最大值（报警判断） */
+} sensorbus_policy_t;
+
+typedef struct {
+    uint32_t channels;      /* 订阅的通道掩码 */
+    uint32_t period_ms;     /* 交付周期，0 = 每次发布都交付 */
+    uint8_t  policy;        /* sensorbus_policy_t */
+    uint8_t  queue_len;     /* 队列深度，0 使用 SENSORBUS_QUEUE_LEN */
+} SensorBus_SubCfg_t;
+
+/* 交付给订阅者的定长记录 */
+typedef struct {
+    uint32_t version;               /* 产生该记录的快照版本 */
+    uint32_t tick;                  /* 交付时刻 (ms) */
+    uint32_t pub_cycles;            /* 发布时刻的 DWT 周期计数，用于延迟统计 */
+    uint32_t valid;                 /* 本记录中有新数据的通道掩码 */
+    float    value[SNAP_FIELD_NUM];
+    uint8_t  count[SNAP_FIELD_NUM]; /* 合并的样本数 */
+} SensorBus_Record_t;
+
+/* 订阅者统计 */
+typedef struct {
+    uint32_t delivered;             /* 已交付记录数 */
+    uint32_t dropped;               /* 队列满丢弃数 */
+    uint32_t lat_min_us;            /* 发布到接收的延迟 (us) */
+    uint32_t lat_max_us;
+    uint32_t lat_avg_us;            /* 指数平均 (1/8) */
+} SensorBus_Stats_t;
+
+/* 注册订阅者（初始化阶段调用，会创建队列），返回句柄 >= 0，失败返回 -1 */
+int SensorBus_Subscribe(const SensorBus_SubCfg_t *cfg);
+
+/* 由采集任务在每次快照发布后调用 */
+void SensorBus_Publish(const SensorSnapshot_t *snap);
+
+/* 接收一条记录，timeout_ms 为等待时间（osWaitForever 永久等待），返回 true 表示收到 */
+bool SensorBus_Receive(int sub, SensorBus_Record_t *rec, uint32_t timeout_ms);
+
+/* 读取订阅者统计 */
+bool SensorBus_GetStats(int sub, SensorBus_Stats_t *stats);
+
+#endif /* __SENSORBUS_H__ */
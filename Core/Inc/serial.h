@@ -0,0 +1,73 @@
+/**
+ * @file    serial.h
+ * @brief   串口端口注册表：每个 UART 独立的收发缓冲、统计与可插拔协议
+ */
+#ifndef __SERIAL_H__
+#define __SERIAL_H__
+
+#include "uartrx.h"
+#include <stdint.h>
+
+/*
+ * 每个端口（与 UartRx 端口号一致）由以下部分组成：
+ *   - 接收：UartRx 的 DMA 循环缓冲，字节段交给当前协议的 rx；
+ *   - 发送：SERIAL_TX_RING_SIZE 字节的环形缓冲，由 DMA 分段发出；
+ *   - 可选的 RS485 收发控制 (DE) 引脚，发送期间拉高；
+ *   - 当前协议（蓝牙行协议、ZigBee 帧、Modbus、控制台……）。
+ * 中断中由 UART 句柄查表得到端口（O(1)），再调用端口当前协议的函数指针，
+ * 切换协议只需调用 Serial_Attach，不涉及中断代码。
+ */
+
+#define SERIAL_TX_RING_SIZE   512U   /* 每端口发送缓冲（2 的幂） */
+
+/* 协议接口，除 attach/detach 外均在中断上下文调用，不需要的函数置 NULL。
+   例外：DMA 启动失败时该段被丢弃，tx_done 在调用 Serial_Write 的上下文中补发 */
+typedef struct {
+    const char *name;
+    void (*attach)(UartRx_Port_t port, void *ctx);                                   /* 挂到端口时 */
+    void (*detach)(UartRx_Port_t port, void *ctx);                                   /* 被替换时 */
+    void (*rx)(UartRx_Port_t port, void *ctx, const uint8_t *data, uint16_t len);    /* 收到字节段 */
+    void (*tx_done)(UartRx_Port_t port, void *ctx, uint32_t sent);                   /* 一段发送完成，sent 为累计发送字节数 */
+} Serial_Protocol_t;
+
+typedef struct {
+    UartRx_Stats_t rx;
+    uint32_t tx_bytes;     /* 已发送字节数 */
+    uint32_t tx_dropped;   /* 发送缓冲放不下被拒绝的字节数 */
+    uint32_t tx_errors;    /* DMA 发送错误次数 */
+} Serial_Stats_t;
+
+/* 把协议挂到端口（替换原协议），首次挂接时启动该端口的 DMA 收发。
+   proto 为 NULL 表示卸下协议，返回 0 成功 */
+int Serial_Attach(UartRx_Port_t port, const Serial_Protocol_t *proto, void *ctx);
+
+/* 启动端口的 DMA 收发但不改变当前协议（只发送的模块使用），已启动时直接返回 0 */
+int Serial_Open(UartRx_Port_t port);
+
+/* 当前协议名，未挂协议返回 "none" */
+const char *Serial_ProtocolName(UartRx_Port_t port);
+
+/* 设置 RS485 收发控制引脚（高电平发送），gpio 为 NULL 表示不使用 */
+void Serial_SetDE(UartRx_Port_t port, GPIO_TypeDef *gpio, uint16_t pin);
+
+/* 非阻塞写：整段复制进发送缓冲，放不下则整段拒绝。
+   end 可为 NULL，否则返回本段最后一个字节发出时的累计发送字节数（与 tx_done 的 sent 比较）。
+   返回 0 成功，1 缓冲不足或端口无效 */
+int Serial_Write(UartRx_Port_t port, const void *data, uint16_t len, uint32_t *end);
+
+/* 发送缓冲剩余空间 */
+uint16_t Serial_TxFree(UartRx_Port_t port);
+
+/* 端口累计发送字节数（与 tx_done 的 sent 相同，用于补查写入后已经发完的数据） */
+uint32_t Serial_TxSent(UartRx_Port_t port);
+
+void Serial_GetStats(UartRx_Port_t port, Serial_Stats_t *stats);
+
+/* 由 HAL 回调转发（usart.c） */
+void Serial_TxCpltCallback(UART_HandleTypeDef *huart);
+void Serial_TxErrorCallback(UART_HandleTypeDef *huart);
+
+/* 由发送 DMA 流中断服务函数调用（stm32f4xx_it.c） */
+void Serial_TxDMAIRQHandler(UartRx_Port_t port);
+
+#endif /* __SERIAL_H__ */
@@ -5,12 +5,36 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-extern double Temperature;
-extern double Humidity;
+extern float Temperature;
+extern float Humidity;
 
 #define SHT30_I2C_ADDR   (0x44 << 1)   // 7bit地址0x44 -> HAL使用8位地址
 #define SHT30_I2C_HANDLE hi2c1         // 使用 I2C1
 
+/* 高重复性单次测量的转换时间 (ms)，数据手册最大 15ms，保守取 20ms */
+#define SHT30_SINGLESHOT_MS  20
+
+/* 周期模式下尚无新数据（读地址被 NACK） */
+#define SHT30_NO_DATA        5
+
+/* 周期测量频率 (measurements per second) */
+typedef enum {
+    SHT30_MPS_0_5 = 0,
+    SHT30_MPS_1,
+    SHT30_MPS_2,
+    SHT30_MPS_4,
+    SHT30_MPS_10
+} SHT30_Mps_t;
+
+/* 时间戳样本（tick 为读取时刻，单位 ms） */
+typedef struct {
+    uint32_t tick;
+    float    temp;
+    float    hum;
+} SHT30_Sample_t;
+
+#define SHT30_STREAM_LEN     64   /* 样本环形缓冲长度（实际可存 LEN-1 个） */
+
 /* 保留原接口：在周期模式下写入测量模式命令 */
 char SHT31_Write_mode(uint16_t dat);
 
@@ -20,6 +44,28 @@ char SHT30_Read(uint16_t dat);
 /* 更友好的单次测量接口（高重复性），通过指针返回 float 值 */
 char SHT30_Read_SingleShot(float *temp, float *hum);
 
+/* 拆分的单次测量：先 Start 触发转换，等待 SHT30_SINGLESHOT_MS 后 Fetch 读取，
+   两次调用之间不占用 CPU，可与其它传感器的转换重叠 */
+char SHT30_Start_SingleShot(void);
+char SHT30_Fetch_SingleShot(float *temp, float *hum);
+
+/* 周期测量模式：传感器按 mps 自行测量，SHT30_FetchPeriodic 用 0xE000 取最新结果，
+   不需要等待；无新数据时返回 SHT30_NO_DATA。周期模式下不接受单次测量命令，需先 Stop */
+char SHT30_StartPeriodic(SHT30_Mps_t mps);
+char SHT30_StopPeriodic(void);
+char SHT30_FetchPeriodic(float *temp, float *hum);
+uint32_t SHT30_PeriodicIntervalMs(SHT30_Mps_t mps);
+
+/* 样本流：每次成功读取都附带时间戳写入环形缓冲，供高频湿度记录使用。
+   唯一的消费者是 GetDataTask 的 sht30_collect（快照与 SensorBus 发布即来自该流）；
+   StreamRead 取出最多 max 个样本（单一消费者），返回实际个数；
+   StreamDropped 返回因缓冲满而丢弃的样本数 */
+uint16_t SHT30_StreamRead(SHT30_Sample_t *buf, uint16_t max);
+uint32_t SHT30_StreamDropped(void);
+
+/* CRC8（多项式 0x31，初值 0xFF，查表），参数区（config.c）的校验也用它 */
+uint8_t SHT30_Crc8(const uint8_t *data, uint16_t len);
+
 /* 检测函数：简单发送命令判断 I2C 总线应答，返回 true 表示设备可通信 */
 bool SHT30_Check(void);
 
@@ -0,0 +1,32 @@
+/**
+ * @file    sigcond.h
+ * @brief   传感器信号调理：滑动中值 + 二阶节级联低通（CMSIS-DSP biquad DF1）
+ */
+#ifndef __SIGCOND_H__
+#define __SIGCOND_H__
+
+#include <stdint.h>
+#include "snapshot.h"
+
+#define SIGCOND_STAGES      2U   /* 级联二阶节数（4 阶低通） */
+#define SIGCOND_MEDIAN_LEN  5U   /* 滑动中值窗口（奇数） */
+
+/* 各通道按默认参数初始化：fs = 1Hz（与默认采样周期一致），fc = fs/5，启用中值 */
+void SigCond_Init(void);
+
+/* 配置单个通道的采样率与截止频率 (Hz)，fc 需小于 fs/2；median = 0 时跳过滑动中值
+   （驱动已做过中值滤波的通道，如 HC-SR04 距离）。会复位该通道的状态，
+   与 SigCond_Process 在同一任务中调用 */
+void SigCond_Config(snap_field_t ch, float fs_hz, float fc_hz, uint8_t median);
+
+/* 处理一个样本：先滑动中值去除尖峰（若启用），再低通。复位后的首个样本用于预置稳态，避免启动瞬态 */
+float SigCond_Process(snap_field_t ch, float x);
+
+/* 复位通道状态 */
+void SigCond_Reset(snap_field_t ch);
+
+/* 一致性自检：同一输入分别经 arm_biquad_cascade_df1_f32 与本文件的标量参考实现，
+   要求输出逐位一致。返回 0 = PASS，1 = FAIL */
+uint8_t SigCond_Test(void);
+
+#endif /* __SIGCOND_H__ */
@@ -0,0 +1,75 @@
+/**
+ * @file    snapshot.h
+ * @brief   传感器数据快照（带时间戳与状态，seqlock 无锁发布，保留历史）
+ */
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* 快照中的字段 */
+typedef enum {
+    SNAP_T1 = 0,   /* 温度 from bmp280 (℃) */
+    SNAP_T2,       /* 温度 from sht30 (℃) */
+    SNAP_H,        /* 湿度 (%RH) */
+    SNAP_L,        /* 光照 (lux) */
+    SNAP_P,        /* 气压 (Pa) */
+    SNAP_A,        /* 海拔 (m) */
+    SNAP_D,        /* 距离 (cm) */
+    SNAP_FIELD_NUM
+} snap_field_t;
+
+/* 字段状态 */
+typedef enum {
+    SNAP_ST_NONE = 0,  /* 尚未采到数据 */
+    SNAP_ST_OK,        /* 最近一次采集成功 */
+    SNAP_ST_ERROR      /* 最近一次采集失败，value/tick 为上一次成功的数据 */
+} snap_status_t;
+
+typedef struct {
+    float    value;
+    uint32_t tick;     /* 采集时刻 (ms) */
+    uint8_t  status;   /* snap_status_t */
+} snap_value_t;
+
+typedef struct {
+    volatile uint32_t seq;   /* 槽位序号：奇数表示正在写入 */
+    uint32_t version;        /* 发布计数，每次发布 +1 */
+    uint32_t tick;           /* 发布时刻 (ms) */
+    snap_value_t f[SNAP_FIELD_NUM];
+} SensorSnapshot_t;
+
+#define SNAP_HISTORY_LEN  8U   /* 历史环长度（含最新一份） */
+
+/*
+ * 发布（仅采集任务调用）：把 src 复制到历史环的下一个槽位后再切换为最新。
+ * 写入的槽位不是当前最新槽位，读最新快照的读者不会与写者冲突。
+ */
+void Snapshot_Publish(const SensorSnapshot_t *src);
+
+/*
+ * 零拷贝读取（任意任务或中断）：
+ *   uint32_t seq;
+ *   const SensorSnapshot_t *s;
+ *   do {
+ *       s = Snapshot_Begin(0, &seq);
+ *       ... 直接读取 s->f[...] ...
+ *   } while (Snapshot_Retry(s, seq));
+ * back = 0 为最新，1 为上一份，依此类推（< SNAP_HISTORY_LEN）。
+ * 槽位正在被覆盖或尚未发布过时返回 NULL（此时 Retry 返回 false）。
+ * 读取窗口内不要做耗时操作（如刷屏），先取到局部变量。
+ */
+const SensorSnapshot_t *Snapshot_Begin(uint8_t back, uint32_t *seq);
+bool Snapshot_Retry(const SensorSnapshot_t *s, uint32_t seq);
+
+/* 复制读取，返回 true 表示 out 有效 */
+bool Snapshot_Read(uint8_t back, SensorSnapshot_t *out);
+
+/* 读取单个字段的最新值，返回字段状态 */
+snap_status_t Snapshot_Get(snap_field_t field, float *value);
+
+/* 当前发布计数 */
+uint32_t Snapshot_Version(void);
+
+#endif /* __SNAPSHOT_H__ */
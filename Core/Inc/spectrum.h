@@ -0,0 +1,55 @@
+/**
+ * @file    spectrum.h
+ * @brief   ADC 流频谱分析（CMSIS-DSP arm_rfft_fast_f32，Hann 窗，平均幅度谱）
+ */
+#ifndef __SPECTRUM_H__
+#define __SPECTRUM_H__
+
+#include <stdint.h>
+
+#define SPECTRUM_MIN_N        256U
+#define SPECTRUM_MAX_N        4096U
+#define SPECTRUM_SIZE_NUM     5U      /* 256, 512, 1024, 2048, 4096 */
+#define SPECTRUM_BANDS        4U      /* 频带能量个数 */
+#define SPECTRUM_BARS         64U     /* 柱状图柱数 */
+
+#define SPECTRUM_DEFAULT_N    1024U
+#define SPECTRUM_DEFAULT_AVG  4U
+
+/* 一次平均后的分析结果 */
+typedef struct {
+    uint32_t seq;                        /* 结果序号 */
+    uint16_t n;                          /* FFT 点数 */
+    uint8_t  channel;                    /* ADC 流通道（0 = IN5, 1 = IN7） */
+    float    fs_hz;                      /* 采样率 */
+    float    peak_hz;                    /* 峰值频率（抛物线插值） */
+    float    peak_amp;                   /* 峰值幅度 (V) */
+    float    band_energy[SPECTRUM_BANDS];/* 各频带能量 (V^2) */
+    uint8_t  bars[SPECTRUM_BARS];        /* 柱高 0~255（对数刻度，相对 60dB 动态范围） */
+} Spectrum_Result_t;
+
+/* 配置分析通道、点数（256~4096 的 2 的幂）与平均帧数，下一帧生效 */
+void Spectrum_Configure(uint8_t channel, uint16_t n, uint8_t navg);
+
+/* 设置频带 [lo_hz, hi_hz)，band < SPECTRUM_BANDS */
+void Spectrum_SetBand(uint8_t band, float lo_hz, float hi_hz);
+
+/* 复制最新结果，返回结果序号（0 = 尚无结果） */
+uint32_t Spectrum_GetResult(Spectrum_Result_t *res);
+
+/* 在 LCD 指定区域绘制最新结果的柱状图 */
+void Spectrum_Draw(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+/* 基准测试：各点数下每块（加窗 + RFFT + 求幅度）的 CPU 周期，
+   同时用合成正弦验证峰值落在正确的频点。返回 0 = PASS，1 = FAIL。
+   使用分析引擎的 CCMRAM 缓冲，需在 SpectrumTask 启动前或暂停时调用；
+   SpectrumTask 启动时（订阅 ADC 流之前）运行一次并经 DLOG 输出结果 */
+typedef struct {
+    uint16_t n[SPECTRUM_SIZE_NUM];
+    uint32_t cycles[SPECTRUM_SIZE_NUM];
+} Spectrum_Bench_t;
+uint8_t Spectrum_Bench(Spectrum_Bench_t *bench);
+
+void SpectrumTask(void *argument);
+
+#endif /* __SPECTRUM_H__ */
@@ -71,6 +71,16 @@ void DMA2_Stream3_IRQHandler(void);
 void USART6_IRQHandler(void);
 void DCMI_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void TIM2_IRQHandler(void);
+void EXTI9_5_IRQHandler(void);
+void DMA1_Stream1_IRQHandler(void);
+void DMA1_Stream5_IRQHandler(void);
+void DMA1_Stream6_IRQHandler(void);
+void DMA1_Stream3_IRQHandler(void);
+void DMA2_Stream6_IRQHandler(void);
+void DMA2_Stream7_IRQHandler(void);
+void DMA2_Stream2_IRQHandler(void);
+void DMA2_Stream5_IRQHandler(void);
 
 /* USER CODE END EFP */
 
@@ -0,0 +1,50 @@
+/**
+ * @file    telemetry.h
+ * @brief   二进制遥测任务（订阅 SensorBus，批量打包，硬件 CRC32，COBS 分帧经串口发出）
+ */
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include "uartrx.h"
+#include <stdint.h>
+
+/*
+ * 帧格式与解码见 tlmcodec.h，上位机用 tlmcodec.c 解码。
+ * 每次快照发布产生一个样本，只携带有新数据的字段；样本攒满一帧
+ * 或距第一个样本超过 TELEMETRY_FLUSH_MS 时发出。
+ * 输出端口可切换到蓝牙模块所在串口，帧与挂在该端口上的协议共用发送缓冲；
+ * 该端口上有控制台会话时（Console_Active）帧被丢弃并计入 muted。
+ */
+
+#define TELEMETRY_DEFAULT_PORT   UARTRX_PORT1
+#define TELEMETRY_FLUSH_MS       200U    /* 最长攒批时间 */
+
+typedef struct {
+    uint32_t samples;      /* 已打包样本数 */
+    uint32_t frames;       /* 已发出帧数 */
+    uint32_t bytes;        /* 已发出字节数（COBS 编码后） */
+    uint32_t dropped;      /* 发送缓冲不足丢弃的帧数 */
+    uint32_t muted;        /* 控制台会话期间未发送的帧数 */
+} Telemetry_Stats_t;
+
+/* 切换输出端口，下一帧生效 */
+void Telemetry_SetPort(UartRx_Port_t port);
+
+void Telemetry_GetStats(Telemetry_Stats_t *stats);
+
+/* 自测 + 基准：按默认采集节拍（三个环境传感器 1s、测距 100ms）合成 10s 数据，
+   用硬件 CRC 编码后再用 tlmcodec 解码器（软件 CRC）回环校验，
+   并与逐行 sprintf 文本比较字节数。返回 0 = PASS，1 = FAIL。
+   TelemetryTask 启动时运行一次并经 DLOG 输出；上位机回环测试见 Tools/tlmloop */
+typedef struct {
+    uint32_t samples;        /* 样本数 */
+    uint32_t bin_bytes;      /* 二进制帧总字节数（含头、CRC、COBS 与分隔符） */
+    uint32_t text_bytes;     /* 同样数据逐行文本的字节数 */
+    uint32_t encode_cycles;  /* 二进制编码总周期 */
+    uint32_t text_cycles;    /* 文本格式化总周期 */
+} Telemetry_Bench_t;
+uint8_t Telemetry_Test(Telemetry_Bench_t *bench);
+
+void TelemetryTask(void *argument);
+
+#endif /* __TELEMETRY_H__ */
@@ -0,0 +1,135 @@
+/**
+ * @file    tlmcodec.h
+ * @brief   二进制遥测编解码（COBS 分帧 + CRC32，按 schema 版本的批量记录）
+ *
+ * 本模块不依赖 HAL/RTOS，目标板（telemetry.c）与上位机解码工具共用同一份源码，
+ * 上位机直接 gcc 编译 tlmcodec.c 即可。
+ */
+#ifndef __TLMCODEC_H__
+#define __TLMCODEC_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "snapshot.h"
+
+/*
+ * 帧格式（COBS 编码前，多字节字段小端）：
+ *   [0]      type    记录类型 TLM_REC_BATCH
+ *   [1]      schema  TLM_SCHEMA_VERSION，字段表变化时递增
+ *   [2..3]   seq     帧序号，用于发现丢帧
+ *   [4..7]   tick    第一个样本的时刻 (ms)
+ *   [8]      count   样本数
+ *   样本 * count：
+ *     dt     varint，与上一样本的时刻差 (ms)，第一个样本为 0
+ *     mask   bit0..6 = 本样本携带的字段，bit7 = 后跟错误掩码
+ *     [err]  bit n = 字段 n 最近一次采集失败
+ *     值     按字段顺序，仅 mask 中的字段，定点小端（见 tlm_field 表）
+ *   [n..n+3] CRC32   对前面所有字节计算，见 Tlm_Crc32
+ * 整帧经 COBS 编码后以 0x00 结尾，接收端以 0x00 分帧，丢字节后在下一帧自动同步。
+ */
+
+#define TLM_SCHEMA_VERSION   1U
+#define TLM_REC_BATCH        1U
+#define TLM_REC_LOG          2U      /* 延迟格式化日志（dlog.h），同一串口上与遥测帧混合 */
+/* 0x20~0x2F 为蓝牙批量下载帧（btxfer.h） */
+
+/*
+ * 日志帧（TLM_REC_LOG，由 dlog.c 产生，上位机 Tools/dlogdump 解析）：
+ *   [0] type  [1] TLM_LOG_VERSION  [2..3] seq  [4..7] 目标板累计丢弃的记录数
+ *   记录 * n，每条为若干小端 32 位字：
+ *     字 0  bit31 提交位 | bit30..28 级别 | bit27..24 参数个数 | bit15..0 格式串 ID
+ *     字 1  时刻 (ms)
+ *     参数
+ *   [n..n+3] CRC32
+ */
+#define TLM_LOG_VERSION      1U
+#define TLM_LOG_HDR_LEN      8U
+
+#define TLM_HDR_LEN          9U
+#define TLM_CRC_LEN          4U
+#define TLM_FRAME_MAX        240U    /* COBS 编码前的最大帧长 */
+#define TLM_COBS_MAX         (TLM_FRAME_MAX + TLM_FRAME_MAX / 254U + 2U)   /* 编码后最大长度（含结尾 0） */
+#define TLM_SAMPLE_MAX       (5U + 2U + 16U)   /* 单个样本最大编码长度 */
+
+#define TLM_MASK_ERR         0x80U
+
+typedef struct {
+    uint32_t tick;                   /* 采样时刻 (ms) */
+    uint8_t  valid;                  /* bit n = value[n] 有效 */
+    uint8_t  error;                  /* bit n = 字段 n 采集失败 */
+    float    value[SNAP_FIELD_NUM];
+} Tlm_Sample_t;
+
+/* 正在组装的一帧，buf 四字节对齐以便直接交给硬件 CRC */
+typedef struct {
+    uint8_t  buf[TLM_FRAME_MAX] __attribute__((aligned(4)));
+    uint16_t len;
+    uint8_t  count;
+    uint32_t last_tick;
+} Tlm_Batch_t;
+
+/* CRC 函数：data 四字节对齐，len 为 4 的倍数（不足部分已补 0） */
+typedef uint32_t (*tlm_crc_fn)(const uint8_t *data, uint32_t len);
+
+/* 软件 CRC32，与 STM32 CRC 外设一致：多项式 0x04C11DB7、初值 0xFFFFFFFF、
+   按小端 32 位字输入、高位先行、无反转无异或，末尾不足 4 字节按 0 补齐 */
+uint32_t Tlm_Crc32(const uint8_t *data, uint32_t len);
+
+/* COBS 编码，out 至少 len + len / 254 + 1 字节（不含结尾 0），返回编码长度 */
+uint16_t Tlm_CobsEncode(const uint8_t *in, uint16_t len, uint8_t *out);
+
+/* COBS 解码（输入不含结尾 0），返回解码长度，格式错误或 out 不足返回 -1 */
+int Tlm_CobsDecode(const uint8_t *in, uint16_t len, uint8_t *out, uint16_t out_size);
+
+/* 开始一帧 */
+void Tlm_BatchBegin(Tlm_Batch_t *b, uint16_t seq, uint32_t tick);
+
+/* 追加样本，帧内放不下返回 false（应先结束本帧） */
+bool Tlm_BatchAdd(Tlm_Batch_t *b, const Tlm_Sample_t *s);
+
+/* 结束本帧：补 CRC（crc 为 NULL 时用 Tlm_Crc32）并 COBS 编码到 out（含结尾 0），
+   返回输出长度，out_size 不足返回 0 */
+uint16_t Tlm_BatchFinish(Tlm_Batch_t *b, tlm_crc_fn crc, uint8_t *out, uint16_t out_size);
+
+/* 通用分帧：buf[0..len) 为以类型字节开头的帧内容，buf 四字节对齐且至少 len + 4 字节，
+   补 CRC 后 COBS 编码到 out（含结尾 0），返回输出长度，出错返回 0 */
+uint16_t Tlm_FrameEncode(uint8_t *buf, uint16_t len, tlm_crc_fn crc, uint8_t *out, uint16_t out_size);
+
+/* ---- 流式解码 ---- */
+
+typedef struct {
+    uint32_t frames;       /* 通过校验的帧数 */
+    uint32_t samples;      /* 解出的样本数 */
+    uint32_t lost;         /* 按帧序号推算的丢帧数 */
+    uint32_t crc_err;      /* CRC 错误 */
+    uint32_t cobs_err;     /* COBS 格式错误或超长 */
+    uint32_t schema_err;   /* 未知类型/版本或记录截断 */
+} Tlm_DecStats_t;
+
+/* 每解出一个样本回调一次 */
+typedef void (*tlm_sample_cb)(const Tlm_Sample_t *s, void *ctx);
+
+/* 其他类型的帧（已通过 CRC 校验，不含 CRC） */
+typedef void (*tlm_frame_cb)(const uint8_t *frame, uint16_t len, void *ctx);
+
+typedef struct {
+    uint8_t  raw[TLM_COBS_MAX];
+    uint8_t  frame[TLM_FRAME_MAX];
+    uint16_t len;
+    uint8_t  overflow;      /* 当前帧超长，丢弃到下一个 0 */
+    uint8_t  has_seq;
+    uint16_t next_seq;
+    tlm_frame_cb frame_cb;
+    void *frame_ctx;
+    Tlm_DecStats_t stats;
+} Tlm_Decoder_t;
+
+void Tlm_DecoderInit(Tlm_Decoder_t *d);
+
+/* 设置其他类型帧的处理函数，未设置时这些帧计入 schema_err */
+void Tlm_DecoderOnFrame(Tlm_Decoder_t *d, tlm_frame_cb cb, void *ctx);
+
+/* 送入任意长度的字节流 */
+void Tlm_DecoderFeed(Tlm_Decoder_t *d, const uint8_t *data, uint32_t len, tlm_sample_cb cb, void *ctx);
+
+#endif /* __TLMCODEC_H__ */
@@ -0,0 +1,68 @@
+/**
+ * @file    uartrx.h
+ * @brief   UART DMA 循环接收引擎（ReceiveToIdle + 半满/全满事件，按段交付）
+ */
+#ifndef __UARTRX_H__
+#define __UARTRX_H__
+
+#include "stm32f4xx_hal.h"
+#include <stdint.h>
+
+/*
+ * 每个端口一块循环 DMA 缓冲，由 HAL_UARTEx_ReceiveToIdle_DMA 启动。
+ * 线路空闲 (IDLE)、半满 (HT)、全满 (TC) 三种事件都会把上次位置到当前位置之间
+ * 的新数据作为连续字节段交给端口的处理函数（跨越缓冲末尾时分两段交付），
+ * 不再逐字节进入中断。
+ * 处理函数在中断上下文执行（优先级 6，可调用 FreeRTOS FromISR 接口）。
+ *
+ * DMA 映射（避开已用的 DMA2 Stream0/1/3 与 DMA1 Stream2/7）：
+ *   USART1_RX  DMA2 Stream5 Ch4
+ *   USART2_RX  DMA1 Stream5 Ch4
+ *   USART3_RX  DMA1 Stream1 Ch4
+ *   USART6_RX  DMA2 Stream2 Ch5
+ */
+
+typedef enum {
+    UARTRX_PORT1 = 0,
+    UARTRX_PORT2,
+    UARTRX_PORT3,
+    UARTRX_PORT6,
+    UARTRX_PORT_NUM
+} UartRx_Port_t;
+
+#define UARTRX_BUF_SIZE   256U   /* 每端口循环缓冲大小（字节，偶数） */
+
+/* 字节段处理函数（中断上下文），data 仅在回调期间有效 */
+typedef void (*uartrx_cb_t)(const uint8_t *data, uint16_t len, void *ctx);
+
+typedef struct {
+    uint32_t bytes;        /* 已交付字节数 */
+    uint32_t idle;         /* IDLE 事件数 */
+    uint32_t half;         /* 半满事件数 */
+    uint32_t full;         /* 全满事件数 */
+    uint32_t overruns;     /* 数据丢失：DMA 套圈（漏掉一次 HT/TC）或 UART ORE */
+    uint32_t errors;       /* 帧错误/噪声/校验错误（接收会自动重启） */
+} UartRx_Stats_t;
+
+/* 启动端口接收并设置处理函数，返回 0 成功 */
+int UartRx_Start(UartRx_Port_t port, uartrx_cb_t cb, void *ctx);
+
+/* 停止端口接收 */
+void UartRx_Stop(UartRx_Port_t port);
+
+/* 运行时更换处理函数 */
+void UartRx_SetHandler(UartRx_Port_t port, uartrx_cb_t cb, void *ctx);
+
+void UartRx_GetStats(UartRx_Port_t port, UartRx_Stats_t *stats);
+
+/* 由 UART 句柄取端口号（查表，O(1)），不是本引擎管理的 UART 返回 -1 */
+int UartRx_PortOf(UART_HandleTypeDef *huart);
+
+/* 由 HAL 回调转发（usart.c） */
+void UartRx_EventCallback(UART_HandleTypeDef *huart, uint16_t pos);
+void UartRx_ErrorCallback(UART_HandleTypeDef *huart);
+
+/* 由 DMA 流中断服务函数调用（stm32f4xx_it.c） */
+void UartRx_DMAIRQHandler(UartRx_Port_t port);
+
+#endif /* __UARTRX_H__ */
@@ -30,7 +30,6 @@ extern "C" {
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
-extern uint8_t device_on_uart2; // 0: 无设备, 1: RS485, 2: Bluetooth, 3: ZigBee
 
 /* USER CODE END Includes */
 
@@ -0,0 +1,82 @@
+/**
+ * @file    zbframe.h
+ * @brief   ZigBee 透传帧封包与流式解包（FE LEN 转义区 FF）
+ *
+ * 不依赖 HAL/RTOS，zigbee.c（中断中逐段喂入）与上位机 Tools/zbbench 共用同一份源码。
+ */
+#ifndef __ZBFRAME_H__
+#define __ZBFRAME_H__
+
+#include <stdint.h>
+
+/*
+ * 帧格式：FE | LEN | src dst addrL addrH data... | FF
+ *   LEN = 数据长度 + 4，不转义；其后直到包尾的字节中 FF -> FE FD，FE -> FE FC，
+ *   因此 FF 只会出现在包尾。
+ */
+#define ZBFRAME_MAX_LEN       128U     /* 整帧（转义后）最大字节数 */
+
+/**
+ * @brief ZigBee 模块操作状态枚举
+ */
+typedef enum {
+    DL_OK = 0,      // 操作成功
+    DL_ERROR,       // 通用错误
+    DL_TIMEOUT,     // 超时
+    DL_INVALID,     // 参数无效
+    DL_BUSY         // 忙碌
+} DL_Status_t;
+
+/**
+ * @brief ZigBee 数据包结构体 (解包后的应用层数据)
+ */
+typedef struct {
+    uint16_t addr;      // 远程地址 (0x0000: 本模块, 0xFFFF: 广播)
+    uint8_t  src;       // 源端口号
+    uint8_t  dst;       // 目的端口号
+    uint8_t  data[128]; // 数据载荷
+    uint16_t data_len;  // 数据长度
+} DL_Packet_t;
+
+#define ZBFRAME_MAX_PAYLOAD   sizeof(((DL_Packet_t *)0)->data)
+
+/**
+ * @brief ZigBee 接收统计
+ */
+typedef struct {
+    uint32_t bytes;       // 收到的字节数
+    uint32_t frames;      // 成功交付的数据包数
+    uint32_t len_err;     // 长度字段非法或与实际解码长度不符
+    uint32_t esc_err;     // 非法转义序列
+    uint32_t overflow;    // 解码数据超过声明长度
+    uint32_t no_slot;     // 数据包池耗尽而丢弃的帧
+    uint32_t queue_full;  // 队列满而丢弃的帧
+} ZigBee_RxStats_t;
+
+/*
+ * 流式解析：字节到达即去转义，解码结果直接写入 alloc 取得的 DL_Packet_t，
+ * 包尾校验通过后由 post 交付，全程不复制整帧。
+ * 一帧出错只丢弃该帧，数据包槽位保留给下一帧使用。
+ */
+typedef struct {
+    uint8_t  state;
+    uint8_t  declared;                    /* 声明长度（数据长度 + 4） */
+    uint16_t n;                           /* 已解码字节数 */
+    DL_Packet_t *pkt;                     /* 当前写入的槽位 */
+    DL_Packet_t *(*alloc)(void);          /* 取一个空槽位，无可用返回 NULL */
+    int (*post)(DL_Packet_t *pkt);        /* 交付完整的包，返回 0 表示已交付（槽位归接收方） */
+    ZigBee_RxStats_t stats;
+} ZbFrame_Parser_t;
+
+/* 复位到等待包头（保留统计与当前槽位） */
+void ZbFrame_Reset(ZbFrame_Parser_t *p);
+
+/* 喂入一段字节，可在任意位置切分 */
+void ZbFrame_Feed(ZbFrame_Parser_t *p, const uint8_t *data, uint16_t len);
+
+/* 封包到 buf（至少 ZBFRAME_MAX_LEN 字节），转义后超长返回 DL_ERROR */
+DL_Status_t ZbFrame_Encode(uint8_t *buf, uint8_t src, uint8_t dst, uint16_t addr,
+                           const uint8_t *payload, uint16_t payload_len,
+                           uint16_t *frame_len);
+
+#endif /* __ZBFRAME_H__ */
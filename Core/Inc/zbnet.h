@@ -0,0 +1,91 @@
+/**
+ * @file    zbnet.h
+ * @brief   ZigBee 协调器：按 16 位远程地址维护节点表（开放寻址哈希，O(1) 更新）
+ */
+#ifndef __ZBNET_H__
+#define __ZBNET_H__
+
+#include <stdint.h>
+#include "zigbee.h"
+#include "zbpack.h"
+
+/*
+ * 每收到一个数据包，按 pkt->addr 查找（不存在则插入）节点，用该节点自己的
+ * zbpack 解码器解出载荷中的样本，更新最近读数、链路统计与帧序号。
+ * 节点只增不删（ZbNet_Reset 清空），槽位数为节点上限的 2 倍，装载率不超过 0.5，
+ * 线性探测平均 1~2 次即可命中。
+ *
+ * 内存：每个节点 116 字节（ZbPack_Dec_t 64 字节 + 8 通道读数 32 字节 + 其余 20 字节），
+ * 每个哈希槽 2 字节，共 ZBNET_MAX_NODES * (116 + 4) 字节静态 SRAM：
+ * 默认 64 个节点约 7.5KB；256 个约 30KB，会挤占 60KB 的 FreeRTOS 堆与其他缓冲，
+ * CCMRAM 也已基本被频谱缓冲占满，需要更多节点时在编译选项中定义 ZBNET_MAX_NODES。
+ *
+ * 端口：ZigBee 模块与蓝牙模块共用 USART2，硬件上二选一。ZBNET_ENABLE 为 1 时
+ * 启动 ZbNetTask 挂到 ZigBee_DEFAULT_PORT，且不启动 BtXferTask；默认为 0（蓝牙）。
+ */
+
+#ifndef ZBNET_MAX_NODES
+#define ZBNET_MAX_NODES     64U     /* 节点上限（2 的幂） */
+#endif
+
+#ifndef ZBNET_ENABLE
+#define ZBNET_ENABLE        0
+#endif
+#define ZBNET_SLOTS         (2U * ZBNET_MAX_NODES)   /* 哈希槽数（须为 2 的幂） */
+
+typedef struct {
+    uint16_t addr;                   /* 远程地址 */
+    uint8_t  src;                    /* 最近一包的源端口 */
+    uint8_t  mask;                   /* 收到过的通道 */
+    uint32_t first_rx;               /* 首次收到的本机时刻 (ms) */
+    uint32_t last_rx;                /* 最近收到的本机时刻 (ms) */
+    uint32_t packets;                /* 收到的数据包数 */
+    uint32_t sample_tick;            /* 最近样本的节点时刻 (ms) */
+    int32_t  value[ZBPACK_MAX_CH];   /* 各通道最近读数（定点整数） */
+    ZbPack_Dec_t dec;                /* 差分状态、帧序号与链路统计 */
+} ZbNet_Node_t;
+
+typedef struct {
+    uint16_t nodes;        /* 节点数 */
+    uint32_t packets;      /* 收到的数据包数 */
+    uint32_t samples;      /* 解出的样本数 */
+    uint32_t lost;         /* 各节点丢帧数之和 */
+    uint32_t errors;       /* 载荷格式错误 */
+    uint32_t table_full;   /* 节点表满被丢弃的包 */
+} ZbNet_Stats_t;
+
+/* 清空节点表 */
+void ZbNet_Reset(void);
+
+/* 处理一个数据包（协调器任务调用），返回 0 成功，1 节点表满或载荷错误 */
+int ZbNet_Input(const DL_Packet_t *pkt, uint32_t now);
+
+/* 复制节点，返回 true 表示存在 */
+bool ZbNet_Find(uint16_t addr, ZbNet_Node_t *out);
+
+/* 按插入顺序复制第 index 个节点（遍历用），越界返回 false */
+bool ZbNet_Get(uint16_t index, ZbNet_Node_t *out);
+
+void ZbNet_GetStats(ZbNet_Stats_t *stats);
+
+/* 一个节点格式化为一行文本（控制台视图），返回长度 */
+int ZbNet_FormatNode(const ZbNet_Node_t *n, uint32_t now, char *out, uint16_t size);
+
+/* 在 LCD 指定区域绘制网络概况与节点列表（16 点阵，每次调用翻一页），没有节点时不绘制 */
+void ZbNet_Draw(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+/*
+ * 批量导出网络状态（二进制，小端），可分多次调用：
+ *   每个节点 ZBNET_EXPORT_HDR 字节：addr u16, mask u8, lost u8（饱和）, age_ms u32,
+ *   packets u32, samples u32，随后 mask 中每个通道一个 int32 读数。
+ * cursor 为下一个要导出的节点序号（首次传 0），只导出完整的节点记录。
+ * 返回写入字节数，0 表示已导出完或 size 放不下一个节点
+ */
+#define ZBNET_EXPORT_HDR    16U
+uint16_t ZbNet_Export(uint8_t *out, uint16_t size, uint16_t *cursor, uint32_t now);
+
+/* 协调器任务：挂接 ZigBee 协议并把收到的数据包送入节点表。
+   argument 指向 UartRx_Port_t 指定端口，NULL 时用 ZigBee_DEFAULT_PORT */
+void ZbNetTask(void *argument);
+
+#endif /* __ZBNET_H__ */
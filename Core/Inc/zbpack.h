@@ -0,0 +1,97 @@
+/**
+ * @file    zbpack.h
+ * @brief   ZigBee 遥测载荷编解码（zigzag varint + 按通道差分，一帧多个带时间戳的样本）
+ *
+ * 不依赖 HAL/RTOS，终端节点与协调器（或上位机）共用同一份源码。
+ */
+#ifndef __ZBPACK_H__
+#define __ZBPACK_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * 载荷格式（一个 DL_Packet_t 的 data 中可以首尾相接多帧，ZigBee_Submit 合并时即如此）：
+ *   [0]  版本 (高 4 位) | 标志 (低 4 位，bit0 = 关键帧)
+ *   [1]  帧序号
+ *   [2]  样本数
+ *   样本 * n：
+ *     dt    varint，与上一样本的时刻差 (ms)；关键帧第一个样本为绝对时刻，
+ *           差分帧第一个样本相对上一帧最后一个样本
+ *     mask  本样本携带的通道
+ *     值    每个通道一个 zigzag varint，为与该通道上一个值之差（跨帧延续），
+ *           关键帧中上一个值视为 0，即绝对值
+ * 差分帧依赖上一帧，接收端发现丢帧后丢弃差分帧直到下一个关键帧。
+ * 发送端每 key_interval 帧插入一个关键帧，发送失败时可用 ZbPack_ForceKey 立即恢复。
+ */
+
+#define ZBPACK_VERSION       1U
+#define ZBPACK_MAX_CH        8U
+#define ZBPACK_HDR_LEN       3U
+#define ZBPACK_FLAG_KEY      0x01U
+#define ZBPACK_SAMPLE_MAX    (5U + 1U + ZBPACK_MAX_CH * 5U)   /* 单个样本最大编码长度 */
+
+typedef struct {
+    uint32_t tick;                /* 采样时刻 (ms) */
+    uint8_t  mask;                /* bit n = v[n] 有效 */
+    int32_t  v[ZBPACK_MAX_CH];    /* 定点整数值，比例由应用约定 */
+} ZbPack_Sample_t;
+
+/* 编码器：每个发送目标一个 */
+typedef struct {
+    uint8_t *buf;
+    uint16_t size;
+    uint16_t len;
+    uint8_t  count;
+    uint8_t  seq;
+    uint8_t  key_interval;         /* 关键帧间隔（帧），0 = 只在首帧与强制时 */
+    uint8_t  since_key;
+    uint8_t  force_key;
+    uint32_t last_tick;            /* 已提交状态 */
+    int32_t  prev[ZBPACK_MAX_CH];
+    uint32_t w_tick;               /* 本帧工作状态 */
+    int32_t  w_prev[ZBPACK_MAX_CH];
+} ZbPack_Enc_t;
+
+void ZbPack_EncInit(ZbPack_Enc_t *e, uint8_t key_interval);
+
+/* 下一帧强制为关键帧（如上一帧发送失败） */
+void ZbPack_ForceKey(ZbPack_Enc_t *e);
+
+/* 开始一帧，编码写入 buf（size 不小于 ZBPACK_HDR_LEN + ZBPACK_SAMPLE_MAX） */
+void ZbPack_Begin(ZbPack_Enc_t *e, uint8_t *buf, uint16_t size);
+
+/* 追加样本，放不下返回 false（本帧不变） */
+bool ZbPack_Add(ZbPack_Enc_t *e, const ZbPack_Sample_t *s);
+
+/* 结束本帧并提交差分状态，返回载荷长度，没有样本返回 0 */
+uint16_t ZbPack_End(ZbPack_Enc_t *e);
+
+/* ---- 解码（协调器侧，每个源节点一个） ---- */
+
+typedef struct {
+    uint32_t frames;     /* 解出的帧数 */
+    uint32_t samples;    /* 解出的样本数 */
+    uint32_t keys;       /* 关键帧数 */
+    uint32_t lost;       /* 按帧序号推算的丢帧数 */
+    uint32_t skipped;    /* 失步期间丢弃的差分帧 */
+    uint32_t errors;     /* 格式错误 */
+} ZbPack_DecStats_t;
+
+typedef void (*zbpack_sample_cb)(const ZbPack_Sample_t *s, void *ctx);
+
+typedef struct {
+    uint32_t last_tick;
+    int32_t  prev[ZBPACK_MAX_CH];
+    uint8_t  next_seq;
+    uint8_t  synced;
+    ZbPack_DecStats_t stats;
+} ZbPack_Dec_t;
+
+void ZbPack_DecInit(ZbPack_Dec_t *d);
+
+/* 解码一个载荷（可含多帧），每个样本回调一次。
+   返回解出的样本数，格式错误返回 -1（此前已回调的样本有效，解码器回到失步状态） */
+int ZbPack_Decode(ZbPack_Dec_t *d, const uint8_t *data, uint16_t len, zbpack_sample_cb cb, void *ctx);
+
+#endif /* __ZBPACK_H__ */
@@ -8,47 +8,75 @@ extern "C" {
 #include <stdint.h>
 #include "stm32f4xx_hal.h"
 #include "usart.h"
+#include "serial.h"
+#include "zbframe.h"   /* DL_Status_t、DL_Packet_t、帧格式与流式解析器 */
 
-/**
- * @brief ZigBee 模块操作状态枚举
- */
-typedef enum {
-    DL_OK = 0,      // 操作成功
-    DL_ERROR,       // 通用错误
-    DL_TIMEOUT,     // 超时
-    DL_INVALID,     // 参数无效
-    DL_BUSY         // 忙碌
-} DL_Status_t;
-
-/* 默认使用的串口句柄，若未定义则使用 huart2 */
+/* 默认使用的串口句柄，若未定义则使用 huart2（模块接在 USART2，与蓝牙模块共用，二选一） */
 #ifndef ZigBee_DEFAULT_UART
 #define ZigBee_DEFAULT_UART      (&huart2)
 #endif
 
+/* 与默认串口对应的端口号（Serial/UartRx） */
+#ifndef ZigBee_DEFAULT_PORT
+#define ZigBee_DEFAULT_PORT      UARTRX_PORT2
+#endif
+
 /* 默认波特率，硬件固定为 115200 */
 #ifndef ZigBee_DEFAULT_BAUDRATE
 #define ZigBee_DEFAULT_BAUDRATE  115200U 
 #endif
 
+/* 接收数据包池大小（同时也是已完成数据包队列深度） */
+#ifndef ZigBee_RX_POOL_LEN
+#define ZigBee_RX_POOL_LEN       8U
+#endif
+
+/* 发送帧缓冲池大小、每帧最多合并的载荷数、单帧最大载荷（预留转义空间） */
+#ifndef ZigBee_TX_POOL_LEN
+#define ZigBee_TX_POOL_LEN       8U
+#endif
+#define ZigBee_TX_MAX_PARTS      4U
+#define ZigBee_TX_PAYLOAD_MAX    118U
+
 /**
- * @brief ZigBee 数据包结构体 (解包后的应用层数据)
+ * @brief 发送通道：告警帧总是先于批量遥测帧发出
+ */
+typedef enum {
+    ZB_LANE_ALARM = 0,
+    ZB_LANE_BULK,
+    ZB_LANE_NUM
+} ZigBee_Lane_t;
+
+/**
+ * @brief 发送完成回调（中断上下文），st 为 DL_OK 或 DL_ERROR
+ */
+typedef void (*zigbee_tx_cb_t)(DL_Status_t st, void *ctx);
+
+/**
+ * @brief ZigBee 发送统计
  */
 typedef struct {
-    uint16_t addr;      // 远程地址 (0x0000: 本模块, 0xFFFF: 广播)
-    uint8_t  src;       // 源端口号
-    uint8_t  dst;       // 目的端口号
-    uint8_t  data[128]; // 数据载荷
-    uint16_t data_len;  // 数据长度
-} DL_Packet_t;
+    uint32_t submitted;   // 提交的载荷数
+    uint32_t frames;      // 发送完成的帧数
+    uint32_t coalesced;   // 合并进已有帧的载荷数
+    uint32_t no_buf;      // 缓冲池耗尽被拒绝的载荷数
+    uint32_t errors;      // 发送失败的帧数
+} ZigBee_TxStats_t;
 
 /* ================= API 函数声明 ================= */
 
 /**
- * @brief 初始化 ZigBee 模块的中断接收
- * @note  需要在 main 初始化阶段调用，启动 UART 接收中断
+ * @brief 初始化 ZigBee 模块的收发
+ * @note  创建接收数据包池并把 ZigBee_Protocol 挂到默认端口
  */
 void ZigBee_InitIT(void);
 
+/**
+ * @brief 同 ZigBee_InitIT，但挂到指定端口（模块接在其他串口时使用）
+ * @return 0 成功，1 接收池创建失败或端口无效
+ */
+int ZigBee_InitPort(UartRx_Port_t port);
+
 /**
  * @brief 构建发送帧 (封包)
  * @param src 源端口
@@ -71,25 +99,49 @@ DL_Status_t ZigBee_BuildFrame(uint8_t src, uint8_t dst, uint16_t addr,
  * @param content_p  内容长度(外部指针)**
  * @param data  需要装填的数据
  * @return DL_Status_t
+ * @note  每个整数占 1 + 百进制位数字节且只接受正数，新代码请用 zbpack.h
  */
 DL_Status_t ZigBee_Load_Data(uint8_t *content, uint8_t content_p, int data);
 
 
 /**
- * @brief 阻塞式发送数据包 (自动封包并发送)
+ * @brief 提交一个载荷到发送队列 (非阻塞，DMA 发送)
+ * @param lane 发送通道 (ZB_LANE_ALARM / ZB_LANE_BULK)
+ * @param src 源端口
+ * @param dst 目的端口
+ * @param addr 远程地址
+ * @param payload 数据载荷（函数返回后即可复用）
+ * @param payload_len 数据长度 (<= ZigBee_TX_PAYLOAD_MAX)
+ * @param cb 发送完成回调，可为 NULL
+ * @param ctx 回调参数
+ * @note  同一通道中尚未发出、目标相同的帧放得下时，载荷会被追加进该帧，
+ *        接收端看到的是多个载荷首尾相接，载荷需自带长度或分隔
+ * @return DL_OK 已入队；DL_BUSY 缓冲池耗尽；DL_ERROR 载荷过长或未初始化
+ */
+DL_Status_t ZigBee_Submit(ZigBee_Lane_t lane, uint8_t src, uint8_t dst, uint16_t addr,
+                          const uint8_t *payload, uint16_t payload_len,
+                          zigbee_tx_cb_t cb, void *ctx);
+
+/**
+ * @brief 发送数据包 (自动封包，批量通道，非阻塞)
  * @param src 源端口
  * @param dst 目的端口
  * @param addr 远程地址
  * @param payload 数据载荷
  * @param payload_len 数据长度
- * @return DL_Status_t
+ * @return DL_Status_t，见 ZigBee_Submit
  */
 DL_Status_t ZigBee_SendPacket(uint8_t src, uint8_t dst, uint16_t addr,
                                const uint8_t *payload, uint16_t payload_len);
 
 /**
- * @brief 中断式发送原始帧 (非阻塞)
- * @param huart 串口句柄 (传 NULL 则使用默认)
+ * @brief 读取发送统计
+ */
+void ZigBee_GetTxStats(ZigBee_TxStats_t *stats);
+
+/**
+ * @brief 发送原始帧 (非阻塞，不经过发送队列，直接复制进端口发送缓冲)
+ * @param huart 串口句柄 (传 NULL 则使用 ZigBee 当前挂接的端口)
  * @param frame 原始帧数据指针
  * @param length 帧长度
  * @return DL_Status_t
@@ -99,7 +151,20 @@ DL_Status_t ZigBee_SendFrameIT(UART_HandleTypeDef *huart,
                                 uint16_t length);
 
 /**
- * @brief 阻塞式接收并解析数据包
+ * @brief 取出一个已完成的数据包（零拷贝，指向池中槽位）
+ * @param pkt [输出] 数据包指针，处理完后必须调用 ZigBee_ReleasePacket 归还
+ * @param timeout_ms 超时时间 (毫秒)，0 为不等待
+ * @return DL_Status_t
+ */
+DL_Status_t ZigBee_GetPacket(DL_Packet_t **pkt, uint32_t timeout_ms);
+
+/**
+ * @brief 归还 ZigBee_GetPacket 取得的数据包槽位
+ */
+void        ZigBee_ReleasePacket(DL_Packet_t *pkt);
+
+/**
+ * @brief 等待并复制一个数据包（ZigBee_GetPacket 的拷贝版本）
  * @param pkt [输出] 解析后的数据包结构体
  * @param timeout_ms 超时时间 (毫秒)
  * @return DL_Status_t
@@ -108,24 +173,21 @@ DL_Status_t ZigBee_RecvPacket(DL_Packet_t *pkt, uint32_t timeout_ms);
 
 /* ================= 中断回调辅助函数 ================= */
 /**
- * @brief  ZigBee UART 接收完成回调（需在 HAL_UART_RxCpltCallback 中调用）
- *         处理收到的字节并重新启动中断接收
+ * @brief  ZigBee 协议（Serial 端口插件）：逐字节去转义并直接写入数据包槽位，
+ *         完整的包放入队列；发送队列的帧经端口发送缓冲由 DMA 发出
  */
-void        ZigBee_UART_RxCpltCallback(void);
+extern const Serial_Protocol_t ZigBee_Protocol;
 
 /**
- * @brief 查询是否接收到完整的一帧数据
- * @return 1: 有新帧, 0: 无
+ * @brief 查询队列中是否有已完成的数据包
+ * @return 1: 有, 0: 无
  */
 uint8_t     ZigBee_IsRxFrameReady(void);
 
 /**
- * @brief 获取接收到的原始帧数据
- * @param buf [输出] 缓冲区
- * @param buf_len 缓冲区大小
- * @return 实际拷贝的字节数
+ * @brief 读取接收统计
  */
-uint16_t    ZigBee_GetRxFrame(uint8_t *buf, uint16_t buf_len);
+void        ZigBee_GetRxStats(ZigBee_RxStats_t *stats);
 
 /* ================= 接收字节处理函数 ================= */
 /* 将字节数组转成十六进制字符串，如 "FE 08 91 90 ..." */
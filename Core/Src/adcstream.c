@@ -0,0 +1,258 @@
+/**
+ * @file    adcstream.c
+ * @brief   双 ADC 同步采样流实现
+ *
+ * CubeMX 生成的 ADC1/ADC2 为软件启动的连续转换，DMA 为半字宽度。
+ * 这里在启动流时改写为：ADC1 主、ADC2 从的规则同步模式，TIM3 TRGO 触发，
+ * DMA2 Stream0 字宽度读取 CDR（低 16 位 ADC1，高 16 位 ADC2）。
+ * 不修改生成代码，重新生成后依然有效。
+ */
+#include "adcstream.h"
+#include "adc.h"
+#include "cmsis_os2.h"
+
+extern DMA_HandleTypeDef hdma_adc1;
+
+#define AS_FLAG_DATA     0x0001U
+#define AS_FLAG_RECONF   0x0002U
+#define AS_MAX_RATE_HZ   100000U
+
+static TIM_HandleTypeDef htim_adc;
+
+/* DMA 双缓冲：前半/后半各 ADCSTREAM_HALF_PAIRS 个样本对（DMA2 不能访问 CCMRAM，放在 SRAM） */
+static uint32_t as_dma_buf[2 * ADCSTREAM_HALF_PAIRS];
+/* 抽取输出，乒乓两份，交付给订阅者的块在下下个块前有效 */
+static uint16_t as_out[2][ADCSTREAM_CH_NUM][ADCSTREAM_HALF_PAIRS];
+
+static osThreadId_t as_thread = NULL;
+static volatile uint8_t as_pending = 0;     /* bit0 前半就绪，bit1 后半就绪 */
+static volatile uint8_t as_last_half = 0;   /* 最近一次完成的半缓冲 */
+
+static volatile uint32_t as_req_rate = ADCSTREAM_DEFAULT_RATE_HZ;
+static volatile uint8_t  as_req_osr = ADCSTREAM_DEFAULT_OSR;
+
+static struct {
+    adcstream_cb_t cb;
+    void *ctx;
+} as_subs[ADCSTREAM_MAX_SUBS];
+static uint8_t as_sub_num = 0;
+
+static AdcStream_Stats_t as_stats;
+static uint8_t as_out_idx = 0;
+
+/* 半满/全满中断：只做标记与通知 */
+static void as_notify(uint8_t half)
+{
+    uint8_t bit = (uint8_t)(1U << half);
+
+    if (as_pending & bit) as_stats.overruns++;   /* 上一轮该半缓冲尚未处理 */
+    as_pending |= bit;
+    as_last_half = half;
+    if (as_thread) osThreadFlagsSet(as_thread, AS_FLAG_DATA);
+}
+
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    if (hadc->Instance == ADC1) as_notify(0);
+}
+
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    if (hadc->Instance == ADC1) as_notify(1);
+}
+
+/* 按采样周期选择采样时间（ADCCLK = PCLK2/8 = 10.5MHz，转换时间 = 采样 + 12 周期） */
+static uint32_t as_sample_time(uint32_t rate_hz)
+{
+    if (rate_hz <= 20000U) return ADC_SAMPLETIME_480CYCLES;
+    if (rate_hz <= 60000U) return ADC_SAMPLETIME_144CYCLES;
+    return ADC_SAMPLETIME_56CYCLES;
+}
+
+static void as_stop(void)
+{
+    HAL_TIM_Base_Stop(&htim_adc);
+    HAL_ADCEx_MultiModeStop_DMA(&hadc1);
+    __HAL_ADC_DISABLE(&hadc2);
+    as_pending = 0;
+}
+
+static int as_start(uint32_t rate_hz, uint8_t osr_log4)
+{
+    ADC_ChannelConfTypeDef ch = {0};
+    ADC_MultiModeTypeDef mm = {0};
+
+    if (rate_hz == 0) rate_hz = ADCSTREAM_DEFAULT_RATE_HZ;
+    if (rate_hz > AS_MAX_RATE_HZ) rate_hz = AS_MAX_RATE_HZ;
+    if (osr_log4 > ADCSTREAM_OSR_LOG4_MAX) osr_log4 = ADCSTREAM_OSR_LOG4_MAX;
+
+    /* ADC1：主，TIM3 TRGO 上升沿触发单次转换 */
+    hadc1.Init.ContinuousConvMode = DISABLE;
+    hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
+    hadc1.Init.ExternalTrigConv = ADC_EXTERNALTRIGCONV_T3_TRGO;
+    hadc1.Init.DMAContinuousRequests = ENABLE;
+    if (HAL_ADC_Init(&hadc1) != HAL_OK) return 1;
+
+    /* ADC2：从，跟随主 ADC 触发 */
+    hadc2.Init.ContinuousConvMode = DISABLE;
+    hadc2.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
+    hadc2.Init.ExternalTrigConv = ADC_SOFTWARE_START;
+    hadc2.Init.DMAContinuousRequests = DISABLE;
+    if (HAL_ADC_Init(&hadc2) != HAL_OK) return 1;
+
+    ch.Rank = 1;
+    ch.SamplingTime = as_sample_time(rate_hz);
+    ch.Channel = ADC_CHANNEL_5;
+    if (HAL_ADC_ConfigChannel(&hadc1, &ch) != HAL_OK) return 1;
+    ch.Channel = ADC_CHANNEL_7;
+    if (HAL_ADC_ConfigChannel(&hadc2, &ch) != HAL_OK) return 1;
+
+    mm.Mode = ADC_DUALMODE_REGSIMULT;
+    mm.DMAAccessMode = ADC_DMAACCESSMODE_2;
+    mm.TwoSamplingDelay = ADC_TWOSAMPLINGDELAY_5CYCLES;
+    if (HAL_ADCEx_MultiModeConfigChannel(&hadc1, &mm) != HAL_OK) return 1;
+
+    /* DMA 改为 32 位：每次传输取一对结果 */
+    HAL_DMA_DeInit(&hdma_adc1);
+    hdma_adc1.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    hdma_adc1.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+    hdma_adc1.Init.Mode = DMA_CIRCULAR;
+    if (HAL_DMA_Init(&hdma_adc1) != HAL_OK) return 1;
+
+    __HAL_ADC_ENABLE(&hadc2);
+    if (HAL_ADCEx_MultiModeStart_DMA(&hadc1, as_dma_buf, 2U * ADCSTREAM_HALF_PAIRS) != HAL_OK) return 1;
+
+    /* TIM3：更新事件作为 TRGO */
+    RCC_ClkInitTypeDef clkconfig;
+    uint32_t flatency, timclk, total, psc;
+    TIM_MasterConfigTypeDef master = {0};
+
+    HAL_RCC_GetClockConfig(&clkconfig, &flatency);
+    timclk = HAL_RCC_GetPCLK1Freq();
+    if (clkconfig.APB1CLKDivider != RCC_HCLK_DIV1) timclk *= 2U;
+    total = timclk / rate_hz;
+    psc = total / 65536U;
+
+    __HAL_RCC_TIM3_CLK_ENABLE();
+    htim_adc.Instance = TIM3;
+    htim_adc.Init.Prescaler = psc;
+    htim_adc.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim_adc.Init.Period = total / (psc + 1U) - 1U;
+    htim_adc.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    htim_adc.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+    if (HAL_TIM_Base_Init(&htim_adc) != HAL_OK) return 1;
+    master.MasterOutputTrigger = TIM_TRGO_UPDATE;
+    master.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+    if (HAL_TIMEx_MasterConfigSynchronization(&htim_adc, &master) != HAL_OK) return 1;
+
+    as_stats.rate_hz = timclk / ((psc + 1U) * (htim_adc.Init.Period + 1U));
+    as_stats.osr_log4 = osr_log4;
+    as_pending = 0;
+
+    return (HAL_TIM_Base_Start(&htim_adc) == HAL_OK) ? 0 : 1;
+}
+
+/* 抽取半缓冲：每 4^k 个样本求和后右移 k 位 */
+static void as_process(uint8_t half)
+{
+    const uint32_t *src = &as_dma_buf[half * ADCSTREAM_HALF_PAIRS];
+    uint8_t k = as_stats.osr_log4;
+    uint32_t osr = 1UL << (2U * k);
+    uint32_t n = ADCSTREAM_HALF_PAIRS / osr;
+    uint16_t *d0 = as_out[as_out_idx][0];
+    uint16_t *d1 = as_out[as_out_idx][1];
+    AdcStream_Block_t blk;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint32_t s0 = 0, s1 = 0;
+        for (uint32_t j = 0; j < osr; j++)
+        {
+            uint32_t w = *src++;
+            s0 += w & 0xFFFFU;
+            s1 += w >> 16;
+        }
+        d0[i] = (uint16_t)(s0 >> k);
+        d1[i] = (uint16_t)(s1 >> k);
+    }
+
+    blk.ch[0] = d0;
+    blk.ch[1] = d1;
+    blk.n = (uint16_t)n;
+    blk.bits = (uint8_t)(12U + k);
+    blk.rate_hz = as_stats.rate_hz / osr;
+    blk.seq = as_stats.blocks++;
+    as_out_idx ^= 1U;
+
+    for (uint8_t i = 0; i < as_sub_num; i++)
+    {
+        as_subs[i].cb(&blk, as_subs[i].ctx);
+    }
+}
+
+int AdcStream_Subscribe(adcstream_cb_t cb, void *ctx)
+{
+    int ret = 1;
+
+    if (cb == NULL) return 1;
+    osKernelLock();
+    if (as_sub_num < ADCSTREAM_MAX_SUBS)
+    {
+        as_subs[as_sub_num].cb = cb;
+        as_subs[as_sub_num].ctx = ctx;
+        as_sub_num++;
+        ret = 0;
+    }
+    osKernelUnlock();
+    return ret;
+}
+
+void AdcStream_Configure(uint32_t rate_hz, uint8_t osr_log4)
+{
+    as_req_rate = rate_hz;
+    as_req_osr = osr_log4;
+    if (as_thread) osThreadFlagsSet(as_thread, AS_FLAG_RECONF);
+}
+
+void AdcStream_GetStats(AdcStream_Stats_t *stats)
+{
+    *stats = as_stats;
+}
+
+void AdcStreamTask(void *argument)
+{
+    as_thread = osThreadGetId();
+    as_start(as_req_rate, as_req_osr);
+
+    for (;;)
+    {
+        uint32_t flags = osThreadFlagsWait(AS_FLAG_DATA | AS_FLAG_RECONF, osFlagsWaitAny, osWaitForever);
+        if (flags & osFlagsError) continue;
+
+        if (flags & AS_FLAG_RECONF)
+        {
+            as_stop();
+            as_start(as_req_rate, as_req_osr);
+            continue;
+        }
+
+        /* 处理完再清除标记，处理期间 DMA 再次写完同一半会被记为溢出；
+           两半都待处理时先处理较早完成的一半 */
+        uint8_t pending = as_pending;
+        uint8_t last = as_last_half;
+
+        if (pending == 0x03U)
+        {
+            as_process((uint8_t)(last ^ 1U));
+            as_process(last);
+        }
+        else if (pending)
+        {
+            as_process((pending & 0x01U) ? 0 : 1);
+        }
+
+        __disable_irq();
+        as_pending &= (uint8_t)~pending;
+        __enable_irq();
+    }
+}
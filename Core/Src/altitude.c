@@ -0,0 +1,126 @@
+#include "altitude.h"
+#include "config.h"
+#include <math.h>
+
+#define ALT_EXP        0.19029495718363465f
+#define ALT_R_MIN      0.25f      /* 表起点 p/p0 */
+#define ALT_TAB_N      128        /* 区间数，步长 1/128 */
+
+/*
+ * alt_tab[i] = 44330 * (1 - r^0.190295)，r = ALT_R_MIN + (i - 1) / ALT_TAB_N
+ * 首尾各多一个点供三次插值使用（离线以双精度生成）
+ */
+static const float alt_tab[ALT_TAB_N + 3] = {
+    10484.1902f, 10279.0878f, 10079.1112f, 9883.9827f,
+    9693.4472f, 9507.2698f, 9325.2339f, 9147.1390f,
+    8972.7995f, 8802.0427f, 8634.7083f, 8470.6466f,
+    8309.7179f, 8151.7915f, 7996.7452f, 7844.4640f,
+    7694.8402f, 7547.7722f, 7403.1646f, 7260.9271f,
+    7120.9747f, 6983.2269f, 6847.6076f, 6714.0446f,
+    6582.4696f, 6452.8175f, 6325.0268f, 6199.0386f,
+    6074.7972f, 5952.2494f, 5831.3443f, 5712.0336f,
+    5594.2711f, 5478.0124f, 5363.2155f, 5249.8398f,
+    5137.8466f, 5027.1987f, 4917.8607f, 4809.7983f,
+    4702.9787f, 4597.3704f, 4492.9433f, 4389.6680f,
+    4287.5167f, 4186.4623f, 4086.4789f, 3987.5414f,
+    3889.6257f, 3792.7085f, 3696.7673f, 3601.7804f,
+    3507.7269f, 3414.5865f, 3322.3396f, 3230.9673f,
+    3140.4513f, 3050.7738f, 2961.9178f, 2873.8664f,
+    2786.6037f, 2700.1141f, 2614.3823f, 2529.3937f,
+    2445.1341f, 2361.5896f, 2278.7469f, 2196.5927f,
+    2115.1146f, 2034.3002f, 1954.1375f, 1874.6150f,
+    1795.7212f, 1717.4451f, 1639.7762f, 1562.7039f,
+    1486.2181f, 1410.3090f, 1334.9668f, 1260.1823f,
+    1185.9462f, 1112.2497f, 1039.0840f, 966.4408f,
+    894.3117f, 822.6887f, 751.5639f, 680.9297f,
+    610.7784f, 541.1029f, 471.8960f, 403.1506f,
+    334.8600f, 267.0175f, 199.6165f, 132.6507f,
+    66.1139f, 0.0000f, -65.6970f, -130.9830f,
+    -195.8635f, -260.3443f, -324.4308f, -388.1282f,
+    -451.4419f, -514.3771f, -576.9386f, -639.1314f,
+    -700.9605f, -762.4303f, -823.5457f, -884.3112f,
+    -944.7311f, -1004.8098f, -1064.5517f, -1123.9609f,
+    -1183.0416f, -1241.7977f, -1300.2332f, -1358.3520f,
+    -1416.1580f, -1473.6548f, -1530.8461f, -1587.7355f,
+    -1644.3266f, -1700.6229f, -1756.6277f, -1812.3444f,
+    -1867.7763f, -1922.9267f, -1977.7986f,
+};
+
+static float sea_level_pa = 101325.0f;
+static float inv_sea_level = 1.0f / 101325.0f;
+
+void Altitude_SetSeaLevel(float pa)
+{
+    if (!(pa > 0.0f)) pa = 101325.0f;
+    sea_level_pa = pa;
+    inv_sea_level = 1.0f / pa;
+}
+
+float Altitude_GetSeaLevel(void)
+{
+    return sea_level_pa;
+}
+
+void Altitude_LoadSeaLevel(void)
+{
+    Altitude_SetSeaLevel(g_config.sea_level_pa);
+}
+
+static float altitude_powf(float pressure_pa)
+{
+    if (pressure_pa <= 0.0f) return 0.0f;
+    return 44330.0f * (1.0f - powf(pressure_pa * inv_sea_level, ALT_EXP));
+}
+
+float Altitude_Calc(float pressure_pa)
+{
+    float x = (pressure_pa * inv_sea_level - ALT_R_MIN) * (float)ALT_TAB_N;
+
+    /* 超出表范围（或 NaN）时使用原始公式 */
+    if (!(x >= 0.0f && x < (float)ALT_TAB_N)) return altitude_powf(pressure_pa);
+
+    int   i = (int)x;
+    float t = x - (float)i;
+    const float *y = &alt_tab[i];   /* y[0..3] 对应节点 i-1, i, i+1, i+2 */
+
+    /* 等距 4 点 Lagrange 三次插值 */
+    float c1 = y[2] - y[0] * (1.0f / 3.0f) - y[1] * 0.5f - y[3] * (1.0f / 6.0f);
+    float c2 = (y[0] + y[2]) * 0.5f - y[1];
+    float c3 = (y[3] - y[0]) * (1.0f / 6.0f) + (y[1] - y[2]) * 0.5f;
+    return ((c3 * t + c2) * t + c1) * t + y[1];
+}
+
+uint8_t Altitude_Test(altitude_cycles_fn cycles, Altitude_Bench_t *bench)
+{
+    float err_fast = 0.0f, err_powf = 0.0f;
+    uint32_t cyc_fast = 0, cyc_powf = 0, n = 0;
+    volatile float sink;
+
+    for (float p = 30000.0f; p <= 110000.0f; p += 7.3f)
+    {
+        float ref = (float)(44330.0 * (1.0 - pow((double)p / (double)sea_level_pa, (double)ALT_EXP)));
+
+        uint32_t t0 = cycles();
+        float a = Altitude_Calc(p);
+        uint32_t t1 = cycles();
+        float b = altitude_powf(p);
+        uint32_t t2 = cycles();
+        sink = a + b;
+
+        cyc_fast += t1 - t0;
+        cyc_powf += t2 - t1;
+        if (fabsf(a - ref) > err_fast) err_fast = fabsf(a - ref);
+        if (fabsf(b - ref) > err_powf) err_powf = fabsf(b - ref);
+        n++;
+    }
+    (void)sink;
+
+    if (bench)
+    {
+        bench->max_err_m      = err_fast;
+        bench->max_err_powf_m = err_powf;
+        bench->cycles_fast    = cyc_fast / n;
+        bench->cycles_powf    = cyc_powf / n;
+    }
+    return (err_fast < 0.05f) ? 0 : 1;
+}
@@ -8,15 +8,97 @@ extern I2C_HandleTypeDef BH1750_I2C_HANDLE; /* hi2c1 by default */
 #define BH1750_CMD_POWER_DOWN       0x00
 #define BH1750_CMD_POWER_ON         0x01
 #define BH1750_CMD_RESET            0x07
+#define BH1750_CMD_MTREG_HIGH       0x40 /* 01000_MT[7:5] */
+#define BH1750_CMD_MTREG_LOW        0x60 /* 011_MT[4:0] */
 /* Measurement modes */
 #define BH1750_ONE_TIME_H_RES       0x20 /* 1 lx resolution, measurement time ~120-180ms */
 #define BH1750_CONT_H_RES           0x10
+#define BH1750_CONT_H_RES2          0x11
+#define BH1750_CONT_L_RES           0x13
+
+/* 自动量程阈值（原始计数）：高于 HIGH 降低灵敏度，低于 LOW 提高灵敏度，目标值 TARGET */
+#define BH1750_RAW_HIGH             50000U
+#define BH1750_RAW_LOW              5000U
+#define BH1750_RAW_TARGET           20000U
+
+static uint8_t  bh_mtreg = BH1750_MTREG_DEFAULT;
+static uint8_t  bh_mode = 0;            /* 当前连续模式，0 = 非连续 */
+static uint8_t  bh_hres_mode = BH1750_CONT_H_RES; /* 自动量程选择的高分辨率模式 */
+static uint32_t bh_valid_at = 0;        /* 该时刻之后的结果才对应当前量程 (tick) */
 
 static HAL_StatusTypeDef bh_write(uint8_t cmd)
 {
     return HAL_I2C_Master_Transmit(&BH1750_I2C_HANDLE, BH1750_ADDR, &cmd, 1, 200);
 }
 
+/* 当前模式与 MTreg 下的最长转换时间 (ms) */
+static uint32_t bh_conv_ms(uint8_t mode)
+{
+    uint32_t base = (mode == BH1750_CONT_L_RES) ? BH1750_L_RES_MS : BH1750_ONE_TIME_MS;
+    return (base * bh_mtreg + BH1750_MTREG_DEFAULT - 1U) / BH1750_MTREG_DEFAULT;
+}
+
+/* 写入连续模式命令并记录首个有效结果的时刻 */
+static int bh_enter_mode(uint8_t mode)
+{
+    if (bh_write(mode) != HAL_OK) return BH1750_ERR_I2C;
+    bh_mode = mode;
+    bh_valid_at = osKernelGetTickCount() + bh_conv_ms(mode);
+    return BH1750_OK;
+}
+
+/* 原始值 -> lux：raw / 1.2 * (69 / MTreg)，H-res2 再除以 2 */
+static float bh_raw_to_lux(uint16_t raw, uint8_t mode)
+{
+    float lux = (float)raw / 1.2f * ((float)BH1750_MTREG_DEFAULT / (float)bh_mtreg);
+    if (mode == BH1750_CONT_H_RES2) lux *= 0.5f;
+    return lux;
+}
+
+/* 自动量程：按原始值把下一次测量调整到目标计数附近，返回是否发生调整 */
+static bool bh_autorange(uint16_t raw)
+{
+    uint32_t mt = bh_mtreg;
+    uint8_t mode = bh_hres_mode;
+
+    if (raw > BH1750_RAW_HIGH)
+    {
+        if (mode == BH1750_CONT_H_RES2)
+        {
+            mode = BH1750_CONT_H_RES;   /* 先退出 H-res2，量程加倍 */
+        }
+        else if (raw == 0xFFFFU)
+        {
+            mt /= 2U;                   /* 已饱和，真实值未知，减半 */
+        }
+        else
+        {
+            mt = mt * BH1750_RAW_TARGET / raw;
+        }
+    }
+    else if (raw < BH1750_RAW_LOW)
+    {
+        if (mt < BH1750_MTREG_MAX)
+        {
+            mt = mt * BH1750_RAW_TARGET / (raw ? raw : 1U);
+        }
+        else if (mode == BH1750_CONT_H_RES)
+        {
+            mode = BH1750_CONT_H_RES2;  /* MTreg 已最大，再切 H-res2 提高分辨率 */
+        }
+    }
+
+    if (mt < BH1750_MTREG_MIN) mt = BH1750_MTREG_MIN;
+    if (mt > BH1750_MTREG_MAX) mt = BH1750_MTREG_MAX;
+    if (mt == bh_mtreg && mode == bh_hres_mode) return false;
+
+    bh_hres_mode = mode;
+    if (BH1750_SetMTreg((uint8_t)mt) != BH1750_OK) return false;
+    /* 修改 MTreg 后需重新发送测量命令才生效 */
+    bh_enter_mode(mode);
+    return true;
+}
+
 int BH1750_Init(void)
 {
     if (BH1750_PowerOn() != BH1750_OK) return BH1750_ERR_I2C;
@@ -34,6 +116,7 @@ int BH1750_PowerOn(void)
 
 int BH1750_PowerDown(void)
 {
+    bh_mode = 0;
     if (bh_write(BH1750_CMD_POWER_DOWN) == HAL_OK) return BH1750_OK;
     return BH1750_ERR_I2C;
 }
@@ -47,31 +130,87 @@ int BH1750_Reset(void)
 
 int BH1750_SetMode(uint8_t mode)
 {
-    if (bh_write(mode) == HAL_OK) return BH1750_OK;
-    return BH1750_ERR_I2C;
+    if (bh_write(mode) != HAL_OK) return BH1750_ERR_I2C;
+    /* 只有连续模式需要记录；单次模式测量后自动休眠 */
+    bh_mode = (mode == BH1750_CONT_H_RES || mode == BH1750_CONT_H_RES2 ||
+               mode == BH1750_CONT_L_RES) ? mode : 0;
+    if (bh_mode) bh_valid_at = osKernelGetTickCount() + bh_conv_ms(bh_mode);
+    return BH1750_OK;
 }
 
-int BH1750_ReadLux(float *lux)
+int BH1750_SetMTreg(uint8_t mt)
 {
-    uint8_t rx[2];
-    HAL_StatusTypeDef ret;
+    if (mt < BH1750_MTREG_MIN) mt = BH1750_MTREG_MIN;
+    if (mt > BH1750_MTREG_MAX) mt = BH1750_MTREG_MAX;
+
+    if (bh_write(BH1750_CMD_MTREG_HIGH | (mt >> 5)) != HAL_OK) return BH1750_ERR_I2C;
+    if (bh_write(BH1750_CMD_MTREG_LOW | (mt & 0x1F)) != HAL_OK) return BH1750_ERR_I2C;
+    bh_mtreg = mt;
+    return BH1750_OK;
+}
 
+uint8_t BH1750_GetMTreg(void)
+{
+    return bh_mtreg;
+}
+
+int BH1750_StartContinuous(void)
+{
+    if (BH1750_PowerOn() != BH1750_OK) return BH1750_ERR_I2C;
+    if (BH1750_SetMTreg(bh_mtreg) != BH1750_OK) return BH1750_ERR_I2C;
+    return bh_enter_mode(bh_hres_mode);
+}
+
+int BH1750_SetLowLatency(bool enable)
+{
+    if (enable) return bh_enter_mode(BH1750_CONT_L_RES);
+    return bh_enter_mode(bh_hres_mode);
+}
+
+int BH1750_StartOneShot(void)
+{
     /* Send one-time high resolution measurement */
-    ret = bh_write(BH1750_ONE_TIME_H_RES);
-    if (ret != HAL_OK) return BH1750_ERR_I2C;
+    if (bh_write(BH1750_ONE_TIME_H_RES) != HAL_OK) return BH1750_ERR_I2C;
+    bh_mode = 0;
+    return BH1750_OK;
+}
+
+int BH1750_FetchLux(float *lux)
+{
+    uint8_t rx[2];
 
-    /* 等待测量完成：datasheet 建议 max 180ms（使用120ms以上较好） */
-    osDelay(180);
+    /* 量程/模式切换后，旧量程的结果不再有效 */
+    if (bh_mode && (int32_t)(osKernelGetTickCount() - bh_valid_at) < 0)
+        return BH1750_BUSY;
 
     /* 读取 2 字节数据 */
-    ret = HAL_I2C_Master_Receive(&BH1750_I2C_HANDLE, BH1750_ADDR, rx, 2, 300);
-    if (ret != HAL_OK) return BH1750_ERR_I2C;
+    if (HAL_I2C_Master_Receive(&BH1750_I2C_HANDLE, BH1750_ADDR, rx, 2, 300) != HAL_OK)
+        return BH1750_ERR_I2C;
 
     uint16_t raw = ((uint16_t)rx[0] << 8) | rx[1];
+    uint8_t mode = bh_mode ? bh_mode : BH1750_ONE_TIME_H_RES;
+
+    /* 转换为 lux：value / 1.2 (datasheet)，并按 MTreg 缩放 */
+    if (lux) *lux = bh_raw_to_lux(raw, mode);
 
-    /* 转换为 lux：value / 1.2 (datasheet) */
-    if (lux) *lux = (float)raw / 1.2f;
+    /* 低分辨率模式只为低延迟，不参与自动量程 */
+    if (bh_mode == BH1750_CONT_H_RES || bh_mode == BH1750_CONT_H_RES2)
+        bh_autorange(raw);
 
     return BH1750_OK;
 }
 
+int BH1750_ReadLux(float *lux)
+{
+    if (bh_mode == 0)
+    {
+        int ret = BH1750_StartContinuous();
+        if (ret != BH1750_OK) return ret;
+    }
+
+    /* 等待当前量程下的首次转换完成 */
+    int32_t wait = (int32_t)(bh_valid_at - osKernelGetTickCount());
+    if (wait > 0) osDelay((uint32_t)wait);
+
+    return BH1750_FetchLux(lux);
+}
@@ -1,5 +1,6 @@
 #include "bluetooth.h"
 #include "usart.h"
+#include "serial.h"
 #include <stdint.h>
 #include <string.h>
 #include <sys/_intsup.h>
@@ -20,9 +21,6 @@ uint8_t bt_line_idx = 0;
 char received[128] = {0};
 uint8_t bt_has_new = 0;
 
-/* 单字节中断接收暂存 */
-static uint8_t rx_byte_it;
-
 /* 内部帮助：若传入 NULL 使用默认实例 */
 static inline BT_Handle_t* _handle(BT_Handle_t *hbt) {
     return hbt ? hbt : &hBluetooth;
@@ -49,37 +47,48 @@ BT_Status_t BT_Init(BT_Handle_t *hbt_in)
     HAL_GPIO_Init(hbt->STATE_Port, &gpio);
 
     hbt->initialized = 1;
-    //开启接收中断
-    if (BT_DEFAULT_UART != NULL) {
-        HAL_UART_Receive_IT(BT_DEFAULT_UART, &rx_byte_it, 1);
+    /* 把行协议挂到蓝牙所在端口（启动 DMA 收发） */
+    int port = UartRx_PortOf(hbt->huart);
+    if (port < 0 || Serial_Attach((UartRx_Port_t)port, &BT_Protocol, NULL) != 0) {
+        return BT_ERROR;
     }
-    device_on_uart2 = 2; // 标记 UART2 连接了 Bluetooth
     return BT_OK;
 }
 
-void Bluetooth_UART_RxCpltCallback(void)
+/* 按行组装：'\n' 结束一行，忽略 '\r' */
+static void bt_rx_byte(uint8_t c)
 {
-
-        extern uint8_t usart2_has_new;
-
-        if (rx_byte_it == '\r') {
-            /* 忽略裸回车 */
-        } else if (rx_byte_it == '\n') {
-            /* 一行结束，拷贝到接收缓冲 */
-            bt_line_buf[bt_line_idx] = '\0';
-            strncpy(received, bt_line_buf, sizeof(received) - 1);
-            received[sizeof(received) - 1] = '\0';
-            bt_line_idx = 0;  // 清空，准备下一行
-            bt_has_new = 1; // 标记有新数据
-        } else {
-            /* 普通字符，累加到当前行（防溢出） */
-            if (bt_line_idx < sizeof(bt_line_buf) - 1) {
-                bt_line_buf[bt_line_idx++] = (char)rx_byte_it;
-            }
+    if (c == '\r') {
+        /* 忽略裸回车 */
+    } else if (c == '\n') {
+        /* 一行结束，拷贝到接收缓冲 */
+        bt_line_buf[bt_line_idx] = '\0';
+        strncpy(received, bt_line_buf, sizeof(received) - 1);
+        received[sizeof(received) - 1] = '\0';
+        bt_line_idx = 0;  // 清空，准备下一行
+        bt_has_new = 1; // 标记有新数据
+    } else {
+        /* 普通字符，累加到当前行（防溢出） */
+        if (bt_line_idx < sizeof(bt_line_buf) - 1) {
+            bt_line_buf[bt_line_idx++] = (char)c;
         }
-    HAL_UART_Receive_IT(BT_DEFAULT_UART, &rx_byte_it, 1);
+    }
+}
+
+static void bt_on_rx(UartRx_Port_t port, void *ctx, const uint8_t *data, uint16_t len)
+{
+    (void)port;
+    (void)ctx;
+    for (uint16_t i = 0; i < len; i++) {
+        bt_rx_byte(data[i]);
+    }
 }
 
+const Serial_Protocol_t BT_Protocol = {
+    .name = "bt-line",
+    .rx   = bt_on_rx,
+};
+
 BT_Status_t BT_Send(BT_Handle_t *hbt_in, const uint8_t *data, uint16_t len)
 {
     BT_Handle_t *hbt = _handle(hbt_in);
@@ -89,8 +98,9 @@ BT_Status_t BT_Send(BT_Handle_t *hbt_in, const uint8_t *data, uint16_t len)
     if (HAL_GPIO_ReadPin(hbt->EN_Port, hbt->EN_Pin) == GPIO_PIN_SET)
         return BT_ERROR;
 
-    /* 中断方式发送 */
-    if (HAL_UART_Transmit_IT(hbt->huart, data, len) != HAL_OK)
+    /* 复制进端口发送缓冲，由 DMA 发出 */
+    int port = UartRx_PortOf(hbt->huart);
+    if (port < 0 || Serial_Write((UartRx_Port_t)port, data, len, NULL) != 0)
         return BT_ERROR;
 
 
@@ -103,3 +113,10 @@ BT_Status_t BT_Receive(BT_Handle_t *hbt_in, uint8_t *buf, uint16_t len)
     return BT_OK;
 }
 
+uint8_t BT_GetState(BT_Handle_t *hbt_in)
+{
+    BT_Handle_t *hbt = _handle(hbt_in);
+    if (!hbt || !hbt->initialized) return BT_DISCONNECTED;
+
+    return HAL_GPIO_ReadPin(hbt->STATE_Port, hbt->STATE_Pin) == GPIO_PIN_SET ? BT_CONNECTED : BT_DISCONNECTED;
+}
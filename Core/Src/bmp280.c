@@ -6,21 +6,6 @@
 
 extern I2C_HandleTypeDef BMP280_I2C_HANDLE; /* hi2c2 by header macro */
 
-typedef struct {
-    uint16_t dig_T1;
-    int16_t  dig_T2;
-    int16_t  dig_T3;
-    uint16_t dig_P1;
-    int16_t  dig_P2;
-    int16_t  dig_P3;
-    int16_t  dig_P4;
-    int16_t  dig_P5;
-    int16_t  dig_P6;
-    int16_t  dig_P7;
-    int16_t  dig_P8;
-    int16_t  dig_P9;
-} bmp280_calib_t;
-
 static bmp280_calib_t calib;
 static int32_t t_fine = 0;
 
@@ -76,38 +61,25 @@ static void parse_calib(uint8_t *buf)
     calib.dig_P9 = (int16_t)buf[22] | ((int16_t)buf[23] << 8);
 }
 
-/* 按 Bosch 数据手册补偿温度，返回摄氏度 *100 (centi-deg)，并设置 t_fine */
-static int32_t compensate_temp(int32_t adc_T)
-{
-    int64_t var1, var2;
-    var1 = ((((int64_t)adc_T >> 3) - ((int64_t)calib.dig_T1 << 1)) * (int64_t)calib.dig_T2) >> 11;
-    var2 = (((((int64_t)adc_T >> 4) - (int64_t)calib.dig_T1) * (((int64_t)adc_T >> 4) - (int64_t)calib.dig_T1)) >> 12) * (int64_t)calib.dig_T3 >> 14;
-    t_fine = (int32_t)(var1 + var2);
-    int32_t T = (t_fine * 5 + 128) >> 8; /* T in 0.01 degC */
-    return T;
-}
-
-/* 补偿气压，输入 adc_P，返回 Pa (浮点) */
-static float compensate_press(int32_t adc_P)
+/* 按编译期选择的实现补偿一组原始值 */
+static void compensate(int32_t adc_T, int32_t adc_P, float *temp_c, float *press_pa)
 {
-    int64_t var1, var2, p;
-    var1 = ((int64_t)t_fine) - 128000;
-    var2 = var1 * var1 * (int64_t)calib.dig_P6;
-    var2 = var2 + ((var1 * (int64_t)calib.dig_P5) << 17);
-    var2 = var2 + (((int64_t)calib.dig_P4) << 35);
-    var1 = ((var1 * var1 * (int64_t)calib.dig_P3) >> 8) + ((var1 * (int64_t)calib.dig_P2) << 12);
-    var1 = (((((int64_t)1) << 47) + var1) * (int64_t)calib.dig_P1) >> 33;
-
-    if (var1 == 0) return 0.0f; /* avoid division by zero */
-
-    p = 1048576 - adc_P;
-    p = (((p << 31) - var2) * 3125) / var1;
-    var1 = ((int64_t)calib.dig_P9 * (p >> 13) * (p >> 13)) >> 25;
-    var2 = ((int64_t)calib.dig_P8 * p) >> 19;
-    p = ((p + var1 + var2) >> 8) + (((int64_t)calib.dig_P7) << 4);
-
-    /* p is in Q24.8 format; convert to Pa */
-    return (float)p / 256.0f;
+#if BMP280_COMP_BACKEND == BMP280_COMP_FLOAT
+    float tf;
+    float t = BMP280_CompTempFloat(&calib, adc_T, &tf);
+    t_fine = (int32_t)tf;
+    if (temp_c)   *temp_c = t;
+    if (press_pa) *press_pa = BMP280_CompPressFloat(&calib, adc_P, tf);
+#elif BMP280_COMP_BACKEND == BMP280_COMP_INT32
+    int32_t T100 = BMP280_CompTempInt32(&calib, adc_T, &t_fine);
+    if (temp_c)   *temp_c = T100 / 100.0f;
+    if (press_pa) *press_pa = (float)BMP280_CompPressInt32(&calib, adc_P, t_fine);
+#else
+    /* 温度补偿 -> 返回 0.01 degC */
+    int32_t T100 = BMP280_CompTempInt64(&calib, adc_T, &t_fine);
+    if (temp_c)   *temp_c = T100 / 100.0f;
+    if (press_pa) *press_pa = BMP280_CompPressInt64(&calib, adc_P, t_fine);
+#endif
 }
 
 int BMP280_Init(void)
@@ -139,11 +111,7 @@ int BMP280_ReadTempPressure(float *temp_c, float *press_pa)
     int32_t adc_P = (int32_t)(((uint32_t)buf[0] << 12) | ((uint32_t)buf[1] << 4) | ((uint32_t)buf[2] >> 4));
     int32_t adc_T = (int32_t)(((uint32_t)buf[3] << 12) | ((uint32_t)buf[4] << 4) | ((uint32_t)buf[5] >> 4));
 
-    /* 温度补偿 -> 返回 0.01 degC */
-    int32_t T100 = compensate_temp(adc_T);
-    if (temp_c) *temp_c = T100 / 100.0f;
-
-    if (press_pa) *press_pa = compensate_press(adc_P);
+    compensate(adc_T, adc_P, temp_c, press_pa);
 
     return BMP280_OK;
 }
@@ -164,4 +132,3 @@ float BMP280_CalcAltitude(float pressure_pa, float sea_level_pa)
     if (sea_level_pa <= 0.0f) sea_level_pa = 101325.0f;
     return 44330.0f * (1.0f - powf(pressure_pa / sea_level_pa, 0.19029495718363465f));
 }
-
@@ -0,0 +1,186 @@
+/**
+ * @file    bmp280_comp.c
+ * @brief   BMP280 温度/气压补偿算法（64 位整数、32 位整数、单精度浮点三种实现）与对比自检
+ *
+ * 本文件不依赖 HAL/RTOS，上位机测试 Tools/bmpcomp 直接编译同一份源码。
+ */
+#include "bmp280_comp.h"
+#include <math.h>
+
+/* ---------------- 补偿算法 ----------------
+ * 三种实现均按 Bosch 数据手册，bmp280.c 按 BMP280_COMP_BACKEND 选择实际使用的一种；
+ * 其余实现仅供 BMP280_CompTest 对比，未被引用时由 --gc-sections 丢弃。
+ */
+
+/* 64 位整数参考实现：返回 0.01 degC，并输出 t_fine */
+int32_t BMP280_CompTempInt64(const bmp280_calib_t *c, int32_t adc_T, int32_t *tf)
+{
+    int64_t var1, var2;
+    var1 = ((((int64_t)adc_T >> 3) - ((int64_t)c->dig_T1 << 1)) * (int64_t)c->dig_T2) >> 11;
+    var2 = (((((int64_t)adc_T >> 4) - (int64_t)c->dig_T1) * (((int64_t)adc_T >> 4) - (int64_t)c->dig_T1)) >> 12) * (int64_t)c->dig_T3 >> 14;
+    *tf = (int32_t)(var1 + var2);
+    return (*tf * 5 + 128) >> 8;
+}
+
+/* 64 位整数参考实现：结果为 Q24.8，转换为 Pa (浮点) */
+float BMP280_CompPressInt64(const bmp280_calib_t *c, int32_t adc_P, int32_t tf)
+{
+    int64_t var1, var2, p;
+    var1 = ((int64_t)tf) - 128000;
+    var2 = var1 * var1 * (int64_t)c->dig_P6;
+    var2 = var2 + ((var1 * (int64_t)c->dig_P5) << 17);
+    var2 = var2 + (((int64_t)c->dig_P4) << 35);
+    var1 = ((var1 * var1 * (int64_t)c->dig_P3) >> 8) + ((var1 * (int64_t)c->dig_P2) << 12);
+    var1 = (((((int64_t)1) << 47) + var1) * (int64_t)c->dig_P1) >> 33;
+
+    if (var1 == 0) return 0.0f; /* avoid division by zero */
+
+    p = 1048576 - adc_P;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = ((int64_t)c->dig_P9 * (p >> 13) * (p >> 13)) >> 25;
+    var2 = ((int64_t)c->dig_P8 * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + (((int64_t)c->dig_P7) << 4);
+
+    /* p is in Q24.8 format; convert to Pa */
+    return (float)p / 256.0f;
+}
+
+/* 32 位整数实现：温度结果与 64 位版本逐位一致 */
+int32_t BMP280_CompTempInt32(const bmp280_calib_t *c, int32_t adc_T, int32_t *tf)
+{
+    int32_t var1, var2;
+    var1 = (((adc_T >> 3) - ((int32_t)c->dig_T1 << 1)) * (int32_t)c->dig_T2) >> 11;
+    var2 = (((((adc_T >> 4) - (int32_t)c->dig_T1) * ((adc_T >> 4) - (int32_t)c->dig_T1)) >> 12) * (int32_t)c->dig_T3) >> 14;
+    *tf = var1 + var2;
+    return (*tf * 5 + 128) >> 8;
+}
+
+/* 32 位整数实现：分辨率 1 Pa，相对 64 位版本误差在 ±8 Pa 以内 */
+uint32_t BMP280_CompPressInt32(const bmp280_calib_t *c, int32_t adc_P, int32_t tf)
+{
+    int32_t var1, var2;
+    uint32_t p;
+    var1 = (tf >> 1) - (int32_t)64000;
+    var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * (int32_t)c->dig_P6;
+    var2 = var2 + ((var1 * (int32_t)c->dig_P5) << 1);
+    var2 = (var2 >> 2) + ((int32_t)c->dig_P4 << 16);
+    var1 = (((c->dig_P3 * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3) + (((int32_t)c->dig_P2 * var1) >> 1)) >> 18;
+    var1 = ((32768 + var1) * (int32_t)c->dig_P1) >> 15;
+
+    if (var1 == 0) return 0; /* avoid division by zero */
+
+    p = ((uint32_t)((int32_t)1048576 - adc_P) - (uint32_t)(var2 >> 12)) * 3125U;
+    if (p < 0x80000000U) p = (p << 1) / (uint32_t)var1;
+    else                 p = (p / (uint32_t)var1) * 2U;
+    var1 = ((int32_t)c->dig_P9 * (int32_t)(((p >> 3) * (p >> 3)) >> 13)) >> 12;
+    var2 = ((int32_t)(p >> 2) * (int32_t)c->dig_P8) >> 13;
+    return (uint32_t)((int32_t)p + ((var1 + var2 + c->dig_P7) >> 4));
+}
+
+/* 单精度浮点实现（FPU）：返回 degC，t_fine 保留小数部分供气压补偿使用 */
+float BMP280_CompTempFloat(const bmp280_calib_t *c, int32_t adc_T, float *tf)
+{
+    float x = (float)adc_T * (1.0f / 16384.0f) - (float)c->dig_T1 * (1.0f / 1024.0f);
+    float y = (float)adc_T * (1.0f / 131072.0f) - (float)c->dig_T1 * (1.0f / 8192.0f);
+    float t = x * (float)c->dig_T2 + y * y * (float)c->dig_T3;
+    *tf = t;
+    return t * (1.0f / 5120.0f);
+}
+
+/* 单精度浮点实现：相对 64 位版本误差在 0.5 Pa 以内 */
+float BMP280_CompPressFloat(const bmp280_calib_t *c, int32_t adc_P, float tf)
+{
+    float var1 = tf * 0.5f - 64000.0f;
+    float var2 = var1 * var1 * (float)c->dig_P6 * (1.0f / 32768.0f);
+    var2 = var2 + var1 * (float)c->dig_P5 * 2.0f;
+    var2 = var2 * 0.25f + (float)c->dig_P4 * 65536.0f;
+    var1 = ((float)c->dig_P3 * var1 * var1 * (1.0f / 524288.0f) + (float)c->dig_P2 * var1) * (1.0f / 524288.0f);
+    var1 = (1.0f + var1 * (1.0f / 32768.0f)) * (float)c->dig_P1;
+
+    if (var1 == 0.0f) return 0.0f; /* avoid division by zero */
+
+    float p = 1048576.0f - (float)adc_P;
+    p = (p - var2 * (1.0f / 4096.0f)) * 6250.0f / var1;
+    var1 = (float)c->dig_P9 * p * p * (1.0f / 2147483648.0f);
+    var2 = p * (float)c->dig_P8 * (1.0f / 32768.0f);
+    return p + (var1 + var2 + (float)c->dig_P7) * (1.0f / 16.0f);
+}
+
+
+/* ---------------- 补偿算法自检与性能测量 ---------------- */
+
+/* Bosch 数据手册中的示例校准参数与原始值 */
+static const bmp280_calib_t ref_calib = {
+    27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000
+};
+#define REF_ADC_T     519888
+#define REF_ADC_P     415148
+#define REF_T100      2508          /* 25.08 degC */
+#define REF_T_FINE    128422
+#define REF_P_Q8      25767233      /* 100653.25 Pa (Q24.8) */
+
+/* 扫描步长：温度/气压原始值各取 256 个点，只比较有效量程内的组合 */
+#define SWEEP_STEP    4096
+
+int BMP280_CompTest(bmp280_cycles_fn cycles, BMP280_CompBench_t *bench)
+{
+    const bmp280_calib_t *c = &ref_calib;
+    uint32_t cyc[BMP280_COMP_NUM] = {0};
+    float    err[BMP280_COMP_NUM] = {0};
+    uint32_t n = 0;
+    int32_t  tf64, tf32;
+    float    tff;
+
+    /* 1. 参考向量 */
+    if (BMP280_CompTempInt64(c, REF_ADC_T, &tf64) != REF_T100 || tf64 != REF_T_FINE) return 1;
+    if (BMP280_CompPressInt64(c, REF_ADC_P, tf64) != REF_P_Q8 / 256.0f) return 1;
+    if (BMP280_CompTempInt32(c, REF_ADC_T, &tf32) != REF_T100) return 1;
+    if (fabsf((float)BMP280_CompPressInt32(c, REF_ADC_P, tf32) - REF_P_Q8 / 256.0f) > 8.0f) return 1;
+    if (fabsf(BMP280_CompTempFloat(c, REF_ADC_T, &tff) - REF_T100 / 100.0f) > 0.01f) return 1;
+    if (fabsf(BMP280_CompPressFloat(c, REF_ADC_P, tff) - REF_P_Q8 / 256.0f) > 0.5f) return 1;
+
+    /* 2. 全量程扫描：以 64 位实现为基准，统计误差与每次补偿(温度+气压)的周期数 */
+    for (int32_t adc_T = 0; adc_T < (1 << 20); adc_T += SWEEP_STEP)
+    {
+        int32_t T100 = BMP280_CompTempInt64(c, adc_T, &tf64);
+        if (T100 < -4000 || T100 > 8500) continue;          /* 工作温度 -40~85 degC */
+
+        for (int32_t adc_P = 0; adc_P < (1 << 20); adc_P += SWEEP_STEP)
+        {
+            uint32_t t0 = cycles();
+            BMP280_CompTempInt64(c, adc_T, &tf64);
+            float p64 = BMP280_CompPressInt64(c, adc_P, tf64);
+            uint32_t t1 = cycles();
+            BMP280_CompTempInt32(c, adc_T, &tf32);
+            float p32 = (float)BMP280_CompPressInt32(c, adc_P, tf32);
+            uint32_t t2 = cycles();
+            BMP280_CompTempFloat(c, adc_T, &tff);
+            float pf = BMP280_CompPressFloat(c, adc_P, tff);
+            uint32_t t3 = cycles();
+
+            if (p64 < 30000.0f || p64 > 110000.0f) continue; /* 工作量程 300~1100 hPa */
+
+            cyc[BMP280_COMP_INT64] += t1 - t0;
+            cyc[BMP280_COMP_INT32] += t2 - t1;
+            cyc[BMP280_COMP_FLOAT] += t3 - t2;
+            if (fabsf(p32 - p64) > err[BMP280_COMP_INT32]) err[BMP280_COMP_INT32] = fabsf(p32 - p64);
+            if (fabsf(pf - p64)  > err[BMP280_COMP_FLOAT]) err[BMP280_COMP_FLOAT] = fabsf(pf - p64);
+            if (tf32 != tf64) return 2;
+            n++;
+        }
+    }
+
+    if (bench)
+    {
+        for (int i = 0; i < BMP280_COMP_NUM; i++)
+        {
+            bench->cycles[i] = n ? cyc[i] / n : 0;
+            bench->max_err_pa[i] = err[i];
+        }
+        bench->samples = n;
+    }
+
+    if (n == 0) return 2;
+    if (err[BMP280_COMP_INT32] > 8.0f || err[BMP280_COMP_FLOAT] > 0.5f) return 2;
+    return 0;
+}
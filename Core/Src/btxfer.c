@@ -0,0 +1,425 @@
+/**
+ * @file    btxfer.c
+ * @brief   蓝牙批量下载实现
+ *
+ * 接收在串口中断中完成：COBS/CRC 解码后把控制帧（OPEN/ACK/CLOSE）放进小队列并唤醒任务。
+ * 发送由任务完成：发送缓冲放得下一整帧时从 Flash 读出一块（持有 W25Q128 访问锁）、补 CRC、COBS 编码后写入，
+ * 由 DMA 发出；每段 DMA 完成中断唤醒任务继续填充，使串口始终有数据可发。
+ */
+#include "btxfer.h"
+#include "bluetooth.h"
+#include "tlmcodec.h"
+#include "serial.h"
+#include "flash.h"
+#include "crc.h"
+#include "cmsis_os2.h"
+#include <string.h>
+
+#define BX_FLAG_RX      0x01U
+#define BX_FLAG_TX      0x02U
+#define BX_POLL_MS      50U
+#define BX_CTL_LEN      8U          /* 控制帧队列（2 的幂） */
+#define BX_CTL_MAX      16U         /* 控制帧最大长度（不含 CRC） */
+#define BX_WMASK        (BTX_WINDOW - 1U)     /* 窗口状态为 32 位位图，BTX_WINDOW 固定为 32 */
+
+typedef enum {
+    BX_IDLE = 0,
+    BX_SEND,        /* 发送数据块 */
+    BX_PAUSE,       /* 断线或无 ACK，等待上位机用 OPEN 续传 */
+    BX_DONE,        /* 全部确认，重发 DONE 直到 CLOSE */
+} bx_state_t;
+
+typedef struct {
+    uint8_t len;
+    uint8_t d[BX_CTL_MAX];
+} bx_ctl_t;
+
+typedef struct {
+    uint8_t  state;
+    uint8_t  sess;
+    uint8_t  done_left;
+    uint32_t addr, len;
+    uint32_t chunks;
+    uint32_t base;              /* 最小未确认块 */
+    uint32_t next;              /* 下一个首次发送的块 */
+    uint32_t acked;             /* 位 i = 块 base+i 已确认 */
+    uint32_t rtx;               /* 位 i = 块 base+i 待重传 */
+    uint32_t seq;               /* 帧发送计数，用于判断先后 */
+    uint32_t sent_seq[BTX_WINDOW];
+    uint32_t sent_at[BTX_WINDOW];
+    uint32_t last_ack;
+    uint32_t retx;
+} bx_sess_t;
+
+static bx_sess_t bx;
+static osThreadId_t bx_task = NULL;
+static UartRx_Port_t bx_port;
+static BtXfer_Stats_t bx_stats;
+
+/* 中断 → 任务的控制帧队列 */
+static Tlm_Decoder_t bx_dec;
+static bx_ctl_t bx_ctl[BX_CTL_LEN];
+static volatile uint32_t bx_ctl_head = 0;
+static volatile uint32_t bx_ctl_tail = 0;
+static volatile uint8_t bx_busy = 0;       /* 有会话时不再把字节交给行协议 */
+
+static uint8_t bx_frame[TLM_FRAME_MAX] __attribute__((aligned(4)));
+static uint8_t bx_out[TLM_COBS_MAX];
+
+static void bx_put_le(uint8_t *p, uint32_t v, uint8_t n)
+{
+    for (uint8_t i = 0; i < n; i++) p[i] = (uint8_t)(v >> (8U * i));
+}
+
+static uint32_t bx_get_le(const uint8_t *p, uint8_t n)
+{
+    uint32_t v = 0;
+    for (uint8_t i = 0; i < n; i++) v |= (uint32_t)p[i] << (8U * i);
+    return v;
+}
+
+/* CRC 外设与遥测、日志共用，锁调度器避免交错 */
+static uint32_t bx_hw_crc(const uint8_t *data, uint32_t len)
+{
+    int32_t lock = osKernelLock();
+    uint32_t crc = HAL_CRC_Calculate(&hcrc, (uint32_t *)(uintptr_t)data, len / 4U);
+    osKernelRestoreLock(lock);
+    return crc;
+}
+
+/* ---- 接收（中断上下文） ---- */
+
+static void bx_on_frame(const uint8_t *p, uint16_t len, void *ctx)
+{
+    uint32_t h = bx_ctl_head;
+    (void)ctx;
+
+    if ((p[0] != BTX_T_OPEN && p[0] != BTX_T_ACK && p[0] != BTX_T_CLOSE) || len > BX_CTL_MAX ||
+        h - bx_ctl_tail == BX_CTL_LEN)
+    {
+        bx_stats.rx_bad++;
+        return;
+    }
+    bx_ctl_t *c = &bx_ctl[h & (BX_CTL_LEN - 1U)];
+    c->len = (uint8_t)len;
+    memcpy(c->d, p, len);
+    __DMB();
+    bx_ctl_head = h + 1U;
+}
+
+static void bx_rx(UartRx_Port_t port, void *ctx, const uint8_t *data, uint16_t len)
+{
+    uint32_t h = bx_ctl_head;
+
+    /* 没有会话时文本行照常组装（JDY-31 状态输出、调试命令） */
+    if (!bx_busy && BT_Protocol.rx) BT_Protocol.rx(port, ctx, data, len);
+
+    Tlm_DecoderFeed(&bx_dec, data, len, NULL, NULL);
+    if (bx_ctl_head != h && bx_task) osThreadFlagsSet(bx_task, BX_FLAG_RX);
+}
+
+static void bx_tx_done(UartRx_Port_t port, void *ctx, uint32_t sent)
+{
+    (void)port;
+    (void)ctx;
+    (void)sent;
+    if (bx_busy && bx_task) osThreadFlagsSet(bx_task, BX_FLAG_TX);
+}
+
+static const Serial_Protocol_t bx_proto = {
+    .name    = "bt-xfer",
+    .rx      = bx_rx,
+    .tx_done = bx_tx_done,
+};
+
+static bool bx_ctl_pop(bx_ctl_t *c)
+{
+    uint32_t t = bx_ctl_tail;
+
+    if (t == bx_ctl_head) return false;
+    __DMB();
+    *c = bx_ctl[t & (BX_CTL_LEN - 1U)];
+    bx_ctl_tail = t + 1U;
+    return true;
+}
+
+/* ---- 发送 ---- */
+
+static bool bx_write(uint16_t len)
+{
+    uint16_t n = Tlm_FrameEncode(bx_frame, len, bx_hw_crc, bx_out, sizeof(bx_out));
+
+    if (n == 0 || Serial_Write(bx_port, bx_out, n, NULL) != 0) return false;
+    bx_stats.bytes += n;
+    return true;
+}
+
+static void bx_send_info(uint8_t status, uint32_t from)
+{
+    bx_frame[0] = BTX_T_INFO;
+    bx_frame[1] = bx.sess;
+    bx_frame[2] = status;
+    bx_frame[3] = BTX_WINDOW;
+    bx_put_le(&bx_frame[4], BTX_CHUNK, 2);
+    bx_put_le(&bx_frame[6], bx.chunks, 4);
+    bx_put_le(&bx_frame[10], from, 4);
+    bx_write(14);
+}
+
+static void bx_send_done(void)
+{
+    bx_frame[0] = BTX_T_DONE;
+    bx_frame[1] = bx.sess;
+    bx_put_le(&bx_frame[2], bx.chunks, 4);
+    bx_put_le(&bx_frame[6], bx.retx, 4);
+    bx_write(10);
+}
+
+static bool bx_send_chunk(uint32_t idx, uint32_t now)
+{
+    uint32_t off = idx * BTX_CHUNK;
+    uint32_t n = bx.len - off < BTX_CHUNK ? bx.len - off : BTX_CHUNK;
+
+    bx_frame[0] = BTX_T_DATA;
+    bx_frame[1] = bx.sess;
+    bx_put_le(&bx_frame[2], idx, 4);
+    W25Q128_Lock();   /* 与 CAN 传输、控制台、Flash 自检共用芯片 */
+    W25Q128_Read(&bx_frame[BTX_DATA_HDR], bx.addr + off, n);
+    W25Q128_Unlock();
+    if (!bx_write((uint16_t)(BTX_DATA_HDR + n))) return false;
+
+    bx.sent_seq[idx & BX_WMASK] = ++bx.seq;
+    bx.sent_at[idx & BX_WMASK] = now;
+    return true;
+}
+
+/* 发送缓冲放得下一整帧时持续填充：先重传，再发窗口内的新块 */
+static void bx_pump(uint32_t now)
+{
+    while (Serial_TxFree(bx_port) >= TLM_COBS_MAX)
+    {
+        if (bx.rtx)
+        {
+            uint32_t i = (uint32_t)__builtin_ctz(bx.rtx);
+            if (!bx_send_chunk(bx.base + i, now)) return;
+            bx.rtx &= ~(1UL << i);
+            bx.retx++;
+        }
+        else if (bx.next < bx.chunks && bx.next - bx.base < BTX_WINDOW)
+        {
+            uint32_t idx = bx.next;
+            if (!bx_send_chunk(idx, now)) return;
+            bx.next++;
+            bx_stats.chunks++;
+            bx_stats.payload += idx + 1U < bx.chunks ? BTX_CHUNK : bx.len - idx * BTX_CHUNK;
+        }
+        else
+        {
+            return;
+        }
+    }
+}
+
+/* 窗口左沿前移 k 块 */
+static void bx_slide(uint32_t k)
+{
+    if (k >= 32U)
+    {
+        bx.acked = 0;
+        bx.rtx = 0;
+    }
+    else
+    {
+        bx.acked >>= k;
+        bx.rtx >>= k;
+    }
+    bx.base += k;
+}
+
+static void bx_on_ack(uint32_t base, uint32_t map, uint32_t now)
+{
+    uint32_t inflight = bx.next - bx.base;
+    uint32_t hi = 0;
+
+    if (base > bx.next) return;
+    bx.last_ack = now;
+
+    /* 已确认块中最晚发出的一块，比它早发出而未确认的块已丢失 */
+    for (uint32_t i = bx.base; i < base; i++)
+        if (!(bx.acked & (1UL << (i - bx.base))) && bx.sent_seq[i & BX_WMASK] > hi) hi = bx.sent_seq[i & BX_WMASK];
+    if (base > bx.base)
+    {
+        bx_slide(base - bx.base);
+        inflight = bx.next - bx.base;
+    }
+
+    /* 过时的 ACK（base 小于当前窗口左沿）把位图对齐到当前窗口 */
+    uint32_t d = bx.base - base;
+    uint32_t rel = d > 32U ? 0U : (uint32_t)(((uint64_t)map << 1) >> d);
+    uint32_t valid = inflight >= 32U ? 0xFFFFFFFFUL : (1UL << inflight) - 1UL;
+    uint32_t newly = rel & valid & ~bx.acked;
+    for (uint32_t i = 1; i < inflight; i++)
+        if ((newly & (1UL << i)) && bx.sent_seq[(bx.base + i) & BX_WMASK] > hi) hi = bx.sent_seq[(bx.base + i) & BX_WMASK];
+    bx.acked |= newly;
+    bx.rtx &= ~bx.acked;
+
+    for (uint32_t i = 0; i < inflight; i++)
+    {
+        uint32_t bit = 1UL << i;
+        if (!(bx.acked & bit) && !(bx.rtx & bit) && bx.sent_seq[(bx.base + i) & BX_WMASK] < hi)
+        {
+            bx.rtx |= bit;
+            bx_stats.retx_fast++;
+        }
+    }
+
+    uint32_t k = 0;
+    while (k < inflight && (bx.acked & (1UL << k))) k++;
+    if (k) bx_slide(k);
+}
+
+static void bx_check_timeout(uint32_t now)
+{
+    uint32_t inflight = bx.next - bx.base;
+
+    for (uint32_t i = 0; i < inflight; i++)
+    {
+        uint32_t bit = 1UL << i;
+        if (!(bx.acked & bit) && !(bx.rtx & bit) && now - bx.sent_at[(bx.base + i) & BX_WMASK] >= BTX_RTO_MS)
+        {
+            bx.rtx |= bit;
+            bx_stats.retx_timeout++;
+        }
+    }
+}
+
+static void bx_open(const uint8_t *d, uint8_t len, uint32_t now)
+{
+    if (len < 14U) return;
+
+    uint32_t addr = bx_get_le(&d[2], 4);
+    uint32_t n = bx_get_le(&d[6], 4);
+    uint32_t from = bx_get_le(&d[10], 4);
+
+    bx.sess++;
+    bx.addr = addr;
+    bx.len = n;
+    bx.chunks = (n + BTX_CHUNK - 1U) / BTX_CHUNK;
+    if (d[1] != BTX_SRC_FLASH || n == 0 || addr >= W25Q128_TOTAL_SIZE || n > W25Q128_TOTAL_SIZE - addr || from > bx.chunks)
+    {
+        bx.chunks = 0;
+        bx.state = BX_IDLE;
+        bx_busy = 0;
+        bx_send_info(BTX_ST_PARAM, from);
+        return;
+    }
+
+    bx_stats.sessions++;
+    if (from) bx_stats.resumes++;
+    bx.base = bx.next = from;
+    bx.acked = bx.rtx = 0;
+    bx.retx = 0;
+    bx.last_ack = now;
+    bx.state = BX_SEND;
+    bx_busy = 1;
+    bx_send_info(BTX_ST_OK, from);
+}
+
+static void bx_close(void)
+{
+    bx.state = BX_IDLE;
+    bx_busy = 0;
+}
+
+static void bx_on_ctl(const bx_ctl_t *c, uint32_t now)
+{
+    switch (c->d[0])
+    {
+    case BTX_T_OPEN:
+        bx_open(c->d, c->len, now);
+        break;
+    case BTX_T_ACK:
+        if (c->len >= 10U && c->d[1] == bx.sess && bx.state == BX_SEND)
+            bx_on_ack(bx_get_le(&c->d[2], 4), bx_get_le(&c->d[6], 4), now);
+        break;
+    case BTX_T_CLOSE:
+        if (c->len >= 2U && c->d[1] == bx.sess) bx_close();
+        break;
+    default:
+        break;
+    }
+}
+
+/* 计数由接收中断与本模块任务更新，关中断复制保证各字段来自同一时刻 */
+void BtXfer_GetStats(BtXfer_Stats_t *stats)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    *stats = bx_stats;
+    stats->rx_bad += bx_dec.stats.crc_err + bx_dec.stats.cobs_err;
+    __set_PRIMASK(pm);
+}
+
+void BtXferTask(void *argument)
+{
+    bx_ctl_t c;
+    uint32_t done_at = 0;
+    int port;
+
+    bx_task = osThreadGetId();
+    Tlm_DecoderInit(&bx_dec);
+    Tlm_DecoderOnFrame(&bx_dec, bx_on_frame, NULL);
+
+    port = UartRx_PortOf(hBluetooth.huart);
+    if (port < 0 || BT_Init(&hBluetooth) != BT_OK) osThreadExit();
+    bx_port = (UartRx_Port_t)port;
+    if (Serial_Attach(bx_port, &bx_proto, NULL) != 0) osThreadExit();
+
+    for (;;)
+    {
+        osThreadFlagsWait(BX_FLAG_RX | BX_FLAG_TX, osFlagsWaitAny, BX_POLL_MS);
+        uint32_t now = osKernelGetTickCount();
+
+        while (bx_ctl_pop(&c)) bx_on_ctl(&c, now);
+
+        if (bx.state == BX_SEND)
+        {
+            if (BT_GetState(&hBluetooth) != BT_CONNECTED)
+            {
+                bx.state = BX_PAUSE;
+                bx_stats.disconnects++;
+            }
+            else if (now - bx.last_ack >= BTX_IDLE_MS)
+            {
+                bx.state = BX_PAUSE;
+                bx_stats.stalls++;
+            }
+            else if (bx.base == bx.chunks)
+            {
+                bx.state = BX_DONE;
+                bx.done_left = BTX_DONE_REPEAT;
+                done_at = now - BTX_RTO_MS;
+            }
+            else
+            {
+                bx_check_timeout(now);
+                bx_pump(now);
+            }
+        }
+
+        /* 暂停期间仍保留会话号，重连后上位机用新的 OPEN 续传，旧会话的 ACK 被忽略 */
+        if (bx.state == BX_DONE && now - done_at >= BTX_RTO_MS)
+        {
+            if (bx.done_left == 0)
+            {
+                bx_close();
+            }
+            else
+            {
+                bx_send_done();
+                bx.done_left--;
+                done_at = now;
+            }
+        }
+    }
+}
@@ -0,0 +1,757 @@
+/**
+ * @file    cannode.c
+ * @brief   CAN1 遥测与命令节点实现
+ *
+ * 过滤器匹配序号 (FMI) 按过滤器组顺序对组内每个过滤器编号（16 位列表 4 个、16 位掩码 2 个、
+ * 32 位列表 2 个、32 位掩码 1 个），与是否启用无关，所以使用的组从 0 开始连续分配，
+ * 未用完的列表位置重复本组最后一项，cn_fmi_map 由此直接把 FMI 映射回接收表项。
+ */
+#include "cannode.h"
+#include "cantp.h"
+#include "can.h"
+#include "snapshot.h"
+#include "sensorbus.h"
+#include "dlog.h"
+#include "cmsis_os2.h"
+#include <string.h>
+
+#define CN_FLAG_RX          0x01U
+#define CN_MAX_FMI          (CANNODE_FILTER_BANKS * 4U)
+#define CN_NO_ENTRY         0xFFU
+#define CN_POLL_MS          10U
+#define CN_PEER_TIMEOUT     (3U * CANNODE_HEARTBEAT_MS)
+#define CN_TEST_WAIT_MS     20U
+
+#define CN_IT  (CAN_IT_RX_FIFO0_MSG_PENDING | CAN_IT_RX_FIFO0_OVERRUN | CAN_IT_TX_MAILBOX_EMPTY | \
+                CAN_IT_ERROR_WARNING | CAN_IT_ERROR_PASSIVE | CAN_IT_BUSOFF | CAN_IT_ERROR)
+
+/* 遥测帧分组 */
+#define CN_TLM1             0x01U
+#define CN_TLM2             0x02U
+#define CN_TLM3             0x04U
+#define CN_TLM_ALL          (CN_TLM1 | CN_TLM2 | CN_TLM3)
+
+/* 过滤器种类，按此顺序装入过滤器组 */
+enum { CN_STD_LIST = 0, CN_STD_MASK, CN_EXT_LIST, CN_EXT_MASK, CN_KIND_NUM };
+static const uint8_t cn_per_bank[CN_KIND_NUM] = { 4, 2, 2, 1 };
+
+/* 接收队列：RX0 中断只写 head，CanTask 只写 tail */
+static CanNode_Frame_t cn_rxq[CANNODE_RXQ_LEN];
+static volatile uint32_t cn_rx_head = 0;
+static volatile uint32_t cn_rx_tail = 0;
+
+/* 软件发送队列，按仲裁优先级升序（关中断访问） */
+static CanNode_Frame_t cn_txq[CANNODE_TXQ_LEN];
+static uint8_t cn_txq_n = 0;
+
+static uint8_t cn_fmi_map[CN_MAX_FMI];
+static uint8_t cn_banks = 0;
+static volatile uint8_t cn_running = 0;
+static volatile uint8_t cn_busoff = 0;
+static volatile uint8_t cn_force_tlm = 0;
+static volatile uint16_t cn_period = CANNODE_TLM_PERIOD_MS;
+static uint8_t cn_selftest = 1;
+static osThreadId_t cn_task = NULL;
+static CanNode_Stats_t cn_stats;
+static uint32_t cn_peer_tick[128];
+
+static void cn_on_sync(const CanNode_Frame_t *f);
+static void cn_on_cmd(const CanNode_Frame_t *f);
+static void cn_on_heartbeat(const CanNode_Frame_t *f);
+
+const CanNode_Rx_t CanNode_RxTable[] = {
+    CAN_RX_STD(CANNODE_ID_SYNC, cn_on_sync),
+    CAN_RX_STD(CANNODE_ID_CMD, cn_on_cmd),
+    CAN_RX_STD(CANNODE_ID_CMD_ALL, cn_on_cmd),
+    CAN_RX_STD_MASK(CANNODE_ID_HEARTBEAT, 0x780U, cn_on_heartbeat),
+    CAN_RX_STD_MASK(CANTP_ID_RX_BASE, CANTP_ID_MASK, CanTp_OnFrame),
+};
+
+const uint8_t CanNode_RxTableSize = sizeof(CanNode_RxTable) / sizeof(CanNode_RxTable[0]);
+
+static uint32_t cn_lock(void)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    return pm;
+}
+
+static void cn_unlock(uint32_t pm)
+{
+    __set_PRIMASK(pm);
+}
+
+static void cn_put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void cn_put32(uint8_t *p, uint32_t v)
+{
+    cn_put16(p, (uint16_t)v);
+    cn_put16(p + 2, (uint16_t)(v >> 16));
+}
+
+/* ---- 过滤器 ---- */
+
+static uint8_t cn_kind(const CanNode_Rx_t *e)
+{
+    if (e->ext) return e->mask ? CN_EXT_MASK : CN_EXT_LIST;
+    return e->mask ? CN_STD_MASK : CN_STD_LIST;
+}
+
+/* 16 位格式：STID[10:0] RTR IDE EXID[17:15]；掩码同时要求 RTR = IDE = 0 */
+static uint16_t cn_std16(uint32_t id)
+{
+    return (uint16_t)((id & 0x7FFU) << 5);
+}
+
+static uint16_t cn_std16_mask(uint32_t mask)
+{
+    return (uint16_t)(cn_std16(mask) | 0x18U);
+}
+
+/* 32 位格式：EXID[28:0] IDE RTR 0；掩码同时要求 IDE = 1、RTR = 0 */
+static uint32_t cn_ext32(uint32_t id)
+{
+    return ((id & 0x1FFFFFFFU) << 3) | CAN_ID_EXT;
+}
+
+static uint32_t cn_ext32_mask(uint32_t mask)
+{
+    return ((mask & 0x1FFFFFFFU) << 3) | 0x6U;
+}
+
+/* 按 FMI 顺序把 slot 中的表项填入一个过滤器组 */
+static void cn_fill_bank(CAN_FilterTypeDef *f, uint8_t kind, const uint8_t *slot)
+{
+    const CanNode_Rx_t *e0 = &CanNode_RxTable[slot[0]];
+    const CanNode_Rx_t *e1 = &CanNode_RxTable[slot[1]];
+    uint32_t v0, v1;
+
+    switch (kind)
+    {
+    case CN_STD_LIST:
+        /* FR1 低半字、FR1 高半字、FR2 低半字、FR2 高半字 */
+        f->FilterMode = CAN_FILTERMODE_IDLIST;
+        f->FilterScale = CAN_FILTERSCALE_16BIT;
+        f->FilterIdLow = cn_std16(e0->id);
+        f->FilterMaskIdLow = cn_std16(e1->id);
+        f->FilterIdHigh = cn_std16(CanNode_RxTable[slot[2]].id);
+        f->FilterMaskIdHigh = cn_std16(CanNode_RxTable[slot[3]].id);
+        break;
+    case CN_STD_MASK:
+        /* FR1 = ID/掩码 0，FR2 = ID/掩码 1 */
+        f->FilterMode = CAN_FILTERMODE_IDMASK;
+        f->FilterScale = CAN_FILTERSCALE_16BIT;
+        f->FilterIdLow = cn_std16(e0->id);
+        f->FilterMaskIdLow = cn_std16_mask(e0->mask);
+        f->FilterIdHigh = cn_std16(e1->id);
+        f->FilterMaskIdHigh = cn_std16_mask(e1->mask);
+        break;
+    case CN_EXT_LIST:
+        v0 = cn_ext32(e0->id);
+        v1 = cn_ext32(e1->id);
+        f->FilterMode = CAN_FILTERMODE_IDLIST;
+        f->FilterScale = CAN_FILTERSCALE_32BIT;
+        f->FilterIdHigh = v0 >> 16;
+        f->FilterIdLow = v0 & 0xFFFFU;
+        f->FilterMaskIdHigh = v1 >> 16;
+        f->FilterMaskIdLow = v1 & 0xFFFFU;
+        break;
+    default:
+        v0 = cn_ext32(e0->id);
+        v1 = cn_ext32_mask(e0->mask);
+        f->FilterMode = CAN_FILTERMODE_IDMASK;
+        f->FilterScale = CAN_FILTERSCALE_32BIT;
+        f->FilterIdHigh = v0 >> 16;
+        f->FilterIdLow = v0 & 0xFFFFU;
+        f->FilterMaskIdHigh = v1 >> 16;
+        f->FilterMaskIdLow = v1 & 0xFFFFU;
+        break;
+    }
+}
+
+static int cn_config_filters(void)
+{
+    CAN_FilterTypeDef f = {0};
+    uint8_t bank = 0, fmi = 0;
+
+    memset(cn_fmi_map, CN_NO_ENTRY, sizeof(cn_fmi_map));
+    f.FilterFIFOAssignment = CAN_FILTER_FIFO0;
+    f.SlaveStartFilterBank = CANNODE_FILTER_BANKS;
+    f.FilterActivation = CAN_FILTER_ENABLE;
+
+    for (uint8_t k = 0; k < CN_KIND_NUM; k++)
+    {
+        uint8_t per = cn_per_bank[k];
+        uint8_t slot[4];
+        uint8_t n = 0;
+
+        for (uint8_t i = 0; i <= CanNode_RxTableSize; i++)
+        {
+            bool last = (i == CanNode_RxTableSize);
+
+            if (!last && cn_kind(&CanNode_RxTable[i]) == k) slot[n++] = i;
+            if (n == 0 || (n < per && !last)) continue;
+            if (bank >= CANNODE_FILTER_BANKS) return 1;
+
+            while (n < per)
+            {
+                slot[n] = slot[n - 1U];
+                n++;
+            }
+            cn_fill_bank(&f, k, slot);
+            f.FilterBank = bank++;
+            if (HAL_CAN_ConfigFilter(&hcan1, &f) != HAL_OK) return 1;
+            for (uint8_t s = 0; s < per; s++) cn_fmi_map[fmi++] = slot[s];
+            n = 0;
+        }
+    }
+    cn_banks = bank;
+
+    /* 其余过滤器组关闭（排在已用组之后，不影响 FMI 编号） */
+    f.FilterActivation = CAN_FILTER_DISABLE;
+    for (; bank < CANNODE_FILTER_BANKS; bank++)
+    {
+        f.FilterBank = bank;
+        if (HAL_CAN_ConfigFilter(&hcan1, &f) != HAL_OK) return 1;
+    }
+    return 0;
+}
+
+/* ---- 接收 ---- */
+
+/* RX0 中断：一次取空 FIFO0（硬件只有 3 级） */
+void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan)
+{
+    CAN_RxHeaderTypeDef h;
+    uint8_t discard[8];
+    uint32_t n = 0;
+
+    if (hcan->Instance != CAN1) return;
+
+    while (HAL_CAN_GetRxFifoFillLevel(hcan, CAN_RX_FIFO0) > 0U)
+    {
+        uint32_t head = cn_rx_head;
+        bool full = (head - cn_rx_tail) >= CANNODE_RXQ_LEN;
+        CanNode_Frame_t *f = &cn_rxq[head & (CANNODE_RXQ_LEN - 1U)];
+
+        /* 队列满也要读出，释放 FIFO 位置 */
+        if (HAL_CAN_GetRxMessage(hcan, CAN_RX_FIFO0, &h, full ? discard : f->data) != HAL_OK) break;
+        if (full)
+        {
+            cn_stats.rx_overflow++;
+            continue;
+        }
+
+        f->ext = (h.IDE == CAN_ID_EXT);
+        f->id = f->ext ? h.ExtId : h.StdId;
+        f->dlc = (uint8_t)(h.DLC > 8U ? 8U : h.DLC);
+        f->entry = h.FilterMatchIndex < CN_MAX_FMI ? cn_fmi_map[h.FilterMatchIndex] : CN_NO_ENTRY;
+        __DMB();
+        cn_rx_head = head + 1U;
+        cn_stats.rx_frames++;
+        n++;
+    }
+
+    if (n && cn_task) osThreadFlagsSet(cn_task, CN_FLAG_RX);
+}
+
+static bool cn_rx_pop(CanNode_Frame_t *out)
+{
+    uint32_t tail = cn_rx_tail;
+
+    if (tail == cn_rx_head) return false;
+    __DMB();
+    *out = cn_rxq[tail & (CANNODE_RXQ_LEN - 1U)];
+    __DMB();
+    cn_rx_tail = tail + 1U;
+    return true;
+}
+
+/* ---- 发送 ---- */
+
+/* 总线仲裁顺序：先比较 11 位基本 ID，相同时标准帧优先于扩展帧 */
+static uint32_t cn_prio(const CanNode_Frame_t *f)
+{
+    return f->ext ? ((f->id << 1) | 1U) : (f->id << 19);
+}
+
+static bool cn_mailbox(const CanNode_Frame_t *f)
+{
+    CAN_TxHeaderTypeDef h = {
+        .StdId = f->ext ? 0U : f->id,
+        .ExtId = f->ext ? f->id : 0U,
+        .IDE = f->ext ? CAN_ID_EXT : CAN_ID_STD,
+        .RTR = CAN_RTR_DATA,
+        .DLC = f->dlc,
+        .TransmitGlobalTime = DISABLE,
+    };
+    uint32_t mb;
+
+    return HAL_CAN_AddTxMessage(&hcan1, &h, (uint8_t *)f->data, &mb) == HAL_OK;
+}
+
+/* 邮箱有空位时依次补入优先级最高的帧（调用方已关中断） */
+static void cn_tx_feed(void)
+{
+    uint8_t k = 0;
+
+    while (k < cn_txq_n && HAL_CAN_GetTxMailboxesFreeLevel(&hcan1) > 0U)
+    {
+        if (!cn_mailbox(&cn_txq[k])) break;
+        k++;
+    }
+    if (k)
+    {
+        cn_txq_n -= k;
+        memmove(cn_txq, &cn_txq[k], cn_txq_n * sizeof(cn_txq[0]));
+    }
+}
+
+/* 按优先级插入（同 ID 保持先后），队列满时丢弃优先级最低的一帧 */
+static int cn_txq_insert(const CanNode_Frame_t *f)
+{
+    uint32_t p = cn_prio(f);
+    uint8_t pos = cn_txq_n;
+
+    if (cn_txq_n == CANNODE_TXQ_LEN)
+    {
+        if (p >= cn_prio(&cn_txq[CANNODE_TXQ_LEN - 1U])) return 1;
+        cn_txq_n--;
+        cn_stats.tx_dropped++;
+        pos = cn_txq_n;
+    }
+    while (pos > 0 && cn_prio(&cn_txq[pos - 1U]) > p) pos--;
+    memmove(&cn_txq[pos + 1U], &cn_txq[pos], (cn_txq_n - pos) * sizeof(cn_txq[0]));
+    cn_txq[pos] = *f;
+    cn_txq_n++;
+    return 0;
+}
+
+int CanNode_Send(uint32_t id, bool ext, const uint8_t *data, uint8_t len)
+{
+    CanNode_Frame_t f = { .id = id, .ext = ext, .dlc = len };
+    int ret = 1;
+
+    if (len > 8U) return 1;
+    if (len) memcpy(f.data, data, len);
+
+    uint32_t pm = cn_lock();
+    if (cn_running && !cn_busoff && cn_txq_insert(&f) == 0)
+    {
+        cn_tx_feed();
+        ret = 0;
+    }
+    if (ret) cn_stats.tx_dropped++;
+    cn_unlock(pm);
+    return ret;
+}
+
+uint8_t CanNode_TxFree(void)
+{
+    uint32_t pm = cn_lock();
+    uint8_t n = (uint8_t)(CANNODE_TXQ_LEN - cn_txq_n + (cn_running ? HAL_CAN_GetTxMailboxesFreeLevel(&hcan1) : 0U));
+    cn_unlock(pm);
+    return n;
+}
+
+static void cn_tx_done(CAN_HandleTypeDef *hcan, bool ok)
+{
+    if (hcan->Instance != CAN1) return;
+
+    uint32_t pm = cn_lock();
+    if (ok) cn_stats.tx_frames++;
+    else cn_stats.tx_dropped++;
+    cn_tx_feed();
+    cn_unlock(pm);
+}
+
+void HAL_CAN_TxMailbox0CompleteCallback(CAN_HandleTypeDef *hcan) { cn_tx_done(hcan, true); }
+void HAL_CAN_TxMailbox1CompleteCallback(CAN_HandleTypeDef *hcan) { cn_tx_done(hcan, true); }
+void HAL_CAN_TxMailbox2CompleteCallback(CAN_HandleTypeDef *hcan) { cn_tx_done(hcan, true); }
+void HAL_CAN_TxMailbox0AbortCallback(CAN_HandleTypeDef *hcan) { cn_tx_done(hcan, false); }
+void HAL_CAN_TxMailbox1AbortCallback(CAN_HandleTypeDef *hcan) { cn_tx_done(hcan, false); }
+void HAL_CAN_TxMailbox2AbortCallback(CAN_HandleTypeDef *hcan) { cn_tx_done(hcan, false); }
+
+/* ---- 错误 ---- */
+
+/* SCE（状态变化）、TX（发送失败）、RX0（FIFO 溢出）中断都经 HAL 汇总到这里 */
+void HAL_CAN_ErrorCallback(CAN_HandleTypeDef *hcan)
+{
+    if (hcan->Instance != CAN1) return;
+
+    uint32_t pm = cn_lock();
+    uint32_t err = HAL_CAN_GetError(hcan);
+    HAL_CAN_ResetError(hcan);
+
+    uint32_t esr = hcan->Instance->ESR;
+    uint32_t tec = (esr & CAN_ESR_TEC) >> CAN_ESR_TEC_Pos, rec = (esr & CAN_ESR_REC) >> CAN_ESR_REC_Pos;
+
+    if (err & HAL_CAN_ERROR_EWG) cn_stats.warnings++;
+    if (err & HAL_CAN_ERROR_EPV)
+    {
+        cn_stats.passives++;
+        LOG_W("can error passive tec=%u rec=%u", tec, rec);
+    }
+    if (err & HAL_CAN_ERROR_RX_FOV0)
+    {
+        cn_stats.rx_fifo_overrun++;
+        LOG_W("can rx fifo overrun");
+    }
+    if (err & (HAL_CAN_ERROR_TX_ALST0 | HAL_CAN_ERROR_TX_TERR0)) cn_stats.tx_errors++;
+    if (err & (HAL_CAN_ERROR_TX_ALST1 | HAL_CAN_ERROR_TX_TERR1)) cn_stats.tx_errors++;
+    if (err & (HAL_CAN_ERROR_TX_ALST2 | HAL_CAN_ERROR_TX_TERR2)) cn_stats.tx_errors++;
+
+    if (err & HAL_CAN_ERROR_BOF)
+    {
+        /* 离线期间不再接受新帧，已排队的快照恢复后已过期，全部丢弃 */
+        cn_busoff = 1;
+        cn_stats.busoffs++;
+        LOG_E("can bus-off tec=%u rec=%u, %u queued frames dropped", tec, rec, (uint32_t)cn_txq_n);
+        cn_stats.tx_dropped += cn_txq_n;
+        cn_txq_n = 0;
+        HAL_CAN_AbortTxRequest(hcan, CAN_TX_MAILBOX0 | CAN_TX_MAILBOX1 | CAN_TX_MAILBOX2);
+    }
+    else
+    {
+        cn_tx_feed();
+    }
+    cn_unlock(pm);
+}
+
+/* 硬件自动恢复后 ESR.BOFF 清零，没有对应中断，由任务轮询 */
+static void cn_check_busoff(void)
+{
+    if (cn_busoff && (hcan1.Instance->ESR & CAN_ESR_BOFF) == 0U)
+    {
+        cn_busoff = 0;
+        cn_stats.recoveries++;
+        LOG_I("can bus-off recovered");
+    }
+}
+
+static uint8_t cn_state(uint32_t esr)
+{
+    if (esr & CAN_ESR_BOFF) return CANNODE_BUSOFF;
+    if (esr & CAN_ESR_EPVF) return CANNODE_PASSIVE;
+    if (esr & CAN_ESR_EWGF) return CANNODE_WARNING;
+    return CANNODE_ACTIVE;
+}
+
+void CanNode_GetStats(CanNode_Stats_t *stats)
+{
+    if (stats == NULL) return;
+
+    uint32_t pm = cn_lock();
+    *stats = cn_stats;
+    cn_unlock(pm);
+
+    uint32_t esr = hcan1.Instance->ESR;
+    uint32_t now = osKernelGetTickCount();
+
+    stats->state = cn_state(esr);
+    stats->tec = (uint8_t)((esr & CAN_ESR_TEC) >> CAN_ESR_TEC_Pos);
+    stats->rec = (uint8_t)((esr & CAN_ESR_REC) >> CAN_ESR_REC_Pos);
+    stats->lec = (uint8_t)((esr & CAN_ESR_LEC) >> CAN_ESR_LEC_Pos);
+    stats->banks = cn_banks;
+    stats->selftest = cn_selftest;
+    stats->peers = 0;
+    for (uint8_t i = 0; i < 128U; i++)
+        if (cn_peer_tick[i] && now - cn_peer_tick[i] < CN_PEER_TIMEOUT) stats->peers++;
+}
+
+void CanNode_SetPeriod(uint16_t period_ms)
+{
+    cn_period = period_ms;
+}
+
+/* ---- 启动 ---- */
+
+int CanNode_Start(void)
+{
+    cn_running = 0;
+    if (cn_config_filters() != 0) return 1;
+
+    cn_rx_head = 0;
+    cn_rx_tail = 0;
+    cn_txq_n = 0;
+    cn_busoff = 0;
+    if (HAL_CAN_ActivateNotification(&hcan1, CN_IT) != HAL_OK) return 1;
+    if (HAL_CAN_Start(&hcan1) != HAL_OK) return 1;
+    cn_running = 1;
+    return 0;
+}
+
+/* 停止并以 mode 重新初始化（保持 READY 状态，过滤器不变） */
+static int cn_reinit(uint32_t mode)
+{
+    cn_running = 0;
+    HAL_CAN_DeactivateNotification(&hcan1, CN_IT);
+    if (hcan1.State == HAL_CAN_STATE_LISTENING) HAL_CAN_Stop(&hcan1);
+    hcan1.Init.Mode = mode;
+    return HAL_CAN_Init(&hcan1) == HAL_OK ? 0 : 1;
+}
+
+/* ---- 遥测与命令 ---- */
+
+/* 快照字段 × scale 四舍五入并饱和到 [lo, hi]，未采到数据返回 none */
+static int32_t cn_fix(const SensorSnapshot_t *s, snap_field_t fld, float scale, int32_t lo, int32_t hi, int32_t none)
+{
+    if (s == NULL || s->f[fld].status == SNAP_ST_NONE) return none;
+
+    float v = s->f[fld].value * scale;
+    v += v >= 0.0f ? 0.5f : -0.5f;
+    if (v <= (float)lo) return lo;
+    if (v >= (float)hi) return hi;
+    return (int32_t)v;
+}
+
+static uint8_t cn_groups(uint32_t valid)
+{
+    uint8_t g = 0;
+
+    if (valid & (SENSORBUS_CH(SNAP_T1) | SENSORBUS_CH(SNAP_T2) | SENSORBUS_CH(SNAP_H) | SENSORBUS_CH(SNAP_A))) g |= CN_TLM1;
+    if (valid & (SENSORBUS_CH(SNAP_L) | SENSORBUS_CH(SNAP_P))) g |= CN_TLM2;
+    if (valid) g |= CN_TLM3;
+    return g;
+}
+
+/* 同一快照生成的几帧连续提交，由邮箱按 ID 排序发出 */
+static void cn_send_tlm(uint8_t groups)
+{
+    SensorSnapshot_t s;
+    const SensorSnapshot_t *sp = Snapshot_Read(0, &s) ? &s : NULL;
+    uint8_t d[8];
+
+    if (groups & CN_TLM1)
+    {
+        cn_put16(&d[0], (uint16_t)cn_fix(sp, SNAP_T1, 100.0f, -32767, 32767, -32768));
+        cn_put16(&d[2], (uint16_t)cn_fix(sp, SNAP_T2, 100.0f, -32767, 32767, -32768));
+        cn_put16(&d[4], (uint16_t)cn_fix(sp, SNAP_H, 100.0f, 0, 65534, 65535));
+        cn_put16(&d[6], (uint16_t)cn_fix(sp, SNAP_A, 10.0f, -32767, 32767, -32768));
+        CanNode_Send(CANNODE_ID_TLM1, false, d, 8);
+    }
+    if (groups & CN_TLM2)
+    {
+        cn_put32(&d[0], (uint32_t)cn_fix(sp, SNAP_L, 10.0f, 0, INT32_MAX, -1));
+        cn_put32(&d[4], (uint32_t)cn_fix(sp, SNAP_P, 10.0f, 0, INT32_MAX, -1));
+        CanNode_Send(CANNODE_ID_TLM2, false, d, 8);
+    }
+    if (groups & CN_TLM3)
+    {
+        uint16_t st = 0;
+        for (uint8_t f = 0; sp && f < SNAP_FIELD_NUM; f++)
+        {
+            if (sp->f[f].status == SNAP_ST_OK) st |= (uint16_t)(1U << f);
+            else if (sp->f[f].status == SNAP_ST_ERROR) st |= (uint16_t)(1U << (8U + f));
+        }
+        cn_put16(&d[0], (uint16_t)cn_fix(sp, SNAP_D, 10.0f, 0, 65534, 65535));
+        cn_put16(&d[2], st);
+        cn_put32(&d[4], sp ? sp->version : 0U);
+        CanNode_Send(CANNODE_ID_TLM3, false, d, 8);
+    }
+}
+
+static void cn_heartbeat(void)
+{
+    uint32_t esr = hcan1.Instance->ESR;
+    uint8_t d[8] = {
+        cn_state(esr),
+        (uint8_t)((esr & CAN_ESR_TEC) >> CAN_ESR_TEC_Pos),
+        (uint8_t)((esr & CAN_ESR_REC) >> CAN_ESR_REC_Pos),
+        0,
+    };
+
+    cn_put32(&d[4], osKernelGetTickCount() / 1000U);
+    CanNode_Send(CANNODE_ID_HEARTBEAT + CANNODE_NODE_ID, false, d, 8);
+}
+
+static void cn_on_sync(const CanNode_Frame_t *f)
+{
+    (void)f;
+    cn_force_tlm = 1;
+}
+
+static void cn_on_heartbeat(const CanNode_Frame_t *f)
+{
+    uint8_t node = (uint8_t)(f->id & 0x7FU);
+
+    /* 0 表示从未收到 */
+    if (node != CANNODE_NODE_ID) cn_peer_tick[node] = osKernelGetTickCount() | 1U;
+}
+
+static void cn_on_cmd(const CanNode_Frame_t *f)
+{
+    uint8_t r[8] = {0};
+    uint8_t len = 2;
+    CanNode_Stats_t st;
+
+    if (f->dlc == 0) return;
+    r[0] = f->data[0];
+
+    switch (f->data[0])
+    {
+    case CANNODE_CMD_PING:
+        cn_put32(&r[2], Snapshot_Version());
+        len = 6;
+        break;
+    case CANNODE_CMD_STATS:
+        CanNode_GetStats(&st);
+        r[2] = st.state;
+        r[3] = st.tec;
+        r[4] = st.rec;
+        r[5] = (uint8_t)(st.busoffs > 255U ? 255U : st.busoffs);
+        cn_put16(&r[6], (uint16_t)(st.rx_overflow > 65535U ? 65535U : st.rx_overflow));
+        len = 8;
+        break;
+    case CANNODE_CMD_PERIOD:
+        if (f->dlc < 3U) r[1] = 2;
+        else CanNode_SetPeriod((uint16_t)(f->data[1] | (f->data[2] << 8)));
+        break;
+    case CANNODE_CMD_TLM:
+        cn_force_tlm = 1;
+        break;
+    default:
+        r[1] = 1;
+        break;
+    }
+
+    if (f->id != CANNODE_ID_CMD_ALL) CanNode_Send(CANNODE_ID_RESP, false, r, len);
+}
+
+void CanTask(void *argument)
+{
+    const SensorBus_SubCfg_t cfg = {
+        .channels = SENSORBUS_CH_ALL,
+        .period_ms = 0,
+        .policy = SENSORBUS_LATEST,
+        .queue_len = 2,
+    };
+    SensorBus_Record_t rec;
+    CanNode_Frame_t f;
+    uint8_t pending = 0;
+    uint32_t last_tlm = 0, last_hb, wait = CN_POLL_MS;
+    int sub = SensorBus_Subscribe(&cfg);
+
+    cn_task = osThreadGetId();
+    cn_selftest = CanNode_Test();
+    if (cn_selftest) LOG_E("can self-test FAIL");
+    else             LOG_I("can self-test PASS");
+    CanTp_Init();
+    if (CanNode_Start() != 0)
+    {
+        LOG_E("can start failed");
+        osThreadExit();
+    }
+    last_hb = osKernelGetTickCount() - CANNODE_HEARTBEAT_MS;
+
+    for (;;)
+    {
+        osThreadFlagsWait(CN_FLAG_RX, osFlagsWaitAny, wait);
+
+        while (cn_rx_pop(&f))
+        {
+            if (f.entry < CanNode_RxTableSize && CanNode_RxTable[f.entry].handler)
+                CanNode_RxTable[f.entry].handler(&f);
+        }
+
+        while (sub >= 0 && SensorBus_Receive(sub, &rec, 0)) pending |= cn_groups(rec.valid);
+
+        uint32_t now = osKernelGetTickCount();
+        if (cn_force_tlm)
+        {
+            cn_force_tlm = 0;
+            pending = CN_TLM_ALL;
+            last_tlm = now - cn_period;
+        }
+        if (pending && now - last_tlm >= cn_period)
+        {
+            cn_send_tlm(pending);
+            pending = 0;
+            last_tlm = now;
+        }
+        if (now - last_hb >= CANNODE_HEARTBEAT_MS)
+        {
+            cn_heartbeat();
+            last_hb = now;
+        }
+        cn_check_busoff();
+
+        /* ISO-TP 传输进行中时按其时刻表缩短等待 */
+        wait = CanTp_Poll();
+        if (wait > CN_POLL_MS) wait = CN_POLL_MS;
+    }
+}
+
+/* ---- 自检 ---- */
+
+static bool cn_test_recv(CanNode_Frame_t *f)
+{
+    uint32_t t0 = osKernelGetTickCount();
+
+    do {
+        if (cn_rx_pop(f)) return true;
+        osDelay(1);
+    } while (osKernelGetTickCount() - t0 < CN_TEST_WAIT_MS);
+    return false;
+}
+
+uint8_t CanNode_Test(void)
+{
+    static const uint8_t pat[8] = { 0x00, 0x5A, 0xA5, 0x3C, 0xC3, 0x0F, 0xF0, 0x7E };
+    CanNode_Frame_t f;
+    uint8_t d[8];
+    uint8_t fail = 0;
+
+    if (cn_reinit(CAN_MODE_SILENT_LOOPBACK) != 0 || CanNode_Start() != 0) fail = 1;
+
+    /* 1. 表内每一项（掩码项取其 id）都能收到，FMI 指回该项，内容一致 */
+    for (uint8_t i = 0; i < CanNode_RxTableSize && !fail; i++)
+    {
+        const CanNode_Rx_t *e = &CanNode_RxTable[i];
+
+        memcpy(d, pat, sizeof(d));
+        d[0] = i;
+        if (CanNode_Send(e->id, e->ext, d, (uint8_t)(1U + i % 8U)) != 0 || !cn_test_recv(&f) ||
+            f.id != e->id || f.ext != e->ext || f.entry != i || f.dlc != 1U + i % 8U ||
+            memcmp(f.data, d, f.dlc) != 0)
+            fail = 1;
+    }
+
+    /* 2. 表外 ID 被滤除：相邻的标准帧、同值的扩展帧 */
+    if (!fail)
+    {
+        CanNode_Send(CANNODE_ID_CMD + 0x10U, false, pat, 8);
+        CanNode_Send(CANNODE_ID_CMD, true, pat, 8);
+        CanNode_Send(CANNODE_ID_SYNC + 1U, false, pat, 8);
+        if (cn_test_recv(&f)) fail = 1;
+    }
+
+    /* 3. 一次提交 6 帧（ID 递减），后 3 帧进入软件队列，必须按 ID 递增发出 */
+    if (!fail)
+    {
+        static const uint32_t ids[6] = { 0x70E, 0x70D, 0x70C, 0x70B, 0x70A, 0x709 };
+        int8_t pos[6] = { -1, -1, -1, -1, -1, -1 };
+
+        uint32_t pm = cn_lock();
+        for (uint8_t k = 0; k < 6U; k++)
+            if (CanNode_Send(ids[k], false, pat, 8) != 0) fail = 1;
+        cn_unlock(pm);
+
+        for (int8_t n = 0; n < 6 && !fail; n++)
+        {
+            if (!cn_test_recv(&f)) fail = 1;
+            for (uint8_t k = 0; k < 6U; k++)
+                if (f.id == ids[k]) pos[k] = n;
+        }
+        if (pos[0] < 0 || pos[1] < 0 || pos[2] < 0 || !(pos[5] >= 0 && pos[5] < pos[4] && pos[4] < pos[3]))
+            fail = 1;
+    }
+
+    if (cn_reinit(CAN_MODE_NORMAL) != 0) fail = 1;
+    memset(&cn_stats, 0, sizeof(cn_stats));
+    return fail;
+}
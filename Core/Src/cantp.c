@@ -0,0 +1,254 @@
+/**
+ * @file    cantp.c
+ * @brief   CAN1 ISO-TP 服务通道实现
+ *
+ * 只在 CanTask 中运行，不需要加锁。Flash 读写都在分段回调中同步进行，
+ * 扇区擦除期间（最长约 400ms）对端按流控暂停，接收队列容得下一个块。
+ */
+#include "cantp.h"
+#include "flash.h"
+#include "cmsis_os2.h"
+#include <string.h>
+
+typedef struct {
+    uint32_t addr;          /* Flash 当前读写地址 */
+    uint32_t left;          /* 读出：剩余字节 */
+    uint8_t  status;        /* 写入：CANTP_ST_* */
+} ct_flash_t;
+
+static IsoTp_Link_t ct_link[CANTP_CHANNELS];
+static IsoTp_Config_t ct_cfg[CANTP_CHANNELS];
+static uint8_t ct_echo[CANTP_ECHO_MAX];
+static uint8_t ct_req[8];
+static uint8_t ct_rd_buf[CANTP_CHUNK];
+static uint8_t ct_wr_buf[CANTP_CHUNK];
+static uint8_t ct_ack[4];
+static ct_flash_t ct_rd, ct_wr;
+
+static uint32_t ct_now_us(void)
+{
+    return osKernelGetTickCount() * 1000U;
+}
+
+static uint32_t ct_get24(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+}
+
+static void ct_put24(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+}
+
+static int ct_can_tx(void *ctx, uint32_t id, const uint8_t *data, uint8_t len)
+{
+    (void)ctx;
+    if (CanNode_TxFree() <= CANTP_TX_RESERVE) return 1;
+    return CanNode_Send(id, false, data, len);
+}
+
+/* ---- ch0 回显 ---- */
+
+static void ct_echo_rx_done(IsoTp_Link_t *l, isotp_result_t r, uint32_t len)
+{
+    if (r != ISOTP_OK) return;
+
+    /* 发回期间不接收新消息（对端会收到溢出流控），发完再恢复缓冲 */
+    IsoTp_SetRxBuffer(l, NULL, 0);
+    if (IsoTp_Send(l, ct_echo, len, len, ct_now_us()) != ISOTP_OK)
+        IsoTp_SetRxBuffer(l, ct_echo, sizeof(ct_echo));
+}
+
+static void ct_echo_tx_done(IsoTp_Link_t *l, isotp_result_t r, uint32_t len)
+{
+    (void)r;
+    (void)len;
+    IsoTp_SetRxBuffer(l, ct_echo, sizeof(ct_echo));
+}
+
+/* ---- ch1 Flash 读出 ---- */
+
+static bool ct_rd_seg(IsoTp_Link_t *l, const uint8_t *done, uint32_t n, uint8_t **next, uint32_t *size)
+{
+    uint32_t k = ct_rd.left < CANTP_CHUNK ? ct_rd.left : CANTP_CHUNK;
+
+    (void)l;
+    (void)done;
+    (void)n;
+    if (k == 0) return false;
+    W25Q128_Lock();
+    W25Q128_Read(ct_rd_buf, ct_rd.addr, k);
+    W25Q128_Unlock();
+    ct_rd.addr += k;
+    ct_rd.left -= k;
+    *next = ct_rd_buf;
+    *size = k;
+    return true;
+}
+
+static void ct_rd_rx_done(IsoTp_Link_t *l, isotp_result_t r, uint32_t len)
+{
+    uint32_t addr = ct_get24(&ct_req[0]);
+    uint32_t n = ct_get24(&ct_req[3]);
+
+    if (r != ISOTP_OK || IsoTp_TxBusy(l)) return;
+
+    if (len != 6U || n == 0 || addr >= W25Q128_TOTAL_SIZE || n > W25Q128_TOTAL_SIZE - addr)
+    {
+        ct_rd_buf[0] = CANTP_ST_PARAM;
+        IsoTp_Send(l, ct_rd_buf, 1, 1, ct_now_us());
+        return;
+    }
+
+    /* 第一段为状态字节加数据开头，其余由 ct_rd_seg 逐段读出 */
+    uint32_t k = n < CANTP_CHUNK - 1U ? n : CANTP_CHUNK - 1U;
+    ct_rd_buf[0] = CANTP_ST_OK;
+    W25Q128_Lock();
+    W25Q128_Read(&ct_rd_buf[1], addr, k);
+    W25Q128_Unlock();
+    ct_rd.addr = addr + k;
+    ct_rd.left = n - k;
+    IsoTp_Send(l, ct_rd_buf, 1U + k, 1U + n, ct_now_us());
+}
+
+/* ---- ch2 Flash 写入 ---- */
+
+static void ct_wr_put(const uint8_t *p, uint32_t n)
+{
+    while (n && ct_wr.status == CANTP_ST_OK)
+    {
+        uint32_t off = ct_wr.addr % W25Q128_SECTOR_SIZE;
+        uint32_t k = W25Q128_SECTOR_SIZE - off;
+
+        if (ct_wr.addr + n > W25Q128_TOTAL_SIZE)
+        {
+            ct_wr.status = CANTP_ST_PARAM;
+            return;
+        }
+        if (k > n) k = n;
+        W25Q128_Lock();   /* 每个扇区的擦除与写入在锁内完成 */
+        if (off == 0) W25Q128_EraseSector(ct_wr.addr);
+        W25Q128_WriteNoCheck(p, ct_wr.addr, k);
+        W25Q128_Unlock();
+        ct_wr.addr += k;
+        p += k;
+        n -= k;
+    }
+}
+
+/* 把 p/n 写入 Flash，first 表示消息开头（前 3 字节为地址） */
+static void ct_wr_chunk(const uint8_t *p, uint32_t n, bool first)
+{
+    if (first)
+    {
+        ct_wr.status = CANTP_ST_OK;
+        ct_wr.left = 0;
+        if (n < 3U)
+        {
+            ct_wr.status = CANTP_ST_PARAM;
+            return;
+        }
+        ct_wr.addr = ct_get24(p);
+        if (ct_wr.addr % W25Q128_SECTOR_SIZE != 0U) ct_wr.status = CANTP_ST_PARAM;
+        p += 3;
+        n -= 3U;
+    }
+    ct_wr_put(p, n);
+    ct_wr.left += n;
+}
+
+static bool ct_wr_seg(IsoTp_Link_t *l, const uint8_t *done, uint32_t n, uint8_t **next, uint32_t *size)
+{
+    ct_wr_chunk(done, n, l->rx_got == n);
+    *next = ct_wr_buf;
+    *size = sizeof(ct_wr_buf);
+    return ct_wr.status == CANTP_ST_OK;
+}
+
+static void ct_wr_rx_done(IsoTp_Link_t *l, isotp_result_t r, uint32_t len)
+{
+    /* 最后一段（可能就是第一段）还留在缓冲中 */
+    uint32_t tail = len % CANTP_CHUNK;
+
+    if (r == ISOTP_OK)
+    {
+        if (tail == 0 && len) tail = CANTP_CHUNK;
+        ct_wr_chunk(ct_wr_buf, tail, len <= CANTP_CHUNK);
+    }
+    else if (len <= CANTP_CHUNK)
+    {
+        /* 还没处理过第一段，ct_wr 仍是上一条消息的结果 */
+        ct_wr.status = CANTP_ST_XFER;
+        ct_wr.left = 0;
+    }
+    else if (ct_wr.status == CANTP_ST_OK)
+    {
+        ct_wr.status = CANTP_ST_XFER;
+    }
+
+    if (IsoTp_TxBusy(l)) return;
+    ct_ack[0] = ct_wr.status;
+    ct_put24(&ct_ack[1], ct_wr.left);
+    IsoTp_Send(l, ct_ack, sizeof(ct_ack), sizeof(ct_ack), ct_now_us());
+}
+
+/* ---- 公共接口 ---- */
+
+void CanTp_Init(void)
+{
+    for (uint8_t ch = 0; ch < CANTP_CHANNELS; ch++)
+    {
+        IsoTp_Config_t *c = &ct_cfg[ch];
+
+        memset(c, 0, sizeof(*c));
+        c->tx_id = CANTP_ID_TX_BASE + ch;
+        c->rx_id = CANTP_ID_RX_BASE + ch;
+        c->bs = CANTP_BS;
+        c->stmin = 0;
+        c->can_tx = ct_can_tx;
+        IsoTp_Init(&ct_link[ch], c);
+    }
+
+    ct_cfg[CANTP_CH_ECHO].rx_done = ct_echo_rx_done;
+    ct_cfg[CANTP_CH_ECHO].tx_done = ct_echo_tx_done;
+    IsoTp_SetRxBuffer(&ct_link[CANTP_CH_ECHO], ct_echo, sizeof(ct_echo));
+
+    ct_cfg[CANTP_CH_FLASH_READ].rx_done = ct_rd_rx_done;
+    ct_cfg[CANTP_CH_FLASH_READ].tx_seg = ct_rd_seg;
+    IsoTp_SetRxBuffer(&ct_link[CANTP_CH_FLASH_READ], ct_req, sizeof(ct_req));
+
+    ct_cfg[CANTP_CH_FLASH_WRITE].rx_done = ct_wr_rx_done;
+    ct_cfg[CANTP_CH_FLASH_WRITE].rx_seg = ct_wr_seg;
+    IsoTp_SetRxBuffer(&ct_link[CANTP_CH_FLASH_WRITE], ct_wr_buf, sizeof(ct_wr_buf));
+}
+
+void CanTp_OnFrame(const CanNode_Frame_t *f)
+{
+    uint32_t ch = f->id - CANTP_ID_RX_BASE;
+
+    if (ch < CANTP_CHANNELS) IsoTp_OnFrame(&ct_link[ch], f->data, f->dlc, ct_now_us());
+}
+
+uint32_t CanTp_Poll(void)
+{
+    uint32_t now = ct_now_us();
+    uint32_t ev = ISOTP_NO_EVENT;
+
+    for (uint8_t ch = 0; ch < CANTP_CHANNELS; ch++)
+    {
+        IsoTp_Poll(&ct_link[ch], now);
+        uint32_t e = IsoTp_NextEvent(&ct_link[ch], now);
+        if (e < ev) ev = e;
+    }
+    if (ev == ISOTP_NO_EVENT) return UINT32_MAX;
+    /* 节拍为 1ms；发送被保留空位挡住时 (ev = 0) 也等 1ms 让队列排出 */
+    return ev < 1000U ? 1U : (ev + 999U) / 1000U;
+}
+
+void CanTp_GetStats(uint8_t ch, IsoTp_Stats_t *stats)
+{
+    if (ch < CANTP_CHANNELS) *stats = ct_link[ch].stats;
+    else memset(stats, 0, sizeof(*stats));
+}
@@ -0,0 +1,82 @@
+#include "config.h"
+#include "eeprom.h"
+#include "i2c.h"
+#include "altitude.h"
+#include "sht30.h"
+#include <stddef.h>
+#include <string.h>
+
+/* 校验与 SHT30 相同：CRC8（多项式 0x31，初值 0xFF），直接用 SHT30_Crc8 的查表实现 */
+
+SysConfig_t g_config;
+
+/* 海平面气压在允许范围内（含 NaN 判断） */
+static bool config_sea_level_ok(float pa)
+{
+    return pa >= CONFIG_SEA_LEVEL_MIN && pa <= CONFIG_SEA_LEVEL_MAX;
+}
+
+void Config_Default(void)
+{
+    memset(&g_config, 0, sizeof(g_config));
+    g_config.magic        = CONFIG_MAGIC;
+    g_config.version      = CONFIG_VERSION;
+    g_config.size         = sizeof(SysConfig_t);
+    g_config.sea_level_pa = 101325.0f;
+}
+
+int Config_Load(void)
+{
+    SysConfig_t tmp;
+    HAL_StatusTypeDef ret;
+
+    I2C1_Lock();
+    ret = AT24C02_Read(CONFIG_EEPROM_ADDR, (uint8_t *)&tmp, sizeof(tmp));
+    I2C1_Unlock();
+
+    if (ret != HAL_OK)
+    {
+        Config_Default();
+        return 2;
+    }
+
+    if (tmp.magic != CONFIG_MAGIC || tmp.version != CONFIG_VERSION ||
+        tmp.size != sizeof(SysConfig_t) ||
+        tmp.crc != SHT30_Crc8((const uint8_t *)&tmp, offsetof(SysConfig_t, crc)) ||
+        !config_sea_level_ok(tmp.sea_level_pa))
+    {
+        Config_Default();
+        return 1;
+    }
+
+    g_config = tmp;
+    return 0;
+}
+
+int Config_Save(void)
+{
+    g_config.magic   = CONFIG_MAGIC;
+    g_config.version = CONFIG_VERSION;
+    g_config.size    = sizeof(SysConfig_t);
+    g_config.crc     = SHT30_Crc8((const uint8_t *)&g_config, offsetof(SysConfig_t, crc));
+
+    /* 多页写入（每页含 5ms 写周期）期间持有总线锁，采集任务的传感器读取在锁外等待 */
+    I2C1_Lock();
+    HAL_StatusTypeDef ret = AT24C02_Write(CONFIG_EEPROM_ADDR, (const uint8_t *)&g_config, sizeof(g_config));
+    I2C1_Unlock();
+
+    return (ret == HAL_OK) ? 0 : 1;
+}
+
+bool Config_IsLoaded(void)
+{
+    return g_config.magic == CONFIG_MAGIC;
+}
+
+int Config_SetSeaLevel(float pa)
+{
+    if (!config_sea_level_ok(pa)) return 1;
+    g_config.sea_level_pa = pa;
+    Altitude_SetSeaLevel(pa);
+    return 0;
+}
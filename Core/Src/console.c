@@ -0,0 +1,482 @@
+/**
+ * @file    console.c
+ * @brief   串口命令行控制台：中断中行编辑，任务中原地分词、二分查找命令并分段输出
+ */
+#include "console.h"
+#include "serial.h"
+#include "cmsis_os2.h"
+#include <string.h>
+
+#define CON_FLAG_RX     0x01U   /* 某端口提交了一行或收到 Ctrl-C */
+#define CON_FLAG_TX     0x02U   /* 忙端口的一段发送完成 */
+#define CON_POLL_MS     100U
+#define CON_ECHO_MAX    48U     /* 中断中一次回显写入的上限 */
+
+#define CON_CTRL_C      0x03U
+#define CON_BS          0x08U
+#define CON_DEL         0x7FU
+
+static Console_t con[UARTRX_PORT_NUM];
+static osThreadId_t con_task = NULL;
+static uint8_t con_selftest = 0xFF;
+
+static const char *const con_port_name[UARTRX_PORT_NUM] = { "USART1", "USART2", "USART3", "USART6" };
+
+/* ---------------- 中断：行编辑 ---------------- */
+
+static void con_wake(uint32_t flag)
+{
+    if (con_task) osThreadFlagsSet(con_task, flag);
+}
+
+static void con_echo(Console_t *c, char *echo, uint16_t *n, const char *s, uint16_t len)
+{
+    if (*n + len > CON_ECHO_MAX)
+    {
+        Serial_Write(c->port, echo, *n, NULL);
+        *n = 0;
+    }
+    memcpy(&echo[*n], s, len);
+    *n += len;
+}
+
+static void con_on_rx(UartRx_Port_t port, void *ctx, const uint8_t *data, uint16_t len)
+{
+    Console_t *c = (Console_t *)ctx;
+    char echo[CON_ECHO_MAX];
+    uint16_t n = 0;
+    (void)port;
+
+    c->last_input = osKernelGetTickCount();
+    c->session = 1;
+
+    for (uint16_t i = 0; i < len; i++)
+    {
+        uint8_t ch = data[i];
+
+        if (c->busy)
+        {
+            /* 命令执行中只响应 Ctrl-C，其余输入丢弃（不回显，避免与命令输出交错） */
+            if (ch == CON_CTRL_C)
+            {
+                c->abort = 1;
+                con_wake(CON_FLAG_RX);
+            }
+            else
+            {
+                c->dropped++;
+            }
+            continue;
+        }
+
+        if (ch == '\n' && c->last_cr)
+        {
+            c->last_cr = 0;         /* CR LF 只算一次回车 */
+            continue;
+        }
+        c->last_cr = (ch == '\r');
+
+        if (ch == '\r' || ch == '\n')
+        {
+            con_echo(c, echo, &n, "\r\n", 2);
+            memcpy(c->line, c->edit, c->edit_len);
+            c->line[c->edit_len] = '\0';
+            c->edit_len = 0;
+            c->busy = 1;
+            con_wake(CON_FLAG_RX);
+        }
+        else if (ch == CON_BS || ch == CON_DEL)
+        {
+            if (c->edit_len)
+            {
+                c->edit_len--;
+                con_echo(c, echo, &n, "\b \b", 3);
+            }
+        }
+        else if (ch == CON_CTRL_C)
+        {
+            c->edit_len = 0;
+            con_echo(c, echo, &n, "^C\r\n" CONSOLE_PROMPT, 4U + sizeof(CONSOLE_PROMPT) - 1U);
+        }
+        else if (ch >= 0x20U && ch < CON_DEL)
+        {
+            if (c->edit_len < CONSOLE_LINE_MAX - 1U)
+            {
+                c->edit[c->edit_len++] = (char)ch;
+                con_echo(c, echo, &n, (const char *)&ch, 1);
+            }
+            else
+            {
+                c->dropped++;
+            }
+        }
+    }
+    if (n) Serial_Write(c->port, echo, n, NULL);
+}
+
+static void con_on_tx_done(UartRx_Port_t port, void *ctx, uint32_t sent)
+{
+    Console_t *c = (Console_t *)ctx;
+    (void)port;
+    (void)sent;
+
+    if (c->busy) con_wake(CON_FLAG_TX);
+}
+
+static void con_on_attach(UartRx_Port_t port, void *ctx)
+{
+    Console_t *c = (Console_t *)ctx;
+
+    c->port = port;
+    c->edit_len = 0;
+    c->last_cr = 0;
+    c->abort = 0;
+    c->busy = 0;
+    c->session = 0;
+    c->attached = 1;
+}
+
+static void con_on_detach(UartRx_Port_t port, void *ctx)
+{
+    (void)port;
+    ((Console_t *)ctx)->attached = 0;
+    ((Console_t *)ctx)->session = 0;
+}
+
+bool Console_Active(UartRx_Port_t port)
+{
+    const Console_t *c;
+
+    if (port >= UARTRX_PORT_NUM) return false;
+    c = &con[port];
+    if (!c->attached || !c->session) return false;
+    return c->busy || osKernelGetTickCount() - c->last_input < CONSOLE_IDLE_MS;
+}
+
+void Console_EndSession(UartRx_Port_t port)
+{
+    if (port < UARTRX_PORT_NUM) con[port].session = 0;
+}
+
+static const Serial_Protocol_t con_proto = {
+    .name    = "console",
+    .attach  = con_on_attach,
+    .detach  = con_on_detach,
+    .rx      = con_on_rx,
+    .tx_done = con_on_tx_done,
+};
+
+/* ---------------- 分词、查找、数字解析 ---------------- */
+
+int Console_Tokenize(char *line, char **argv, int max)
+{
+    int argc = 0;
+    char *p = line;
+
+    for (;;)
+    {
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '\0') return argc;
+        if (argc >= max) return -1;
+
+        if (*p == '"')
+        {
+            argv[argc++] = ++p;
+            while (*p != '\0' && *p != '"') p++;
+            if (*p == '\0') return -1;
+        }
+        else
+        {
+            argv[argc++] = p;
+            while (*p != '\0' && *p != ' ' && *p != '\t') p++;
+            if (*p == '\0') return argc;
+        }
+        *p++ = '\0';
+    }
+}
+
+const Console_Cmd_t *Console_Find(const char *name)
+{
+    uint8_t lo = 0, hi = Console_CmdCount;
+
+    while (lo < hi)
+    {
+        uint8_t mid = (uint8_t)((lo + hi) / 2U);
+        int r = strcmp(name, Console_Cmds[mid].name);
+
+        if (r == 0) return &Console_Cmds[mid];
+        if (r < 0) hi = mid;
+        else lo = (uint8_t)(mid + 1U);
+    }
+    return NULL;
+}
+
+bool Console_ParseU32(const char *s, uint32_t *v)
+{
+    uint32_t x = 0;
+    uint32_t base = 10;
+
+    if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))
+    {
+        base = 16;
+        s += 2;
+    }
+    if (*s == '\0') return false;
+
+    for (; *s; s++)
+    {
+        uint32_t d;
+
+        if (*s >= '0' && *s <= '9') d = (uint32_t)(*s - '0');
+        else if (base == 16 && *s >= 'a' && *s <= 'f') d = (uint32_t)(*s - 'a' + 10);
+        else if (base == 16 && *s >= 'A' && *s <= 'F') d = (uint32_t)(*s - 'A' + 10);
+        else return false;
+
+        if (x > (0xFFFFFFFFUL - d) / base) return false;
+        x = x * base + d;
+    }
+    *v = x;
+    return true;
+}
+
+bool Console_ParseFloat(const char *s, float *v)
+{
+    /* 最多取 9 位有效数字，其余整数位只计数量级、小数位忽略；不支持指数 */
+    uint32_t m = 0;
+    uint8_t  sig = 0, digits = 0;
+    int8_t   exp10 = 0;
+    bool neg = false, dot = false;
+    float x;
+
+    if (*s == '-' || *s == '+') neg = (*s++ == '-');
+    for (; *s; s++)
+    {
+        if (*s == '.' && !dot)
+        {
+            dot = true;
+            continue;
+        }
+        if (*s < '0' || *s > '9') return false;
+        digits++;
+        if (sig < 9U)
+        {
+            m = m * 10U + (uint32_t)(*s - '0');
+            if (m) sig++;
+            if (dot) exp10--;
+        }
+        else if (!dot)
+        {
+            if (exp10 >= 30) return false;
+            exp10++;
+        }
+    }
+    if (digits == 0) return false;
+
+    x = (float)m;
+    for (; exp10 > 0; exp10--) x *= 10.0f;
+    for (; exp10 < 0; exp10++) x /= 10.0f;
+    *v = neg ? -x : x;
+    return true;
+}
+
+/* ---------------- 任务：执行命令 ---------------- */
+
+static bool con_flush(Console_t *c)
+{
+    if (c->olen == 0) return true;
+    if (Serial_Write(c->port, c->obuf, c->olen, NULL) != 0) return false;
+    c->olen = 0;
+    return true;
+}
+
+static void con_finish(Console_t *c)
+{
+    c->olen = c->out.len;
+    c->done = 1;
+}
+
+/* 开始执行 line 中的命令：分词并查表，出错时直接产生错误信息 */
+static void con_start(Console_t *c)
+{
+    int argc = Console_Tokenize(c->line, c->argv, CONSOLE_ARGS_MAX);
+
+    c->cursor = 0;
+    c->arg = 0;
+    c->lines++;
+    Fmt_Init(&c->out, c->obuf, sizeof(c->obuf));
+
+    if (argc == 0)
+    {
+        con_finish(c);
+        return;
+    }
+    if (argc < 0)
+    {
+        Fmt_Str(&c->out, "unbalanced quote or too many arguments\r\n");
+        con_finish(c);
+        return;
+    }
+    c->argc = (uint8_t)argc;
+    c->cmd = Console_Find(c->argv[0]);
+    if (c->cmd == NULL)
+    {
+        Fmt_Str(&c->out, "unknown command '");
+        Fmt_Str(&c->out, c->argv[0]);
+        Fmt_Str(&c->out, "', try help\r\n");
+        con_finish(c);
+    }
+}
+
+/* 推进一步，返回 false 表示命令已结束或需要等待发送缓冲 */
+static bool con_step(Console_t *c)
+{
+    int rc;
+
+    if (!con_flush(c)) return false;
+
+    if (c->done)
+    {
+        if (Serial_Write(c->port, CONSOLE_PROMPT, sizeof(CONSOLE_PROMPT) - 1U, NULL) != 0) return false;
+        c->cmd = NULL;
+        c->done = 0;
+        c->abort = 0;
+        c->busy = 0;        /* 最后清除，之后中断才开始编辑下一行 */
+        return false;
+    }
+
+    if (c->abort)
+    {
+        Fmt_Init(&c->out, c->obuf, sizeof(c->obuf));
+        Fmt_Str(&c->out, "^C\r\n");
+        con_finish(c);
+        return true;
+    }
+
+    if (c->cmd == NULL)
+    {
+        con_start(c);
+        return true;
+    }
+
+    if (Serial_TxFree(c->port) < CONSOLE_OUT_MAX) return false;
+
+    Fmt_Init(&c->out, c->obuf, sizeof(c->obuf));
+    rc = c->cmd->fn(c, c->argc, c->argv);
+    if (rc == CONSOLE_MORE)
+    {
+        c->olen = c->out.len;
+        return true;
+    }
+    if (rc == CONSOLE_USAGE)
+    {
+        Fmt_Init(&c->out, c->obuf, sizeof(c->obuf));
+        Fmt_Str(&c->out, "usage: ");
+        Fmt_Str(&c->out, c->cmd->name);
+        Fmt_Char(&c->out, ' ');
+        Fmt_Str(&c->out, c->cmd->usage);
+        Fmt_Str(&c->out, "\r\n");
+    }
+    con_finish(c);
+    return true;
+}
+
+int Console_Attach(UartRx_Port_t port)
+{
+    Fmt_t f;
+    char msg[64];
+
+    if (port >= UARTRX_PORT_NUM) return 1;
+    if (Serial_Attach(port, &con_proto, &con[port]) != 0) return 1;
+
+    Fmt_Init(&f, msg, sizeof(msg));
+    Fmt_Str(&f, "\r\nconsole on ");
+    Fmt_Str(&f, con_port_name[port]);
+    Fmt_Str(&f, con_selftest == 0 ? ", type help\r\n" : ", selftest FAIL\r\n");
+    Fmt_Str(&f, CONSOLE_PROMPT);
+    Serial_Write(port, msg, f.len, NULL);
+    return 0;
+}
+
+void ConsoleTask(void *argument)
+{
+    (void)argument;
+
+    con_task = osThreadGetId();
+    con_selftest = Console_Test();
+    if (Console_Attach(CONSOLE_DEFAULT_PORT) != 0) osThreadExit();
+
+    for (;;)
+    {
+        osThreadFlagsWait(CON_FLAG_RX | CON_FLAG_TX, osFlagsWaitAny, CON_POLL_MS);
+
+        for (uint8_t i = 0; i < UARTRX_PORT_NUM; i++)
+        {
+            Console_t *c = &con[i];
+
+            if (!c->attached)
+            {
+                /* 被其他协议替换：丢弃进行中的命令 */
+                c->cmd = NULL;
+                c->done = 0;
+                c->olen = 0;
+                continue;
+            }
+            while (c->busy && con_step(c))
+            {
+            }
+        }
+    }
+}
+
+/* ---------------- 自检 ---------------- */
+
+static bool con_tok_is(const char *line, int expect, const char *a0, const char *a1)
+{
+    char buf[CONSOLE_LINE_MAX];
+    char *argv[4];
+    int n;
+
+    strncpy(buf, line, sizeof(buf) - 1U);
+    buf[sizeof(buf) - 1U] = '\0';
+    n = Console_Tokenize(buf, argv, 4);
+    if (n != expect) return false;
+    if (n > 0 && strcmp(argv[0], a0) != 0) return false;
+    if (n > 1 && strcmp(argv[1], a1) != 0) return false;
+    return true;
+}
+
+uint8_t Console_Test(void)
+{
+    uint32_t u;
+    float f;
+
+    for (uint8_t i = 0; i < Console_CmdCount; i++)
+    {
+        if (i > 0 && strcmp(Console_Cmds[i - 1U].name, Console_Cmds[i].name) >= 0) return 1;
+        if (Console_Find(Console_Cmds[i].name) != &Console_Cmds[i]) return 1;
+    }
+    if (Console_Find("") != NULL || Console_Find("zz") != NULL || Console_Find("a") != NULL) return 1;
+
+    if (!con_tok_is("", 0, NULL, NULL)) return 1;
+    if (!con_tok_is("   \t ", 0, NULL, NULL)) return 1;
+    if (!con_tok_is("help", 1, "help", NULL)) return 1;
+    if (!con_tok_is("  flash  read 0x100 ", 3, "flash", "read")) return 1;
+    if (!con_tok_is("say \"a b\" c", 3, "say", "a b")) return 1;
+    if (!con_tok_is("x \"\"", 2, "x", "")) return 1;
+    if (!con_tok_is("x \"open", -1, NULL, NULL)) return 1;
+    if (!con_tok_is("a b c d e", -1, NULL, NULL)) return 1;
+
+    if (!Console_ParseU32("0", &u) || u != 0U) return 1;
+    if (!Console_ParseU32("4294967295", &u) || u != 0xFFFFFFFFUL) return 1;
+    if (!Console_ParseU32("0x1000", &u) || u != 0x1000U) return 1;
+    if (!Console_ParseU32("0xFfFfFfFf", &u) || u != 0xFFFFFFFFUL) return 1;
+    if (Console_ParseU32("4294967296", &u) || Console_ParseU32("0x100000000", &u)) return 1;
+    if (Console_ParseU32("", &u) || Console_ParseU32("0x", &u) || Console_ParseU32("12a", &u)) return 1;
+
+    if (!Console_ParseFloat("101325", &f) || f != 101325.0f) return 1;
+    if (!Console_ParseFloat("-1.5", &f) || f != -1.5f) return 1;
+    if (!Console_ParseFloat(".25", &f) || f != 0.25f) return 1;
+    if (Console_ParseFloat("1e5", &f) || Console_ParseFloat("-", &f) || Console_ParseFloat("1.2.3", &f)) return 1;
+
+    return 0;
+}
@@ -0,0 +1,549 @@
+/**
+ * @file    console_cmd.c
+ * @brief   控制台内置命令表
+ *
+ * 每个命令一次调用输出一段（一行或几行），用 c->cursor 记录进度，返回 CONSOLE_MORE 继续；
+ * 需要跨段保持一致的数据（任务列表、快照）在第一段取得，后续段按记录的位置读取。
+ * 新增命令只需实现处理函数并在 Console_Cmds 中按名字顺序插入一行（Console_Test 会检查顺序）。
+ */
+#include "console.h"
+#include "serial.h"
+#include "snapshot.h"
+#include "config.h"
+#include "altitude.h"
+#include "flash.h"
+#include "dlog.h"
+#include "telemetry.h"
+#include "cannode.h"
+#include "cantp.h"
+#include "btxfer.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "cmsis_os2.h"
+#include <string.h>
+
+#define CC_TASKS_MAX        24U     /* tasks 命令一次最多列出的任务数 */
+#define CC_DUMP_LINE        16U     /* flash read 每行字节数 */
+#define CC_DUMP_LINES       2U      /* flash read 每段行数 */
+#define CC_DUMP_DEFAULT     256U
+
+static const char *const cc_port_name[UARTRX_PORT_NUM] = { "USART1", "USART2", "USART3", "USART6" };
+
+/* ---------------- 辅助 ---------------- */
+
+/* 左对齐输出 s，不足 width 补空格 */
+static void cc_pad(Fmt_t *f, const char *s, uint8_t width)
+{
+    size_t n = strlen(s);
+
+    Fmt_Str(f, s);
+    for (; n < width; n++) Fmt_Char(f, ' ');
+}
+
+static void cc_kv(Fmt_t *f, const char *key, uint32_t v)
+{
+    Fmt_Char(f, ' ');
+    Fmt_Str(f, key);
+    Fmt_Char(f, '=');
+    Fmt_U32(f, v, 0, ' ');
+}
+
+/* "1" / "2" / "3" / "6" 或 "usart1" 等 → 端口号 */
+static bool cc_port(const char *s, UartRx_Port_t *port)
+{
+    size_t n = strlen(s);
+
+    if (n == 0) return false;
+    switch (s[n - 1U])
+    {
+    case '1': *port = UARTRX_PORT1; break;
+    case '2': *port = UARTRX_PORT2; break;
+    case '3': *port = UARTRX_PORT3; break;
+    case '6': *port = UARTRX_PORT6; break;
+    default: return false;
+    }
+    return n == 1U || (n == 6U && (strncmp(s, "usart", 5) == 0 || strncmp(s, "USART", 5) == 0));
+}
+
+/* ---------------- 命令 ---------------- */
+
+static int cc_attach(Console_t *c, int argc, char **argv)
+{
+    UartRx_Port_t port;
+
+    if (argc != 2 || !cc_port(argv[1], &port)) return CONSOLE_USAGE;
+    if (port == c->port)
+    {
+        Fmt_Str(&c->out, "already here\r\n");
+        return CONSOLE_DONE;
+    }
+    Fmt_Str(&c->out, Console_Attach(port) == 0 ? "console also on " : "attach failed: ");
+    Fmt_Str(&c->out, cc_port_name[port]);
+    Fmt_Str(&c->out, "\r\n");
+    return CONSOLE_DONE;
+}
+
+static int cc_bt(Console_t *c, int argc, char **argv)
+{
+    BtXfer_Stats_t s;
+    Fmt_t *f = &c->out;
+    (void)argc;
+    (void)argv;
+
+    BtXfer_GetStats(&s);
+    if (c->cursor == 0)
+    {
+        Fmt_Str(f, "sessions=");
+        Fmt_U32(f, s.sessions, 0, ' ');
+        cc_kv(f, "resumes", s.resumes);
+        cc_kv(f, "disconnects", s.disconnects);
+        cc_kv(f, "stalls", s.stalls);
+        cc_kv(f, "rx_bad", s.rx_bad);
+        Fmt_Str(f, "\r\n");
+        c->cursor = 1;
+        return CONSOLE_MORE;
+    }
+    Fmt_Str(f, "chunks=");
+    Fmt_U32(f, s.chunks, 0, ' ');
+    cc_kv(f, "retx_fast", s.retx_fast);
+    cc_kv(f, "retx_timeout", s.retx_timeout);
+    cc_kv(f, "payload", s.payload);
+    cc_kv(f, "bytes", s.bytes);
+    Fmt_Str(f, "\r\n");
+    return CONSOLE_DONE;
+}
+
+static int cc_can(Console_t *c, int argc, char **argv)
+{
+    static const char *const state[] = { "active", "warning", "passive", "bus-off" };
+    static const char *const chan[CANTP_CHANNELS] = { "echo", "flash-read", "flash-write" };
+    Fmt_t *f = &c->out;
+    (void)argc;
+    (void)argv;
+
+    if (c->cursor == 0)
+    {
+        CanNode_Stats_t s;
+
+        CanNode_GetStats(&s);
+        Fmt_Str(f, s.state < 4U ? state[s.state] : "?");
+        cc_kv(f, "tec", s.tec);
+        cc_kv(f, "rec", s.rec);
+        cc_kv(f, "peers", s.peers);
+        cc_kv(f, "busoffs", s.busoffs);
+        Fmt_Str(f, "\r\nrx=");
+        Fmt_U32(f, s.rx_frames, 0, ' ');
+        cc_kv(f, "rx_overflow", s.rx_overflow + s.rx_fifo_overrun);
+        cc_kv(f, "tx", s.tx_frames);
+        cc_kv(f, "tx_dropped", s.tx_dropped);
+        cc_kv(f, "tx_errors", s.tx_errors);
+        Fmt_Str(f, "\r\n");
+    }
+    else
+    {
+        IsoTp_Stats_t t;
+        uint8_t ch = (uint8_t)(c->cursor - 1U);
+
+        CanTp_GetStats(ch, &t);
+        Fmt_Str(f, "tp");
+        Fmt_U32(f, ch, 0, ' ');
+        Fmt_Char(f, ' ');
+        cc_pad(f, chan[ch], 12);
+        Fmt_Str(f, "tx=");
+        Fmt_U32(f, t.tx_msgs, 0, ' ');
+        Fmt_Char(f, '/');
+        Fmt_U32(f, t.tx_bytes, 0, ' ');
+        Fmt_Str(f, "B rx=");
+        Fmt_U32(f, t.rx_msgs, 0, ' ');
+        Fmt_Char(f, '/');
+        Fmt_U32(f, t.rx_bytes, 0, ' ');
+        Fmt_Char(f, 'B');
+        cc_kv(f, "errors", t.errors);
+        Fmt_Str(f, "\r\n");
+    }
+    return ++c->cursor <= CANTP_CHANNELS ? CONSOLE_MORE : CONSOLE_DONE;
+}
+
+/* 可由 config 命令读写的参数，按需加行；写入经 set 使新值立即生效 */
+typedef struct {
+    const char *name;
+    const float *value;
+    float       min, max;
+    uint8_t     decimals;
+    int       (*set)(float v);
+} cc_param_t;
+
+static const cc_param_t cc_params[] = {
+    { "sea_level_pa", &g_config.sea_level_pa, CONFIG_SEA_LEVEL_MIN, CONFIG_SEA_LEVEL_MAX, 1, Config_SetSeaLevel },
+};
+#define CC_PARAM_NUM   (sizeof(cc_params) / sizeof(cc_params[0]))
+
+static int cc_config(Console_t *c, int argc, char **argv)
+{
+    Fmt_t *f = &c->out;
+    const char *op = argc > 1 ? argv[1] : "get";
+    const cc_param_t *p = NULL;
+
+    if (argc > 2 && (strcmp(op, "get") == 0 || strcmp(op, "set") == 0))
+    {
+        for (uint8_t i = 0; i < CC_PARAM_NUM; i++)
+            if (strcmp(argv[2], cc_params[i].name) == 0) p = &cc_params[i];
+        if (p == NULL)
+        {
+            Fmt_Str(f, "no such parameter\r\n");
+            return CONSOLE_DONE;
+        }
+    }
+
+    if (strcmp(op, "get") == 0 && argc <= 3)
+    {
+        if (p == NULL) p = &cc_params[c->cursor];
+        cc_pad(f, p->name, 16);
+        Fmt_Fixed(f, *p->value, p->decimals);
+        Fmt_Str(f, "\r\n");
+        return argc <= 2 && ++c->cursor < CC_PARAM_NUM ? CONSOLE_MORE : CONSOLE_DONE;
+    }
+    if (strcmp(op, "set") == 0 && argc == 4)
+    {
+        float v;
+
+        if (!Console_ParseFloat(argv[3], &v) || v < p->min || v > p->max || p->set(v) != 0)
+        {
+            Fmt_Str(f, "out of range ");
+            Fmt_Fixed(f, p->min, p->decimals);
+            Fmt_Str(f, "..");
+            Fmt_Fixed(f, p->max, p->decimals);
+            Fmt_Str(f, "\r\n");
+            return CONSOLE_DONE;
+        }
+        Fmt_Str(f, "ok (config save to keep)\r\n");
+        return CONSOLE_DONE;
+    }
+    if (strcmp(op, "save") == 0 && argc == 2)
+    {
+        Fmt_Str(f, Config_Save() == 0 ? "saved\r\n" : "EEPROM write failed\r\n");
+        return CONSOLE_DONE;
+    }
+    if (strcmp(op, "default") == 0 && argc == 2)
+    {
+        Config_Default();
+        Altitude_LoadSeaLevel();   /* 站地址由 Usart3Task 的 Modbus_MapService 重新生效 */
+        Fmt_Str(f, "defaults loaded (config save to keep)\r\n");
+        return CONSOLE_DONE;
+    }
+    return CONSOLE_USAGE;
+}
+
+static int cc_flash(Console_t *c, int argc, char **argv)
+{
+    Fmt_t *f = &c->out;
+    uint32_t addr, len = 0;
+
+    if (argc < 3 || !Console_ParseU32(argv[2], &addr) || addr >= W25Q128_TOTAL_SIZE) return CONSOLE_USAGE;
+    if (argc > 4 || (argc == 4 && (!Console_ParseU32(argv[3], &len) || len == 0))) return CONSOLE_USAGE;
+
+    if (strcmp(argv[1], "read") == 0)
+    {
+        uint8_t buf[CC_DUMP_LINE];
+
+        if (argc == 3) len = CC_DUMP_DEFAULT;
+        if (len > W25Q128_TOTAL_SIZE - addr) len = W25Q128_TOTAL_SIZE - addr;
+
+        for (uint8_t l = 0; l < CC_DUMP_LINES && c->cursor < len; l++)
+        {
+            uint32_t n = len - c->cursor;
+
+            if (n > CC_DUMP_LINE) n = CC_DUMP_LINE;
+            W25Q128_Lock();
+            uint8_t err = W25Q128_Read(buf, addr + c->cursor, n);
+            W25Q128_Unlock();
+            if (err)
+            {
+                Fmt_Str(f, "read failed\r\n");
+                return CONSOLE_DONE;
+            }
+            Fmt_Hex(f, addr + c->cursor, 6);
+            Fmt_Str(f, "  ");
+            Fmt_HexBytes(f, buf, (uint16_t)n, ' ');
+            for (uint32_t i = n; i < CC_DUMP_LINE; i++) Fmt_Str(f, "   ");
+            Fmt_Str(f, "  ");
+            for (uint32_t i = 0; i < n; i++) Fmt_Char(f, (buf[i] >= 0x20U && buf[i] < 0x7FU) ? (char)buf[i] : '.');
+            Fmt_Str(f, "\r\n");
+            c->cursor += n;
+        }
+        return c->cursor < len ? CONSOLE_MORE : CONSOLE_DONE;
+    }
+
+    if (strcmp(argv[1], "erase") == 0)
+    {
+        /* 一段擦一个扇区，擦除期间（约 50 ms）只阻塞控制台任务，Ctrl-C 可在扇区之间中止 */
+        uint32_t sectors = argc == 4 ? len : 1U;
+
+        if (addr % W25Q128_SECTOR_SIZE != 0U || sectors > (W25Q128_TOTAL_SIZE - addr) / W25Q128_SECTOR_SIZE)
+        {
+            Fmt_Str(f, "address must be sector aligned (4096), count within the chip\r\n");
+            return CONSOLE_DONE;
+        }
+        addr += c->cursor * W25Q128_SECTOR_SIZE;
+        W25Q128_Lock();
+        W25Q128_EraseSector(addr);
+        W25Q128_Unlock();
+        Fmt_Str(f, "erased ");
+        Fmt_Hex(f, addr, 6);
+        Fmt_Str(f, "\r\n");
+        return ++c->cursor < sectors ? CONSOLE_MORE : CONSOLE_DONE;
+    }
+    return CONSOLE_USAGE;
+}
+
+static int cc_heap(Console_t *c, int argc, char **argv)
+{
+    HeapStats_t h;
+    Fmt_t *f = &c->out;
+    (void)argc;
+    (void)argv;
+
+    vPortGetHeapStats(&h);
+    Fmt_Str(f, "total=");
+    Fmt_U32(f, configTOTAL_HEAP_SIZE, 0, ' ');
+    cc_kv(f, "free", h.xAvailableHeapSpaceInBytes);
+    cc_kv(f, "min_free", h.xMinimumEverFreeBytesRemaining);
+    cc_kv(f, "largest", h.xSizeOfLargestFreeBlockInBytes);
+    Fmt_Str(f, "\r\nfree_blocks=");
+    Fmt_U32(f, h.xNumberOfFreeBlocks, 0, ' ');
+    cc_kv(f, "allocs", h.xNumberOfSuccessfulAllocations);
+    cc_kv(f, "frees", h.xNumberOfSuccessfulFrees);
+    Fmt_Str(f, "\r\n");
+    return CONSOLE_DONE;
+}
+
+static int cc_help(Console_t *c, int argc, char **argv)
+{
+    const Console_Cmd_t *cmd;
+    (void)argc;
+    (void)argv;
+
+    cmd = &Console_Cmds[c->cursor];
+    cc_pad(&c->out, cmd->name, 8);
+    cc_pad(&c->out, cmd->usage, 32);
+    Fmt_Str(&c->out, "  ");
+    Fmt_Str(&c->out, cmd->help);
+    Fmt_Str(&c->out, "\r\n");
+    return ++c->cursor < Console_CmdCount ? CONSOLE_MORE : CONSOLE_DONE;
+}
+
+static int cc_log(Console_t *c, int argc, char **argv)
+{
+    static const char *const level[] = { "error", "warn", "info", "debug" };
+    Fmt_t *f = &c->out;
+
+    if (argc == 1)
+    {
+        DLog_Stats_t s;
+
+        DLog_GetStats(&s);
+        Fmt_Str(f, "records=");
+        Fmt_U32(f, s.records, 0, ' ');
+        cc_kv(f, "dropped", s.dropped);
+        cc_kv(f, "frames", s.frames);
+        cc_kv(f, "bytes", s.bytes);
+        cc_kv(f, "high_water", s.high_water);
+        Fmt_Str(f, "\r\n");
+        return CONSOLE_DONE;
+    }
+    if (argc == 3 && strcmp(argv[1], "level") == 0)
+    {
+        for (uint8_t i = 0; i < 4U; i++)
+        {
+            if (strcmp(argv[2], level[i]) == 0)
+            {
+                DLog_SetLevel((dlog_level_t)i);
+                Fmt_Str(f, "ok\r\n");
+                return CONSOLE_DONE;
+            }
+        }
+    }
+    return CONSOLE_USAGE;
+}
+
+static int cc_quit(Console_t *c, int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    Console_EndSession(c->port);
+    Fmt_Str(&c->out, "bye, binary frames resume on this port\r\n");
+    return CONSOLE_DONE;
+}
+
+static int cc_route(Console_t *c, int argc, char **argv)
+{
+    UartRx_Port_t port;
+
+    if (argc != 3 || !cc_port(argv[2], &port)) return CONSOLE_USAGE;
+    if (strcmp(argv[1], "tlm") == 0) Telemetry_SetPort(port);
+    else if (strcmp(argv[1], "log") == 0) DLog_SetPort(port);
+    else return CONSOLE_USAGE;
+
+    Fmt_Str(&c->out, argv[1]);
+    Fmt_Str(&c->out, " -> ");
+    Fmt_Str(&c->out, cc_port_name[port]);
+    Fmt_Str(&c->out, "\r\n");
+    return CONSOLE_DONE;
+}
+
+static int cc_snap(Console_t *c, int argc, char **argv)
+{
+    static const char *const name[SNAP_FIELD_NUM] = { "T1", "T2", "H", "L", "P", "A", "D" };
+    static const char *const unit[SNAP_FIELD_NUM] = { "C", "C", "%RH", "lux", "Pa", "m", "cm" };
+    static const char *const status[] = { "none", "ok", "error" };
+    SensorSnapshot_t s;
+    Fmt_t *f = &c->out;
+    uint32_t back = 0, ver;
+
+    if (argc > 2 || (argc == 2 && (!Console_ParseU32(argv[1], &back) || back >= SNAP_HISTORY_LEN)))
+        return CONSOLE_USAGE;
+
+    /* 第一段记下版本号，后续段按新发布的份数后移，保证各行来自同一份快照 */
+    ver = Snapshot_Version();
+    if (c->cursor == 0) c->arg = ver;
+    back += ver - c->arg;
+    if (back >= SNAP_HISTORY_LEN || !Snapshot_Read((uint8_t)back, &s))
+    {
+        Fmt_Str(f, c->cursor == 0 ? "no snapshot\r\n" : "snapshot overwritten\r\n");
+        return CONSOLE_DONE;
+    }
+
+    if (c->cursor == 0)
+    {
+        Fmt_Str(f, "version=");
+        Fmt_U32(f, s.version, 0, ' ');
+        cc_kv(f, "age_ms", osKernelGetTickCount() - s.tick);
+        Fmt_Str(f, "\r\n");
+    }
+    else
+    {
+        const snap_value_t *v = &s.f[c->cursor - 1U];
+
+        cc_pad(f, name[c->cursor - 1U], 4);
+        Fmt_Fixed(f, v->value, 2);
+        Fmt_Char(f, ' ');
+        cc_pad(f, unit[c->cursor - 1U], 5);
+        Fmt_Str(f, v->status < 3U ? status[v->status] : "?");
+        Fmt_Str(f, "\r\n");
+    }
+    return ++c->cursor <= SNAP_FIELD_NUM ? CONSOLE_MORE : CONSOLE_DONE;
+}
+
+static int cc_tasks(Console_t *c, int argc, char **argv)
+{
+    /* 任务快照在第一段取得并保留到列完；快照只有一份，另一端口正在列出时拒绝执行 */
+    static TaskStatus_t tasks[CC_TASKS_MAX];
+    static UBaseType_t count;
+    static uint32_t total;
+    static Console_t *owner;
+    static const char state[] = { 'X', 'R', 'B', 'S', 'D', '?' };
+    Fmt_t *f = &c->out;
+    (void)argc;
+    (void)argv;
+
+    if (c->cursor == 0)
+    {
+        if (owner && owner != c && owner->cmd && owner->cmd->fn == cc_tasks)
+        {
+            Fmt_Str(f, "tasks busy on another port\r\n");
+            return CONSOLE_DONE;
+        }
+        count = uxTaskGetSystemState(tasks, CC_TASKS_MAX, &total);
+        owner = c;
+        Fmt_Str(f, "name            st pri stack  cpu%\r\n");
+        if (count == 0)
+        {
+            Fmt_Str(f, "more than ");
+            Fmt_U32(f, CC_TASKS_MAX, 0, ' ');
+            Fmt_Str(f, " tasks\r\n");
+        }
+        c->cursor = 1;
+        return count ? CONSOLE_MORE : CONSOLE_DONE;
+    }
+    if (c->cursor > count) return CONSOLE_DONE;
+
+    TaskStatus_t *t = &tasks[c->cursor - 1U];
+
+    cc_pad(f, t->pcTaskName, 16);
+    Fmt_Char(f, state[t->eCurrentState < 5 ? t->eCurrentState : 5]);
+    Fmt_U32(f, t->uxCurrentPriority, 4, ' ');
+    Fmt_U32(f, t->usStackHighWaterMark * 4U, 6, ' ');
+    if (total / 100U)
+        Fmt_U32(f, t->ulRunTimeCounter / (total / 100U), 6, ' ');
+    else
+        Fmt_Str(f, "     -");
+    Fmt_Str(f, "\r\n");
+    return c->cursor++ < count ? CONSOLE_MORE : CONSOLE_DONE;
+}
+
+static int cc_uart(Console_t *c, int argc, char **argv)
+{
+    Serial_Stats_t s;
+    Fmt_t *f = &c->out;
+    UartRx_Port_t port = (UartRx_Port_t)c->cursor;
+    (void)argc;
+    (void)argv;
+
+    Serial_GetStats(port, &s);
+    Fmt_Str(f, cc_port_name[port]);
+    Fmt_Char(f, ' ');
+    cc_pad(f, Serial_ProtocolName(port), 9);
+    Fmt_Str(f, "rx=");
+    Fmt_U32(f, s.rx.bytes, 0, ' ');
+    cc_kv(f, "ovr", s.rx.overruns);
+    cc_kv(f, "err", s.rx.errors);
+    cc_kv(f, "tx", s.tx_bytes);
+    cc_kv(f, "tx_drop", s.tx_dropped);
+    cc_kv(f, "tx_err", s.tx_errors);
+    Fmt_Str(f, "\r\n");
+    return ++c->cursor < UARTRX_PORT_NUM ? CONSOLE_MORE : CONSOLE_DONE;
+}
+
+static int cc_uptime(Console_t *c, int argc, char **argv)
+{
+    uint32_t ms = osKernelGetTickCount();
+    uint32_t s = ms / 1000U;
+    Fmt_t *f = &c->out;
+    (void)argc;
+    (void)argv;
+
+    Fmt_Str(f, "up ");
+    Fmt_U32(f, s / 86400U, 0, ' ');
+    Fmt_Str(f, "d ");
+    Fmt_U32(f, s / 3600U % 24U, 2, '0');
+    Fmt_Char(f, ':');
+    Fmt_U32(f, s / 60U % 60U, 2, '0');
+    Fmt_Char(f, ':');
+    Fmt_U32(f, s % 60U, 2, '0');
+    cc_kv(f, "tick", ms);
+    cc_kv(f, "lines", c->lines);
+    cc_kv(f, "dropped", c->dropped);
+    Fmt_Str(f, "\r\n");
+    return CONSOLE_DONE;
+}
+
+/* 按名字排序（strcmp），Console_Find 二分查找 */
+const Console_Cmd_t Console_Cmds[] = {
+    { "attach", cc_attach, "<port 1|2|3|6>",                        "also run a console on that port" },
+    { "bt",     cc_bt,     "",                                      "bluetooth transfer stats" },
+    { "can",    cc_can,    "",                                      "CAN node and ISO-TP stats" },
+    { "config", cc_config, "[get [name]|set <name> <value>|save|default]", "system parameters" },
+    { "flash",  cc_flash,  "read <addr> [len] | erase <addr> [sectors]", "W25Q128 hex dump / sector erase" },
+    { "heap",   cc_heap,   "",                                      "FreeRTOS heap stats" },
+    { "help",   cc_help,   "",                                      "this list" },
+    { "log",    cc_log,    "[level error|warn|info|debug]",         "binary log stats and level" },
+    { "quit",   cc_quit,   "",                                      "end session, resume telemetry/log frames here" },
+    { "route",  cc_route,  "tlm|log <port 1|2|3|6>",                "move telemetry or log frames to a port" },
+    { "snap",   cc_snap,   "[back 0..7]",                           "sensor snapshot" },
+    { "tasks",  cc_tasks,  "",                                      "task state, stack high water, cpu" },
+    { "uart",   cc_uart,   "",                                      "serial port stats" },
+    { "uptime", cc_uptime, "",                                      "time since boot" },
+};
+
+const uint8_t Console_CmdCount = (uint8_t)(sizeof(Console_Cmds) / sizeof(Console_Cmds[0]));
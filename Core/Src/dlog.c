@@ -0,0 +1,201 @@
+/**
+ * @file    dlog.c
+ * @brief   延迟格式化二进制日志实现
+ *
+ * 环形缓冲以 32 位字为单位，head/tail 为自由运行的累计字数。记录格式：
+ *   字 0  bit31 提交位 | bit30..28 级别 | bit27..24 参数个数 | bit15..0 格式串 ID
+ *   字 1  HAL_GetTick() (ms)
+ *   字 2… 参数
+ * 生产者用 LDREX/STREX 推进 head 预留空间，写入参数后（DMB）再写记录头；
+ * 消费者遇到未提交的记录头即停止，取走记录后把各字清零再推进 tail，
+ * 保证下一圈落在此处的记录头在提交前一定读到 0。
+ *
+ * 记录原样（小端）打包进 TLM_REC_LOG 帧，帧格式见 tlmcodec.h。
+ */
+#include "dlog.h"
+#include "tlmcodec.h"
+#include "serial.h"
+#include "crc.h"
+#include "dwt.h"
+#include "console.h"
+#include "cmsis_os2.h"
+#include <stdio.h>
+#include <string.h>
+
+#define DL_MASK        (DLOG_RING_WORDS - 1U)
+#define DL_COMMIT      0x80000000U
+
+static volatile uint32_t dl_ring[DLOG_RING_WORDS];
+static volatile uint32_t dl_head = 0;     /* 已预留字数（生产者） */
+static volatile uint32_t dl_tail = 0;     /* 已取走字数（DLogTask） */
+static volatile uint32_t dl_dropped = 0;
+static volatile uint8_t dl_level = DLOG_DEBUG;
+static volatile UartRx_Port_t dl_port = DLOG_DEFAULT_PORT;
+
+static uint8_t dl_frame[TLM_FRAME_MAX] __attribute__((aligned(4)));
+static uint8_t dl_out[TLM_COBS_MAX];
+static uint16_t dl_seq = 0;
+static DLog_Stats_t dl_stats;
+
+static void dl_count_drop(void)
+{
+    uint32_t v;
+    do {
+        v = __LDREXW(&dl_dropped);
+    } while (__STREXW(v + 1U, &dl_dropped));
+}
+
+void DLog_Write(uint8_t level, uint32_t id, const uint32_t *args, uint32_t nargs)
+{
+    uint32_t h;
+
+    if (level > dl_level) return;
+    if (nargs > DLOG_MAX_ARGS) nargs = DLOG_MAX_ARGS;
+
+    uint32_t need = 2U + nargs;
+    do {
+        h = __LDREXW(&dl_head);
+        if (DLOG_RING_WORDS - (h - dl_tail) < need)
+        {
+            __CLREX();
+            dl_count_drop();
+            return;
+        }
+    } while (__STREXW(h + need, &dl_head));
+
+    dl_ring[(h + 1U) & DL_MASK] = HAL_GetTick();
+    for (uint32_t i = 0; i < nargs; i++) dl_ring[(h + 2U + i) & DL_MASK] = args[i];
+    __DMB();
+    dl_ring[h & DL_MASK] = DL_COMMIT | ((uint32_t)(level & 0x7U) << 28) | (nargs << 24) | (id & 0xFFFFU);
+}
+
+void DLog_SetLevel(dlog_level_t level)
+{
+    dl_level = (uint8_t)level;
+}
+
+void DLog_SetPort(UartRx_Port_t port)
+{
+    if (port < UARTRX_PORT_NUM) dl_port = port;
+}
+
+void DLog_GetStats(DLog_Stats_t *stats)
+{
+    if (stats == NULL) return;
+    osKernelLock();
+    *stats = dl_stats;
+    stats->dropped = dl_dropped;
+    osKernelUnlock();
+}
+
+static void dl_put_le(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/* 把已提交的记录搬进 dl_frame，返回帧内容长度（只有帧头时返回 0） */
+static uint16_t dl_collect(void)
+{
+    uint16_t len = TLM_LOG_HDR_LEN;
+    uint32_t tail = dl_tail;
+    uint32_t used = dl_head - tail;
+
+    if (used > dl_stats.high_water) dl_stats.high_water = used;
+
+    while (tail != dl_head)
+    {
+        uint32_t hdr = dl_ring[tail & DL_MASK];
+        if (!(hdr & DL_COMMIT)) break;   /* 生产者尚未写完 */
+        __DMB();
+
+        uint32_t words = 2U + ((hdr >> 24) & 0xFU);
+        if (len + words * 4U > TLM_FRAME_MAX - TLM_CRC_LEN) break;
+
+        for (uint32_t w = 0; w < words; w++)
+        {
+            uint32_t *slot = (uint32_t *)&dl_ring[(tail + w) & DL_MASK];
+            dl_put_le(&dl_frame[len], *slot);
+            *slot = 0;
+            len += 4U;
+        }
+        tail += words;
+        dl_stats.records++;
+        __DMB();
+        dl_tail = tail;
+    }
+    if (len == TLM_LOG_HDR_LEN) return 0;
+
+    dl_frame[0] = TLM_REC_LOG;
+    dl_frame[1] = TLM_LOG_VERSION;
+    dl_frame[2] = (uint8_t)dl_seq;
+    dl_frame[3] = (uint8_t)(dl_seq >> 8);
+    dl_put_le(&dl_frame[4], dl_dropped);
+    return len;
+}
+
+/* CRC 外设与遥测共用，锁调度器避免交错 */
+static uint32_t dl_hw_crc(const uint8_t *data, uint32_t len)
+{
+    int32_t lock = osKernelLock();
+    uint32_t crc = HAL_CRC_Calculate(&hcrc, (uint32_t *)(uintptr_t)data, len / 4U);
+    osKernelRestoreLock(lock);
+    return crc;
+}
+
+void DLogTask(void *argument)
+{
+    for (;;)
+    {
+        UartRx_Port_t port = dl_port;
+
+        /* 先确认发送缓冲放得下一整帧，否则记录留在环中，由写入端计数丢弃；
+           控制台会话期间同样暂停，会话结束后补发 */
+        if (Console_Active(port) || Serial_Open(port) != 0 || Serial_TxFree(port) < TLM_COBS_MAX)
+        {
+            osDelay(DLOG_DRAIN_MS);
+            continue;
+        }
+
+        uint16_t len = dl_collect();
+        if (len == 0)
+        {
+            osDelay(DLOG_DRAIN_MS);
+            continue;
+        }
+
+        uint16_t n = Tlm_FrameEncode(dl_frame, len, dl_hw_crc, dl_out, sizeof(dl_out));
+        dl_seq++;
+        if (n && Serial_Write(port, dl_out, n, NULL) == 0)
+        {
+            dl_stats.frames++;
+            dl_stats.bytes += n;
+        }
+    }
+}
+
+void DLog_Bench(DLog_Bench_t *bench)
+{
+    char buf[64];
+    uint32_t w = 0, s = 0;
+
+    DWT_Init();
+    for (uint32_t i = 0; i < 16U; i++)
+    {
+        uint32_t t0 = DWT_GetCycles();
+        LOG_D("bench i=%u tick=%u v=%d", i, HAL_GetTick(), -(int32_t)i);
+        uint32_t t1 = DWT_GetCycles();
+        snprintf(buf, sizeof(buf), "bench i=%lu tick=%lu v=%ld", (unsigned long)i,
+                 (unsigned long)HAL_GetTick(), -(long)i);
+        uint32_t t2 = DWT_GetCycles();
+        w += t1 - t0;
+        s += t2 - t1;
+    }
+    if (bench)
+    {
+        bench->write_cycles = w / 16U;
+        bench->sprintf_cycles = s / 16U;
+    }
+}
@@ -11,6 +11,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "eeprom.h"
 #include "i2c.h"
+#include "config.h"
 #include <string.h>
 
 /* ---------- 内部辅助 ------------------------------------------------------ */
@@ -100,37 +101,74 @@ HAL_StatusTypeDef AT24C02_Read(uint8_t addr, uint8_t *pBuf, uint16_t len)
 }
 
 /**
- * @brief  EEPROM 读写自检（逐页遍历全部 256 字节地址空间）
- * @param  testedSize 输出: 实际测试通过的字节数
+ * @brief  单页自检：备份、写入测试图样、回读、写回原内容（总线锁内完成）
  * @retval 0 = PASS, 1 = FAIL
  */
-uint8_t AT24C02_Test(uint16_t *testedSize)
+static uint8_t at24c02_test_page(uint8_t addr)
 {
     uint8_t wBuf[AT24C02_PAGE_SIZE];
     uint8_t rBuf[AT24C02_PAGE_SIZE];
+    uint8_t bak[AT24C02_PAGE_SIZE];
+    uint8_t fail = 1;
+
+    /* 填充测试数据（每页不同模式） */
+    for (uint8_t i = 0; i < AT24C02_PAGE_SIZE; i++)
+        wBuf[i] = (uint8_t)(addr + i);
+
+    I2C1_Lock();
+    do
+    {
+        /* 备份原内容 */
+        if (AT24C02_Read(addr, bak, AT24C02_PAGE_SIZE) != HAL_OK)
+            break;
+
+        if (AT24C02_Write(addr, wBuf, AT24C02_PAGE_SIZE) != HAL_OK)
+            break;
+
+        memset(rBuf, 0, AT24C02_PAGE_SIZE);
+        if (AT24C02_Read(addr, rBuf, AT24C02_PAGE_SIZE) != HAL_OK)
+            break;
+
+        /* 写回原内容 */
+        if (AT24C02_Write(addr, bak, AT24C02_PAGE_SIZE) != HAL_OK)
+            break;
+
+        fail = (memcmp(wBuf, rBuf, AT24C02_PAGE_SIZE) != 0);
+    } while (0);
+    I2C1_Unlock();
+
+    return fail;
+}
+
+/**
+ * @brief  EEPROM 读写自检（逐页遍历 256 字节地址空间，跳过参数区所在的页）
+ *         每页测试前先备份原内容，测试后写回；参数区不参与测试，
+ *         即使测试中途掉电或出错也不会破坏已保存的参数。
+ *         每页的备份/写/读/写回在 I2C1 总线锁内完成
+ * @param  testedSize 输出: 实际测试通过的字节数
+ * @retval 0 = PASS, 1 = FAIL
+ */
+uint8_t AT24C02_Test(uint16_t *testedSize)
+{
     uint16_t passed = 0;
 
     if (testedSize) *testedSize = 0;
 
     /* 1. 检测设备在线 */
-    if (AT24C02_IsConnected() != HAL_OK)
+    I2C1_Lock();
+    HAL_StatusTypeDef online = AT24C02_IsConnected();
+    I2C1_Unlock();
+    if (online != HAL_OK)
         return 1;
 
     /* 2. 逐页写入/回读/校验 */
     for (uint16_t addr = 0; addr < AT24C02_MEM_SIZE; addr += AT24C02_PAGE_SIZE)
     {
-        /* 填充测试数据（每页不同模式） */
-        for (uint8_t i = 0; i < AT24C02_PAGE_SIZE; i++)
-            wBuf[i] = (uint8_t)(addr + i);
-
-        if (AT24C02_Write((uint8_t)addr, wBuf, AT24C02_PAGE_SIZE) != HAL_OK)
-            return 1;
-
-        memset(rBuf, 0, AT24C02_PAGE_SIZE);
-        if (AT24C02_Read((uint8_t)addr, rBuf, AT24C02_PAGE_SIZE) != HAL_OK)
-            return 1;
+        /* 与参数区重叠的页不测试 */
+        if (addr < CONFIG_EEPROM_END && addr + AT24C02_PAGE_SIZE > CONFIG_EEPROM_ADDR)
+            continue;
 
-        if (memcmp(wBuf, rBuf, AT24C02_PAGE_SIZE) != 0)
+        if (at24c02_test_page((uint8_t)addr) != 0)
             return 1;
 
         passed += AT24C02_PAGE_SIZE;
@@ -12,22 +12,54 @@
 /* Includes ------------------------------------------------------------------*/
 #include "flash.h"
 #include "spi.h"
+#include "cmsis_os2.h"
 #include <string.h>
 
 /* ---------- 内部缓冲 ------------------------------------------------------ */
 static uint8_t W25Q128_SectorBuf[W25Q128_SECTOR_SIZE];
 
+/* ---------- 访问锁（递归互斥量，同一任务可嵌套加锁） ------------------------ */
+static osMutexId_t w25q128_mutex;
+static const osMutexAttr_t w25q128_mutex_attr = {
+    .name = "w25q128",
+    .attr_bits = osMutexRecursive | osMutexPrioInherit,
+};
+
+/* ========================================================================== */
+/*                        访问锁                                               */
+/* ========================================================================== */
+
+void W25Q128_LockInit(void)
+{
+    if (w25q128_mutex == NULL) w25q128_mutex = osMutexNew(&w25q128_mutex_attr);
+}
+
+/* 调度器启动前只有一个执行流，无需加锁 */
+void W25Q128_Lock(void)
+{
+    if (w25q128_mutex != NULL && osKernelGetState() == osKernelRunning)
+        osMutexAcquire(w25q128_mutex, osWaitForever);
+}
+
+void W25Q128_Unlock(void)
+{
+    if (w25q128_mutex != NULL && osKernelGetState() == osKernelRunning)
+        osMutexRelease(w25q128_mutex);
+}
+
 /* ========================================================================== */
 /*                        底层 SPI 字节读写                                    */
 /* ========================================================================== */
 
+static uint8_t spi3_err;   /* 收发失败（SPI 未初始化或超时）后置位，由 W25Q128_Read 清除并返回 */
+
 /**
  * @brief  通过 SPI3 收发 1 字节
  */
 static uint8_t SPI3_ReadWriteByte(uint8_t txData)
 {
     uint8_t rxData = 0;
-    HAL_SPI_TransmitReceive(&hspi3, &txData, &rxData, 1, W25Q128_TIMEOUT);
+    if (HAL_SPI_TransmitReceive(&hspi3, &txData, &rxData, 1, W25Q128_TIMEOUT) != HAL_OK) spi3_err = 1;
     return rxData;
 }
 
@@ -145,20 +177,24 @@ uint32_t W25Q128_ReadJedecID(void)
  * @param  pBuf  目标缓冲
  * @param  addr  24-bit 起始地址
  * @param  len   读取长度
+ * @return 0 = 成功, 1 = SPI 收发失败（缓冲内容无效）
  */
-void W25Q128_Read(uint8_t *pBuf, uint32_t addr, uint32_t len)
+uint8_t W25Q128_Read(uint8_t *pBuf, uint32_t addr, uint32_t len)
 {
+    spi3_err = 0;
     W25Q128_CS_LOW();
     SPI3_ReadWriteByte(W25X_ReadData);
     SPI3_ReadWriteByte((uint8_t)(addr >> 16));
     SPI3_ReadWriteByte((uint8_t)(addr >> 8));
     SPI3_ReadWriteByte((uint8_t)(addr));
 
-    for (uint32_t i = 0; i < len; i++)
+    /* 出错后每字节都要等满超时，直接放弃本次读取 */
+    for (uint32_t i = 0; i < len && !spi3_err; i++)
     {
         pBuf[i] = SPI3_ReadWriteByte(0xFF);
     }
     W25Q128_CS_HIGH();
+    return spi3_err;
 }
 
 /**
@@ -368,9 +404,10 @@ void W25Q128_WakeUp(void)
 /* ========================================================================== */
 
 /**
- * @brief  W25Q128 读写自检
+ * @brief  W25Q128 读写自检（非破坏性，全程持有访问锁）
  *         1. 读 JEDEC ID 并据此推算芯片容量
- *         2. 擦除第 0 扇区 → 写入 256 字节 → 回读比较
+ *         2. 备份最后一个扇区 → 擦除 → 写入 256 字节 → 回读比较 → 恢复原内容
+ *         第 0 扇区起存放 CAN / 蓝牙上传的数据，不在此处测试
  * @param  detectedSizeKB 输出: 从 JEDEC ID 推算的容量 (KB)
  * @return 0 = PASS, 1 = ID 错误, 2 = 读写校验失败
  */
@@ -378,9 +415,12 @@ uint8_t W25Q128_Test(uint32_t *detectedSize)
 {
     uint8_t txBuf[256];
     uint8_t rxBuf[256];
+    uint8_t result = 0;
 
     if (detectedSize) *detectedSize = 0;
 
+    W25Q128_Lock();
+
     /* ---- 1. JEDEC ID → 推算容量 ---- */
     uint32_t jedecId = W25Q128_ReadJedecID();
     uint8_t  mfr     = (jedecId >> 16) & 0xFF;
@@ -388,29 +428,40 @@ uint8_t W25Q128_Test(uint32_t *detectedSize)
 
     if (mfr != W25Q128_MANUFACTURER_ID || capCode < 0x11 || capCode > 0x21)
     {
+        W25Q128_Unlock();
         return 1;   /* 非 Winbond 或容量码异常 */
     }
 
     /* 容量 = 2^capCode 字节, 转 KB */
-    uint32_t sizeKB = (1UL << capCode) / 1024;
+    uint32_t sizeKB = (capCode >= 0x1E) ? (1UL << (capCode - 10)) : ((1UL << capCode) / 1024);
     if (detectedSize) *detectedSize = sizeKB;
 
+    /* 测试扇区：实际容量与驱动地址范围中较小者的最后一个扇区 */
+    uint32_t span = (sizeKB < W25Q128_TOTAL_SIZE / 1024) ? sizeKB * 1024 : W25Q128_TOTAL_SIZE;
+    uint32_t addr = span - W25Q128_SECTOR_SIZE;
+
     /* ---- 2. 填充测试数据 ---- */
     for (uint16_t i = 0; i < 256; i++)
     {
         txBuf[i] = (uint8_t)i;
     }
 
-    /* ---- 3. 擦除 → 写入 → 回读 ---- */
-    W25Q128_EraseSector(0);
-    W25Q128_Write(txBuf, 0, 256);
-    W25Q128_Read(rxBuf, 0, 256);
+    /* ---- 3. 备份 → 擦除 → 写入 → 回读 ---- */
+    W25Q128_Read(W25Q128_SectorBuf, addr, W25Q128_SECTOR_SIZE);
+    W25Q128_EraseSector(addr);
+    W25Q128_WriteNoCheck(txBuf, addr, 256);
+    W25Q128_Read(rxBuf, addr, 256);
 
     /* ---- 4. 比较 ---- */
     if (memcmp(txBuf, rxBuf, 256) != 0)
     {
-        return 2;   /* 数据不匹配 */
+        result = 2;   /* 数据不匹配 */
     }
 
-    return 0;   /* PASS */
+    /* ---- 5. 恢复原内容 ---- */
+    W25Q128_EraseSector(addr);
+    W25Q128_WriteNoCheck(W25Q128_SectorBuf, addr, W25Q128_SECTOR_SIZE);
+
+    W25Q128_Unlock();
+    return result;
 }
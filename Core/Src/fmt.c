@@ -0,0 +1,326 @@
+/**
+ * @file    fmt.c
+ * @brief   无堆分配的快速文本格式化实现
+ *
+ * 十进制每次除以 100 并查两位数字表，除法次数减半；十六进制查 16 字符表。
+ * 浮点先乘 10^decimals 再取整，全程单精度（FPU 单周期），不经过 double 软件库。
+ */
+#include "fmt.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char fmt_dec2[200] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const char fmt_hex[16] = "0123456789ABCDEF";
+
+static const float fmt_pow10f[FMT_MAX_DECIMALS + 1U] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f };
+static const uint32_t fmt_pow10[FMT_MAX_DECIMALS + 1U] = { 1U, 10U, 100U, 1000U, 10000U, 100000U, 1000000U };
+
+void Fmt_Init(Fmt_t *f, char *buf, uint16_t size)
+{
+    f->buf = buf;
+    f->size = size;
+    f->len = 0;
+    f->overflow = (size == 0);
+    if (size) buf[0] = '\0';
+}
+
+/* 追加 n 个字符，放不下时截断 */
+static void fmt_put(Fmt_t *f, const char *s, uint16_t n)
+{
+    if (f->overflow) return;
+
+    uint16_t room = (uint16_t)(f->size - 1U - f->len);
+    if (n > room)
+    {
+        n = room;
+        f->overflow = true;
+    }
+    memcpy(&f->buf[f->len], s, n);
+    f->len += n;
+    f->buf[f->len] = '\0';
+}
+
+static void fmt_fill(Fmt_t *f, char c, uint8_t n)
+{
+    char tmp[16];
+
+    while (n)
+    {
+        uint8_t k = n < sizeof(tmp) ? n : (uint8_t)sizeof(tmp);
+        memset(tmp, c, k);
+        fmt_put(f, tmp, k);
+        n -= k;
+    }
+}
+
+uint8_t Fmt_Utoa(uint32_t v, char *out)
+{
+    char tmp[10];
+    uint8_t n = sizeof(tmp);
+
+    while (v >= 100U)
+    {
+        uint32_t q = v / 100U;
+        uint32_t r = (v - q * 100U) * 2U;
+        v = q;
+        n -= 2;
+        tmp[n] = fmt_dec2[r];
+        tmp[n + 1] = fmt_dec2[r + 1U];
+    }
+    if (v >= 10U)
+    {
+        n -= 2;
+        tmp[n] = fmt_dec2[v * 2U];
+        tmp[n + 1] = fmt_dec2[v * 2U + 1U];
+    }
+    else
+    {
+        tmp[--n] = (char)('0' + v);
+    }
+    memcpy(out, &tmp[n], sizeof(tmp) - n);
+    return (uint8_t)(sizeof(tmp) - n);
+}
+
+void Fmt_Char(Fmt_t *f, char c)
+{
+    fmt_put(f, &c, 1);
+}
+
+void Fmt_Str(Fmt_t *f, const char *s)
+{
+    fmt_put(f, s, (uint16_t)strlen(s));
+}
+
+/* 符号 + 数字，按 printf 规则补齐：补 0 时符号在最前，补空格时符号紧贴数字 */
+static void fmt_num(Fmt_t *f, bool neg, uint32_t mag, uint8_t width, char pad)
+{
+    char d[10];
+    uint8_t n = Fmt_Utoa(mag, d);
+    uint8_t w = (uint8_t)(n + (neg ? 1U : 0U));
+    uint8_t fill = width > w ? (uint8_t)(width - w) : 0U;
+
+    if (pad != '0') fmt_fill(f, ' ', fill);
+    if (neg) fmt_put(f, "-", 1);
+    if (pad == '0') fmt_fill(f, '0', fill);
+    fmt_put(f, d, n);
+}
+
+void Fmt_U32(Fmt_t *f, uint32_t v, uint8_t width, char pad)
+{
+    fmt_num(f, false, v, width, pad);
+}
+
+void Fmt_I32(Fmt_t *f, int32_t v, uint8_t width, char pad)
+{
+    fmt_num(f, v < 0, v < 0 ? 0U - (uint32_t)v : (uint32_t)v, width, pad);
+}
+
+void Fmt_Hex(Fmt_t *f, uint32_t v, uint8_t digits)
+{
+    char d[8];
+
+    if (digits == 0) digits = 1;
+    if (digits > 8U) digits = 8;
+    for (uint8_t i = digits; i > 0; i--)
+    {
+        d[i - 1U] = fmt_hex[v & 0xFU];
+        v >>= 4;
+    }
+    fmt_put(f, d, digits);
+}
+
+void Fmt_HexBytes(Fmt_t *f, const uint8_t *data, uint16_t len, char sep)
+{
+    char d[3];
+
+    for (uint16_t i = 0; i < len; i++)
+    {
+        uint8_t n = 0;
+        if (i && sep) d[n++] = sep;
+        d[n++] = fmt_hex[data[i] >> 4];
+        d[n++] = fmt_hex[data[i] & 0xFU];
+
+        /* 只输出完整的字节 */
+        if (f->len + n > f->size - 1U)
+        {
+            f->overflow = true;
+            return;
+        }
+        fmt_put(f, d, n);
+    }
+}
+
+void Fmt_Fixed(Fmt_t *f, float v, uint8_t decimals)
+{
+    uint32_t ip, fr;
+
+    if (decimals > FMT_MAX_DECIMALS) decimals = FMT_MAX_DECIMALS;
+    if (v != v)
+    {
+        Fmt_Str(f, "nan");
+        return;
+    }
+
+    bool neg = v < 0.0f;
+    float a = neg ? -v : v;
+    float s = a * fmt_pow10f[decimals];
+    uint32_t scale = fmt_pow10[decimals];
+
+    /* 4294967040 为小于 2^32 的最大 float */
+    if (s < 4294967040.0f)
+    {
+        uint32_t u = (uint32_t)(s + 0.5f);
+        ip = u / scale;
+        fr = u - ip * scale;
+    }
+    else if (a < 4294967040.0f)
+    {
+        /* 整数部分较大时小数位已无有效精度，单独取整避免溢出 */
+        ip = (uint32_t)a;
+        fr = (uint32_t)((a - (float)ip) * fmt_pow10f[decimals] + 0.5f);
+        if (fr >= scale) fr = scale - 1U;
+    }
+    else
+    {
+        if (neg) Fmt_Char(f, '-');
+        Fmt_Str(f, a > 3.4e38f ? "inf" : "ovf");
+        return;
+    }
+
+    char d[10];
+    if (neg && (ip | fr)) Fmt_Char(f, '-');
+    fmt_put(f, d, Fmt_Utoa(ip, d));
+    if (decimals)
+    {
+        uint8_t n = Fmt_Utoa(fr, d);
+        Fmt_Char(f, '.');
+        fmt_fill(f, '0', (uint8_t)(decimals - n));
+        fmt_put(f, d, n);
+    }
+}
+
+/* ---- 基准与自检 ---- */
+
+#define FMT_BENCH_ROUNDS   32U
+
+static uint32_t fmt_rand(uint32_t *s)
+{
+    *s = *s * 1664525U + 1013904223U;
+    return *s;
+}
+
+/* 一轮四组用例，先用 Fmt 再用 snprintf 生成同样的文本 */
+static void fmt_bench_round(uint32_t *seed, bool use_fmt, char out[4][64])
+{
+    Fmt_t f;
+    uint32_t kb = fmt_rand(seed) >> 12;
+    uint16_t addr = (uint16_t)fmt_rand(seed);
+    uint32_t pk = fmt_rand(seed) >> 8;
+    int32_t val = (int32_t)fmt_rand(seed) >> (fmt_rand(seed) & 31U);
+    uint8_t bytes[12];
+    for (uint8_t i = 0; i < sizeof(bytes); i++) bytes[i] = (uint8_t)fmt_rand(seed);
+    float t = (float)((int32_t)fmt_rand(seed) >> 16) / 37.0f;
+
+    if (use_fmt)
+    {
+        /* 测试结果消息（freertos.c） */
+        Fmt_Init(&f, out[0], 64);
+        Fmt_Str(&f, "SRAM Test: PASS (");
+        Fmt_U32(&f, kb, 0, ' ');
+        Fmt_Str(&f, "KB)");
+
+        /* 节点行（zbnet.c） */
+        Fmt_Init(&f, out[1], 64);
+        Fmt_Hex(&f, addr, 4);
+        Fmt_Str(&f, " pk:");
+        Fmt_U32(&f, pk, 0, ' ');
+        Fmt_Char(&f, ' ');
+        Fmt_I32(&f, val, 0, ' ');
+
+        /* 十六进制转储（zigbee.c） */
+        Fmt_Init(&f, out[2], 64);
+        Fmt_HexBytes(&f, bytes, sizeof(bytes), ' ');
+
+        /* 定点温度 */
+        Fmt_Init(&f, out[3], 64);
+        Fmt_Str(&f, "T=");
+        Fmt_Fixed(&f, t, 2);
+        return;
+    }
+
+    snprintf(out[0], 64, "SRAM Test: PASS (%luKB)", (unsigned long)kb);
+    snprintf(out[1], 64, "%04X pk:%lu %ld", addr, (unsigned long)pk, (long)val);
+    int pos = 0;
+    for (uint8_t i = 0; i < sizeof(bytes); i++)
+        pos += snprintf(&out[2][pos], 64 - pos, i ? " %02X" : "%02X", bytes[i]);
+
+    /* newlib-nano 不含 %f，按 telemetry.c 中的方式拆成整数与小数两部分 */
+    int32_t x = (int32_t)(t * 100.0f + (t >= 0.0f ? 0.5f : -0.5f));
+    uint32_t a = (uint32_t)(x < 0 ? -x : x);
+    snprintf(out[3], 64, "T=%s%lu.%02lu", x < 0 ? "-" : "", (unsigned long)(a / 100U), (unsigned long)(a % 100U));
+}
+
+uint8_t Fmt_Bench(fmt_cycles_fn cycles, Fmt_Bench_t *bench)
+{
+    static char a[4][64], b[4][64];
+    uint32_t seed_a = 1, seed_b = 1;
+    Fmt_Bench_t r = {0};
+
+    for (uint32_t i = 0; i < FMT_BENCH_ROUNDS; i++)
+    {
+        uint32_t t0 = cycles ? cycles() : 0U;
+        fmt_bench_round(&seed_a, true, a);
+        uint32_t t1 = cycles ? cycles() : 0U;
+        fmt_bench_round(&seed_b, false, b);
+        uint32_t t2 = cycles ? cycles() : 0U;
+
+        r.fmt_cycles += t1 - t0;
+        r.printf_cycles += t2 - t1;
+        for (uint8_t k = 0; k < 4U; k++)
+        {
+            r.cases++;
+            if (strcmp(a[k], b[k]) != 0) r.mismatches++;
+        }
+    }
+
+    /* 边界值 */
+    static const struct { float v; uint8_t dec; const char *s; } fixed[] = {
+        { 0.0f, 2, "0.00" }, { -0.004f, 2, "0.00" }, { -0.005f, 1, "0.0" }, { 1.5f, 0, "2" },
+        { 2.675f, 2, "2.68" }, { -273.15f, 2, "-273.15" }, { 101325.0f, 1, "101325.0" },
+        { 0.000123f, 6, "0.000123" }, { 5e9f, 1, "ovf" },
+    };
+    char s[24];
+    Fmt_t f;
+    for (uint8_t i = 0; i < sizeof(fixed) / sizeof(fixed[0]); i++)
+    {
+        Fmt_Init(&f, s, sizeof(s));
+        Fmt_Fixed(&f, fixed[i].v, fixed[i].dec);
+        r.cases++;
+        if (strcmp(s, fixed[i].s) != 0) r.mismatches++;
+    }
+
+    Fmt_Init(&f, s, sizeof(s));
+    Fmt_I32(&f, INT32_MIN, 0, ' ');
+    Fmt_Char(&f, '|');
+    Fmt_I32(&f, -42, 6, '0');
+    Fmt_Char(&f, '|');
+    Fmt_U32(&f, 7, 3, ' ');
+    r.cases++;
+    if (strcmp(s, "-2147483648|-00042|  7") != 0) r.mismatches++;
+
+    /* 截断：始终以 0 结尾，十六进制只输出完整字节 */
+    static const uint8_t hx[] = { 0xDE, 0xAD, 0xBE, 0xEF };
+    Fmt_Init(&f, s, 8);
+    Fmt_HexBytes(&f, hx, sizeof(hx), ' ');
+    r.cases++;
+    if (strcmp(s, "DE AD") != 0 || !f.overflow) r.mismatches++;
+
+    if (bench) *bench = r;
+    return r.mismatches ? 1 : 0;
+}
@@ -35,7 +35,20 @@
 #include "sram.h"
 #include "eeprom.h"
 #include "flash.h"
-#include <stdio.h>
+#include "adcstream.h"
+#include "spectrum.h"
+#include "telemetry.h"
+#include "zbnet.h"
+#include "dlog.h"
+#include "fmt.h"
+#include "cannode.h"
+#include "btxfer.h"
+#include "console.h"
+#include "bmp280.h"
+#include "altitude.h"
+#include "sigcond.h"
+#include "dwt.h"
+#include "i2c.h"
 
 
 
@@ -80,6 +93,62 @@ const osThreadAttr_t getdataTask_attributes = {
   .priority = (osPriority_t) osPriorityNormal,
 };
 
+osThreadId_t adcStreamTaskHandle;
+const osThreadAttr_t adcStreamTask_attributes = {
+  .name = "adcStreamTask",
+  .stack_size = 256 * 4,
+  .priority = (osPriority_t) osPriorityAboveNormal,
+};
+
+osThreadId_t spectrumTaskHandle;
+const osThreadAttr_t spectrumTask_attributes = {
+  .name = "spectrumTask",
+  .stack_size = 256 * 4,
+  .priority = (osPriority_t) osPriorityBelowNormal,
+};
+
+osThreadId_t telemetryTaskHandle;
+const osThreadAttr_t telemetryTask_attributes = {
+  .name = "telemetryTask",
+  .stack_size = 256 * 4,
+  .priority = (osPriority_t) osPriorityBelowNormal,
+};
+
+osThreadId_t zbnetTaskHandle;
+const osThreadAttr_t zbnetTask_attributes = {
+  .name = "zbnetTask",
+  .stack_size = 256 * 4,
+  .priority = (osPriority_t) osPriorityNormal,
+};
+
+osThreadId_t dlogTaskHandle;
+const osThreadAttr_t dlogTask_attributes = {
+  .name = "dlogTask",
+  .stack_size = 256 * 4,
+  .priority = (osPriority_t) osPriorityLow,
+};
+
+osThreadId_t canTaskHandle;
+const osThreadAttr_t canTask_attributes = {
+  .name = "canTask",
+  .stack_size = 256 * 4,
+  .priority = (osPriority_t) osPriorityBelowNormal,
+};
+
+osThreadId_t btxferTaskHandle;
+const osThreadAttr_t btxferTask_attributes = {
+  .name = "btxferTask",
+  .stack_size = 256 * 4,
+  .priority = (osPriority_t) osPriorityBelowNormal,
+};
+
+osThreadId_t consoleTaskHandle;
+const osThreadAttr_t consoleTask_attributes = {
+  .name = "consoleTask",
+  .stack_size = 384 * 4,
+  .priority = (osPriority_t) osPriorityLow,
+};
+
 osThreadId_t usart2TaskHandle;
 const osThreadAttr_t usart2Task_attributes = {
   .name = "usart2Task",
@@ -122,6 +191,13 @@ const osThreadAttr_t flashTestTask_attributes = {
   .priority = (osPriority_t) osPriorityBelowNormal,
 };
 
+osThreadId_t selfTestTaskHandle;
+const osThreadAttr_t selfTestTask_attributes = {
+  .name = "selfTestTask",
+  .stack_size = 512 * 4,
+  .priority = (osPriority_t) osPriorityLow,
+};
+
 
 
 /* USER CODE END Variables */
@@ -145,6 +221,7 @@ void CameraTask(void *argument);
 void SramTestTask(void *argument);
 void EepromTestTask(void *argument);
 void FlashTestTask(void *argument);
+void SelfTestTask(void *argument);
 
 void StartDefaultTask(void *argument);
 
@@ -159,14 +236,29 @@ void vApplicationMallocFailedHook(void);
 
 /* USER CODE BEGIN 1 */
 /* Functions needed when configGENERATE_RUN_TIME_STATS is on */
-__weak void configureTimerForRunTimeStats(void)
-{
+/* 运行时间统计时基：DWT 周期计数在软件中扩展到 64 位后右移 12 位（168MHz 下约 41kHz，
+   32 位计数约 29 小时回绕）。调度器每次切换任务都会读取，间隔远小于 CYCCNT 约 25s 的回绕周期 */
+#define RTS_SHIFT  12U
+
+static uint64_t rts_cycles;
+static uint32_t rts_last;
 
+void configureTimerForRunTimeStats(void)
+{
+  DWT_Init();
+  rts_last = DWT_GetCycles();
 }
 
-__weak unsigned long getRunTimeCounterValue(void)
+unsigned long getRunTimeCounterValue(void)
 {
-return 0;
+  uint32_t pm = __get_PRIMASK();
+  __disable_irq();
+  uint32_t now = DWT_GetCycles();
+  rts_cycles += now - rts_last;
+  rts_last = now;
+  unsigned long v = (unsigned long)(rts_cycles >> RTS_SHIFT);
+  __set_PRIMASK(pm);
+  return v;
 }
 /* USER CODE END 1 */
 
@@ -234,6 +326,8 @@ void MX_FREERTOS_Init(void) {
 
   /* USER CODE BEGIN RTOS_MUTEX */
   /* add mutexes, ... */
+  I2C1_LockInit();
+  W25Q128_LockInit();
   /* USER CODE END RTOS_MUTEX */
 
   /* USER CODE BEGIN RTOS_SEMAPHORES */
@@ -256,12 +350,26 @@ void MX_FREERTOS_Init(void) {
   lcdTaskHandle = osThreadNew(LcdDisplayTask, NULL, &lcdTask_attributes);
   iwdgTaskHandle = osThreadNew(IwdgFeedTask, NULL, &iwdgTask_attributes);
   getdataTaskHandle = osThreadNew(GetDataTask, NULL, &getdataTask_attributes);
+  adcStreamTaskHandle = osThreadNew(AdcStreamTask, NULL, &adcStreamTask_attributes);
+  spectrumTaskHandle = osThreadNew(SpectrumTask, NULL, &spectrumTask_attributes);
+  telemetryTaskHandle = osThreadNew(TelemetryTask, NULL, &telemetryTask_attributes);
+  dlogTaskHandle = osThreadNew(DLogTask, NULL, &dlogTask_attributes);
+  canTaskHandle = osThreadNew(CanTask, NULL, &canTask_attributes);
+#if ZBNET_ENABLE
+  /* ZigBee 模块与蓝牙模块共用 USART2，二选一（见 zbnet.h） */
+  static const UartRx_Port_t zbnet_port = ZigBee_DEFAULT_PORT;
+  zbnetTaskHandle = osThreadNew(ZbNetTask, (void *)&zbnet_port, &zbnetTask_attributes);   /* ZigBee 协调器，占用 USART2 */
+#else
+  btxferTaskHandle = osThreadNew(BtXferTask, NULL, &btxferTask_attributes);   /* 蓝牙，占用 USART2 */
+#endif
+  consoleTaskHandle = osThreadNew(ConsoleTask, NULL, &consoleTask_attributes);   /* 默认在 USART1，可用 attach 命令加到其他端口 */
   usart2TaskHandle = osThreadNew(Usart2Task, NULL, &usart2Task_attributes);
   usart3TaskHandle = osThreadNew(Usart3Task, NULL, &usart3Task_attributes);
   //cameraTaskHandle = osThreadNew(CameraTask, NULL, &cameraTask_attributes);
   sramTestTaskHandle = osThreadNew(SramTestTask, NULL, &sramTestTask_attributes);
   eepromTestTaskHandle = osThreadNew(EepromTestTask, NULL, &eepromTestTask_attributes);
   flashTestTaskHandle = osThreadNew(FlashTestTask, NULL, &flashTestTask_attributes);
+  selfTestTaskHandle = osThreadNew(SelfTestTask, NULL, &selfTestTask_attributes);
 
   /* USER CODE END RTOS_THREADS */
 
@@ -326,10 +434,11 @@ void SramTestTask(void *argument)
 
     if (result == 0)
     {
-        if (testedSize >= 1024)
-            sprintf(msg, "SRAM Test: PASS (%luMB)", testedSize / 1024);
-        else
-            sprintf(msg, "SRAM Test: PASS (%luKB)", testedSize);
+        Fmt_t f;
+        Fmt_Init(&f, msg, sizeof(msg));
+        Fmt_Str(&f, "SRAM Test: PASS (");
+        Fmt_U32(&f, testedSize >= 1024 ? testedSize / 1024 : testedSize, 0, ' ');
+        Fmt_Str(&f, testedSize >= 1024 ? "MB)" : "KB)");
         lcd_show_string(10, 630, 460, 24, 24, msg, GREEN);
     }
     else
@@ -360,7 +469,11 @@ void EepromTestTask(void *argument)
 
     if (result == 0)
     {
-        sprintf(msg, "EEPROM Test: PASS (%dB)", testedSize);
+        Fmt_t f;
+        Fmt_Init(&f, msg, sizeof(msg));
+        Fmt_Str(&f, "EEPROM Test: PASS (");
+        Fmt_U32(&f, testedSize, 0, ' ');
+        Fmt_Str(&f, "B)");
         lcd_show_string(10, 690, 460, 24, 24, msg, GREEN);
     }
     else
@@ -388,16 +501,20 @@ void FlashTestTask(void *argument)
     lcd_show_string(10, 720, 460, 24, 24, "Flash Testing...", BLUE);
 
     /* 初始化驱动（含 PB14 CS GPIO 配置） */
+    W25Q128_Lock();
     W25Q128_Init();
+    W25Q128_Unlock();
 
+    /* 在最后一个扇区读写并恢复原内容，不破坏已上传的数据 */
     uint8_t result = W25Q128_Test(&testedSize);
 
     if (result == 0)
     {
-        if (testedSize >= 1024)
-            sprintf(msg, "Flash Test: PASS (%luMB)", testedSize / 1024);
-        else
-            sprintf(msg, "Flash Test: PASS (%luKB)", testedSize);
+        Fmt_t f;
+        Fmt_Init(&f, msg, sizeof(msg));
+        Fmt_Str(&f, "Flash Test: PASS (");
+        Fmt_U32(&f, testedSize >= 1024 ? testedSize / 1024 : testedSize, 0, ' ');
+        Fmt_Str(&f, testedSize >= 1024 ? "MB)" : "KB)");
         lcd_show_string(10, 750, 460, 24, 24, msg, GREEN);
     }
     else if (result == 1)
@@ -413,5 +530,43 @@ void FlashTestTask(void *argument)
     osThreadTerminate(osThreadGetId());
 }
 
+/**
+ * @brief  算法自检任务
+ *         上电后以低优先级依次运行各模块的纯计算自检与性能测量（不访问外设），
+ *         结果经 DLOG 输出（PASS 为 INFO，FAIL 为 ERROR），完成后自动删除任务
+ */
+void SelfTestTask(void *argument)
+{
+    /* 等待各外设任务启动，避免测量期间与初始化争抢 CPU */
+    osDelay(2000);
+    DWT_Init();
+
+    BMP280_CompBench_t bmp;
+    int r = BMP280_CompTest(DWT_GetCycles, &bmp);
+    if (r == 0)
+        LOG_I("bmp280 comp PASS int64=%u int32=%u float=%u cyc, err32=%f errf=%f Pa",
+              bmp.cycles[BMP280_COMP_INT64], bmp.cycles[BMP280_COMP_INT32], bmp.cycles[BMP280_COMP_FLOAT],
+              DLOG_F(bmp.max_err_pa[BMP280_COMP_INT32]), DLOG_F(bmp.max_err_pa[BMP280_COMP_FLOAT]));
+    else
+        LOG_E("bmp280 comp FAIL %u", (uint32_t)r);
+
+    Altitude_Bench_t alt;
+    if (Altitude_Test(DWT_GetCycles, &alt) == 0)
+        LOG_I("altitude PASS table=%u powf=%u cyc, err=%f m",
+              alt.cycles_fast, alt.cycles_powf, DLOG_F(alt.max_err_m));
+    else
+        LOG_E("altitude FAIL err=%f m", DLOG_F(alt.max_err_m));
+
+    if (SigCond_Test() == 0) LOG_I("sigcond biquad PASS");
+    else                     LOG_E("sigcond biquad FAIL");
+
+    DLog_Bench_t dl;
+    DLog_Bench(&dl);
+    LOG_I("dlog write=%u snprintf=%u cyc", dl.write_cycles, dl.sprintf_cycles);
+
+    /* 测试完成，删除自身 */
+    osThreadTerminate(osThreadGetId());
+}
+
 /* USER CODE END Application */
 
@@ -1,50 +1,388 @@
 #include "getdata.h"
+#include "altitude.h"
+#include "config.h"
+#include "sensorbus.h"
+#include "sigcond.h"
+#include "i2c.h"
+#include "dlog.h"
 
-float T1 = 0;
-float T2 = 0;
-float H  = 0;
-float L  = 0;
-float P  = 0;
-float A  = 0;
-float D  = 0;
+/* 采集任务私有的暂存快照：各 collect 写入这里，一轮结束后整体发布 */
+static SensorSnapshot_t stage;
 
+/* 更新暂存字段（不经信号调理）；失败时保留上一次的值与时间戳，只标记状态 */
+static void stage_put(snap_field_t f, float value, int ok)
+{
+    if (ok)
+    {
+        stage.f[f].value = value;
+        stage.f[f].tick = osKernelGetTickCount();
+        stage.f[f].status = SNAP_ST_OK;
+    }
+    else
+    {
+        stage.f[f].status = SNAP_ST_ERROR;
+    }
+}
+
+/* 更新暂存字段（经信号调理） */
+static void stage_set(snap_field_t f, float value, int ok)
+{
+    stage_put(f, ok ? SigCond_Process(f, value) : value, ok);
+}
+
+/*
+ * 流水线采集调度：
+ * 每个传感器分为 "触发(start)" 与 "读取(collect)" 两步。到期的传感器先全部触发，
+ * 随后任务休眠到最早的就绪/到期时刻再逐个读取，因此一轮采集的耗时为
+ * 最长的单次转换时间，而不是各传感器等待时间之和。
+ * conv_ms == 0 的传感器没有独立的转换过程，在 collect 中同步完成
+ * （放在所有触发之后执行，其耗时与其它传感器的转换重叠）。
+ */
+typedef struct {
+    int (*start)(void);         /* 触发转换，返回 0 成功；可为 NULL */
+    int (*collect)(void);       /* 读取结果，返回 0 成功，ACQ_NO_DATA 表示传感器尚无新结果（不算失败） */
+    uint32_t conv_ms;           /* 触发到结果就绪的时间 */
+    volatile uint32_t period_ms;/* 采样周期，0 = 停止 */
+    uint32_t retry_ms;          /* 自主测量的传感器：无新结果时的重试间隔，0 = 不重试 */
+    volatile uint8_t reconf;    /* 周期已修改，需按新采样率重新配置信号调理 */
+    uint32_t next_due;          /* 下次触发时刻 (tick) */
+    uint32_t ready_at;          /* 本次结果就绪时刻 (tick) */
+    uint8_t  busy;              /* 已触发，等待读取 */
+    uint16_t fails;             /* 连续读取失败次数，只在开始失败与恢复时记日志（编号见 getdata_sensor_t） */
+} acq_sensor_t;
+
+/* collect 返回值：传感器自行按周期测量，本次读取时新结果还未产生 */
+#define ACQ_NO_DATA  2
+
+static int bmp280_collect(void)
+{
+    float t = 0.0f, p = 0.0f;
+    int ok = (BMP280_ReadTempPressure(&t, &p) == BMP280_OK);
+
+    stage_set(SNAP_T1, t, ok);
+    stage_set(SNAP_P, p, ok);
+    /* 海拔由滤波后的气压计算，不再单独滤波 */
+    stage_put(SNAP_A, ok ? Altitude_Calc(stage.f[SNAP_P].value) : 0.0f, ok);
+    return ok ? 0 : 1;
+}
+
+/* SHT30 工作在周期测量模式，读取时直接取最新结果，无新数据不算错误。
+   取到的结果由驱动带时间戳放入样本流，这里把流中的样本逐个经信号调理，
+   快照时间戳用样本自身的读取时刻 */
+static int sht30_collect(void)
+{
+    SHT30_Sample_t s[4];
+    uint16_t n;
+    char ret = SHT30_FetchPeriodic(NULL, NULL);
+
+    if (ret == SHT30_NO_DATA) return ACQ_NO_DATA;
+    if (ret != 0)
+    {
+        stage_set(SNAP_T2, 0.0f, 0);
+        stage_set(SNAP_H, 0.0f, 0);
+        return 1;
+    }
+    while ((n = SHT30_StreamRead(s, 4)) > 0)
+    {
+        for (uint16_t i = 0; i < n; i++)
+        {
+            stage_set(SNAP_T2, s[i].temp, 1);
+            stage_set(SNAP_H, s[i].hum, 1);
+        }
+        stage.f[SNAP_T2].tick = s[n - 1U].tick;
+        stage.f[SNAP_H].tick = s[n - 1U].tick;
+    }
+    return 0;
+}
+
+/* BH1750 工作在连续自动量程模式，读取只需 2 字节；量程切换期间保留上次结果 */
+static int bh1750_collect(void)
+{
+    float lux = 0.0f;
+    int ret = BH1750_FetchLux(&lux);
+
+    if (ret == BH1750_BUSY) return 0;
+    stage_set(SNAP_L, lux, ret == BH1750_OK);
+    return ret ? 1 : 0;
+}
+
+/* HC-SR04 在后台连续测距，这里只取走队列中的结果，保留最新的滤波距离。
+   队列为空（两次测距之间）不算失败，快照保持上次的值与状态；
+   只有本轮取到的结果全部超时才标记为错误 */
+static int hcsr04_collect(void)
+{
+    hcsr04_result_t res;
+    int got = 0, ok = 0;
+    float d = 0.0f;
+
+    if (stage.f[SNAP_T2].status == SNAP_ST_OK)
+    {
+        HC_SR04_SetAirTemperature(stage.f[SNAP_T2].value);
+    }
+    while (HC_SR04_GetResult(&res, 0) == HCSR04_OK)
+    {
+        got = 1;
+        if (res.status == HCSR04_OK)
+        {
+            d = res.cm;
+            ok = 1;
+        }
+    }
+    if (!got) return ACQ_NO_DATA;
+    stage_set(SNAP_D, d, ok);
+    return ok ? 0 : 1;
+}
+
+/* SHT30 周期测量频率 */
+#define SHT30_MPS  SHT30_MPS_1
+
+/* SHT30 读取的相位跟踪间隔 (ms)：读取时刻最多比新结果晚这么多 */
+#define SHT30_RETRY_MS  50U
+
+static acq_sensor_t acq_table[GETDATA_SENSOR_NUM] = {
+    [GETDATA_BMP280] = { NULL,                bmp280_collect, 0,                  GETDATA_DEFAULT_PERIOD_MS },
+    [GETDATA_SHT30]  = { NULL,                sht30_collect,  0,                  GETDATA_DEFAULT_PERIOD_MS, SHT30_RETRY_MS },
+    [GETDATA_BH1750] = { NULL,                bh1750_collect, 0,                  GETDATA_DEFAULT_PERIOD_MS },
+    [GETDATA_HCSR04] = { NULL,                hcsr04_collect, 0,                  GETDATA_DEFAULT_PERIOD_MS },
+};
+
+/* HC-SR04 连续测距周期 (ms) */
+#define HCSR04_PERIOD_MS  100U
+
+/* tick 比较（兼容回绕）：a 是否已到达 b */
+static inline int tick_reached(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) >= 0;
+}
+
+void GetData_SetPeriod(getdata_sensor_t sensor, uint32_t period_ms)
+{
+    if (sensor >= GETDATA_SENSOR_NUM) return;
+    if (acq_table[sensor].period_ms == period_ms) return;
+    acq_table[sensor].period_ms = period_ms;
+    acq_table[sensor].reconf = 1;    /* 滤波器状态只在采集任务中修改 */
+}
+
+uint32_t GetData_GetPeriod(getdata_sensor_t sensor)
+{
+    if (sensor >= GETDATA_SENSOR_NUM) return 0;
+    return acq_table[sensor].period_ms;
+}
+
+/* 触发所有到期且空闲的传感器 */
+static void acq_trigger_due(uint32_t now)
+{
+    for (int i = 0; i < GETDATA_SENSOR_NUM; i++)
+    {
+        acq_sensor_t *s = &acq_table[i];
+        uint32_t period = s->period_ms;
+
+        if (period == 0 || s->busy || !tick_reached(now, s->next_due)) continue;
+
+        /* 下次到期时刻按周期推进；若已落后一个周期以上则从当前时刻重新对齐 */
+        s->next_due += period;
+        if (tick_reached(now, s->next_due)) s->next_due = now + period;
+
+        if (s->start != NULL)
+        {
+            I2C1_Lock();
+            int ret = s->start();
+            I2C1_Unlock();
+            if (ret != 0) continue;   /* 触发失败，本周期跳过 */
+        }
+
+        s->ready_at = now + s->conv_ms;
+        s->busy = 1;
+    }
+}
+
+/* 读取所有已就绪的传感器，有新结果时发布一份快照 */
+static void acq_collect_ready(void)
+{
+    int collected = 0;
+
+    for (int i = 0; i < GETDATA_SENSOR_NUM; i++)
+    {
+        acq_sensor_t *s = &acq_table[i];
+        if (!s->busy || !tick_reached(osKernelGetTickCount(), s->ready_at)) continue;
+
+        /* 传感器与 EEPROM 共用 I2C1，参数保存期间在此等待 */
+        I2C1_Lock();
+        int ret = s->collect();
+        I2C1_Unlock();
+        s->busy = 0;
+
+        /*
+         * 自主测量的传感器（SHT30 周期模式）与本任务各用各的时钟，读取周期等于测量周期时
+         * 两者相位会慢慢漂移：读取落在新结果之前就读不到，落在下一次测量之后就丢掉一个。
+         * 因此读取时刻跟踪传感器的相位：无新结果时 retry_ms 后再读，读到后下次提前
+         * retry_ms 读取，使读取总落在新结果产生后的 retry_ms 之内。
+         */
+        uint32_t period = s->period_ms;
+        if (s->retry_ms != 0 && period != 0)
+        {
+            uint32_t now = osKernelGetTickCount();
+            if (ret == ACQ_NO_DATA)          s->next_due = now + s->retry_ms;
+            else if (period > s->retry_ms)   s->next_due = now + period - s->retry_ms;
+            else                             s->next_due = now + period;
+        }
+        if (ret != ACQ_NO_DATA) collected = 1;
+
+        if (ret == 1)
+        {
+            if (s->fails++ == 0) LOG_W("sensor %u read failed", (uint32_t)i);
+        }
+        else if (ret == 0 && s->fails != 0)
+        {
+            LOG_I("sensor %u recovered after %u failed reads", (uint32_t)i, (uint32_t)s->fails);
+            s->fails = 0;
+        }
+    }
+
+    if (collected)
+    {
+        Snapshot_Publish(&stage);
+        stage.version = Snapshot_Version();
+        SensorBus_Publish(&stage);
+    }
+}
+
+/* 计算下一次需要唤醒的时刻：最早的就绪时刻或到期时刻 */
+static uint32_t acq_next_wakeup(uint32_t now)
+{
+    uint32_t wake = now + GETDATA_DEFAULT_PERIOD_MS;
+
+    for (int i = 0; i < GETDATA_SENSOR_NUM; i++)
+    {
+        acq_sensor_t *s = &acq_table[i];
+        uint32_t t;
+
+        if (s->busy)                t = s->ready_at;
+        else if (s->period_ms != 0) t = s->next_due;
+        else                        continue;
+
+        if ((int32_t)(t - wake) < 0) wake = t;
+    }
+    return wake;
+}
+
+/* 各传感器对应的调理通道；海拔由滤波后的气压计算，不单独调理 */
+static const struct {
+    snap_field_t ch;
+    getdata_sensor_t sensor;
+    uint8_t median;             /* HC-SR04 驱动已做中值滤波，此处不再重复 */
+} sc_map[] = {
+    { SNAP_T1, GETDATA_BMP280, 1 },
+    { SNAP_P,  GETDATA_BMP280, 1 },
+    { SNAP_T2, GETDATA_SHT30,  1 },
+    { SNAP_H,  GETDATA_SHT30,  1 },
+    { SNAP_L,  GETDATA_BH1750, 1 },
+    { SNAP_D,  GETDATA_HCSR04, 0 },
+};
+
+/* 按传感器当前采样周期配置其调理通道，截止频率取 fs/5 */
+static void sigcond_config_sensor(getdata_sensor_t sensor)
+{
+    uint32_t period = acq_table[sensor].period_ms;
+    if (period == 0) return;
+    float fs = 1000.0f / (float)period;
+
+    for (uint32_t i = 0; i < sizeof(sc_map) / sizeof(sc_map[0]); i++)
+    {
+        if (sc_map[i].sensor == sensor)
+            SigCond_Config(sc_map[i].ch, fs, 0.2f * fs, sc_map[i].median);
+    }
+}
+
+/* BH1750 采样周期短于此值时高分辨率模式（约 120 ms 刷新）跟不上，切到低分辨率连续模式 */
+#define BH1750_LOW_LATENCY_MS  120U
+
+/* 按 BH1750 的采样周期选择低延迟（L-res）或自动量程（H-res）模式，只在需要切换时发命令 */
+static void bh1750_apply_period(void)
+{
+    static uint8_t low_latency = 0;
+    uint32_t period = acq_table[GETDATA_BH1750].period_ms;
+    uint8_t want = (period != 0U && period < BH1750_LOW_LATENCY_MS) ? 1U : 0U;
+
+    if (want == low_latency) return;
+    I2C1_Lock();
+    if (BH1750_SetLowLatency(want != 0U) == BH1750_OK) low_latency = want;
+    I2C1_Unlock();
+}
+
+/* 采样周期被修改过的传感器重新配置滤波器（BH1750 同时调整测量模式） */
+static void sigcond_apply_periods(void)
+{
+    for (int i = 0; i < GETDATA_SENSOR_NUM; i++)
+    {
+        if (!acq_table[i].reconf) continue;
+        acq_table[i].reconf = 0;
+        sigcond_config_sensor((getdata_sensor_t)i);
+        if (i == GETDATA_BH1750) bh1750_apply_period();
+    }
+}
 
 void GetDataTask(void *argument)
 {
   /* USER CODE BEGIN GetDataTask */
 
+  /* 载入持久化参数（海平面参考气压等） */
+  Config_Load();
+  Altitude_LoadSeaLevel();
+
+  I2C1_Lock();
   BMP280_Init();
   if(BMP280_Init() != BMP280_OK){
-    // 初始化失败处理
+    LOG_E("bmp280 init failed");
   }
   
   if(!SHT30_Check())
   {
-    // 初始化失败处理
+    LOG_E("sht30 not responding");
   }
+  SHT30_StartPeriodic(SHT30_MPS);
+  GetData_SetPeriod(GETDATA_SHT30, SHT30_PeriodicIntervalMs(SHT30_MPS));
     
   BH1750_PowerOn();
   BH1750_Reset();
-  if(BH1750_SetMode(0x21) != BH1750_OK)
+  if(BH1750_StartContinuous() != BH1750_OK)
   {
-    // 初始化失败处理
+    LOG_E("bh1750 start failed");
   }
+  I2C1_Unlock();
 
   HC_SR04_Init(GPIOG, GPIO_PIN_6, GPIOG, GPIO_PIN_7, GPIO_NOPULL);
   HC_SR04_SetTimeoutUs(30000);  //测量超时(30ms) 
+  HC_SR04_Start(HCSR04_PERIOD_MS);
+
+  /* 信号调理按各通道的采样周期配置，截止频率取 fs/5；之后周期修改时在循环中重新配置 */
+  SigCond_Init();
+  for (int i = 0; i < GETDATA_SENSOR_NUM; i++)
+  {
+    acq_table[i].reconf = 1;
+  }
+  sigcond_apply_periods();
+
+  uint32_t now = osKernelGetTickCount();
+  for (int i = 0; i < GETDATA_SENSOR_NUM; i++)
+  {
+    acq_table[i].next_due = now;
+  }
 
   /* Infinite loop */
   for(;;)
   {
-    // 在此处添加获取数据的代码
-    BMP280_ReadTempPressure(&T1 , &P);
-    A = (int)BMP280_CalcAltitude(P, 101325.0f);
-    SHT30_Read_SingleShot(&T2, &H);
-    BH1750_ReadLux(&L);
-    HC_SR04_Measure(NULL,&D);
-    
-    osDelay(1000);
+    sigcond_apply_periods();
+    now = osKernelGetTickCount();
+    acq_trigger_due(now);
+    acq_collect_ready();
+
+    now = osKernelGetTickCount();
+    uint32_t wake = acq_next_wakeup(now);
+    if (!tick_reached(now, wake))
+    {
+      osDelayUntil(wake);
+    }
   }
   /* USER CODE END GetDataTask */
 }
-
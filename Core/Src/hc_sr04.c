@@ -1,7 +1,21 @@
 #include "hc_sr04.h"
 #include "main.h" /* for SystemCoreClock and HAL */
+#include "cmsis_os2.h"
 
 #include <stdbool.h>
+#include <string.h>
+
+/* 测量状态机 */
+typedef enum {
+    HC_IDLE = 0,     /* 空闲 */
+    HC_TRIG,         /* TRIG 高电平中，等待 10us 到 */
+    HC_WAIT_RISE,    /* 等待回波上升沿 */
+    HC_WAIT_FALL,    /* 回波高电平中，等待下降沿 */
+    HC_WAIT_NEXT     /* 连续模式：等待下一周期 */
+} hc_state_t;
+
+#define HC_TRIG_US        10U
+#define HC_IRQ_PRIORITY   5U   /* 不高于 configMAX_SYSCALL_INTERRUPT_PRIORITY，ISR 中可调用 osMessageQueuePut */
 
 static GPIO_TypeDef *hc_trig_port = NULL;
 static uint16_t hc_trig_pin = 0;
@@ -9,28 +23,160 @@ static GPIO_TypeDef *hc_echo_port = NULL;
 static uint16_t hc_echo_pin = 0;
 static uint32_t hc_timeout_us = 30000; /* default 30 ms */
 
-static uint32_t dwt_scale = 0; /* SystemCoreClock / 1_000_000 */
+static TIM_HandleTypeDef htim_hc;
+static osMessageQueueId_t hc_queue = NULL;
+static volatile hcsr04_callback_t hc_callback = NULL;
+
+static volatile hc_state_t hc_state = HC_IDLE;
+static volatile uint32_t hc_period_us = 0;     /* 0 = 单次 */
+static uint32_t hc_cycle_start = 0;            /* 本次触发开始时刻 (us) */
+static uint32_t hc_rise_us = 0;
+
+/* 声速的一半，单位 cm/us，默认按 20℃ */
+static volatile float hc_half_c = (331.3f + 0.606f * 20.0f) * 1e-4f * 0.5f;
+
+/* 中值滤波窗口 */
+static float hc_window[HCSR04_MEDIAN_LEN];
+static uint8_t hc_win_count = 0;
+static uint8_t hc_win_pos = 0;
+
+static inline uint32_t hc_now_us(void)
+{
+    return TIM2->CNT;
+}
+
+/* 在时刻 at (us) 产生 CC1 中断；已过期则尽快触发 */
+static void hc_arm(uint32_t at)
+{
+    if ((int32_t)(at - hc_now_us()) < 2) at = hc_now_us() + 2U;
+    TIM2->CCR1 = at;
+    TIM2->SR = ~TIM_SR_CC1IF;
+    TIM2->DIER |= TIM_DIER_CC1IE;
+}
+
+static void hc_disarm(void)
+{
+    TIM2->DIER &= ~TIM_DIER_CC1IE;
+    TIM2->SR = ~TIM_SR_CC1IF;
+}
+
+static IRQn_Type hc_exti_irqn(uint16_t pin)
+{
+    uint32_t n = (uint32_t)__builtin_ctz(pin);
+    if (n <= 4U) return (IRQn_Type)(EXTI0_IRQn + (int)n);
+    if (n <= 9U) return EXTI9_5_IRQn;
+    return EXTI15_10_IRQn;
+}
+
+static float hc_median_push(float cm)
+{
+    float sorted[HCSR04_MEDIAN_LEN];
+
+    hc_window[hc_win_pos] = cm;
+    hc_win_pos = (uint8_t)((hc_win_pos + 1U) % HCSR04_MEDIAN_LEN);
+    if (hc_win_count < HCSR04_MEDIAN_LEN) hc_win_count++;
+
+    /* 插入排序，窗口很小 */
+    for (uint8_t i = 0; i < hc_win_count; i++)
+    {
+        float v = hc_window[i];
+        int8_t j = (int8_t)i - 1;
+        while (j >= 0 && sorted[j] > v)
+        {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = v;
+    }
+    return sorted[hc_win_count / 2U];
+}
 
-static inline void dwt_init_once(void)
+static void hc_start_trigger(void)
 {
-    if (dwt_scale != 0) return;
-    /* enable DWT */
-    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
-    DWT->CYCCNT = 0;
-    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
-    dwt_scale = SystemCoreClock / 1000000U;
-    if (dwt_scale == 0) dwt_scale = 1;
+    hc_cycle_start = hc_now_us();
+    HAL_GPIO_WritePin(hc_trig_port, hc_trig_pin, GPIO_PIN_SET);
+    hc_state = HC_TRIG;
+    hc_arm(hc_cycle_start + HC_TRIG_US);
 }
 
-static inline uint32_t dwt_get_us(void)
+/* 一次测量结束（成功或超时）：交付结果并安排下一次 */
+static void hc_finish(hcsr04_status_t status, uint32_t pulse_us)
 {
-    return DWT->CYCCNT / dwt_scale;
+    hcsr04_result_t res;
+
+    res.status = status;
+    res.pulse_us = pulse_us;
+    res.cm_raw = 0.0f;
+    res.cm = 0.0f;
+    res.tick = osKernelGetTickCount();
+    if (status == HCSR04_OK)
+    {
+        res.cm_raw = (float)pulse_us * hc_half_c;
+        res.cm = hc_median_push(res.cm_raw);
+    }
+
+    if (hc_queue) osMessageQueuePut(hc_queue, &res, 0, 0);   /* 队列满则丢弃 */
+    hcsr04_callback_t cb = hc_callback;
+    if (cb) cb(&res);
+
+    if (hc_period_us)
+    {
+        hc_state = HC_WAIT_NEXT;
+        hc_arm(hc_cycle_start + hc_period_us);
+    }
+    else
+    {
+        hc_state = HC_IDLE;
+        hc_disarm();
+    }
 }
 
-static void dwt_delay_us(uint32_t us)
+void HC_SR04_TimerIRQHandler(void)
 {
-    uint32_t start = dwt_get_us();
-    while ((dwt_get_us() - start) < us) { __NOP(); }
+    if (!(TIM2->SR & TIM_SR_CC1IF)) return;
+    TIM2->SR = ~TIM_SR_CC1IF;
+
+    switch (hc_state)
+    {
+    case HC_TRIG:
+        HAL_GPIO_WritePin(hc_trig_port, hc_trig_pin, GPIO_PIN_RESET);
+        hc_state = HC_WAIT_RISE;
+        hc_arm(hc_now_us() + hc_timeout_us);
+        break;
+    case HC_WAIT_RISE:
+        hc_finish(HCSR04_ERR_TIMEOUT_RISING, 0);
+        break;
+    case HC_WAIT_FALL:
+        hc_finish(HCSR04_ERR_TIMEOUT_FALLING, 0);
+        break;
+    case HC_WAIT_NEXT:
+        hc_start_trigger();
+        break;
+    default:
+        hc_disarm();
+        break;
+    }
+}
+
+void HC_SR04_EchoIRQHandler(void)
+{
+    uint32_t now = hc_now_us();   /* 先取时间戳，减小中断延迟带来的误差 */
+
+    if (__HAL_GPIO_EXTI_GET_IT(hc_echo_pin) == 0) return;
+    __HAL_GPIO_EXTI_CLEAR_IT(hc_echo_pin);
+
+    bool level = (hc_echo_port->IDR & hc_echo_pin) != 0;
+
+    if (level && hc_state == HC_WAIT_RISE)
+    {
+        hc_rise_us = now;
+        hc_state = HC_WAIT_FALL;
+        hc_arm(now + hc_timeout_us);
+    }
+    else if (!level && hc_state == HC_WAIT_FALL)
+    {
+        hc_finish(HCSR04_OK, now - hc_rise_us);
+    }
 }
 
 void HC_SR04_SetTimeoutUs(uint32_t timeout_us)
@@ -38,6 +184,17 @@ void HC_SR04_SetTimeoutUs(uint32_t timeout_us)
     hc_timeout_us = timeout_us;
 }
 
+void HC_SR04_SetCallback(hcsr04_callback_t cb)
+{
+    hc_callback = cb;
+}
+
+void HC_SR04_SetAirTemperature(float temp_c)
+{
+    /* m/s -> cm/us 为 1e-4，往返取一半 */
+    hc_half_c = (331.3f + 0.606f * temp_c) * 1e-4f * 0.5f;
+}
+
 void HC_SR04_Init(GPIO_TypeDef *trig_port, uint16_t trig_pin,
                   GPIO_TypeDef *echo_port, uint16_t echo_pin,
                   uint32_t echo_pull)
@@ -48,9 +205,6 @@ void HC_SR04_Init(GPIO_TypeDef *trig_port, uint16_t trig_pin,
     hc_echo_port = echo_port;
     hc_echo_pin = echo_pin;
 
-    /* init DWT */
-    dwt_init_once();
-
     /* configure TRIG as output push-pull */
     GPIO_InitTypeDef gpio = {0};
     gpio.Pin = hc_trig_pin;
@@ -60,53 +214,101 @@ void HC_SR04_Init(GPIO_TypeDef *trig_port, uint16_t trig_pin,
     HAL_GPIO_Init(hc_trig_port, &gpio);
     HAL_GPIO_WritePin(hc_trig_port, hc_trig_pin, GPIO_PIN_RESET);
 
-    /* configure ECHO as input with specified pull */
+    /* configure ECHO as both-edge interrupt input with specified pull */
     gpio.Pin = hc_echo_pin;
-    gpio.Mode = GPIO_MODE_INPUT;
+    gpio.Mode = GPIO_MODE_IT_RISING_FALLING;
     gpio.Pull = (echo_pull == GPIO_PULLUP) ? GPIO_PULLUP :
                 (echo_pull == GPIO_PULLDOWN) ? GPIO_PULLDOWN : GPIO_NOPULL;
     HAL_GPIO_Init(hc_echo_port, &gpio);
+
+    /* TIM2: 1MHz 自由计数，32 位不分频溢出约 71 分钟，用差值比较兼容回绕 */
+    RCC_ClkInitTypeDef clkconfig;
+    uint32_t flatency, timclk;
+    HAL_RCC_GetClockConfig(&clkconfig, &flatency);
+    timclk = HAL_RCC_GetPCLK1Freq();
+    if (clkconfig.APB1CLKDivider != RCC_HCLK_DIV1) timclk *= 2U;
+
+    __HAL_RCC_TIM2_CLK_ENABLE();
+    htim_hc.Instance = TIM2;
+    htim_hc.Init.Prescaler = (timclk / 1000000U) - 1U;
+    htim_hc.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim_hc.Init.Period = 0xFFFFFFFFU;
+    htim_hc.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    htim_hc.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    HAL_TIM_Base_Init(&htim_hc);
+    hc_disarm();
+    HAL_TIM_Base_Start(&htim_hc);
+
+    if (hc_queue == NULL)
+    {
+        hc_queue = osMessageQueueNew(HCSR04_QUEUE_LEN, sizeof(hcsr04_result_t), NULL);
+    }
+
+    HAL_NVIC_SetPriority(TIM2_IRQn, HC_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(TIM2_IRQn);
+    HAL_NVIC_SetPriority(hc_exti_irqn(hc_echo_pin), HC_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(hc_exti_irqn(hc_echo_pin));
+
+    hc_state = HC_IDLE;
 }
 
-hcsr04_status_t HC_SR04_Measure(uint32_t *us_ptr, float *cm_ptr)
+hcsr04_status_t HC_SR04_Trigger(void)
 {
     if (hc_trig_port == NULL || hc_echo_port == NULL) return HCSR04_ERR_NOT_INIT;
+    if (hc_state != HC_IDLE) return HCSR04_ERR_BUSY;
 
-    /* ensure trigger low */
-    HAL_GPIO_WritePin(hc_trig_port, hc_trig_pin, GPIO_PIN_RESET);
-    dwt_delay_us(2);
+    __disable_irq();
+    hc_start_trigger();
+    __enable_irq();
+    return HCSR04_OK;
+}
 
-    /* send 10us pulse */
-    HAL_GPIO_WritePin(hc_trig_port, hc_trig_pin, GPIO_PIN_SET);
-    dwt_delay_us(10);
-    HAL_GPIO_WritePin(hc_trig_port, hc_trig_pin, GPIO_PIN_RESET);
+hcsr04_status_t HC_SR04_Start(uint32_t period_ms)
+{
+    if (period_ms < HCSR04_MIN_PERIOD_MS) period_ms = HCSR04_MIN_PERIOD_MS;
+    if (hc_trig_port == NULL || hc_echo_port == NULL) return HCSR04_ERR_NOT_INIT;
 
-    uint32_t start_tick = dwt_get_us();
-    uint32_t timeout = hc_timeout_us;
+    hc_period_us = period_ms * 1000U;
+    if (hc_state == HC_IDLE) return HC_SR04_Trigger();
+    return HCSR04_OK;   /* 已在测量中，结束后按新周期继续 */
+}
 
-    /* wait for rising edge */
-    while (HAL_GPIO_ReadPin(hc_echo_port, hc_echo_pin) == GPIO_PIN_RESET)
+void HC_SR04_Stop(void)
+{
+    __disable_irq();
+    hc_period_us = 0;
+    if (hc_state == HC_WAIT_NEXT)
     {
-        if ((dwt_get_us() - start_tick) > timeout) return HCSR04_ERR_TIMEOUT_RISING;
+        hc_state = HC_IDLE;
+        hc_disarm();
     }
-    uint32_t t1 = dwt_get_us();
+    __enable_irq();
+}
 
-    /* wait for falling edge */
-    while (HAL_GPIO_ReadPin(hc_echo_port, hc_echo_pin) == GPIO_PIN_SET)
-    {
-        if ((dwt_get_us() - t1) > timeout) return HCSR04_ERR_TIMEOUT_FALLING;
-    }
-    uint32_t t2 = dwt_get_us();
+hcsr04_status_t HC_SR04_GetResult(hcsr04_result_t *res, uint32_t timeout_ms)
+{
+    if (hc_queue == NULL) return HCSR04_ERR_NOT_INIT;
+    if (osMessageQueueGet(hc_queue, res, NULL, timeout_ms) != osOK) return HCSR04_ERR_NO_RESULT;
+    return HCSR04_OK;
+}
+
+hcsr04_status_t HC_SR04_Measure(uint32_t *us_ptr, float *cm_ptr)
+{
+    hcsr04_result_t res;
+    hcsr04_status_t st;
 
-    uint32_t pulse_us = (t2 - t1);
+    if (hc_period_us) return HCSR04_ERR_BUSY;
+    if (hc_queue) osMessageQueueReset(hc_queue);
 
-    if (us_ptr) *us_ptr = pulse_us;
-    if (cm_ptr)
-    {
-        /* distance cm = (pulse_us * speed_of_sound_cm_per_us) / 2
-           speed_of_sound ~ 34300 cm/s = 0.0343 cm/us */
-        *cm_ptr = (pulse_us * 0.0343f) / 2.0f;
-    }
+    st = HC_SR04_Trigger();
+    if (st != HCSR04_OK) return st;
+
+    /* 上升沿等待 + 下降沿等待，各 timeout，外加 1 tick 余量 */
+    if (HC_SR04_GetResult(&res, (2U * hc_timeout_us) / 1000U + 2U) != HCSR04_OK)
+        return HCSR04_ERR_NO_RESULT;
+    if (res.status != HCSR04_OK) return res.status;
 
+    if (us_ptr) *us_ptr = res.pulse_us;
+    if (cm_ptr) *cm_ptr = res.cm_raw;
     return HCSR04_OK;
 }
@@ -21,7 +21,14 @@
 #include "i2c.h"
 
 /* USER CODE BEGIN 0 */
-
+#include "cmsis_os2.h"
+
+/* I2C1 总线锁（递归互斥量，同一任务可嵌套加锁） */
+static osMutexId_t i2c1_mutex;
+static const osMutexAttr_t i2c1_mutex_attr = {
+  .name = "i2c1",
+  .attr_bits = osMutexRecursive | osMutexPrioInherit,
+};
 /* USER CODE END 0 */
 
 I2C_HandleTypeDef hi2c1;
@@ -122,4 +129,22 @@ void HAL_I2C_MspDeInit(I2C_HandleTypeDef* i2cHandle)
 
 /* USER CODE BEGIN 1 */
 
+void I2C1_LockInit(void)
+{
+  if (i2c1_mutex == NULL) i2c1_mutex = osMutexNew(&i2c1_mutex_attr);
+}
+
+/* 调度器启动前只有一个执行流，无需加锁 */
+void I2C1_Lock(void)
+{
+  if (i2c1_mutex != NULL && osKernelGetState() == osKernelRunning)
+    osMutexAcquire(i2c1_mutex, osWaitForever);
+}
+
+void I2C1_Unlock(void)
+{
+  if (i2c1_mutex != NULL && osKernelGetState() == osKernelRunning)
+    osMutexRelease(i2c1_mutex);
+}
+
 /* USER CODE END 1 */
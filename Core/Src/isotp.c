@@ -0,0 +1,450 @@
+/**
+ * @file    isotp.c
+ * @brief   ISO-TP 分段传输层实现
+ *
+ * 发送与接收各是一个小状态机，所有动作都由 IsoTp_OnFrame（收到帧）与 IsoTp_Poll（时间推进）
+ * 触发，不阻塞、不分配内存。底层暂时放不下的帧留在 tx_frame 中，下次 Poll 原样重发，
+ * 因此 can_tx 可以直接接到一个有限深度的发送队列上。
+ */
+#include "isotp.h"
+#include <string.h>
+
+enum { IT_TX_IDLE = 0, IT_TX_WAIT_FC, IT_TX_SEND };
+enum { IT_RX_IDLE = 0, IT_RX_RECV };
+enum { IT_FRAME_SF = 0, IT_FRAME_FF, IT_FRAME_CF };
+
+#define IT_PCI_SF     0x00U
+#define IT_PCI_FF     0x10U
+#define IT_PCI_CF     0x20U
+#define IT_PCI_FC     0x30U
+
+#define IT_FS_CTS     0U
+#define IT_FS_WAIT    1U
+#define IT_FS_OVFLW   2U
+
+/* 时刻比较（32 位微秒计数回绕约 71 分钟） */
+static bool it_before(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+static uint32_t it_until(uint32_t at, uint32_t now)
+{
+    return it_before(now, at) ? at - now : 0U;
+}
+
+static uint32_t it_min(uint32_t a, uint32_t b)
+{
+    return a < b ? a : b;
+}
+
+static int it_emit(IsoTp_Link_t *l, const uint8_t *frame)
+{
+    return l->cfg->can_tx(l->cfg->can_ctx, l->cfg->tx_id, frame, ISOTP_FRAME_LEN);
+}
+
+uint32_t IsoTp_StminToUs(uint8_t st)
+{
+    if (st <= 0x7FU) return st * 1000U;
+    if (st >= 0xF1U && st <= 0xF9U) return (st - 0xF0U) * 100U;
+    return 127000U;
+}
+
+uint8_t IsoTp_UsToStmin(uint32_t us)
+{
+    if (us == 0) return 0;
+    if (us < 1000U)
+    {
+        uint32_t k = (us + 99U) / 100U;
+        return k < 10U ? (uint8_t)(0xF0U + k) : 1U;
+    }
+    uint32_t ms = (us + 999U) / 1000U;
+    return (uint8_t)(ms > 127U ? 127U : ms);
+}
+
+void IsoTp_Init(IsoTp_Link_t *l, const IsoTp_Config_t *cfg)
+{
+    memset(l, 0, sizeof(*l));
+    l->cfg = cfg;
+}
+
+void IsoTp_SetRxBuffer(IsoTp_Link_t *l, uint8_t *buf, uint32_t size)
+{
+    l->rx_base = buf;
+    l->rx_base_size = buf ? size : 0U;
+}
+
+bool IsoTp_TxBusy(const IsoTp_Link_t *l)
+{
+    return l->tx_state != IT_TX_IDLE;
+}
+
+bool IsoTp_RxBusy(const IsoTp_Link_t *l)
+{
+    return l->rx_state != IT_RX_IDLE;
+}
+
+/* ---- 发送 ---- */
+
+static void it_tx_finish(IsoTp_Link_t *l, isotp_result_t r)
+{
+    l->tx_state = IT_TX_IDLE;
+    l->tx_frame_ready = 0;
+    if (r == ISOTP_OK)
+    {
+        l->stats.tx_msgs++;
+        l->stats.tx_bytes += l->tx_total;
+    }
+    else
+    {
+        l->stats.errors++;
+    }
+    /* 回调中可以立即开始下一次发送 */
+    if (l->cfg->tx_done) l->cfg->tx_done(l, r, l->tx_done_len);
+}
+
+/* 从发送数据流取 n 字节，当前段用完时经 tx_seg 换段 */
+static bool it_tx_take(IsoTp_Link_t *l, uint8_t *dst, uint32_t n)
+{
+    while (n)
+    {
+        if (l->tx_pos == l->tx_len)
+        {
+            uint8_t *next = NULL;
+            uint32_t size = 0;
+
+            if (l->cfg->tx_seg == NULL || !l->cfg->tx_seg(l, l->tx_buf, l->tx_len, &next, &size) || size == 0)
+                return false;
+            l->tx_buf = next;
+            l->tx_len = size;
+            l->tx_pos = 0;
+        }
+
+        uint32_t k = it_min(n, l->tx_len - l->tx_pos);
+        memcpy(dst, &l->tx_buf[l->tx_pos], k);
+        dst += k;
+        n -= k;
+        l->tx_pos += k;
+        l->tx_done_len += k;
+    }
+    return true;
+}
+
+/* 交出已组好的帧，成功后按帧类型转入下一状态 */
+static void it_tx_push(IsoTp_Link_t *l, uint8_t kind, uint32_t now)
+{
+    if (it_emit(l, l->tx_frame) != 0) return;
+
+    l->tx_frame_ready = 0;
+    if (l->tx_done_len == l->tx_total)
+    {
+        it_tx_finish(l, ISOTP_OK);
+        return;
+    }
+    if (kind == IT_FRAME_FF || (l->tx_bs && --l->tx_bs_left == 0))
+    {
+        l->tx_state = IT_TX_WAIT_FC;
+        l->tx_at = now + ISOTP_N_BS_US;
+        return;
+    }
+    l->tx_at = now + l->tx_stmin_us;
+}
+
+isotp_result_t IsoTp_Send(IsoTp_Link_t *l, const uint8_t *buf, uint32_t len, uint32_t total, uint32_t now_us)
+{
+    uint8_t *f = l->tx_frame;
+    uint32_t n;
+
+    if (l->tx_state != IT_TX_IDLE) return ISOTP_ERR_BUSY;
+    if (total == 0 || len > total || (len < total && l->cfg->tx_seg == NULL)) return ISOTP_ERR_PARAM;
+
+    l->tx_buf = buf;
+    l->tx_len = len;
+    l->tx_pos = 0;
+    l->tx_total = total;
+    l->tx_done_len = 0;
+    l->tx_sn = 1;
+    l->tx_wft = 0;
+    memset(f, ISOTP_PAD, ISOTP_FRAME_LEN);
+
+    if (total <= ISOTP_SF_MAX)
+    {
+        f[0] = (uint8_t)(IT_PCI_SF | total);
+        n = total;
+        if (!it_tx_take(l, &f[1], n)) return ISOTP_ERR_PARAM;
+        l->tx_state = IT_TX_SEND;
+        l->tx_frame_ready = IT_FRAME_SF + 1U;
+    }
+    else
+    {
+        if (total <= ISOTP_FF12_MAX)
+        {
+            f[0] = (uint8_t)(IT_PCI_FF | (total >> 8));
+            f[1] = (uint8_t)total;
+            n = 6;
+        }
+        else
+        {
+            f[0] = IT_PCI_FF;
+            f[1] = 0;
+            f[2] = (uint8_t)(total >> 24);
+            f[3] = (uint8_t)(total >> 16);
+            f[4] = (uint8_t)(total >> 8);
+            f[5] = (uint8_t)total;
+            n = 2;
+        }
+        if (!it_tx_take(l, &f[ISOTP_FRAME_LEN - n], n)) return ISOTP_ERR_PARAM;
+        l->tx_state = IT_TX_SEND;
+        l->tx_frame_ready = IT_FRAME_FF + 1U;
+    }
+
+    it_tx_push(l, (uint8_t)(l->tx_frame_ready - 1U), now_us);
+    return ISOTP_OK;
+}
+
+static void it_tx_poll(IsoTp_Link_t *l, uint32_t now)
+{
+    while (l->tx_state != IT_TX_IDLE)
+    {
+        if (l->tx_frame_ready)
+        {
+            it_tx_push(l, (uint8_t)(l->tx_frame_ready - 1U), now);
+            if (l->tx_frame_ready || l->tx_state == IT_TX_IDLE) return;
+            continue;
+        }
+        if (l->tx_state == IT_TX_WAIT_FC)
+        {
+            if (!it_before(now, l->tx_at)) it_tx_finish(l, ISOTP_ERR_TIMEOUT_BS);
+            return;
+        }
+        if (it_before(now, l->tx_at)) return;
+
+        uint8_t *f = l->tx_frame;
+        uint32_t n = it_min(7U, l->tx_total - l->tx_done_len);
+
+        memset(f, ISOTP_PAD, ISOTP_FRAME_LEN);
+        f[0] = (uint8_t)(IT_PCI_CF | (l->tx_sn & 0x0FU));
+        if (!it_tx_take(l, &f[1], n))
+        {
+            it_tx_finish(l, ISOTP_ERR_ABORT);
+            return;
+        }
+        l->tx_sn++;
+        l->tx_frame_ready = IT_FRAME_CF + 1U;
+    }
+}
+
+static void it_on_fc(IsoTp_Link_t *l, const uint8_t *d, uint8_t len, uint32_t now)
+{
+    if (l->tx_state != IT_TX_WAIT_FC || len < 3U) return;
+
+    switch (d[0] & 0x0FU)
+    {
+    case IT_FS_CTS:
+        l->tx_bs = d[1];
+        l->tx_bs_left = d[1];
+        l->tx_stmin_us = IsoTp_StminToUs(d[2]);
+        l->tx_wft = 0;
+        l->tx_state = IT_TX_SEND;
+        l->tx_at = now;
+        it_tx_poll(l, now);
+        break;
+    case IT_FS_WAIT:
+        l->stats.fc_wait++;
+        if (++l->tx_wft > ISOTP_WFT_MAX) it_tx_finish(l, ISOTP_ERR_WFT_OVRN);
+        else l->tx_at = now + ISOTP_N_BS_US;
+        break;
+    case IT_FS_OVFLW:
+        it_tx_finish(l, ISOTP_ERR_OVERFLOW);
+        break;
+    default:
+        it_tx_finish(l, ISOTP_ERR_ABORT);
+        break;
+    }
+}
+
+/* ---- 接收 ---- */
+
+static void it_rx_finish(IsoTp_Link_t *l, isotp_result_t r)
+{
+    l->rx_state = IT_RX_IDLE;
+    if (r == ISOTP_OK)
+    {
+        l->stats.rx_msgs++;
+        l->stats.rx_bytes += l->rx_got;
+    }
+    else
+    {
+        l->stats.errors++;
+    }
+    if (l->cfg->rx_done) l->cfg->rx_done(l, r, l->rx_got);
+}
+
+static void it_rx_fc(IsoTp_Link_t *l)
+{
+    uint8_t f[ISOTP_FRAME_LEN];
+
+    memset(f, ISOTP_PAD, sizeof(f));
+    f[0] = (uint8_t)(IT_PCI_FC | (l->rx_fc_pending - 1U));
+    f[1] = l->cfg->bs;
+    f[2] = l->cfg->stmin;
+    if (it_emit(l, f) == 0) l->rx_fc_pending = 0;
+}
+
+/* 把 n 字节写入接收数据流，当前段写满时经 rx_seg 换段 */
+static bool it_rx_put(IsoTp_Link_t *l, const uint8_t *src, uint32_t n)
+{
+    while (n)
+    {
+        if (l->rx_pos == l->rx_size)
+        {
+            uint8_t *next = NULL;
+            uint32_t size = 0;
+
+            if (l->cfg->rx_seg == NULL || !l->cfg->rx_seg(l, l->rx_buf, l->rx_pos, &next, &size) || size == 0)
+                return false;
+            l->rx_buf = next;
+            l->rx_size = size;
+            l->rx_pos = 0;
+        }
+
+        uint32_t k = it_min(n, l->rx_size - l->rx_pos);
+        memcpy(&l->rx_buf[l->rx_pos], src, k);
+        src += k;
+        n -= k;
+        l->rx_pos += k;
+        l->rx_got += k;
+    }
+    return true;
+}
+
+static void it_rx_begin(IsoTp_Link_t *l, uint32_t total)
+{
+    if (l->rx_state == IT_RX_RECV) it_rx_finish(l, ISOTP_ERR_UNEXP_PDU);
+
+    l->rx_buf = l->rx_base;
+    l->rx_size = l->rx_base_size;
+    l->rx_pos = 0;
+    l->rx_got = 0;
+    l->rx_total = total;
+}
+
+static void it_on_sf(IsoTp_Link_t *l, const uint8_t *d, uint8_t len)
+{
+    uint32_t dl = d[0] & 0x0FU;
+
+    if (dl == 0 || dl > ISOTP_SF_MAX || dl + 1U > len) return;
+
+    it_rx_begin(l, dl);
+    if (!it_rx_put(l, &d[1], dl))
+    {
+        it_rx_finish(l, ISOTP_ERR_OVERFLOW);
+        return;
+    }
+    it_rx_finish(l, ISOTP_OK);
+}
+
+static void it_on_ff(IsoTp_Link_t *l, const uint8_t *d, uint8_t len, uint32_t now)
+{
+    uint32_t total = ((uint32_t)(d[0] & 0x0FU) << 8) | d[1];
+    uint32_t off = 2;
+
+    if (len < ISOTP_FRAME_LEN) return;
+    if (total == 0)
+    {
+        total = ((uint32_t)d[2] << 24) | ((uint32_t)d[3] << 16) | ((uint32_t)d[4] << 8) | d[5];
+        off = 6;
+        if (total <= ISOTP_FF12_MAX) return;
+    }
+    else if (total <= ISOTP_SF_MAX)
+    {
+        return;
+    }
+
+    it_rx_begin(l, total);
+    if (l->rx_base == NULL || (total > l->rx_base_size && l->cfg->rx_seg == NULL) ||
+        !it_rx_put(l, &d[off], ISOTP_FRAME_LEN - off))
+    {
+        l->rx_fc_pending = IT_FS_OVFLW + 1U;
+        it_rx_fc(l);
+        it_rx_finish(l, ISOTP_ERR_OVERFLOW);
+        return;
+    }
+
+    l->rx_state = IT_RX_RECV;
+    l->rx_sn = 1;
+    l->rx_bs_left = l->cfg->bs;
+    l->rx_at = now + ISOTP_N_CR_US;
+    l->rx_fc_pending = IT_FS_CTS + 1U;
+    it_rx_fc(l);
+}
+
+static void it_on_cf(IsoTp_Link_t *l, const uint8_t *d, uint8_t len, uint32_t now)
+{
+    if (l->rx_state != IT_RX_RECV) return;
+
+    uint32_t n = it_min(7U, l->rx_total - l->rx_got);
+    if (len < n + 1U) return;
+
+    if ((d[0] & 0x0FU) != (l->rx_sn & 0x0FU))
+    {
+        it_rx_finish(l, ISOTP_ERR_WRONG_SN);
+        return;
+    }
+    if (!it_rx_put(l, &d[1], n))
+    {
+        it_rx_finish(l, ISOTP_ERR_ABORT);
+        return;
+    }
+
+    l->rx_sn++;
+    l->rx_at = now + ISOTP_N_CR_US;
+    if (l->rx_got == l->rx_total)
+    {
+        it_rx_finish(l, ISOTP_OK);
+    }
+    else if (l->cfg->bs && --l->rx_bs_left == 0)
+    {
+        l->rx_bs_left = l->cfg->bs;
+        l->rx_fc_pending = IT_FS_CTS + 1U;
+        it_rx_fc(l);
+    }
+}
+
+void IsoTp_OnFrame(IsoTp_Link_t *l, const uint8_t *data, uint8_t len, uint32_t now_us)
+{
+    if (len == 0) return;
+
+    switch (data[0] & 0xF0U)
+    {
+    case IT_PCI_SF: it_on_sf(l, data, len); break;
+    case IT_PCI_FF: it_on_ff(l, data, len, now_us); break;
+    case IT_PCI_CF: it_on_cf(l, data, len, now_us); break;
+    case IT_PCI_FC: it_on_fc(l, data, len, now_us); break;
+    default: break;
+    }
+}
+
+void IsoTp_Poll(IsoTp_Link_t *l, uint32_t now_us)
+{
+    if (l->rx_fc_pending) it_rx_fc(l);
+    if (l->rx_state == IT_RX_RECV && !it_before(now_us, l->rx_at)) it_rx_finish(l, ISOTP_ERR_TIMEOUT_CR);
+    it_tx_poll(l, now_us);
+}
+
+uint32_t IsoTp_NextEvent(const IsoTp_Link_t *l, uint32_t now_us)
+{
+    uint32_t ev = ISOTP_NO_EVENT;
+
+    if (l->rx_fc_pending || l->tx_frame_ready) return 0;
+    if (l->tx_state != IT_TX_IDLE) ev = it_until(l->tx_at, now_us);
+    if (l->rx_state == IT_RX_RECV) ev = it_min(ev, it_until(l->rx_at, now_us));
+    return ev;
+}
+
+void IsoTp_Abort(IsoTp_Link_t *l)
+{
+    l->rx_fc_pending = 0;
+    if (l->tx_state != IT_TX_IDLE) it_tx_finish(l, ISOTP_ERR_ABORT);
+    if (l->rx_state == IT_RX_RECV) it_rx_finish(l, ISOTP_ERR_ABORT);
+}
@@ -0,0 +1,658 @@
+/**
+ * @file    modbus.c
+ * @brief   Modbus RTU 主/从站实现
+ *
+ * 接收字节段先拼进 mb.rx，TIM7 单脉冲计时到期即一帧结束。
+ * 接收回调与 TIM7 中断同为优先级 6，不会互相打断，mb.rx 无需加锁。
+ * 从站在 TIM7 中断中完成 查表 -> 组应答 -> Serial_Write，DMA 立即开始发送；
+ * 主站在中断中把应答交给等待的任务（信号量）。
+ */
+#include "modbus.h"
+#include "serial.h"
+#include "snapshot.h"
+#include "usart.h"
+#include "dwt.h"
+#include "cmsis_os2.h"
+#include <string.h>
+
+#define MB_TIM                TIM7
+#define MB_TURNAROUND_MS      20U      /* 广播后的等待时间，给从站处理 */
+
+/* 多项式 0xA001（0x8005 反射）的字节表 */
+static const uint16_t mb_crc_tab[256] = {
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040,
+};
+
+typedef struct {
+    uint8_t  role;
+    uint8_t  addr;
+    uint8_t  started;
+    uint8_t  rx_overflow;
+    uint16_t rx_len;
+    uint8_t  rx[MODBUS_ADU_MAX];
+    uint8_t  tx[MODBUS_ADU_MAX];
+    /* 主站 */
+    volatile uint8_t waiting;      /* 正在等待 expect 站的应答 */
+    uint8_t  expect;
+    uint8_t  rsp_status;           /* MB_OK 或 MB_ERR_CRC */
+    uint16_t rsp_len;
+    uint8_t  rsp[MODBUS_ADU_MAX];
+    osSemaphoreId_t rsp_sem;
+    osMutexId_t lock;
+    Modbus_Stats_t stats;
+} mb_ctx_t;
+
+static mb_ctx_t mb = { .addr = MODBUS_SLAVE_ADDR };
+static TIM_HandleTypeDef mb_htim;
+
+uint16_t Modbus_Crc16(const uint8_t *data, uint16_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    while (len--) crc = (uint16_t)((crc >> 8) ^ mb_crc_tab[(crc ^ *data++) & 0xFFU]);
+    return crc;
+}
+
+static inline uint16_t mb_be16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static inline void mb_put_be16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static uint16_t mb_seal(uint8_t *adu, uint16_t n)
+{
+    uint16_t crc = Modbus_Crc16(adu, n);
+    adu[n++] = (uint8_t)crc;
+    adu[n++] = (uint8_t)(crc >> 8);
+    return n;
+}
+
+/* ---- 寄存器表 ---- */
+
+static inline uint8_t mb_width(const Modbus_Reg_t *r)
+{
+    return (r->type >= MB_U32) ? 2U : 1U;
+}
+
+static inline uint32_t mb_key(uint8_t space, uint16_t addr)
+{
+    return ((uint32_t)space << 16) | addr;
+}
+
+/* 有序且互不重叠 */
+static bool mb_map_check(void)
+{
+    for (uint16_t i = 1; i < Modbus_MapSize; i++)
+    {
+        const Modbus_Reg_t *p = &Modbus_Map[i - 1U], *r = &Modbus_Map[i];
+        if (mb_key(p->space, p->addr) + mb_width(p) > mb_key(r->space, r->addr)) return false;
+    }
+    return true;
+}
+
+/* 第一个结束地址在 addr 之后的表项（覆盖 addr 或在其后），没有返回 Modbus_MapSize */
+static uint16_t mb_find(uint8_t space, uint16_t addr)
+{
+    uint32_t key = mb_key(space, addr);
+    uint16_t lo = 0, hi = Modbus_MapSize;
+
+    while (lo < hi)
+    {
+        uint16_t mid = (uint16_t)((lo + hi) / 2U);
+        const Modbus_Reg_t *r = &Modbus_Map[mid];
+        if (mb_key(r->space, r->addr) + mb_width(r) <= key) lo = (uint16_t)(mid + 1U);
+        else hi = mid;
+    }
+    return lo;
+}
+
+static uint32_t mb_quant(float v, uint8_t type)
+{
+    float lo, hi;
+
+    switch (type)
+    {
+    case MB_I16: lo = -32768.0f;       hi = 32767.0f;       break;
+    case MB_U16: lo = 0.0f;            hi = 65535.0f;       break;
+    case MB_I32: lo = -2147483648.0f;  hi = 2147483520.0f;  break;
+    default:     lo = 0.0f;            hi = 4294967040.0f;  break;
+    }
+    if (!(v > lo)) return (uint32_t)(int32_t)lo;   /* 含 NaN */
+    if (v >= hi) return (type == MB_U32) ? (uint32_t)hi : (uint32_t)(int32_t)hi;
+    v += (v >= 0.0f) ? 0.5f : -0.5f;
+    return (type == MB_U32 || type == MB_U16) ? (uint32_t)v : (uint32_t)(int32_t)v;
+}
+
+/* 无数据时的占位值 */
+static uint32_t mb_invalid(uint8_t type)
+{
+    static const uint32_t inv[] = {
+        [MB_U16] = 0xFFFFU, [MB_I16] = 0x8000U, [MB_U32] = 0xFFFFFFFFU,
+        [MB_I32] = 0x80000000U, [MB_F32] = 0x7FC00000U,
+    };
+    return inv[type];
+}
+
+static bool mb_get(const Modbus_Reg_t *r, uint32_t *raw)
+{
+    float v;
+
+    switch (r->src)
+    {
+    case MB_SRC_SNAP:
+        if (Snapshot_Get((snap_field_t)r->field, &v) == SNAP_ST_NONE) *raw = mb_invalid(r->type);
+        else if (r->type == MB_F32) memcpy(raw, &v, 4);
+        else *raw = mb_quant(v * r->scale, r->type);
+        return true;
+    case MB_SRC_VAR:
+        if (mb_width(r) == 1U) *raw = *(const volatile uint16_t *)r->var;
+        else *raw = *(const volatile uint32_t *)r->var;
+        return true;
+    default:
+        return r->get ? r->get(raw) : false;
+    }
+}
+
+static bool mb_in_range(const Modbus_Reg_t *r, uint32_t raw)
+{
+    int64_t v;
+
+    if (r->min == 0 && r->max == 0) return true;
+    switch (r->type)
+    {
+    case MB_I16: v = (int16_t)raw; break;
+    case MB_I32: v = (int32_t)raw; break;
+    case MB_F32:
+    {
+        float f;
+        memcpy(&f, &raw, 4);
+        return f >= (float)r->min && f <= (float)r->max;   /* NaN 不通过 */
+    }
+    default: v = raw; break;
+    }
+    return v >= r->min && v <= r->max;
+}
+
+static bool mb_set(const Modbus_Reg_t *r, uint32_t raw)
+{
+    if (r->src == MB_SRC_FN) return r->set(raw);
+
+    if (mb_width(r) == 1U) *(volatile uint16_t *)r->var = (uint16_t)raw;
+    else *(volatile uint32_t *)r->var = raw;
+    return true;
+}
+
+/* 读 count 个寄存器到 out（大端） */
+static uint8_t mb_read(uint8_t space, uint16_t start, uint16_t count, uint8_t *out)
+{
+    uint32_t a = start, end = (uint32_t)start + count;
+    uint16_t i = mb_find(space, start);
+
+    while (a < end)
+    {
+        const Modbus_Reg_t *r = &Modbus_Map[i];
+        if (i >= Modbus_MapSize || r->space != space || r->addr > a) return MB_EX_ILLEGAL_ADDRESS;
+
+        uint32_t raw;
+        if (!mb_get(r, &raw)) return MB_EX_DEVICE_FAILURE;
+
+        uint8_t w = mb_width(r);
+        for (uint8_t k = (uint8_t)(a - r->addr); k < w && a < end; k++, a++)
+        {
+            mb_put_be16(out, (w == 2U && k == 0U) ? (uint16_t)(raw >> 16) : (uint16_t)raw);
+            out += 2;
+        }
+        i++;
+    }
+    return MB_OK;
+}
+
+/* 写 count 个寄存器：先全部校验再写入，32 位量必须整体写 */
+static uint8_t mb_write(uint16_t start, uint16_t count, const uint8_t *data)
+{
+    uint32_t end = (uint32_t)start + count;
+    uint16_t first = mb_find(MB_HOLDING, start);
+
+    for (uint8_t pass = 0; pass < 2U; pass++)
+    {
+        uint32_t a = start;
+        for (uint16_t i = first; a < end; i++)
+        {
+            const Modbus_Reg_t *r = &Modbus_Map[i];
+            if (i >= Modbus_MapSize || r->space != MB_HOLDING || r->addr != a ||
+                r->src == MB_SRC_SNAP || (r->src == MB_SRC_FN && r->set == NULL))
+                return MB_EX_ILLEGAL_ADDRESS;
+
+            uint8_t w = mb_width(r);
+            if (a + w > end) return MB_EX_ILLEGAL_ADDRESS;
+
+            const uint8_t *p = &data[(a - start) * 2U];
+            uint32_t raw = (w == 2U) ? ((uint32_t)mb_be16(p) << 16) | mb_be16(p + 2) : mb_be16(p);
+            if (pass == 0U)
+            {
+                if (!mb_in_range(r, raw)) return MB_EX_ILLEGAL_VALUE;
+            }
+            else if (!mb_set(r, raw))
+            {
+                return MB_EX_DEVICE_FAILURE;
+            }
+            a += w;
+        }
+    }
+    return MB_OK;
+}
+
+/* 从站处理一帧（CRC 已校验），应答写入 rsp，返回长度，不应答返回 0 */
+static uint16_t mb_slave_process(const uint8_t *req, uint16_t len, uint8_t *rsp)
+{
+    uint8_t dst = req[0], fc = req[1];
+    uint8_t ex = MB_OK;
+    uint16_t n = 0;
+
+    if (dst != mb.addr && dst != 0U)
+    {
+        mb.stats.ignored++;
+        return 0;
+    }
+    mb.stats.requests++;
+    len = (uint16_t)(len - 2U);   /* 去掉 CRC */
+    rsp[0] = mb.addr;
+    rsp[1] = fc;
+
+    switch (fc)
+    {
+    case 0x03:
+    case 0x04:
+    {
+        uint16_t count = mb_be16(&req[4]);
+        if (len != 6U || count == 0U || count > MODBUS_MAX_REGS)
+        {
+            ex = MB_EX_ILLEGAL_VALUE;
+            break;
+        }
+        ex = mb_read(fc == 0x03 ? MB_HOLDING : MB_INPUT, mb_be16(&req[2]), count, &rsp[3]);
+        rsp[2] = (uint8_t)(count * 2U);
+        n = (uint16_t)(3U + count * 2U);
+        break;
+    }
+    case 0x06:
+        if (len != 6U)
+        {
+            ex = MB_EX_ILLEGAL_VALUE;
+            break;
+        }
+        ex = mb_write(mb_be16(&req[2]), 1, &req[4]);
+        memcpy(&rsp[2], &req[2], 4);
+        n = 6;
+        break;
+    case 0x10:
+    {
+        uint16_t count = mb_be16(&req[4]);
+        if (len < 7U || count == 0U || count > MODBUS_MAX_WRITE || req[6] != count * 2U || len != 7U + req[6])
+        {
+            ex = MB_EX_ILLEGAL_VALUE;
+            break;
+        }
+        ex = mb_write(mb_be16(&req[2]), count, &req[7]);
+        memcpy(&rsp[2], &req[2], 4);
+        n = 6;
+        break;
+    }
+    default:
+        ex = MB_EX_ILLEGAL_FUNCTION;
+        break;
+    }
+
+    if (dst == 0U) return 0;   /* 广播不应答 */
+    if (ex != MB_OK)
+    {
+        rsp[1] = (uint8_t)(fc | 0x80U);
+        rsp[2] = ex;
+        n = 3;
+        mb.stats.exceptions++;
+    }
+    return mb_seal(rsp, n);
+}
+
+/* ---- 帧定时 ---- */
+
+static void mb_rx(UartRx_Port_t port, void *ctx, const uint8_t *data, uint16_t len)
+{
+    (void)port;
+    (void)ctx;
+
+    MB_TIM->CNT = 0;
+    if (mb.rx_len + len > MODBUS_ADU_MAX)
+    {
+        mb.rx_overflow = 1;
+    }
+    else
+    {
+        memcpy(&mb.rx[mb.rx_len], data, len);
+        mb.rx_len += len;
+    }
+    MB_TIM->CR1 |= TIM_CR1_CEN;
+}
+
+static void mb_detach(UartRx_Port_t port, void *ctx)
+{
+    (void)port;
+    (void)ctx;
+    MB_TIM->CR1 &= ~TIM_CR1_CEN;
+    mb.rx_len = 0;
+}
+
+static const Serial_Protocol_t mb_proto = {
+    .name = "modbus",
+    .detach = mb_detach,
+    .rx = mb_rx,
+};
+
+void Modbus_TimerIRQHandler(void)
+{
+    if (!(MB_TIM->SR & TIM_SR_UIF)) return;
+    MB_TIM->SR = ~TIM_SR_UIF;
+
+    uint32_t t0 = DWT_GetCycles();
+    uint16_t len = mb.rx_len;
+    mb.rx_len = 0;
+
+    if (mb.rx_overflow)
+    {
+        mb.rx_overflow = 0;
+        mb.stats.overflow++;
+        return;
+    }
+
+    /* 含 CRC 一起计算结果为 0 */
+    bool crc_ok = len >= 4U && Modbus_Crc16(mb.rx, len) == 0U;
+    if (!crc_ok) mb.stats.crc_err++;
+    else mb.stats.frames++;
+
+    if (mb.role == MODBUS_SLAVE)
+    {
+        if (!crc_ok) return;
+        uint16_t n = mb_slave_process(mb.rx, len, mb.tx);
+        if (n && Serial_Write(MODBUS_PORT, mb.tx, n, NULL) == 0)
+        {
+            uint32_t dt = DWT_GetCycles() - t0;
+            if (dt > mb.stats.turnaround_max) mb.stats.turnaround_max = dt;
+        }
+        return;
+    }
+
+    if (!mb.waiting || len < 2U || mb.rx[0] != mb.expect)
+    {
+        mb.stats.ignored++;
+        return;
+    }
+    mb.rsp_status = crc_ok ? MB_OK : MB_ERR_CRC;
+    mb.rsp_len = (uint16_t)(len - 2U);
+    memcpy(mb.rsp, mb.rx, len);
+    mb.waiting = 0;
+    osSemaphoreRelease(mb.rsp_sem);
+}
+
+/* TIM7：1MHz 计数，单脉冲，只有计满才产生更新中断 */
+static void mb_timer_init(void)
+{
+    RCC_ClkInitTypeDef clkconfig;
+    uint32_t flatency, timclk;
+    UART_HandleTypeDef *hu = &huart3;
+
+    HAL_RCC_GetClockConfig(&clkconfig, &flatency);
+    timclk = HAL_RCC_GetPCLK1Freq();
+    if (clkconfig.APB1CLKDivider != RCC_HCLK_DIV1) timclk *= 2U;
+
+    /* 一个字符的位数：起始 + 数据 + 校验 + 停止 */
+    uint32_t bits = 1U + 8U + (hu->Init.Parity != UART_PARITY_NONE ? 1U : 0U) +
+                    (hu->Init.StopBits == UART_STOPBITS_2 ? 2U : 1U);
+    uint32_t char_us = (bits * 1000000U + hu->Init.BaudRate - 1U) / hu->Init.BaudRate;
+    uint32_t gap_us = (hu->Init.BaudRate > 19200U) ? 1750U : (char_us * 35U + 9U) / 10U;
+
+    __HAL_RCC_TIM7_CLK_ENABLE();
+    mb_htim.Instance = MB_TIM;
+    mb_htim.Init.Prescaler = (timclk / 1000000U) - 1U;
+    mb_htim.Init.CounterMode = TIM_COUNTERMODE_UP;
+    mb_htim.Init.Period = gap_us - char_us - 1U;   /* IDLE 事件已晚一个字符 */
+    mb_htim.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    mb_htim.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    HAL_TIM_Base_Init(&mb_htim);
+
+    MB_TIM->CR1 |= TIM_CR1_OPM | TIM_CR1_URS;
+    MB_TIM->SR = 0;
+    MB_TIM->DIER |= TIM_DIER_UIE;
+
+    HAL_NVIC_SetPriority(TIM7_IRQn, MODBUS_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(TIM7_IRQn);
+}
+
+int Modbus_Start(modbus_role_t role, uint8_t slave_addr)
+{
+    if (role == MODBUS_SLAVE && (slave_addr == 0U || slave_addr > 247U || !mb_map_check())) return 1;
+
+    if (!mb.started)
+    {
+        DWT_Init();
+        mb.rsp_sem = osSemaphoreNew(1, 0, NULL);
+        mb.lock = osMutexNew(NULL);
+        if (mb.rsp_sem == NULL || mb.lock == NULL) return 1;
+        mb_timer_init();
+        Serial_SetDE(MODBUS_PORT, MODBUS_DE_GPIO, MODBUS_DE_PIN);
+        mb.started = 1;
+    }
+
+    mb.role = (uint8_t)role;
+    mb.addr = slave_addr;
+    return Serial_Attach(MODBUS_PORT, &mb_proto, NULL);
+}
+
+void Modbus_GetStats(Modbus_Stats_t *stats)
+{
+    if (stats == NULL) return;
+    HAL_NVIC_DisableIRQ(TIM7_IRQn);
+    *stats = mb.stats;
+    HAL_NVIC_EnableIRQ(TIM7_IRQn);
+}
+
+/* ---- 主站 ---- */
+
+/* 发送 req[0..n)（不含 CRC），等待应答放入 mb.rsp（不含 CRC），返回长度检查前的结果 */
+static mb_result_t mb_transact(uint8_t *req, uint16_t n, uint32_t timeout_ms)
+{
+    if (!mb.started || mb.role != MODBUS_MASTER) return MB_ERR_BUSY;
+    if (osMutexAcquire(mb.lock, timeout_ms) != osOK) return MB_ERR_BUSY;
+
+    n = mb_seal(req, n);
+    osSemaphoreAcquire(mb.rsp_sem, 0);   /* 清掉上次超时后迟到的应答 */
+    mb.expect = req[0];
+    mb.waiting = (req[0] != 0U);
+
+    mb_result_t res = MB_OK;
+    if (Serial_Write(MODBUS_PORT, req, n, NULL) != 0)
+    {
+        mb.waiting = 0;
+        res = MB_ERR_BUSY;
+    }
+    else if (req[0] == 0U)
+    {
+        osDelay(MB_TURNAROUND_MS);
+    }
+    else if (osSemaphoreAcquire(mb.rsp_sem, timeout_ms) != osOK)
+    {
+        mb.waiting = 0;
+        mb.stats.timeouts++;
+        res = MB_ERR_TIMEOUT;
+    }
+    else if (mb.rsp_status != MB_OK)
+    {
+        res = (mb_result_t)mb.rsp_status;
+    }
+    else if (mb.rsp[1] == (req[1] | 0x80U) && mb.rsp_len == 3U)
+    {
+        res = (mb_result_t)mb.rsp[2];
+    }
+    else if (mb.rsp[1] != req[1])
+    {
+        res = MB_ERR_FRAME;
+    }
+
+    osMutexRelease(mb.lock);
+    return res;
+}
+
+mb_result_t Modbus_ReadRegs(uint8_t slave, uint8_t fc, uint16_t addr, uint16_t count, uint16_t *out, uint32_t timeout_ms)
+{
+    uint8_t req[8];
+
+    if (slave == 0U || (fc != 0x03 && fc != 0x04) || count == 0U || count > MODBUS_MAX_REGS || out == NULL)
+        return MB_ERR_PARAM;
+
+    req[0] = slave;
+    req[1] = fc;
+    mb_put_be16(&req[2], addr);
+    mb_put_be16(&req[4], count);
+    mb_result_t res = mb_transact(req, 6, timeout_ms);
+    if (res != MB_OK) return res;
+    if (mb.rsp_len != 3U + count * 2U || mb.rsp[2] != count * 2U) return MB_ERR_FRAME;
+
+    for (uint16_t i = 0; i < count; i++) out[i] = mb_be16(&mb.rsp[3U + i * 2U]);
+    return MB_OK;
+}
+
+mb_result_t Modbus_WriteReg(uint8_t slave, uint16_t addr, uint16_t value, uint32_t timeout_ms)
+{
+    uint8_t req[8];
+
+    req[0] = slave;
+    req[1] = 0x06;
+    mb_put_be16(&req[2], addr);
+    mb_put_be16(&req[4], value);
+    mb_result_t res = mb_transact(req, 6, timeout_ms);
+    if (res != MB_OK || slave == 0U) return res;
+    return (mb.rsp_len == 6U && memcmp(mb.rsp, req, 6) == 0) ? MB_OK : MB_ERR_FRAME;
+}
+
+mb_result_t Modbus_WriteRegs(uint8_t slave, uint16_t addr, const uint16_t *values, uint16_t count, uint32_t timeout_ms)
+{
+    uint8_t req[7U + MODBUS_MAX_WRITE * 2U + 2U];
+
+    if (count == 0U || count > MODBUS_MAX_WRITE || values == NULL) return MB_ERR_PARAM;
+
+    req[0] = slave;
+    req[1] = 0x10;
+    mb_put_be16(&req[2], addr);
+    mb_put_be16(&req[4], count);
+    req[6] = (uint8_t)(count * 2U);
+    for (uint16_t i = 0; i < count; i++) mb_put_be16(&req[7U + i * 2U], values[i]);
+    mb_result_t res = mb_transact(req, (uint16_t)(7U + count * 2U), timeout_ms);
+    if (res != MB_OK || slave == 0U) return res;
+    return (mb.rsp_len == 6U && memcmp(mb.rsp, req, 6) == 0) ? MB_OK : MB_ERR_FRAME;
+}
+
+/* ---- 自检 ---- */
+
+typedef struct {
+    uint8_t  req[12];
+    uint8_t  len;          /* 不含 CRC */
+    uint8_t  rsp_fc;       /* 期望应答功能码（0 表示不应答） */
+    uint8_t  rsp_len;      /* 期望应答长度（不含 CRC），异常应答为 3 */
+} mb_case_t;
+
+uint8_t Modbus_Test(uint32_t *max_cycles)
+{
+    const uint8_t started_addr = mb.addr;
+    if (mb.addr == 0U) mb.addr = MODBUS_SLAVE_ADDR;   /* 尚未启动时按默认站地址测试 */
+    const uint8_t a = mb.addr;
+    const mb_case_t cases[] = {
+        { { a, 0x04, 0x00, 0x00, 0x00, 0x09 }, 6, 0x04, 3 + 18 },                   /* 全部定点传感器值 */
+        { { a, 0x04, 0x00, 0x03, 0x00, 0x01 }, 6, 0x04, 3 + 2 },                    /* 32 位量的高字 */
+        { { a, 0x03, 0x00, 0x00, 0x00, 0x04 }, 6, 0x03, 3 + 8 },                    /* 保持寄存器 */
+        { { a, 0x06, 0x00, 0x03, 0x00, 0x00 }, 6, 0x06, 6 },                        /* 写单个（保存命令 = 0） */
+        { { a, 0x2B, 0x0E, 0x01, 0x00 }, 5, 0xAB, 3 },                              /* 不支持的功能码 */
+        { { a, 0x04, 0x00, 0x09, 0x00, 0x01 }, 6, 0x84, 3 },                        /* 未定义地址 */
+        { { a, 0x04, 0x00, 0x00, 0x00, 0x00 }, 6, 0x84, 3 },                        /* 数量为 0 */
+        { { a, 0x06, 0x00, 0x00, 0x12, 0x34 }, 6, 0x86, 3 },                        /* 只写 32 位量的一半 */
+        { { a, 0x06, 0x00, 0x03, 0x00, 0x05 }, 6, 0x86, 3 },                        /* 超出范围 */
+        { { a, 0x10, 0x00, 0x00, 0x00, 0x01, 0x02, 0x12, 0x34 }, 9, 0x90, 3 },      /* 写多个只写一半 */
+        { { (uint8_t)(a + 1U), 0x04, 0x00, 0x00, 0x00, 0x01 }, 6, 0, 0 },           /* 其他站 */
+        { { 0, 0x06, 0x00, 0x03, 0x00, 0x00 }, 6, 0, 0 },                           /* 广播 */
+    };
+    static const uint8_t ref[] = { 0x01, 0x03, 0x00, 0x00, 0x00, 0x0A, 0xC5, 0xCD };
+    uint8_t req[MODBUS_ADU_MAX], rsp[MODBUS_ADU_MAX];
+    uint32_t worst = 0;
+    uint8_t bad = 0;
+    Modbus_Stats_t saved = mb.stats;
+
+    if (Modbus_Crc16(ref, 6) != 0xCDC5U || Modbus_Crc16(ref, 8) != 0U || !mb_map_check()) bad = 1;
+
+    DWT_Init();
+    for (uint8_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        const mb_case_t *c = &cases[i];
+        memcpy(req, c->req, c->len);
+        uint16_t n = mb_seal(req, c->len);
+
+        uint32_t t0 = DWT_GetCycles();
+        uint16_t r = mb_slave_process(req, n, rsp);
+        uint32_t dt = DWT_GetCycles() - t0;
+        if (dt > worst) worst = dt;
+
+        if (c->rsp_fc == 0U)
+        {
+            if (r != 0U) bad = 1;
+            continue;
+        }
+        if (r != c->rsp_len + 2U || rsp[0] != a || rsp[1] != c->rsp_fc || Modbus_Crc16(rsp, r) != 0U) bad = 1;
+    }
+
+    /* 保持寄存器 0-1 读出后原样写回（写多个），检验 32 位往返 */
+    uint8_t w[] = { a, 0x10, 0x00, 0x00, 0x00, 0x02, 0x04, 0, 0, 0, 0 };
+    if (mb_read(MB_HOLDING, 0, 2, &w[7]) != MB_OK) bad = 1;
+    uint16_t n = mb_seal(memcpy(req, w, sizeof(w)), sizeof(w));
+    if (mb_slave_process(req, n, rsp) != 8U || rsp[1] != 0x10) bad = 1;
+
+    uint32_t char_cycles = SystemCoreClock / huart3.Init.BaudRate * 10U;
+    if (worst > char_cycles) bad = 1;
+
+    mb.stats = saved;
+    mb.addr = started_addr;
+    if (max_cycles) *max_cycles = worst;
+    return bad;
+}
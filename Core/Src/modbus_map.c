@@ -0,0 +1,136 @@
+/**
+ * @file    modbus_map.c
+ * @brief   本板 Modbus 寄存器表
+ *
+ * 输入寄存器 (04)：
+ *   0    T1   0.01 ℃   I16        1    T2   0.01 ℃   I16
+ *   2    H    0.01 %RH U16        3-4  L    0.1 lux  U32
+ *   5-6  P    0.1 Pa   U32        7    A    0.1 m    I16
+ *   8    D    0.1 cm   U16
+ *   16   状态：bit n = 字段 n 正常，bit 8+n = 字段 n 采集失败
+ *   17-18 快照版本 U32            19-20 运行时间 (s) U32
+ *   32-45 T1..D 的单精度浮点值（每个占两个寄存器）
+ *   未采到数据的定点字段为 0x8000 (I16) / 0xFFFF (U16) / 0xFFFFFFFF (U32)，浮点为 NaN。
+ * 保持寄存器 (03/06/16)：
+ *   0-1  海平面气压 (Pa, F32)，80000~120000，写入后立即用于海拔计算
+ *   2    从站地址 1~247（应答后生效，写 3 保存后重启仍有效）
+ *   3    写 1 保存参数到 EEPROM（由 Usart3Task 执行），读出 1 表示尚未完成
+ * 新增寄存器只需在表中按地址顺序加一行。
+ */
+#include "modbus.h"
+#include "snapshot.h"
+#include "config.h"
+#include "cmsis_os2.h"
+
+static volatile uint8_t mm_save_req = 0;
+static uint8_t mm_cur_addr = 0;   /* 当前生效的站地址，0 = 从站尚未启动 */
+
+static bool mm_status(uint32_t *raw)
+{
+    uint32_t v = 0;
+
+    for (uint8_t f = 0; f < SNAP_FIELD_NUM; f++)
+    {
+        snap_status_t st = Snapshot_Get((snap_field_t)f, NULL);
+        if (st == SNAP_ST_OK) v |= 1UL << f;
+        else if (st == SNAP_ST_ERROR) v |= 1UL << (8U + f);
+    }
+    *raw = v;
+    return true;
+}
+
+static bool mm_version(uint32_t *raw)
+{
+    *raw = Snapshot_Version();
+    return true;
+}
+
+static bool mm_uptime(uint32_t *raw)
+{
+    *raw = osKernelGetTickCount() / 1000U;
+    return true;
+}
+
+/* 参数区中的站地址，0 或越界（旧参数）时用默认值 */
+static uint8_t mm_addr(void)
+{
+    uint8_t a = g_config.modbus_addr;
+    return (a >= 1U && a <= 247U) ? a : MODBUS_SLAVE_ADDR;
+}
+
+static bool mm_get_sea_level(uint32_t *raw)
+{
+    union { float f; uint32_t u; } v = { g_config.sea_level_pa };
+    *raw = v.u;
+    return true;
+}
+
+/* 经 Config_SetSeaLevel 写入，海拔计算立即使用新值 */
+static bool mm_set_sea_level(uint32_t raw)
+{
+    union { uint32_t u; float f; } v = { raw };
+    return Config_SetSeaLevel(v.f) == 0;
+}
+
+static bool mm_get_addr(uint32_t *raw)
+{
+    *raw = mm_addr();
+    return true;
+}
+
+/* 只改参数，在中断中不能重挂协议，由 Modbus_MapService 在任务中生效 */
+static bool mm_set_addr(uint32_t raw)
+{
+    g_config.modbus_addr = (uint8_t)raw;
+    return true;
+}
+
+static bool mm_get_save(uint32_t *raw)
+{
+    *raw = mm_save_req;
+    return true;
+}
+
+static bool mm_set_save(uint32_t raw)
+{
+    if (raw) mm_save_req = 1;
+    return true;
+}
+
+const Modbus_Reg_t Modbus_Map[] = {
+    MB_SNAP(MB_INPUT, 0,  SNAP_T1, 100.0f, MB_I16),
+    MB_SNAP(MB_INPUT, 1,  SNAP_T2, 100.0f, MB_I16),
+    MB_SNAP(MB_INPUT, 2,  SNAP_H,  100.0f, MB_U16),
+    MB_SNAP(MB_INPUT, 3,  SNAP_L,  10.0f,  MB_U32),
+    MB_SNAP(MB_INPUT, 5,  SNAP_P,  10.0f,  MB_U32),
+    MB_SNAP(MB_INPUT, 7,  SNAP_A,  10.0f,  MB_I16),
+    MB_SNAP(MB_INPUT, 8,  SNAP_D,  10.0f,  MB_U16),
+    MB_FN(MB_INPUT,   16, MB_U16, mm_status,  NULL, 0, 0),
+    MB_FN(MB_INPUT,   17, MB_U32, mm_version, NULL, 0, 0),
+    MB_FN(MB_INPUT,   19, MB_U32, mm_uptime,  NULL, 0, 0),
+    MB_SNAP(MB_INPUT, 32, SNAP_T1, 1.0f, MB_F32),
+    MB_SNAP(MB_INPUT, 34, SNAP_T2, 1.0f, MB_F32),
+    MB_SNAP(MB_INPUT, 36, SNAP_H,  1.0f, MB_F32),
+    MB_SNAP(MB_INPUT, 38, SNAP_L,  1.0f, MB_F32),
+    MB_SNAP(MB_INPUT, 40, SNAP_P,  1.0f, MB_F32),
+    MB_SNAP(MB_INPUT, 42, SNAP_A,  1.0f, MB_F32),
+    MB_SNAP(MB_INPUT, 44, SNAP_D,  1.0f, MB_F32),
+
+    MB_FN(MB_HOLDING, 0, MB_F32, mm_get_sea_level, mm_set_sea_level, 80000, 120000),
+    MB_FN(MB_HOLDING, 2, MB_U16, mm_get_addr, mm_set_addr, 1, 247),
+    MB_FN(MB_HOLDING, 3, MB_U16, mm_get_save, mm_set_save, 0, 1),
+};
+
+const uint16_t Modbus_MapSize = sizeof(Modbus_Map) / sizeof(Modbus_Map[0]);
+
+void Modbus_MapService(void)
+{
+    uint8_t addr = mm_addr();
+    if (addr != mm_cur_addr && Modbus_Start(MODBUS_SLAVE, addr) == 0) mm_cur_addr = addr;
+
+    if (mm_save_req)
+    {
+        Config_Save();   /* 内部持有 I2C1 锁 */
+        mm_save_req = 0;
+    }
+}
@@ -0,0 +1,157 @@
+/**
+ * @file    sensorbus.c
+ * @brief   传感器数据发布/订阅总线
+ *
+ * 每个订阅者持有一个 osMessageQueue，元素为定长 SensorBus_Record_t，
+ * 交付时按值复制入队，不做动态分配（队列在订阅时创建）。
+ * 发布者（采集任务）为每个订阅者累积其通道上的新样本，
+ * 到达订阅者的交付周期时按策略合并成一条记录入队；队列满则丢弃并计数。
+ */
+#include "sensorbus.h"
+#include "cmsis_os2.h"
+#include "dwt.h"
+#include <string.h>
+
+typedef struct {
+    volatile uint8_t active;
+    SensorBus_SubCfg_t cfg;
+    osMessageQueueId_t queue;
+    uint32_t last_deliver;                  /* 上次交付时刻 (tick) */
+    uint32_t seen_tick[SNAP_FIELD_NUM];     /* 各通道已累积样本的采集时刻 */
+    float    acc[SNAP_FIELD_NUM];           /* 累积值（和/最大/最新） */
+    uint8_t  cnt[SNAP_FIELD_NUM];
+    SensorBus_Stats_t stats;
+} sensorbus_sub_t;
+
+static sensorbus_sub_t bus_subs[SENSORBUS_MAX_SUBS];
+static uint8_t bus_sub_num = 0;
+
+/* 累积一个样本 */
+static void bus_accumulate(sensorbus_sub_t *s, int f, float v)
+{
+    if (s->cnt[f] == 0)
+    {
+        s->acc[f] = v;
+    }
+    else
+    {
+        switch (s->cfg.policy)
+        {
+        case SENSORBUS_AVERAGE: s->acc[f] += v; break;
+        case SENSORBUS_MAX:     if (v > s->acc[f]) s->acc[f] = v; break;
+        default:                s->acc[f] = v; break;
+        }
+    }
+    if (s->cnt[f] < 0xFF) s->cnt[f]++;
+}
+
+static void bus_deliver(sensorbus_sub_t *s, const SensorSnapshot_t *snap, uint32_t now, uint32_t cycles)
+{
+    SensorBus_Record_t rec;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.version = snap->version;
+    rec.tick = now;
+    rec.pub_cycles = cycles;
+    for (int f = 0; f < SNAP_FIELD_NUM; f++)
+    {
+        if (s->cnt[f] == 0) continue;
+        rec.valid |= SENSORBUS_CH(f);
+        rec.count[f] = s->cnt[f];
+        rec.value[f] = (s->cfg.policy == SENSORBUS_AVERAGE) ? s->acc[f] / (float)s->cnt[f] : s->acc[f];
+        s->cnt[f] = 0;
+    }
+    s->last_deliver = now;
+
+    if (rec.valid == 0) return;
+    if (osMessageQueuePut(s->queue, &rec, 0, 0) == osOK)
+        s->stats.delivered++;
+    else
+        s->stats.dropped++;
+}
+
+int SensorBus_Subscribe(const SensorBus_SubCfg_t *cfg)
+{
+    int id;
+    osMessageQueueId_t q;
+
+    if (cfg == NULL) return -1;
+
+    /* 先创建队列，失败时不占用槽位 */
+    q = osMessageQueueNew(cfg->queue_len ? cfg->queue_len : SENSORBUS_QUEUE_LEN,
+                          sizeof(SensorBus_Record_t), NULL);
+    if (q == NULL) return -1;
+
+    /* 预留槽位（可能有多个任务同时订阅） */
+    osKernelLock();
+    id = (bus_sub_num < SENSORBUS_MAX_SUBS) ? bus_sub_num++ : -1;
+    osKernelUnlock();
+    if (id < 0)
+    {
+        osMessageQueueDelete(q);
+        return -1;
+    }
+
+    sensorbus_sub_t *s = &bus_subs[id];
+
+    s->cfg = *cfg;
+    s->cfg.channels &= SENSORBUS_CH_ALL;
+    s->queue = q;
+    s->last_deliver = osKernelGetTickCount();
+    s->stats.lat_min_us = 0xFFFFFFFFU;
+    DWT_Init();
+
+    __DMB();
+    s->active = 1;      /* 先填好配置再置位，发布者不会看到半初始化的订阅者 */
+    return id;
+}
+
+void SensorBus_Publish(const SensorSnapshot_t *snap)
+{
+    uint32_t cycles = DWT_GetCycles();
+    uint32_t now = osKernelGetTickCount();
+
+    for (uint32_t i = 0; i < SENSORBUS_MAX_SUBS; i++)
+    {
+        sensorbus_sub_t *s = &bus_subs[i];
+        if (!s->active) continue;
+
+        /* 只累积采集时刻有更新的通道 */
+        for (int f = 0; f < SNAP_FIELD_NUM; f++)
+        {
+            const snap_value_t *v = &snap->f[f];
+            if (!(s->cfg.channels & SENSORBUS_CH(f)) || v->status != SNAP_ST_OK) continue;
+            if (v->tick == s->seen_tick[f]) continue;
+            s->seen_tick[f] = v->tick;
+            bus_accumulate(s, f, v->value);
+        }
+
+        if ((int32_t)(now - s->last_deliver) >= (int32_t)s->cfg.period_ms)
+            bus_deliver(s, snap, now, cycles);
+    }
+}
+
+bool SensorBus_Receive(int sub, SensorBus_Record_t *rec, uint32_t timeout_ms)
+{
+    if (sub < 0 || sub >= (int)SENSORBUS_MAX_SUBS || !bus_subs[sub].active) return false;
+
+    sensorbus_sub_t *s = &bus_subs[sub];
+    if (osMessageQueueGet(s->queue, rec, NULL, timeout_ms) != osOK) return false;
+
+    /* 发布到接收的延迟 */
+    uint32_t us = (DWT_GetCycles() - rec->pub_cycles) / (SystemCoreClock / 1000000U);
+    if (us < s->stats.lat_min_us) s->stats.lat_min_us = us;
+    if (us > s->stats.lat_max_us) s->stats.lat_max_us = us;
+    if (s->stats.lat_avg_us == 0)
+        s->stats.lat_avg_us = us;
+    else
+        s->stats.lat_avg_us = s->stats.lat_avg_us - (s->stats.lat_avg_us >> 3) + (us >> 3);
+    return true;
+}
+
+bool SensorBus_GetStats(int sub, SensorBus_Stats_t *stats)
+{
+    if (sub < 0 || sub >= (int)SENSORBUS_MAX_SUBS || !bus_subs[sub].active) return false;
+    *stats = bus_subs[sub].stats;
+    return true;
+}
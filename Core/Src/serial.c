@@ -0,0 +1,296 @@
+/**
+ * @file    serial.c
+ * @brief   串口端口注册表实现
+ *
+ * 发送缓冲用自由运行的写入/发送计数 (head/tail) 表示，下标取低位。
+ * 空闲时启动 DMA 发送从 tail 起连续可读的一段，完成中断中推进 tail、
+ * 通知协议并启动下一段；缓冲发空后释放 DE。
+ * HAL 的 DMA 发送在最后一个字节移出移位寄存器 (TC) 后才回调 TxCplt，此时释放 DE 不会截断数据。
+ *
+ * 发送 DMA 映射：
+ *   USART1_TX  DMA2 Stream7 Ch4
+ *   USART2_TX  DMA1 Stream6 Ch4
+ *   USART3_TX  DMA1 Stream3 Ch4
+ *   USART6_TX  DMA2 Stream6 Ch5
+ */
+#include "serial.h"
+#include "usart.h"
+#include "dlog.h"
+#include <string.h>
+
+#define SP_RING_MASK  (SERIAL_TX_RING_SIZE - 1U)
+#define SP_IRQ_PRIO   6U
+
+typedef struct {
+    UART_HandleTypeDef *huart;
+    DMA_Stream_TypeDef *stream;
+    uint32_t channel;
+    IRQn_Type irq;
+} sp_hw_t;
+
+static const sp_hw_t sp_hw[UARTRX_PORT_NUM] = {
+    { &huart1, DMA2_Stream7, DMA_CHANNEL_4, DMA2_Stream7_IRQn },
+    { &huart2, DMA1_Stream6, DMA_CHANNEL_4, DMA1_Stream6_IRQn },
+    { &huart3, DMA1_Stream3, DMA_CHANNEL_4, DMA1_Stream3_IRQn },
+    { &huart6, DMA2_Stream6, DMA_CHANNEL_5, DMA2_Stream6_IRQn },
+};
+
+typedef struct {
+    const Serial_Protocol_t *volatile proto;
+    void *ctx;
+    DMA_HandleTypeDef hdma_tx;
+    uint8_t id;
+    uint8_t started;
+    uint8_t tx_busy;
+    uint8_t tx_full;              /* 上次写入因缓冲满被拒绝，恢复前只记一次日志 */
+    uint16_t tx_chunk;            /* 正在发送的段长 */
+    uint32_t head;                /* 累计写入字节数 */
+    uint32_t tail;                /* 累计发送字节数 */
+    GPIO_TypeDef *de_gpio;
+    uint16_t de_pin;
+    Serial_Stats_t stats;
+} sp_port_t;
+
+static sp_port_t sp_port[UARTRX_PORT_NUM];
+/* DMA 缓冲必须在 SRAM（DMA 不能访问 CCMRAM） */
+static uint8_t sp_ring[UARTRX_PORT_NUM][SERIAL_TX_RING_SIZE];
+
+static uint32_t sp_lock(void)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    return pm;
+}
+
+static void sp_unlock(uint32_t pm)
+{
+    __set_PRIMASK(pm);
+}
+
+static void sp_de(sp_port_t *p, GPIO_PinState st)
+{
+    if (p->de_gpio) HAL_GPIO_WritePin(p->de_gpio, p->de_pin, st);
+}
+
+/* UartRx 回调：交给端口当前协议 */
+static void sp_rx(const uint8_t *data, uint16_t len, void *ctx)
+{
+    sp_port_t *p = (sp_port_t *)ctx;
+    const Serial_Protocol_t *proto = p->proto;
+
+    if (proto && proto->rx) proto->rx((UartRx_Port_t)p->id, p->ctx, data, len);
+}
+
+static int sp_tx_init(UartRx_Port_t port)
+{
+    const sp_hw_t *hw = &sp_hw[port];
+    sp_port_t *p = &sp_port[port];
+
+    if (hw->stream == DMA2_Stream7 || hw->stream == DMA2_Stream6) __HAL_RCC_DMA2_CLK_ENABLE();
+    else __HAL_RCC_DMA1_CLK_ENABLE();
+
+    p->hdma_tx.Instance = hw->stream;
+    p->hdma_tx.Init.Channel = hw->channel;
+    p->hdma_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    p->hdma_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    p->hdma_tx.Init.MemInc = DMA_MINC_ENABLE;
+    p->hdma_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    p->hdma_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    p->hdma_tx.Init.Mode = DMA_NORMAL;
+    p->hdma_tx.Init.Priority = DMA_PRIORITY_LOW;
+    p->hdma_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&p->hdma_tx) != HAL_OK) return 1;
+    __HAL_LINKDMA(hw->huart, hdmatx, p->hdma_tx);
+
+    HAL_NVIC_SetPriority(hw->irq, SP_IRQ_PRIO, 0);
+    HAL_NVIC_EnableIRQ(hw->irq);
+    return 0;
+}
+
+/* 空闲且有数据时启动下一段 DMA 发送 */
+static void sp_tx_kick(sp_port_t *p)
+{
+    uint32_t pm = sp_lock();
+    if (p->tx_busy || p->head == p->tail)
+    {
+        sp_unlock(pm);
+        return;
+    }
+    uint32_t idx = p->tail & SP_RING_MASK;
+    uint32_t n = p->head - p->tail;
+    if (n > SERIAL_TX_RING_SIZE - idx) n = SERIAL_TX_RING_SIZE - idx;   /* 只发到缓冲末尾 */
+    p->tx_chunk = (uint16_t)n;
+    p->tx_busy = 1;
+    sp_unlock(pm);
+
+    sp_de(p, GPIO_PIN_SET);
+    if (HAL_UART_Transmit_DMA(sp_hw[p->id].huart, &sp_ring[p->id][idx], (uint16_t)n) != HAL_OK)
+    {
+        /* UART 正被其他方式占用：放弃本段，避免发送缓冲卡死 */
+        const Serial_Protocol_t *proto = p->proto;
+
+        pm = sp_lock();
+        p->tail += n;
+        p->tx_busy = 0;
+        p->stats.tx_errors++;
+        uint32_t sent = p->tail;
+        sp_unlock(pm);
+        sp_de(p, GPIO_PIN_RESET);
+        LOG_E("serial %u tx dma start failed", (uint32_t)p->id);
+
+        /* 不会再有发送完成中断，照常通知协议本段已结束，等完成的协议（如 ZigBee 帧）才不会卡住 */
+        if (proto && proto->tx_done) proto->tx_done((UartRx_Port_t)p->id, p->ctx, sent);
+    }
+}
+
+/* 一段发送结束（成功或出错） */
+static void sp_tx_end(sp_port_t *p, uint8_t ok)
+{
+    const Serial_Protocol_t *proto = p->proto;
+
+    if (!p->tx_busy) return;
+    p->tail += p->tx_chunk;
+    if (ok) p->stats.tx_bytes += p->tx_chunk;
+    else
+    {
+        p->stats.tx_errors++;
+        LOG_E("serial %u tx dma error, %u bytes lost", (uint32_t)p->id, (uint32_t)p->tx_chunk);
+    }
+    p->tx_busy = 0;
+
+    if (proto && proto->tx_done) proto->tx_done((UartRx_Port_t)p->id, p->ctx, p->tail);
+
+    sp_tx_kick(p);
+    if (!p->tx_busy) sp_de(p, GPIO_PIN_RESET);
+}
+
+int Serial_Attach(UartRx_Port_t port, const Serial_Protocol_t *proto, void *ctx)
+{
+    if (port >= UARTRX_PORT_NUM) return 1;
+
+    sp_port_t *p = &sp_port[port];
+    const Serial_Protocol_t *old = p->proto;
+
+    /* 先摘下旧协议，切换期间中断看到的是“无协议” */
+    p->proto = NULL;
+    if (old && old->detach) old->detach(port, p->ctx);
+
+    p->ctx = ctx;
+    if (proto && proto->attach) proto->attach(port, ctx);
+    p->proto = proto;
+
+    return Serial_Open(port);
+}
+
+int Serial_Open(UartRx_Port_t port)
+{
+    if (port >= UARTRX_PORT_NUM) return 1;
+
+    sp_port_t *p = &sp_port[port];
+    if (p->started) return 0;
+
+    p->id = (uint8_t)port;
+    if (sp_tx_init(port) != 0) return 1;
+    if (UartRx_Start(port, sp_rx, p) != 0) return 1;
+    p->started = 1;
+    return 0;
+}
+
+const char *Serial_ProtocolName(UartRx_Port_t port)
+{
+    if (port >= UARTRX_PORT_NUM) return "none";
+
+    const Serial_Protocol_t *proto = sp_port[port].proto;
+    return (proto && proto->name) ? proto->name : "none";
+}
+
+void Serial_SetDE(UartRx_Port_t port, GPIO_TypeDef *gpio, uint16_t pin)
+{
+    if (port >= UARTRX_PORT_NUM) return;
+
+    sp_port_t *p = &sp_port[port];
+    if (gpio)
+    {
+        GPIO_InitTypeDef init = {0};
+        init.Pin = pin;
+        init.Mode = GPIO_MODE_OUTPUT_PP;
+        init.Pull = GPIO_NOPULL;
+        init.Speed = GPIO_SPEED_FREQ_HIGH;
+        HAL_GPIO_WritePin(gpio, pin, GPIO_PIN_RESET);
+        HAL_GPIO_Init(gpio, &init);
+    }
+    p->de_gpio = gpio;
+    p->de_pin = pin;
+}
+
+int Serial_Write(UartRx_Port_t port, const void *data, uint16_t len, uint32_t *end)
+{
+    if (port >= UARTRX_PORT_NUM || (data == NULL && len > 0U)) return 1;
+
+    sp_port_t *p = &sp_port[port];
+    if (!p->started) return 1;
+
+    uint32_t pm = sp_lock();
+    if (SERIAL_TX_RING_SIZE - (p->head - p->tail) < len)
+    {
+        uint8_t first = !p->tx_full;
+        p->stats.tx_dropped += len;
+        p->tx_full = 1;
+        sp_unlock(pm);
+        if (first) LOG_W("serial %u tx buffer full, dropping writes (%u bytes)", (uint32_t)port, (uint32_t)len);
+        return 1;
+    }
+    p->tx_full = 0;
+    uint32_t idx = p->head & SP_RING_MASK;
+    uint32_t first = SERIAL_TX_RING_SIZE - idx;
+    if (first > len) first = len;
+    memcpy(&sp_ring[port][idx], data, first);
+    memcpy(sp_ring[port], (const uint8_t *)data + first, len - first);
+    p->head += len;
+    if (end) *end = p->head;
+    sp_unlock(pm);
+
+    sp_tx_kick(p);
+    return 0;
+}
+
+uint16_t Serial_TxFree(UartRx_Port_t port)
+{
+    if (port >= UARTRX_PORT_NUM) return 0;
+    return (uint16_t)(SERIAL_TX_RING_SIZE - (sp_port[port].head - sp_port[port].tail));
+}
+
+uint32_t Serial_TxSent(UartRx_Port_t port)
+{
+    if (port >= UARTRX_PORT_NUM) return 0;
+    return sp_port[port].tail;
+}
+
+void Serial_GetStats(UartRx_Port_t port, Serial_Stats_t *stats)
+{
+    if (port >= UARTRX_PORT_NUM || stats == NULL) return;
+
+    uint32_t pm = sp_lock();
+    *stats = sp_port[port].stats;
+    sp_unlock(pm);
+    UartRx_GetStats(port, &stats->rx);
+}
+
+void Serial_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    int port = UartRx_PortOf(huart);
+    if (port >= 0) sp_tx_end(&sp_port[port], 1);
+}
+
+/* DMA 发送出错时 HAL 已中止发送并置 gState 为 READY */
+void Serial_TxErrorCallback(UART_HandleTypeDef *huart)
+{
+    int port = UartRx_PortOf(huart);
+    if (port >= 0 && (huart->ErrorCode & HAL_UART_ERROR_DMA) && huart->gState == HAL_UART_STATE_READY)
+        sp_tx_end(&sp_port[port], 0);
+}
+
+void Serial_TxDMAIRQHandler(UartRx_Port_t port)
+{
+    if (port < UARTRX_PORT_NUM) HAL_DMA_IRQHandler(&sp_port[port].hdma_tx);
+}
@@ -7,25 +7,68 @@
 
 extern I2C_HandleTypeDef hi2c1; /* 使用 I2C1 */
 
-double Temperature = 0.0;
-double Humidity = 0.0;
-
-/* CRC8 (polynomial 0x31, init 0xFF) */
-static uint8_t sht30_crc8(const uint8_t *data, int len)
+float Temperature = 0.0f;
+float Humidity = 0.0f;
+
+/* CRC8 (polynomial 0x31, init 0xFF) 查找表：sht30_crc_table[i] 为单字节 i 的余式 */
+static const uint8_t sht30_crc_table[256] = {
+    0x00, 0x31, 0x62, 0x53, 0xC4, 0xF5, 0xA6, 0x97, 0xB9, 0x88, 0xDB, 0xEA, 0x7D, 0x4C, 0x1F, 0x2E,
+    0x43, 0x72, 0x21, 0x10, 0x87, 0xB6, 0xE5, 0xD4, 0xFA, 0xCB, 0x98, 0xA9, 0x3E, 0x0F, 0x5C, 0x6D,
+    0x86, 0xB7, 0xE4, 0xD5, 0x42, 0x73, 0x20, 0x11, 0x3F, 0x0E, 0x5D, 0x6C, 0xFB, 0xCA, 0x99, 0xA8,
+    0xC5, 0xF4, 0xA7, 0x96, 0x01, 0x30, 0x63, 0x52, 0x7C, 0x4D, 0x1E, 0x2F, 0xB8, 0x89, 0xDA, 0xEB,
+    0x3D, 0x0C, 0x5F, 0x6E, 0xF9, 0xC8, 0x9B, 0xAA, 0x84, 0xB5, 0xE6, 0xD7, 0x40, 0x71, 0x22, 0x13,
+    0x7E, 0x4F, 0x1C, 0x2D, 0xBA, 0x8B, 0xD8, 0xE9, 0xC7, 0xF6, 0xA5, 0x94, 0x03, 0x32, 0x61, 0x50,
+    0xBB, 0x8A, 0xD9, 0xE8, 0x7F, 0x4E, 0x1D, 0x2C, 0x02, 0x33, 0x60, 0x51, 0xC6, 0xF7, 0xA4, 0x95,
+    0xF8, 0xC9, 0x9A, 0xAB, 0x3C, 0x0D, 0x5E, 0x6F, 0x41, 0x70, 0x23, 0x12, 0x85, 0xB4, 0xE7, 0xD6,
+    0x7A, 0x4B, 0x18, 0x29, 0xBE, 0x8F, 0xDC, 0xED, 0xC3, 0xF2, 0xA1, 0x90, 0x07, 0x36, 0x65, 0x54,
+    0x39, 0x08, 0x5B, 0x6A, 0xFD, 0xCC, 0x9F, 0xAE, 0x80, 0xB1, 0xE2, 0xD3, 0x44, 0x75, 0x26, 0x17,
+    0xFC, 0xCD, 0x9E, 0xAF, 0x38, 0x09, 0x5A, 0x6B, 0x45, 0x74, 0x27, 0x16, 0x81, 0xB0, 0xE3, 0xD2,
+    0xBF, 0x8E, 0xDD, 0xEC, 0x7B, 0x4A, 0x19, 0x28, 0x06, 0x37, 0x64, 0x55, 0xC2, 0xF3, 0xA0, 0x91,
+    0x47, 0x76, 0x25, 0x14, 0x83, 0xB2, 0xE1, 0xD0, 0xFE, 0xCF, 0x9C, 0xAD, 0x3A, 0x0B, 0x58, 0x69,
+    0x04, 0x35, 0x66, 0x57, 0xC0, 0xF1, 0xA2, 0x93, 0xBD, 0x8C, 0xDF, 0xEE, 0x79, 0x48, 0x1B, 0x2A,
+    0xC1, 0xF0, 0xA3, 0x92, 0x05, 0x34, 0x67, 0x56, 0x78, 0x49, 0x1A, 0x2B, 0xBC, 0x8D, 0xDE, 0xEF,
+    0x82, 0xB3, 0xE0, 0xD1, 0x46, 0x77, 0x24, 0x15, 0x3B, 0x0A, 0x59, 0x68, 0xFF, 0xCE, 0x9D, 0xAC,
+};
+
+uint8_t SHT30_Crc8(const uint8_t *data, uint16_t len)
 {
     uint8_t crc = 0xFF;
-    const uint8_t POLY = 0x31;
-    for (int i = 0; i < len; i++)
+    for (uint16_t i = 0; i < len; i++)
     {
-        crc ^= data[i];
-        for (int b = 0; b < 8; b++)
-        {
-            crc = (crc & 0x80) ? (crc << 1) ^ POLY : (crc << 1);
-        }
+        crc = sht30_crc_table[crc ^ data[i]];
     }
     return crc;
 }
 
+/* 周期测量命令（高重复性），下标为 SHT30_Mps_t */
+static const uint16_t sht30_periodic_cmd[] = { 0x2032, 0x2130, 0x2236, 0x2334, 0x2737 };
+static const uint16_t sht30_periodic_ms[]  = { 2000,   1000,   500,    250,    100    };
+
+#define SHT30_CMD_FETCH   0xE000
+#define SHT30_CMD_BREAK   0x3093
+
+/* 带时间戳的采样环形缓冲（单生产者/单消费者） */
+static SHT30_Sample_t sht30_stream[SHT30_STREAM_LEN];
+static volatile uint16_t stream_head = 0;   /* 写入位置（采集侧） */
+static volatile uint16_t stream_tail = 0;   /* 读取位置（消费侧） */
+static volatile uint32_t stream_dropped = 0;
+
+static void sht30_stream_push(float t, float h)
+{
+    uint16_t head = stream_head;
+    uint16_t next = (uint16_t)((head + 1U) % SHT30_STREAM_LEN);
+    if (next == stream_tail)
+    {
+        stream_dropped++;   /* 缓冲已满，丢弃最新样本 */
+        return;
+    }
+    sht30_stream[head].tick = osKernelGetTickCount();
+    sht30_stream[head].temp = t;
+    sht30_stream[head].hum  = h;
+    __DMB();
+    stream_head = next;
+}
+
 /* 发送 16 位命令到 SHT30，返回 0 成功，非0 错误 */
 char SHT31_Write_mode(uint16_t dat)
 {
@@ -40,60 +83,130 @@ char SHT31_Write_mode(uint16_t dat)
     return 0;
 }
 
-/* 读取命令 dat（读取6字节：T.MSB T.LSB T.CRC H.MSB H.LSB H.CRC）
-   返回 0 成功并更新全局 Temperature/Humidity；非0 为错误码 */
-char SHT30_Read(uint16_t dat)
+/* 读取测量结果（6字节：T.MSB T.LSB T.CRC H.MSB H.LSB H.CRC），校验并更新全局 Temperature/Humidity
+   返回 0 成功；2 I2C 错误；3/4 CRC 错误 */
+static char sht30_fetch(void)
 {
-    uint8_t cmd[2];
     uint8_t buf[6];
 
-    cmd[0] = (uint8_t)(dat >> 8);
-    cmd[1] = (uint8_t)(dat & 0xFF);
-
-    /* 发送测量命令 */
-    if (HAL_I2C_Master_Transmit(&hi2c1, SHT30_I2C_ADDR, cmd, 2, 100) != HAL_OK)
-    {
-        return 1;
-    }
-
-    /* 测量完成所需时间因命令而异；高重复性单次测量一般需要 ~15ms，保守使用20ms */
-    osDelay(20);
-
-    /* 读取6字节数据 */
     if (HAL_I2C_Master_Receive(&hi2c1, SHT30_I2C_ADDR, buf, 6, 200) != HAL_OK)
     {
+        /* 周期模式下尚无新数据时传感器对读地址回 NACK */
+        if (HAL_I2C_GetError(&hi2c1) & HAL_I2C_ERROR_AF) return SHT30_NO_DATA;
         return 2;
     }
 
     /* CRC 校验 */
-    if (sht30_crc8(buf, 2) != buf[2]) return 3;
-    if (sht30_crc8(buf + 3, 2) != buf[5]) return 4;
+    if (SHT30_Crc8(buf, 2) != buf[2]) return 3;
+    if (SHT30_Crc8(buf + 3, 2) != buf[5]) return 4;
 
     uint16_t rawT = ((uint16_t)buf[0] << 8) | buf[1];
     uint16_t rawH = ((uint16_t)buf[3] << 8) | buf[4];
 
-    /* 按数据手册转换 */
-    double t = -45.0 + 175.0 * ((double)rawT / 65535.0);
-    double h = 100.0 * ((double)rawH / 65535.0);
+    /* 按数据手册转换（单精度，避免软件模拟的 double 运算） */
+    float t = -45.0f + (float)rawT * (175.0f / 65535.0f);
+    float h = (float)rawH * (100.0f / 65535.0f);
 
     Temperature = t;
     Humidity = h;
+    sht30_stream_push(t, h);
 
     return 0;
 }
 
+/* 读取命令 dat（读取6字节：T.MSB T.LSB T.CRC H.MSB H.LSB H.CRC）
+   返回 0 成功并更新全局 Temperature/Humidity；非0 为错误码 */
+char SHT30_Read(uint16_t dat)
+{
+    /* 发送测量命令 */
+    if (SHT31_Write_mode(dat) != 0)
+    {
+        return 1;
+    }
+
+    /* 测量完成所需时间因命令而异；高重复性单次测量一般需要 ~15ms，保守使用20ms */
+    osDelay(SHT30_SINGLESHOT_MS);
+
+    return sht30_fetch();
+}
+
+/* 非阻塞单次测量：仅发送 0x2C06，SHT30_SINGLESHOT_MS 后再调用 SHT30_Fetch_SingleShot 取结果 */
+char SHT30_Start_SingleShot(void)
+{
+    return SHT31_Write_mode(0x2C06);
+}
+
+char SHT30_Fetch_SingleShot(float *temp, float *hum)
+{
+    char ret = sht30_fetch();
+    if (ret == 0)
+    {
+        if (temp) *temp = Temperature;
+        if (hum)  *hum  = Humidity;
+    }
+    return ret;
+}
+
 /* 友好单次测量接口：使用命令 0x2C06（高重复性，无时钟拉伸） */
 char SHT30_Read_SingleShot(float *temp, float *hum)
 {
-    char ret = SHT30_Read(0x2C06);
-    if (ret == 0)
+    if (SHT30_Start_SingleShot() != 0)
     {
-        if (temp) *temp = (float)Temperature;
-        if (hum)  *hum  = (float)Humidity;
+        return 1;
     }
+    osDelay(SHT30_SINGLESHOT_MS);
+    return SHT30_Fetch_SingleShot(temp, hum);
+}
+
+char SHT30_StartPeriodic(SHT30_Mps_t mps)
+{
+    if ((unsigned)mps >= sizeof(sht30_periodic_cmd) / sizeof(sht30_periodic_cmd[0])) return 1;
+    return SHT31_Write_mode(sht30_periodic_cmd[mps]);
+}
+
+char SHT30_StopPeriodic(void)
+{
+    char ret = SHT31_Write_mode(SHT30_CMD_BREAK);
+    osDelay(1);   /* break 命令执行时间 max 1ms */
     return ret;
 }
 
+uint32_t SHT30_PeriodicIntervalMs(SHT30_Mps_t mps)
+{
+    if ((unsigned)mps >= sizeof(sht30_periodic_ms) / sizeof(sht30_periodic_ms[0])) return 0;
+    return sht30_periodic_ms[mps];
+}
+
+/* 周期模式取数：发送 0xE000 后立即读取，不等待 */
+char SHT30_FetchPeriodic(float *temp, float *hum)
+{
+    if (SHT31_Write_mode(SHT30_CMD_FETCH) != 0)
+    {
+        return 1;
+    }
+    return SHT30_Fetch_SingleShot(temp, hum);
+}
+
+uint16_t SHT30_StreamRead(SHT30_Sample_t *buf, uint16_t max)
+{
+    uint16_t n = 0;
+    uint16_t tail = stream_tail;
+
+    while (n < max && tail != stream_head)
+    {
+        __DMB();
+        buf[n++] = sht30_stream[tail];
+        tail = (uint16_t)((tail + 1U) % SHT30_STREAM_LEN);
+    }
+    stream_tail = tail;
+    return n;
+}
+
+uint32_t SHT30_StreamDropped(void)
+{
+    return stream_dropped;
+}
+
 /* 简单检测：发送软复位并检查 I2C 总线应答，返回 true 表示通信正常 */
 bool SHT30_Check(void)
 {
@@ -0,0 +1,173 @@
+/**
+ * @file    sigcond.c
+ * @brief   传感器信号调理实现
+ *
+ * 每个通道：滑动中值（去尖峰，可关闭） -> SIGCOND_STAGES 级二阶节低通。
+ * 低通系数按 RBJ cookbook（Butterworth, Q = 0.7071）在配置时计算，
+ * 滤波使用 CMSIS-DSP 的 arm_biquad_cascade_df1_f32。
+ * CMSIS 的系数约定为 {b0, b1, b2, a1, a2}，且 y[n] = ... + a1*y[n-1] + a2*y[n-2]，
+ * 即 a1/a2 与常见差分方程中的符号相反。
+ */
+#include "sigcond.h"
+#include "arm_math.h"
+#include <math.h>
+#include <string.h>
+
+typedef struct {
+    arm_biquad_casd_df1_inst_f32 inst;
+    float32_t coeffs[5 * SIGCOND_STAGES];
+    float32_t state[4 * SIGCOND_STAGES];
+    float32_t win[SIGCOND_MEDIAN_LEN];
+    uint8_t   win_n;
+    uint8_t   win_pos;
+    uint8_t   primed;
+    uint8_t   median;     /* 是否启用滑动中值 */
+} sigcond_ch_t;
+
+static sigcond_ch_t sc_ch[SNAP_FIELD_NUM];
+
+/* 二阶低通系数（CMSIS 约定），所有级使用相同系数 */
+static void sc_lowpass_coeffs(float32_t *c, float fs_hz, float fc_hz)
+{
+    float w0 = 2.0f * PI * fc_hz / fs_hz;
+    float cw = cosf(w0);
+    float alpha = sinf(w0) / (2.0f * 0.70710678f);
+    float a0 = 1.0f + alpha;
+
+    for (uint32_t s = 0; s < SIGCOND_STAGES; s++, c += 5)
+    {
+        c[0] = (1.0f - cw) * 0.5f / a0;
+        c[1] = (1.0f - cw) / a0;
+        c[2] = c[0];
+        c[3] = 2.0f * cw / a0;
+        c[4] = -(1.0f - alpha) / a0;
+    }
+}
+
+static float32_t sc_median(sigcond_ch_t *c, float32_t x)
+{
+    float32_t sorted[SIGCOND_MEDIAN_LEN];
+
+    c->win[c->win_pos] = x;
+    c->win_pos = (uint8_t)((c->win_pos + 1U) % SIGCOND_MEDIAN_LEN);
+    if (c->win_n < SIGCOND_MEDIAN_LEN) c->win_n++;
+
+    for (uint8_t i = 0; i < c->win_n; i++)
+    {
+        float32_t v = c->win[i];
+        int8_t j = (int8_t)i - 1;
+        while (j >= 0 && sorted[j] > v)
+        {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = v;
+    }
+    return sorted[c->win_n / 2U];
+}
+
+void SigCond_Reset(snap_field_t ch)
+{
+    if (ch >= SNAP_FIELD_NUM) return;
+    sigcond_ch_t *c = &sc_ch[ch];
+    memset(c->state, 0, sizeof(c->state));
+    c->win_n = 0;
+    c->win_pos = 0;
+    c->primed = 0;
+}
+
+void SigCond_Config(snap_field_t ch, float fs_hz, float fc_hz, uint8_t median)
+{
+    if (ch >= SNAP_FIELD_NUM || fs_hz <= 0.0f) return;
+    if (fc_hz <= 0.0f || fc_hz >= 0.5f * fs_hz) fc_hz = 0.2f * fs_hz;
+
+    sigcond_ch_t *c = &sc_ch[ch];
+    c->median = median ? 1U : 0U;
+    sc_lowpass_coeffs(c->coeffs, fs_hz, fc_hz);
+    arm_biquad_cascade_df1_init_f32(&c->inst, SIGCOND_STAGES, c->coeffs, c->state);
+    SigCond_Reset(ch);
+}
+
+void SigCond_Init(void)
+{
+    for (int i = 0; i < SNAP_FIELD_NUM; i++)
+    {
+        SigCond_Config((snap_field_t)i, 1.0f, 0.2f, 1);
+    }
+}
+
+float SigCond_Process(snap_field_t ch, float x)
+{
+    if (ch >= SNAP_FIELD_NUM) return x;
+    sigcond_ch_t *c = &sc_ch[ch];
+    float32_t m, y;
+
+    /* 首个样本：每级状态置为稳态 (x[n-1] = x[n-2] = y[n-1] = y[n-2] = x)，低通直流增益为 1 */
+    if (!c->primed)
+    {
+        for (uint32_t i = 0; i < 4 * SIGCOND_STAGES; i++) c->state[i] = x;
+        c->primed = 1;
+    }
+
+    m = c->median ? sc_median(c, x) : x;
+    arm_biquad_cascade_df1_f32(&c->inst, &m, &y, 1);
+    return y;
+}
+
+/* 标量参考实现：与 CMSIS 标量路径相同的运算顺序，禁止乘加融合以保证逐位可比 */
+__attribute__((optimize("fp-contract=off")))
+static void sc_biquad_ref(const float32_t *coeffs, float32_t *state, const float32_t *in, float32_t *out, uint32_t n)
+{
+    for (uint32_t s = 0; s < SIGCOND_STAGES; s++)
+    {
+        const float32_t *c = &coeffs[5 * s];
+        float32_t *st = &state[4 * s];
+        float32_t x1 = st[0], x2 = st[1], y1 = st[2], y2 = st[3];
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            float32_t x = in[i];
+            float32_t acc = (c[0] * x) + (c[1] * x1) + (c[2] * x2) + (c[3] * y1) + (c[4] * y2);
+            x2 = x1;
+            x1 = x;
+            y2 = y1;
+            y1 = acc;
+            out[i] = acc;
+        }
+        st[0] = x1; st[1] = x2; st[2] = y1; st[3] = y2;
+        in = out;   /* 下一级处理上一级的输出 */
+    }
+}
+
+#define SC_TEST_LEN    256U
+#define SC_TEST_BLOCK  37U   /* 非 4 的倍数，覆盖展开循环与尾部处理 */
+
+uint8_t SigCond_Test(void)
+{
+    static float32_t in[SC_TEST_LEN], out_dsp[SC_TEST_LEN], out_ref[SC_TEST_LEN];
+    float32_t coeffs[5 * SIGCOND_STAGES];
+    float32_t st_dsp[4 * SIGCOND_STAGES] = {0};
+    float32_t st_ref[4 * SIGCOND_STAGES] = {0};
+    arm_biquad_casd_df1_inst_f32 inst;
+    uint32_t seed = 12345;
+
+    /* 正弦 + 伪随机噪声 + 阶跃 */
+    for (uint32_t i = 0; i < SC_TEST_LEN; i++)
+    {
+        seed = seed * 1103515245U + 12345U;
+        in[i] = 10.0f * sinf(0.05f * (float)i) + (float)((seed >> 16) & 0xFF) * 0.01f
+              + ((i >= SC_TEST_LEN / 2U) ? 50.0f : 0.0f);
+    }
+
+    sc_lowpass_coeffs(coeffs, 100.0f, 5.0f);
+    arm_biquad_cascade_df1_init_f32(&inst, SIGCOND_STAGES, coeffs, st_dsp);
+
+    for (uint32_t i = 0; i < SC_TEST_LEN; i += SC_TEST_BLOCK)
+    {
+        uint32_t n = (SC_TEST_LEN - i < SC_TEST_BLOCK) ? SC_TEST_LEN - i : SC_TEST_BLOCK;
+        arm_biquad_cascade_df1_f32(&inst, &in[i], &out_dsp[i], n);
+    }
+    sc_biquad_ref(coeffs, st_ref, in, out_ref, SC_TEST_LEN);
+
+    return (memcmp(out_dsp, out_ref, sizeof(out_ref)) == 0) ? 0 : 1;
+}
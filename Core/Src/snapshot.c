@@ -0,0 +1,96 @@
+/**
+ * @file    snapshot.c
+ * @brief   传感器数据快照 seqlock 实现
+ *
+ * 历史环兼做 seqlock 的多缓冲：写者只写 "下一个" 槽位（最旧的历史），
+ * 写完后再移动 head。每个槽位自带序号，写入期间为奇数。
+ * 读者读取后比较序号，只有在读取期间写者恰好绕环覆盖了同一槽位时才需重读，
+ * 因此读最新快照的读者不会自旋等待，也不会阻塞采集任务。
+ */
+#include "snapshot.h"
+#include "main.h"
+#include "cmsis_os2.h"
+#include <string.h>
+
+static SensorSnapshot_t snap_ring[SNAP_HISTORY_LEN];
+static volatile uint8_t snap_head = 0;        /* 最新槽位 */
+static volatile uint32_t snap_version = 0;    /* 已发布份数 */
+
+void Snapshot_Publish(const SensorSnapshot_t *src)
+{
+    uint8_t idx = (uint8_t)((snap_head + 1U) % SNAP_HISTORY_LEN);
+    SensorSnapshot_t *dst = &snap_ring[idx];
+    uint32_t seq = dst->seq;
+
+    dst->seq = seq + 1U;            /* 奇数：写入中 */
+    __DMB();
+    memcpy(dst->f, src->f, sizeof(dst->f));
+    dst->version = snap_version + 1U;
+    dst->tick = osKernelGetTickCount();
+    __DMB();
+    dst->seq = seq + 2U;            /* 偶数：写入完成 */
+    __DMB();
+
+    snap_head = idx;
+    snap_version = dst->version;
+}
+
+const SensorSnapshot_t *Snapshot_Begin(uint8_t back, uint32_t *seq)
+{
+    if (back >= SNAP_HISTORY_LEN || back >= snap_version) return NULL;
+
+    uint8_t idx = (uint8_t)((snap_head + SNAP_HISTORY_LEN - back) % SNAP_HISTORY_LEN);
+    const SensorSnapshot_t *s = &snap_ring[idx];
+    uint32_t q = s->seq;
+
+    if (q & 1U) return NULL;        /* 正在被覆盖 */
+    __DMB();
+    *seq = q;
+    return s;
+}
+
+bool Snapshot_Retry(const SensorSnapshot_t *s, uint32_t seq)
+{
+    if (s == NULL) return false;
+    __DMB();
+    return s->seq != seq;
+}
+
+bool Snapshot_Read(uint8_t back, SensorSnapshot_t *out)
+{
+    const SensorSnapshot_t *s;
+    uint32_t seq;
+
+    do {
+        s = Snapshot_Begin(back, &seq);
+        if (s == NULL) return false;
+        out->version = s->version;
+        out->tick = s->tick;
+        memcpy(out->f, s->f, sizeof(out->f));
+    } while (Snapshot_Retry(s, seq));
+
+    out->seq = seq;
+    return true;
+}
+
+snap_status_t Snapshot_Get(snap_field_t field, float *value)
+{
+    const SensorSnapshot_t *s;
+    uint32_t seq;
+    snap_value_t v;
+
+    if (field >= SNAP_FIELD_NUM) return SNAP_ST_NONE;
+    do {
+        s = Snapshot_Begin(0, &seq);
+        if (s == NULL) return SNAP_ST_NONE;
+        v = s->f[field];
+    } while (Snapshot_Retry(s, seq));
+
+    if (value) *value = v.value;
+    return (snap_status_t)v.status;
+}
+
+uint32_t Snapshot_Version(void)
+{
+    return snap_version;
+}
@@ -0,0 +1,327 @@
+/**
+ * @file    spectrum.c
+ * @brief   ADC 流频谱分析实现
+ *
+ * AdcStream 订阅回调把所选通道的样本（换算为伏特）收集到 sp_in，收满 N 点后
+ * 通知 SpectrumTask：去直流 -> Hann 窗 -> arm_rfft_fast_f32 -> 求幅度 -> 累加平均，
+ * 满 navg 帧后提取峰值与频带能量并生成柱状图数据。
+ * 收集与计算互斥进行（计算期间丢弃新样本），适合平均谱分析。
+ * FFT 工作缓冲放在 CCMRAM 的 NOLOAD 段（约 56KB），CPU 零等待访问且不占用主 SRAM。
+ */
+#include "spectrum.h"
+#include "adcstream.h"
+#include "tftlcd.h"
+#include "dwt.h"
+#include "dlog.h"
+#include "cmsis_os2.h"
+#include "arm_math.h"
+#include <math.h>
+#include <string.h>
+
+#define CCMRAM_NOINIT  __attribute__((section(".ccmnoinit")))
+
+#define SP_FLAG_FRAME   0x0001U
+#define SP_FLAG_RECONF  0x0002U
+#define SP_VREF         3.3f
+#define SP_DB_RANGE     60.0f
+
+static float32_t sp_in[SPECTRUM_MAX_N] CCMRAM_NOINIT;          /* 时域样本，FFT 后复用为本帧幅度 */
+static float32_t sp_fft[SPECTRUM_MAX_N] CCMRAM_NOINIT;         /* RFFT 输出（打包复数） */
+static float32_t sp_win[SPECTRUM_MAX_N] CCMRAM_NOINIT;         /* Hann 窗 */
+static float32_t sp_avg[SPECTRUM_MAX_N / 2 + 1] CCMRAM_NOINIT; /* 幅度累加 */
+
+static arm_rfft_fast_instance_f32 sp_rfft;
+static osThreadId_t sp_thread = NULL;
+
+static volatile uint8_t  sp_collecting = 0;
+static volatile uint16_t sp_fill = 0;
+static uint16_t sp_n = SPECTRUM_DEFAULT_N;
+static uint8_t  sp_ch = 0;
+static uint8_t  sp_navg = SPECTRUM_DEFAULT_AVG;
+static uint8_t  sp_frames = 0;
+static float    sp_win_sum = 1.0f;
+static volatile float sp_fs = 0.0f;
+static volatile float sp_vscale = SP_VREF / 4096.0f;
+
+static volatile uint8_t  sp_req_ch = 0;
+static volatile uint16_t sp_req_n = SPECTRUM_DEFAULT_N;
+static volatile uint8_t  sp_req_navg = SPECTRUM_DEFAULT_AVG;
+
+static float sp_band[SPECTRUM_BANDS][2] = {
+    { 1.0f, 50.0f }, { 50.0f, 200.0f }, { 200.0f, 1000.0f }, { 1000.0f, 5000.0f }
+};
+
+static Spectrum_Result_t sp_result;
+
+static int sp_size_ok(uint16_t n)
+{
+    return n >= SPECTRUM_MIN_N && n <= SPECTRUM_MAX_N && (n & (n - 1U)) == 0;
+}
+
+/* 生成 Hann 窗，返回窗函数和（相干增益 * N） */
+static float sp_make_window(uint16_t n)
+{
+    float sum = 0.0f;
+    for (uint16_t i = 0; i < n; i++)
+    {
+        sp_win[i] = 0.5f - 0.5f * arm_cos_f32(2.0f * PI * (float)i / (float)n);
+        sum += sp_win[i];
+    }
+    return sum;
+}
+
+static void sp_apply_config(void)
+{
+    uint16_t n = sp_req_n;
+
+    if (!sp_size_ok(n)) n = SPECTRUM_DEFAULT_N;
+    sp_n = n;
+    sp_ch = (sp_req_ch < ADCSTREAM_CH_NUM) ? sp_req_ch : 0;
+    sp_navg = sp_req_navg ? sp_req_navg : 1;
+    arm_rfft_fast_init_f32(&sp_rfft, n);
+    sp_win_sum = sp_make_window(n);
+    memset(sp_avg, 0, sizeof(sp_avg));
+    sp_frames = 0;
+    sp_fill = 0;
+}
+
+/* AdcStream 订阅回调（AdcStreamTask 上下文）：收集一帧样本 */
+static void sp_on_block(const AdcStream_Block_t *blk, void *ctx)
+{
+    (void)ctx;
+    if (!sp_collecting) return;
+
+    const uint16_t *src = blk->ch[sp_ch];
+    uint16_t fill = sp_fill;
+    uint16_t cnt = blk->n;
+    float scale = SP_VREF / (float)(1UL << blk->bits);
+
+    if (cnt > sp_n - fill) cnt = sp_n - fill;
+    for (uint16_t i = 0; i < cnt; i++)
+    {
+        sp_in[fill + i] = (float32_t)src[i] * scale;
+    }
+    fill += cnt;
+    sp_fs = (float)blk->rate_hz;
+    sp_vscale = scale;
+
+    if (fill >= sp_n)
+    {
+        sp_collecting = 0;
+        osThreadFlagsSet(sp_thread, SP_FLAG_FRAME);
+    }
+    sp_fill = fill;
+}
+
+/* 加窗 + RFFT + 求幅度，结果写入 sp_in[0 .. n/2] */
+static void sp_transform(arm_rfft_fast_instance_f32 *inst, uint16_t n)
+{
+    arm_mult_f32(sp_in, sp_win, sp_in, n);
+    arm_rfft_fast_f32(inst, sp_in, sp_fft, 0);
+    /* 打包格式：sp_fft[0] = 直流，sp_fft[1] = 奈奎斯特频点（均为实数） */
+    sp_in[0] = fabsf(sp_fft[0]);
+    arm_cmplx_mag_f32(&sp_fft[2], &sp_in[1], n / 2U - 1U);
+    sp_in[n / 2U] = fabsf(sp_fft[1]);
+}
+
+static void sp_publish(void)
+{
+    Spectrum_Result_t r;
+    uint16_t half = sp_n / 2U;
+    float fs = sp_fs;
+    float bin_hz = fs / (float)sp_n;
+    float32_t pmax;
+    uint32_t pidx;
+
+    /* 单边幅度谱：2|X| / sum(w)，再除以平均帧数 */
+    arm_scale_f32(sp_avg, 2.0f / (sp_win_sum * (float)sp_navg), sp_avg, half + 1U);
+
+    memset(&r, 0, sizeof(r));
+    r.seq = sp_result.seq + 1U;
+    r.n = sp_n;
+    r.channel = sp_ch;
+    r.fs_hz = fs;
+
+    /* 峰值（跳过直流），抛物线插值估计频率 */
+    arm_max_f32(&sp_avg[1], half, &pmax, &pidx);
+    pidx += 1U;
+    float delta = 0.0f;
+    if (pidx > 1U && pidx < half)
+    {
+        float a = sp_avg[pidx - 1U], b = sp_avg[pidx], c = sp_avg[pidx + 1U];
+        float den = a - 2.0f * b + c;
+        if (den != 0.0f) delta = 0.5f * (a - c) / den;
+    }
+    r.peak_hz = ((float)pidx + delta) * bin_hz;
+    r.peak_amp = pmax;
+
+    /* 频带能量：sum(A^2 / 2)，即正弦分量的均方值 */
+    for (uint8_t b = 0; b < SPECTRUM_BANDS; b++)
+    {
+        uint32_t lo = (uint32_t)(sp_band[b][0] / bin_hz);
+        uint32_t hi = (uint32_t)(sp_band[b][1] / bin_hz);
+        float32_t e = 0.0f;
+        if (lo < 1U) lo = 1U;
+        if (hi > half + 1U) hi = half + 1U;
+        if (hi > lo) arm_power_f32(&sp_avg[lo], hi - lo, &e);
+        r.band_energy[b] = 0.5f * e;
+    }
+
+    /* 柱状图：每柱取组内最大值，相对峰值的 dB 映射到 0~255 */
+    uint16_t group = half / SPECTRUM_BARS;
+    for (uint16_t i = 0; i < SPECTRUM_BARS; i++)
+    {
+        float32_t m;
+        uint32_t idx;
+        arm_max_f32(&sp_avg[1U + i * group], group, &m, &idx);
+        float db = (pmax > 0.0f && m > 0.0f) ? 20.0f * log10f(m / pmax) : -SP_DB_RANGE;
+        if (db < -SP_DB_RANGE) db = -SP_DB_RANGE;
+        r.bars[i] = (uint8_t)((db + SP_DB_RANGE) * (255.0f / SP_DB_RANGE));
+    }
+
+    osKernelLock();
+    sp_result = r;
+    osKernelUnlock();
+
+    memset(sp_avg, 0, sizeof(float32_t) * (half + 1U));
+}
+
+static void sp_frame(void)
+{
+    float32_t mean;
+
+    arm_mean_f32(sp_in, sp_n, &mean);
+    arm_offset_f32(sp_in, -mean, sp_in, sp_n);
+    sp_transform(&sp_rfft, sp_n);
+    arm_add_f32(sp_avg, sp_in, sp_avg, sp_n / 2U + 1U);
+
+    if (++sp_frames >= sp_navg)
+    {
+        sp_publish();
+        sp_frames = 0;
+    }
+}
+
+void Spectrum_Configure(uint8_t channel, uint16_t n, uint8_t navg)
+{
+    sp_req_ch = channel;
+    sp_req_n = n;
+    sp_req_navg = navg;
+    if (sp_thread) osThreadFlagsSet(sp_thread, SP_FLAG_RECONF);
+}
+
+void Spectrum_SetBand(uint8_t band, float lo_hz, float hi_hz)
+{
+    if (band >= SPECTRUM_BANDS || hi_hz <= lo_hz) return;
+    sp_band[band][0] = lo_hz;
+    sp_band[band][1] = hi_hz;
+}
+
+uint32_t Spectrum_GetResult(Spectrum_Result_t *res)
+{
+    osKernelLock();
+    *res = sp_result;
+    osKernelUnlock();
+    return res->seq;
+}
+
+void Spectrum_Draw(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    static uint8_t bars[SPECTRUM_BARS];
+    uint16_t bw = w / SPECTRUM_BARS;
+
+    osKernelLock();
+    uint32_t seq = sp_result.seq;
+    memcpy(bars, sp_result.bars, sizeof(bars));
+    osKernelUnlock();
+
+    if (seq == 0 || bw < 2) return;
+
+    for (uint16_t i = 0; i < SPECTRUM_BARS; i++)
+    {
+        uint16_t bh = (uint16_t)((uint32_t)bars[i] * h / 255U);
+        uint16_t x0 = x + i * bw;
+        uint16_t x1 = x0 + bw - 2;   /* 柱间留 1 像素 */
+        if (bh < h) lcd_fill(x0, y, x1, y + h - bh - 1, WHITE);
+        if (bh > 0) lcd_fill(x0, y + h - bh, x1, y + h - 1, BLUE);
+    }
+}
+
+uint8_t Spectrum_Bench(Spectrum_Bench_t *bench)
+{
+    arm_rfft_fast_instance_f32 inst;
+    uint8_t fail = 0;
+
+    DWT_Init();
+    for (uint8_t s = 0; s < SPECTRUM_SIZE_NUM; s++)
+    {
+        uint16_t n = (uint16_t)(SPECTRUM_MIN_N << s);
+        uint32_t k = n / 8U;   /* 测试正弦位于第 n/8 个频点 */
+        float32_t m;
+        uint32_t idx;
+
+        if (arm_rfft_fast_init_f32(&inst, n) != ARM_MATH_SUCCESS) return 1;
+        sp_make_window(n);
+        for (uint16_t i = 0; i < n; i++)
+        {
+            sp_in[i] = arm_sin_f32(2.0f * PI * (float)(k * i) / (float)n);
+        }
+
+        uint32_t t0 = DWT_GetCycles();
+        sp_transform(&inst, n);
+        uint32_t t1 = DWT_GetCycles();
+
+        arm_max_f32(sp_in, n / 2U + 1U, &m, &idx);
+        if (idx != k) fail = 1;
+
+        if (bench)
+        {
+            bench->n[s] = n;
+            bench->cycles[s] = t1 - t0;
+        }
+    }
+
+    /* 缓冲已被改写，让分析任务重新初始化 */
+    if (sp_thread) osThreadFlagsSet(sp_thread, SP_FLAG_RECONF);
+    return fail;
+}
+
+void SpectrumTask(void *argument)
+{
+    Spectrum_Bench_t bench;
+
+    /* 订阅 ADC 流之前 CCM 缓冲空闲，先跑一遍基准与峰值自检 */
+    if (Spectrum_Bench(&bench) == 0)
+    {
+        for (uint8_t s = 0; s < SPECTRUM_SIZE_NUM; s++)
+            LOG_I("spectrum n=%u %u cyc/block", bench.n[s], bench.cycles[s]);
+    }
+    else
+    {
+        LOG_E("spectrum bench FAIL");
+    }
+
+    sp_thread = osThreadGetId();
+    sp_apply_config();
+    AdcStream_Subscribe(sp_on_block, NULL);
+    sp_collecting = 1;
+
+    for (;;)
+    {
+        uint32_t flags = osThreadFlagsWait(SP_FLAG_FRAME | SP_FLAG_RECONF, osFlagsWaitAny, osWaitForever);
+        if (flags & osFlagsError) continue;
+
+        if (flags & SP_FLAG_RECONF)
+        {
+            /* AdcStreamTask 优先级更高，此时回调不会在执行中 */
+            sp_collecting = 0;
+            sp_apply_config();
+            sp_collecting = 1;
+            continue;
+        }
+
+        sp_frame();
+        sp_fill = 0;
+        sp_collecting = 1;
+    }
+}
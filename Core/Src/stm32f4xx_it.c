@@ -22,6 +22,10 @@
 #include "stm32f4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "hc_sr04.h"
+#include "uartrx.h"
+#include "serial.h"
+#include "modbus.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -430,4 +434,92 @@ void DCMI_IRQHandler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles TIM2 global interrupt (HC-SR04 trigger/timeout).
+  */
+void TIM2_IRQHandler(void)
+{
+  HC_SR04_TimerIRQHandler();
+}
+
+/**
+  * @brief This function handles TIM7 global interrupt (Modbus RTU frame gap).
+  */
+void TIM7_IRQHandler(void)
+{
+  Modbus_TimerIRQHandler();
+}
+
+/**
+  * @brief This function handles EXTI line[9:5] interrupts (HC-SR04 ECHO on PG7).
+  */
+void EXTI9_5_IRQHandler(void)
+{
+  HC_SR04_EchoIRQHandler();
+}
+
+/**
+  * @brief This function handles DMA1 stream1 global interrupt (USART3_RX).
+  */
+void DMA1_Stream1_IRQHandler(void)
+{
+  UartRx_DMAIRQHandler(UARTRX_PORT3);
+}
+
+/**
+  * @brief This function handles DMA1 stream5 global interrupt (USART2_RX).
+  */
+void DMA1_Stream5_IRQHandler(void)
+{
+  UartRx_DMAIRQHandler(UARTRX_PORT2);
+}
+
+/**
+  * @brief This function handles DMA1 stream6 global interrupt (USART2_TX).
+  */
+void DMA1_Stream6_IRQHandler(void)
+{
+  Serial_TxDMAIRQHandler(UARTRX_PORT2);
+}
+
+/**
+  * @brief This function handles DMA1 stream3 global interrupt (USART3_TX).
+  */
+void DMA1_Stream3_IRQHandler(void)
+{
+  Serial_TxDMAIRQHandler(UARTRX_PORT3);
+}
+
+/**
+  * @brief This function handles DMA2 stream6 global interrupt (USART6_TX).
+  */
+void DMA2_Stream6_IRQHandler(void)
+{
+  Serial_TxDMAIRQHandler(UARTRX_PORT6);
+}
+
+/**
+  * @brief This function handles DMA2 stream7 global interrupt (USART1_TX).
+  */
+void DMA2_Stream7_IRQHandler(void)
+{
+  Serial_TxDMAIRQHandler(UARTRX_PORT1);
+}
+
+/**
+  * @brief This function handles DMA2 stream2 global interrupt (USART6_RX).
+  */
+void DMA2_Stream2_IRQHandler(void)
+{
+  UartRx_DMAIRQHandler(UARTRX_PORT6);
+}
+
+/**
+  * @brief This function handles DMA2 stream5 global interrupt (USART1_RX).
+  */
+void DMA2_Stream5_IRQHandler(void)
+{
+  UartRx_DMAIRQHandler(UARTRX_PORT1);
+}
+
 /* USER CODE END 1 */
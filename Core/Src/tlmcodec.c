@@ -0,0 +1,314 @@
+/**
+ * @file    tlmcodec.c
+ * @brief   二进制遥测编解码实现
+ *
+ * 字段按定点整数传输（见 tlm_field 表），温湿度 0.01、其余 0.1 的分辨率，
+ * 已高于传感器本身的精度。样本只携带本周期内有新数据的字段，
+ * 时刻用与上一样本的差值 (varint) 表示，典型样本只有 4~9 字节。
+ */
+#include "tlmcodec.h"
+#include <string.h>
+
+/* 定点字段描述：传输值 = round(value * scale)，width 为 2 或 3 字节 */
+typedef struct {
+    float   scale;
+    uint8_t width;
+    uint8_t is_signed;
+} tlm_field_t;
+
+/* schema 1 的字段表，修改后必须递增 TLM_SCHEMA_VERSION */
+static const tlm_field_t tlm_field[SNAP_FIELD_NUM] = {
+    [SNAP_T1] = { 100.0f, 2, 1 },   /* 0.01 ℃ */
+    [SNAP_T2] = { 100.0f, 2, 1 },   /* 0.01 ℃ */
+    [SNAP_H]  = { 100.0f, 2, 0 },   /* 0.01 %RH */
+    [SNAP_L]  = { 10.0f,  3, 0 },   /* 0.1 lux */
+    [SNAP_P]  = { 10.0f,  3, 0 },   /* 0.1 Pa */
+    [SNAP_A]  = { 10.0f,  2, 1 },   /* 0.1 m */
+    [SNAP_D]  = { 10.0f,  2, 0 },   /* 0.1 cm */
+};
+
+/* 多项式 0x04C11DB7 的 4 位查表，高位先行 */
+static const uint32_t tlm_crc_tab[16] = {
+    0x00000000U, 0x04C11DB7U, 0x09823B6EU, 0x0D4326D9U,
+    0x130476DCU, 0x17C56B6BU, 0x1A864DB2U, 0x1E475005U,
+    0x2608EDB8U, 0x22C9F00FU, 0x2F8AD6D6U, 0x2B4BCB61U,
+    0x350C9B64U, 0x31CD86D3U, 0x3C8EA00AU, 0x384FBDBDU,
+};
+
+uint32_t Tlm_Crc32(const uint8_t *data, uint32_t len)
+{
+    uint32_t crc = 0xFFFFFFFFU;
+
+    for (uint32_t i = 0; i < len; i += 4)
+    {
+        uint32_t w = 0;
+        for (uint32_t k = 0; k < 4 && i + k < len; k++) w |= (uint32_t)data[i + k] << (8 * k);
+        crc ^= w;
+        for (uint32_t k = 0; k < 8; k++) crc = (crc << 4) ^ tlm_crc_tab[crc >> 28];
+    }
+    return crc;
+}
+
+uint16_t Tlm_CobsEncode(const uint8_t *in, uint16_t len, uint8_t *out)
+{
+    uint16_t code_pos = 0, o = 1;
+    uint8_t code = 1;
+
+    for (uint16_t i = 0; i < len; i++)
+    {
+        if (in[i] == 0)
+        {
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+            continue;
+        }
+        out[o++] = in[i];
+        if (++code == 0xFF)
+        {
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    return o;
+}
+
+int Tlm_CobsDecode(const uint8_t *in, uint16_t len, uint8_t *out, uint16_t out_size)
+{
+    uint16_t i = 0, o = 0;
+
+    while (i < len)
+    {
+        uint8_t code = in[i++];
+        if (code == 0 || (uint32_t)i + code - 1U > len) return -1;
+        for (uint8_t k = 1; k < code; k++)
+        {
+            if (o >= out_size || in[i] == 0) return -1;
+            out[o++] = in[i++];
+        }
+        if (code != 0xFF && i < len)
+        {
+            if (o >= out_size) return -1;
+            out[o++] = 0;
+        }
+    }
+    return o;
+}
+
+static void tlm_put_le(uint8_t *p, uint32_t v, uint8_t n)
+{
+    for (uint8_t k = 0; k < n; k++) p[k] = (uint8_t)(v >> (8 * k));
+}
+
+static uint32_t tlm_get_le(const uint8_t *p, uint8_t n)
+{
+    uint32_t v = 0;
+    for (uint8_t k = 0; k < n; k++) v |= (uint32_t)p[k] << (8 * k);
+    return v;
+}
+
+static int32_t tlm_quant(float v, const tlm_field_t *f)
+{
+    uint8_t bits = (uint8_t)(8U * f->width);
+    int32_t lo = f->is_signed ? -(1L << (bits - 1U)) : 0;
+    int32_t hi = f->is_signed ? (1L << (bits - 1U)) - 1 : (1L << bits) - 1;
+    float x = v * f->scale;
+
+    if (!(x > (float)lo)) return lo;   /* 含 NaN */
+    if (x >= (float)hi) return hi;
+    return (int32_t)(x + (x >= 0.0f ? 0.5f : -0.5f));
+}
+
+void Tlm_BatchBegin(Tlm_Batch_t *b, uint16_t seq, uint32_t tick)
+{
+    b->buf[0] = TLM_REC_BATCH;
+    b->buf[1] = TLM_SCHEMA_VERSION;
+    tlm_put_le(&b->buf[2], seq, 2);
+    tlm_put_le(&b->buf[4], tick, 4);
+    b->buf[8] = 0;
+    b->len = TLM_HDR_LEN;
+    b->count = 0;
+    b->last_tick = tick;
+}
+
+bool Tlm_BatchAdd(Tlm_Batch_t *b, const Tlm_Sample_t *s)
+{
+    uint8_t tmp[TLM_SAMPLE_MAX];
+    uint16_t n = 0;
+    uint32_t dt = s->tick - b->last_tick;
+    uint8_t mask = (uint8_t)(s->valid & 0x7FU);
+    uint8_t err = (uint8_t)(s->error & 0x7FU);
+
+    if (b->count == 0xFF) return false;
+
+    while (dt >= 0x80U)
+    {
+        tmp[n++] = (uint8_t)(dt | 0x80U);
+        dt >>= 7;
+    }
+    tmp[n++] = (uint8_t)dt;
+    tmp[n++] = err ? (uint8_t)(mask | TLM_MASK_ERR) : mask;
+    if (err) tmp[n++] = err;
+
+    for (uint8_t f = 0; f < SNAP_FIELD_NUM; f++)
+    {
+        if (!(mask & (1U << f))) continue;
+        tlm_put_le(&tmp[n], (uint32_t)tlm_quant(s->value[f], &tlm_field[f]), tlm_field[f].width);
+        n += tlm_field[f].width;
+    }
+
+    if (b->len + n + TLM_CRC_LEN > TLM_FRAME_MAX) return false;
+    memcpy(&b->buf[b->len], tmp, n);
+    b->len += n;
+    b->buf[8] = ++b->count;
+    b->last_tick = s->tick;
+    return true;
+}
+
+uint16_t Tlm_FrameEncode(uint8_t *buf, uint16_t len, tlm_crc_fn crc, uint8_t *out, uint16_t out_size)
+{
+    uint16_t total = (uint16_t)(len + TLM_CRC_LEN);
+
+    if (len == 0 || len > TLM_FRAME_MAX - TLM_CRC_LEN || out_size < total + total / 254U + 2U) return 0;
+
+    /* 按字补 0 后计算，补齐部分随后被 CRC 覆盖 */
+    uint16_t padded = (uint16_t)((len + 3U) & ~3U);
+    memset(&buf[len], 0, padded - len);
+    uint32_t c = crc ? crc(buf, padded) : Tlm_Crc32(buf, padded);
+    tlm_put_le(&buf[len], c, 4);
+
+    uint16_t n = Tlm_CobsEncode(buf, total, out);
+    out[n++] = 0;
+    return n;
+}
+
+uint16_t Tlm_BatchFinish(Tlm_Batch_t *b, tlm_crc_fn crc, uint8_t *out, uint16_t out_size)
+{
+    return Tlm_FrameEncode(b->buf, b->len, crc, out, out_size);
+}
+
+/* ---- 解码 ---- */
+
+void Tlm_DecoderInit(Tlm_Decoder_t *d)
+{
+    memset(d, 0, sizeof(*d));
+}
+
+void Tlm_DecoderOnFrame(Tlm_Decoder_t *d, tlm_frame_cb cb, void *ctx)
+{
+    d->frame_cb = cb;
+    d->frame_ctx = ctx;
+}
+
+static void tlm_dec_frame(Tlm_Decoder_t *d, tlm_sample_cb cb, void *ctx)
+{
+    int n = Tlm_CobsDecode(d->raw, d->len, d->frame, sizeof(d->frame));
+    const uint8_t *p = d->frame;
+
+    if (n < 0)
+    {
+        d->stats.cobs_err++;
+        return;
+    }
+    if (n <= (int)TLM_CRC_LEN)
+    {
+        d->stats.schema_err++;
+        return;
+    }
+
+    uint16_t end = (uint16_t)(n - (int)TLM_CRC_LEN);
+    if (Tlm_Crc32(p, end) != tlm_get_le(&p[end], 4))
+    {
+        d->stats.crc_err++;
+        return;
+    }
+    if (p[0] != TLM_REC_BATCH && d->frame_cb)
+    {
+        d->frame_cb(p, end, d->frame_ctx);
+        return;
+    }
+    if (p[0] != TLM_REC_BATCH || p[1] != TLM_SCHEMA_VERSION || end < TLM_HDR_LEN)
+    {
+        d->stats.schema_err++;
+        return;
+    }
+
+    uint16_t seq = (uint16_t)tlm_get_le(&p[2], 2);
+    if (d->has_seq) d->stats.lost += (uint16_t)(seq - d->next_seq);
+    d->next_seq = (uint16_t)(seq + 1U);
+    d->has_seq = 1;
+    d->stats.frames++;
+
+    Tlm_Sample_t s;
+    uint16_t pos = TLM_HDR_LEN;
+    uint8_t count = p[8];
+
+    s.tick = tlm_get_le(&p[4], 4);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        uint32_t dt = 0;
+        uint8_t shift = 0, c;
+        do {
+            if (pos >= end || shift > 28U) goto truncated;
+            c = p[pos++];
+            dt |= (uint32_t)(c & 0x7FU) << shift;
+            shift += 7;
+        } while (c & 0x80U);
+
+        if (pos >= end) goto truncated;
+        uint8_t mask = p[pos++];
+        s.tick += dt;
+        s.valid = (uint8_t)(mask & 0x7FU);
+        s.error = 0;
+        if (mask & TLM_MASK_ERR)
+        {
+            if (pos >= end) goto truncated;
+            s.error = p[pos++];
+        }
+        for (uint8_t f = 0; f < SNAP_FIELD_NUM; f++)
+        {
+            const tlm_field_t *fd = &tlm_field[f];
+            s.value[f] = 0.0f;
+            if (!(s.valid & (1U << f))) continue;
+            if (pos + fd->width > end) goto truncated;
+
+            uint32_t raw = tlm_get_le(&p[pos], fd->width);
+            int32_t v = (int32_t)raw;
+            if (fd->is_signed && (raw & (1UL << (8U * fd->width - 1U))))
+                v = (int32_t)(raw | ~((1UL << (8U * fd->width)) - 1UL));   /* 符号扩展 */
+            s.value[f] = (float)v / fd->scale;
+            pos += fd->width;
+        }
+        d->stats.samples++;
+        if (cb) cb(&s, ctx);
+    }
+    return;
+
+truncated:
+    d->stats.schema_err++;
+}
+
+void Tlm_DecoderFeed(Tlm_Decoder_t *d, const uint8_t *data, uint32_t len, tlm_sample_cb cb, void *ctx)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        uint8_t c = data[i];
+        if (c == 0)
+        {
+            if (d->overflow) d->stats.cobs_err++;
+            else if (d->len > 0) tlm_dec_frame(d, cb, ctx);
+            d->len = 0;
+            d->overflow = 0;
+        }
+        else if (d->len < sizeof(d->raw))
+        {
+            d->raw[d->len++] = c;
+        }
+        else
+        {
+            d->overflow = 1;
+        }
+    }
+}
@@ -0,0 +1,219 @@
+/**
+ * @file    uartrx.c
+ * @brief   UART DMA 循环接收引擎实现
+ *
+ * CubeMX 未给 USART 配置 DMA，这里自行初始化 RX 流并链接到 huart->hdmarx，
+ * 不修改生成代码。HAL 在循环模式下的 ReceiveToIdle 回调参数是 DMA 当前写入位置
+ * （HT 为 N/2，TC 为 N，IDLE 为 N - NDTR），据此与上次位置求出新数据段。
+ * 正常情况下 HT 与 TC 交替出现，连续两次同类边界事件说明 DMA 已套圈、数据被覆盖。
+ */
+#include "uartrx.h"
+#include "usart.h"
+#include "dlog.h"
+
+#define UR_BOUND_HT  0U
+#define UR_BOUND_TC  1U
+#define UR_IRQ_PRIO  6U   /* 与 USART 中断同级 */
+
+typedef struct {
+    UART_HandleTypeDef *huart;
+    DMA_Stream_TypeDef *stream;
+    uint32_t channel;
+    IRQn_Type irq;
+} ur_hw_t;
+
+static const ur_hw_t ur_hw[UARTRX_PORT_NUM] = {
+    { &huart1, DMA2_Stream5, DMA_CHANNEL_4, DMA2_Stream5_IRQn },
+    { &huart2, DMA1_Stream5, DMA_CHANNEL_4, DMA1_Stream5_IRQn },
+    { &huart3, DMA1_Stream1, DMA_CHANNEL_4, DMA1_Stream1_IRQn },
+    { &huart6, DMA2_Stream2, DMA_CHANNEL_5, DMA2_Stream2_IRQn },
+};
+
+typedef struct {
+    DMA_HandleTypeDef hdma;
+    uartrx_cb_t cb;
+    void *ctx;
+    uint16_t pos;          /* 已交付到的位置 */
+    uint8_t last_bound;    /* 上一次边界事件 */
+    uint8_t running;
+    UartRx_Stats_t stats;
+} ur_port_t;
+
+static ur_port_t ur_port[UARTRX_PORT_NUM];
+/* DMA 缓冲必须在 SRAM（DMA 不能访问 CCMRAM） */
+static uint8_t ur_buf[UARTRX_PORT_NUM][UARTRX_BUF_SIZE] __attribute__((aligned(4)));
+
+/* 外设地址 bit14..10 互不相同，直接查表得到端口号 + 1（0 表示不是本引擎的端口）：
+   USART1 0x40011000 -> 4，USART6 0x40011400 -> 5，USART2 0x40004400 -> 17，USART3 0x40004800 -> 18 */
+static const uint8_t ur_index[32] = {
+    [4] = UARTRX_PORT1 + 1, [17] = UARTRX_PORT2 + 1, [18] = UARTRX_PORT3 + 1, [5] = UARTRX_PORT6 + 1
+};
+
+int UartRx_PortOf(UART_HandleTypeDef *huart)
+{
+    if (huart == NULL) return -1;
+
+    int i = (int)ur_index[((uintptr_t)huart->Instance >> 10) & 0x1FU] - 1;
+    if (i < 0 || ur_hw[i].huart != huart) return -1;
+    return i;
+}
+
+static void ur_span(ur_port_t *p, const uint8_t *data, uint16_t len)
+{
+    p->stats.bytes += len;
+    if (p->cb) p->cb(data, len, p->ctx);
+}
+
+/* 交付 [pos, new_pos) 之间的数据，跨越缓冲末尾时分两段 */
+static void ur_deliver(UartRx_Port_t port, uint16_t new_pos)
+{
+    ur_port_t *p = &ur_port[port];
+    const uint8_t *buf = ur_buf[port];
+    uint16_t old = p->pos;
+
+    if (new_pos > UARTRX_BUF_SIZE || new_pos == old) return;
+
+    if (new_pos > old)
+    {
+        ur_span(p, &buf[old], (uint16_t)(new_pos - old));
+    }
+    else
+    {
+        ur_span(p, &buf[old], (uint16_t)(UARTRX_BUF_SIZE - old));
+        if (new_pos) ur_span(p, buf, new_pos);
+    }
+    p->pos = (new_pos == UARTRX_BUF_SIZE) ? 0 : new_pos;
+}
+
+static int ur_arm(UartRx_Port_t port)
+{
+    ur_port_t *p = &ur_port[port];
+
+    p->pos = 0;
+    p->last_bound = UR_BOUND_TC;
+    if (HAL_UARTEx_ReceiveToIdle_DMA(ur_hw[port].huart, ur_buf[port], UARTRX_BUF_SIZE) != HAL_OK)
+        return 1;
+    return 0;
+}
+
+int UartRx_Start(UartRx_Port_t port, uartrx_cb_t cb, void *ctx)
+{
+    if (port >= UARTRX_PORT_NUM) return 1;
+
+    const ur_hw_t *hw = &ur_hw[port];
+    ur_port_t *p = &ur_port[port];
+
+    if (p->running) UartRx_Stop(port);
+
+    if (hw->stream == DMA2_Stream5 || hw->stream == DMA2_Stream2) __HAL_RCC_DMA2_CLK_ENABLE();
+    else __HAL_RCC_DMA1_CLK_ENABLE();
+
+    p->hdma.Instance = hw->stream;
+    p->hdma.Init.Channel = hw->channel;
+    p->hdma.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    p->hdma.Init.PeriphInc = DMA_PINC_DISABLE;
+    p->hdma.Init.MemInc = DMA_MINC_ENABLE;
+    p->hdma.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    p->hdma.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    p->hdma.Init.Mode = DMA_CIRCULAR;
+    p->hdma.Init.Priority = DMA_PRIORITY_MEDIUM;
+    p->hdma.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&p->hdma) != HAL_OK) return 1;
+    __HAL_LINKDMA(hw->huart, hdmarx, p->hdma);
+
+    HAL_NVIC_SetPriority(hw->irq, UR_IRQ_PRIO, 0);
+    HAL_NVIC_EnableIRQ(hw->irq);
+
+    p->cb = cb;
+    p->ctx = ctx;
+    p->running = 1;
+    if (ur_arm(port) != 0)
+    {
+        p->running = 0;
+        return 1;
+    }
+    return 0;
+}
+
+void UartRx_Stop(UartRx_Port_t port)
+{
+    if (port >= UARTRX_PORT_NUM) return;
+
+    ur_port[port].running = 0;
+    HAL_UART_AbortReceive(ur_hw[port].huart);
+    HAL_NVIC_DisableIRQ(ur_hw[port].irq);
+    HAL_DMA_DeInit(&ur_port[port].hdma);
+}
+
+void UartRx_SetHandler(UartRx_Port_t port, uartrx_cb_t cb, void *ctx)
+{
+    if (port >= UARTRX_PORT_NUM) return;
+
+    __disable_irq();
+    ur_port[port].cb = cb;
+    ur_port[port].ctx = ctx;
+    __enable_irq();
+}
+
+void UartRx_GetStats(UartRx_Port_t port, UartRx_Stats_t *stats)
+{
+    if (port >= UARTRX_PORT_NUM || stats == NULL) return;
+
+    __disable_irq();
+    *stats = ur_port[port].stats;
+    __enable_irq();
+}
+
+void UartRx_EventCallback(UART_HandleTypeDef *huart, uint16_t pos)
+{
+    int port = UartRx_PortOf(huart);
+    if (port < 0 || !ur_port[port].running) return;
+
+    ur_port_t *p = &ur_port[port];
+
+    switch (HAL_UARTEx_GetRxEventType(huart))
+    {
+    case HAL_UART_RXEVENT_HT:
+        p->stats.half++;
+        if (p->last_bound == UR_BOUND_HT)
+        {
+            p->stats.overruns++;
+            LOG_W("uart %u rx dma overrun", (uint32_t)port);
+        }
+        p->last_bound = UR_BOUND_HT;
+        break;
+    case HAL_UART_RXEVENT_TC:
+        p->stats.full++;
+        if (p->last_bound == UR_BOUND_TC)
+        {
+            p->stats.overruns++;
+            LOG_W("uart %u rx dma overrun", (uint32_t)port);
+        }
+        p->last_bound = UR_BOUND_TC;
+        break;
+    default:
+        p->stats.idle++;
+        break;
+    }
+    ur_deliver((UartRx_Port_t)port, pos);
+}
+
+/* 使用 DMA 接收时 HAL 把所有接收错误都当作阻塞错误并中止传输，这里统计后重新启动 */
+void UartRx_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    int port = UartRx_PortOf(huart);
+    if (port < 0 || !ur_port[port].running) return;
+
+    ur_port_t *p = &ur_port[port];
+
+    if (huart->ErrorCode & HAL_UART_ERROR_ORE) p->stats.overruns++;
+    if (huart->ErrorCode & (HAL_UART_ERROR_FE | HAL_UART_ERROR_NE | HAL_UART_ERROR_PE)) p->stats.errors++;
+    LOG_W("uart %u rx error 0x%x, restarting", (uint32_t)port, huart->ErrorCode);
+
+    if (huart->RxState == HAL_UART_STATE_READY) ur_arm((UartRx_Port_t)port);
+}
+
+void UartRx_DMAIRQHandler(UartRx_Port_t port)
+{
+    if (port < UARTRX_PORT_NUM) HAL_DMA_IRQHandler(&ur_port[port].hdma);
+}
@@ -1,4 +1,23 @@
 #include "ui.h"
+#include "spectrum.h"
+#include "zbnet.h"
+#include <string.h>
+
+/* 显示一项传感器数据：标签 + 整数值，未采到数据时显示 "--" */
+static void ui_show_field(uint16_t x, uint16_t y, char *label, const snap_value_t *v, uint8_t len)
+{
+    lcd_show_string(x, y, 60, 24, 24, label, DARKBLUE);
+    if (v->status == SNAP_ST_NONE)
+    {
+        lcd_show_string(x + 60, y, 12 * len, 24, 24, "--", GRAY);
+        return;
+    }
+    /* 采集失败时以红色显示上一次的值 */
+    uint16_t color = (v->status == SNAP_ST_OK) ? BLACK : RED;
+    int32_t n = (int32_t)v->value;
+    lcd_show_char(x + 60, y, n < 0 ? '-' : ' ', 24, 0, color);
+    lcd_show_xnum(x + 72, y, (uint32_t)(n < 0 ? -n : n), len, 24, 0, color);
+}
 
 /**
  * @brief  LCD 显示任务：初始化屏幕并周期刷新显示内容
@@ -12,6 +31,7 @@ void LcdDisplayTask(void *argument)
   lcd_show_image(0, 0, gImage_xueyuan);
   lcd_show_image(0, 623, gImage_school);
   uint32_t tick_count = 0;
+  snap_value_t f[SNAP_FIELD_NUM];
 
   for (;;)
   {
@@ -20,13 +40,30 @@ void LcdDisplayTask(void *argument)
     lcd_show_string(10, 290, 200, 24, 24, "Tick:", DARKBLUE);
     lcd_show_num(90, 290, tick_count, 8, 24, RED);
 
-    // lcd_show_xnum(150, 100, T1, 2, 32, 0, BLACK);
-    // lcd_show_xnum(200, 100, T2, 2, 32, 0, BLACK);
-    // lcd_show_xnum(150, 150, H, 2, 32, 0, BLACK);
-    // lcd_show_xnum(170, 200, P, 5, 32, 0, BLACK);
-    // lcd_show_xnum(150, 250, A, 3, 32, 0, BLACK);
-    // lcd_show_xnum(170, 300, L, 5, 32, 0, BLACK);
-    // lcd_show_xnum(150, 350, D, 3, 32, 0, BLACK);
+    /* 零拷贝读取最新快照，只在读取窗口内取字段，刷屏放在窗口外 */
+    const SensorSnapshot_t *snap;
+    uint32_t seq;
+    do {
+      snap = Snapshot_Begin(0, &seq);
+      if (snap) memcpy(f, snap->f, sizeof(f));
+    } while (Snapshot_Retry(snap, seq));
+
+    if (snap)
+    {
+      ui_show_field(10,  330, "T1:", &f[SNAP_T1], 3);
+      ui_show_field(10,  360, "T2:", &f[SNAP_T2], 3);
+      ui_show_field(10,  390, "H:",  &f[SNAP_H],  3);
+      ui_show_field(10,  420, "L:",  &f[SNAP_L],  6);
+      ui_show_field(250, 330, "P:",  &f[SNAP_P],  6);
+      ui_show_field(250, 360, "A:",  &f[SNAP_A],  5);
+      ui_show_field(250, 390, "D:",  &f[SNAP_D],  4);
+    }
+
+    /* ZigBee 协调器节点表（无节点时不绘制） */
+    ZbNet_Draw(10, 450, 460, 48);
+
+    /* ADC 频谱柱状图 */
+    Spectrum_Draw(10, 535, 460, 80);
 
     /* 显示usart2接收内容 */
     if (usart2_rx_display[0] != '\0') {
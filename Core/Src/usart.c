@@ -21,9 +21,9 @@
 #include "usart.h"
 #include "zigbee.h"
 #include "bluetooth.h"
+#include "serial.h"
 
 /* USER CODE BEGIN 0 */
-uint8_t device_on_uart2 = 0; // 0: 无设备, 1: RS485, 2: Bluetooth, 3: ZigBee
 
 /* USER CODE END 0 */
 
@@ -352,13 +352,19 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* uartHandle)
 
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 {
+  Serial_TxCpltCallback(huart);
+}
 
+/* 各 UART 由 Serial 端口注册表管理：接收走 UartRx 的 DMA 循环缓冲（IDLE/半满/全满事件），
+   发送走端口的 DMA 发送缓冲，按句柄分发到端口当前挂接的协议 */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+  UartRx_EventCallback(huart, Size);
 }
 
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
 {
-  if(device_on_uart2==2) Bluetooth_UART_RxCpltCallback();
-  if(device_on_uart2==3) ZigBee_UART_RxCpltCallback();
-    
+  UartRx_ErrorCallback(huart);
+  Serial_TxErrorCallback(huart);
 }
 /* USER CODE END 1 */
@@ -25,20 +25,13 @@ void Usart2Task(void *argument)
     //     bt_has_new = 0; // 重置标记
     //   }
 
-    // /* === 检查是否有 ZigBee 模块发来的完整帧 === */
-    // if (ZigBee_IsRxFrameReady())
+    // /* === 取出 ZigBee 模块发来的数据包（零拷贝，用完归还） === */
+    // DL_Packet_t *pkt;
+    // while (ZigBee_GetPacket(&pkt, 0) == DL_OK)
     // {
-    //     uint8_t raw_frame[128];
-    //     uint16_t rlen = ZigBee_GetRxFrame(raw_frame, sizeof(raw_frame));
-    //     if (rlen > 0)
-    //     {
-    //         /* 把原始帧转成十六进制字符串，例如 "FE 05 91 21 00 00 01 FF" */
-    //         bytes_to_hex_str(raw_frame, rlen, usart2_rx_display, sizeof(usart2_rx_display));
-    //         DL_Packet_t receive_pkg;
-    //         ZigBee_Read_data(raw_frame, rlen, &receive_pkg);  // 提取包中实际数据
-    //         //lcd_show_string(10, 700, 400, 32, 24, "Received LN33 Packet Data:", MAGENTA);
-    //         //lcd_show_xnum(350, 700, receive_pkg.data[0], 5, 24, 1, MAGENTA); //以十进制显示数据
-    //     }
+    //     /* 把数据转成十六进制字符串，例如 "21 00 00 01" */
+    //     bytes_to_hex_str(pkt->data, pkt->data_len, usart2_rx_display, sizeof(usart2_rx_display));
+    //     ZigBee_ReleasePacket(pkt);
     // }
 
     osDelay(500);
@@ -1,17 +1,36 @@
 #include "usart3task.h"
+#include "modbus.h"
+#include "config.h"
+#include "dlog.h"
 
 
 /* usart3接收内容（供 LCD 任务显示） */
 char usart3_rx_display[128] = {0};
 
 
+/**
+ * @brief  USART3 (RS485) 任务：作为 Modbus RTU 从站对外提供传感器寄存器
+ *         请求在中断中应答，本任务只处理写寄存器引起的延后操作
+ *         站地址保存在参数区，等 GetDataTask 载入参数后先自检，再由 Modbus_MapService 启动从站
+ */
 void Usart3Task(void *argument)
 {
-  
+  uint32_t cycles = 0;
+
+  while (!Config_IsLoaded())
+  {
+    osDelay(10);
+  }
+
+  if (Modbus_Test(&cycles) == 0)
+    LOG_I("modbus self-test PASS, worst %u cyc/frame", cycles);
+  else
+    LOG_E("modbus self-test FAIL, worst %u cyc/frame", cycles);
+
   for (;;)
   {
-    
-    osDelay(500);
+    Modbus_MapService();
+    osDelay(50);
   }
 }
 
@@ -0,0 +1,207 @@
+/**
+ * @file    zbframe.c
+ * @brief   ZigBee 透传帧封包与流式解包实现
+ */
+#include "zbframe.h"
+#include <stddef.h>
+
+typedef enum {
+    ZP_IDLE = 0,    /* 等待包头 FE */
+    ZP_LEN,         /* 长度字节（不转义） */
+    ZP_BODY,        /* 转义区 */
+    ZP_ESC,         /* 收到 FE，等待 FD/FC */
+    ZP_SKIP         /* 丢弃到包尾 FF */
+} zp_state_t;
+
+static void zp_put(ZbFrame_Parser_t *p, uint8_t b)
+{
+    DL_Packet_t *pkt = p->pkt;
+
+    if (p->n >= p->declared) {
+        p->stats.overflow++;
+        p->state = ZP_SKIP;
+        return;
+    }
+    switch (p->n) {
+    case 0:  pkt->src = b; break;
+    case 1:  pkt->dst = b; break;
+    case 2:  pkt->addr = b; break;
+    case 3:  pkt->addr |= (uint16_t)b << 8; break;
+    default: pkt->data[p->n - 4U] = b; break;
+    }
+    p->n++;
+}
+
+static void zp_end(ZbFrame_Parser_t *p)
+{
+    p->state = ZP_IDLE;
+    if (p->n != p->declared) {
+        p->stats.len_err++;
+        return;
+    }
+    p->pkt->data_len = (uint16_t)(p->n - 4U);
+    if (p->post(p->pkt) != 0) {
+        p->stats.queue_full++;   /* 队列满：丢弃本帧，槽位留给下一帧 */
+        return;
+    }
+    p->pkt = NULL;
+    p->stats.frames++;
+}
+
+static void zp_feed(ZbFrame_Parser_t *p, uint8_t b)
+{
+    switch (p->state) {
+    case ZP_IDLE:
+        if (b == 0xFE) {
+            p->state = ZP_LEN;
+        }
+        break;
+
+    case ZP_LEN:
+        if (b < 4U || b > 4U + ZBFRAME_MAX_PAYLOAD) {
+            p->stats.len_err++;
+            p->state = (b == 0xFE) ? ZP_LEN : ZP_IDLE;
+            break;
+        }
+        if (p->pkt == NULL) {
+            p->pkt = p->alloc();
+        }
+        if (p->pkt == NULL) {
+            p->stats.no_slot++;
+            p->state = ZP_SKIP;
+            break;
+        }
+        p->declared = b;
+        p->n = 0;
+        p->state = ZP_BODY;
+        break;
+
+    case ZP_BODY:
+        /* 数据中的 FF 必被转义为 FE FD，所以 FF 只能是包尾 */
+        if (b == 0xFF) {
+            zp_end(p);
+        } else if (b == 0xFE) {
+            p->state = ZP_ESC;
+        } else {
+            zp_put(p, b);
+        }
+        break;
+
+    case ZP_ESC:
+        p->state = ZP_BODY;
+        if (b == 0xFD) {
+            zp_put(p, 0xFF);
+        } else if (b == 0xFC) {
+            zp_put(p, 0xFE);
+        } else {
+            p->stats.esc_err++;
+            p->state = (b == 0xFF) ? ZP_IDLE : ZP_SKIP;
+        }
+        break;
+
+    default:   /* ZP_SKIP */
+        if (b == 0xFF) {
+            p->state = ZP_IDLE;
+        }
+        break;
+    }
+}
+
+void ZbFrame_Reset(ZbFrame_Parser_t *p)
+{
+    p->state = ZP_IDLE;
+}
+
+void ZbFrame_Feed(ZbFrame_Parser_t *p, const uint8_t *data, uint16_t len)
+{
+    const uint8_t *s = data;
+    const uint8_t *e = data + len;
+
+    p->stats.bytes += len;
+    while (s < e) {
+        if (p->state == ZP_BODY && p->n >= 4U) {
+            /* 快速路径：载荷中连续的普通字节（非 FE/FF）直接写入槽位，不经状态机，
+               遇到转义、包尾或写满声明长度时回到逐字节处理 */
+            uint8_t *dst = &p->pkt->data[p->n - 4U];
+            const uint8_t *run = s;
+            const uint8_t *stop = (e - s > p->declared - p->n) ? s + (p->declared - p->n) : e;
+
+            while (s < stop && *s < 0xFEU) {
+                *dst++ = *s++;
+            }
+            p->n = (uint16_t)(p->n + (s - run));
+            if (s == e) break;
+        }
+        zp_feed(p, *s++);
+    }
+}
+
+static DL_Status_t append_byte(uint8_t **ptr, uint16_t *len,
+                               uint8_t byte)
+{
+    if ((*len) >= ZBFRAME_MAX_LEN) {
+        return DL_ERROR;
+    }
+
+    **ptr = byte;
+    (*ptr)++;
+    (*len)++;
+    return DL_OK;
+}
+
+/* 
+ * 转义规则 (根据图片):
+ * FF -> FE FD
+ * FE -> FE FC
+ */
+static DL_Status_t append_escaped(uint8_t **ptr, uint16_t *len,
+                                  uint8_t byte)
+{
+    if (byte == 0xFF) {
+        if (append_byte(ptr, len, 0xFE) != DL_OK) return DL_ERROR;
+        if (append_byte(ptr, len, 0xFD) != DL_OK) return DL_ERROR;
+    } else if (byte == 0xFE) {
+        if (append_byte(ptr, len, 0xFE) != DL_OK) return DL_ERROR;
+        if (append_byte(ptr, len, 0xFC) != DL_OK) return DL_ERROR;
+    } else {
+        if (append_byte(ptr, len, byte) != DL_OK) return DL_ERROR;
+    }
+    return DL_OK;
+}
+
+DL_Status_t ZbFrame_Encode(uint8_t *buf, uint8_t src, uint8_t dst, uint16_t addr,
+                           const uint8_t *payload, uint16_t payload_len,
+                           uint16_t *frame_len)
+{
+    uint8_t *p = buf;
+    uint16_t len = 0;
+
+    if (payload_len > ZBFRAME_MAX_PAYLOAD) return DL_ERROR;
+
+    /* 1. 包头 FE */
+    if (append_byte(&p, &len, 0xFE) != DL_OK) return DL_ERROR;
+    
+    /* 2. 长度 (数据长度+4), 不转义 */
+    if (append_byte(&p, &len, (uint8_t)(4U + payload_len)) != DL_OK) return DL_ERROR;
+    
+    /* 3. 源端口 (转义) */
+    if (append_escaped(&p, &len, src) != DL_OK) return DL_ERROR;
+    
+    /* 4. 目的端口 (转义) */
+    if (append_escaped(&p, &len, dst) != DL_OK) return DL_ERROR;
+    
+    /* 5. 远程地址 (小端, 转义) */
+    if (append_escaped(&p, &len, (uint8_t)(addr & 0xFFU)) != DL_OK) return DL_ERROR;
+    if (append_escaped(&p, &len, (uint8_t)((addr >> 8) & 0xFFU)) != DL_OK) return DL_ERROR;
+
+    /* 6. 数据 (转义) */
+    for (uint16_t i = 0; i < payload_len; ++i) {
+        if (append_escaped(&p, &len, payload[i]) != DL_OK) return DL_ERROR;
+    }
+
+    /* 7. 包尾 FF */
+    if (append_byte(&p, &len, 0xFF) != DL_OK) return DL_ERROR;
+
+    *frame_len = len;
+    return DL_OK;
+}
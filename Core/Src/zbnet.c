@@ -0,0 +1,258 @@
+/**
+ * @file    zbnet.c
+ * @brief   ZigBee 协调器节点表实现
+ *
+ * 节点按插入顺序连续存放在 zn_node 中（便于遍历与导出），哈希槽 zn_slot 只存
+ * 节点序号 + 1（0 为空），地址经乘法散列后线性探测。
+ * 协调器任务写入、LCD/控制台读取，读写都在调度器锁内完成，单个数据包的解码只需几微秒。
+ */
+#include "zbnet.h"
+#include "tftlcd.h"
+#include "fmt.h"
+#include "cmsis_os2.h"
+#include <string.h>
+
+#define ZN_SLOT_MASK   (ZBNET_SLOTS - 1U)
+#define ZN_ROW_H       16U
+
+static ZbNet_Node_t zn_node[ZBNET_MAX_NODES];
+static uint16_t zn_slot[ZBNET_SLOTS];
+static uint16_t zn_count = 0;
+static ZbNet_Stats_t zn_stats;
+static uint16_t zn_page = 0;
+
+static inline uint32_t zn_hash(uint16_t addr)
+{
+    return (((uint32_t)addr * 0x9E3779B1U) >> 16) & ZN_SLOT_MASK;
+}
+
+/* 查找节点，insert 为真且不存在时插入，表满返回 NULL（调用方持锁） */
+static ZbNet_Node_t *zn_lookup(uint16_t addr, bool insert)
+{
+    uint32_t i = zn_hash(addr);
+
+    /* 装载率不超过 0.5，必然遇到空槽 */
+    for (;;)
+    {
+        uint16_t s = zn_slot[i];
+        if (s == 0) break;
+        if (zn_node[s - 1U].addr == addr) return &zn_node[s - 1U];
+        i = (i + 1U) & ZN_SLOT_MASK;
+    }
+    if (!insert || zn_count >= ZBNET_MAX_NODES) return NULL;
+
+    ZbNet_Node_t *n = &zn_node[zn_count];
+    memset(n, 0, sizeof(*n));
+    n->addr = addr;
+    ZbPack_DecInit(&n->dec);
+    zn_slot[i] = ++zn_count;
+    zn_stats.nodes = zn_count;
+    return n;
+}
+
+static void zn_on_sample(const ZbPack_Sample_t *s, void *ctx)
+{
+    ZbNet_Node_t *n = (ZbNet_Node_t *)ctx;
+
+    n->sample_tick = s->tick;
+    n->mask |= s->mask;
+    for (uint8_t ch = 0; ch < ZBPACK_MAX_CH; ch++)
+        if (s->mask & (1U << ch)) n->value[ch] = s->v[ch];
+}
+
+void ZbNet_Reset(void)
+{
+    osKernelLock();
+    memset(zn_slot, 0, sizeof(zn_slot));
+    memset(&zn_stats, 0, sizeof(zn_stats));
+    zn_count = 0;
+    zn_page = 0;
+    osKernelUnlock();
+}
+
+int ZbNet_Input(const DL_Packet_t *pkt, uint32_t now)
+{
+    int ret = 0;
+
+    if (pkt == NULL) return 1;
+
+    osKernelLock();
+    zn_stats.packets++;
+    ZbNet_Node_t *n = zn_lookup(pkt->addr, true);
+    if (n == NULL)
+    {
+        zn_stats.table_full++;
+        osKernelUnlock();
+        return 1;
+    }
+
+    if (n->packets == 0) n->first_rx = now;
+    n->packets++;
+    n->last_rx = now;
+    n->src = pkt->src;
+
+    uint32_t lost = n->dec.stats.lost;
+    uint16_t len = pkt->data_len <= sizeof(pkt->data) ? pkt->data_len : sizeof(pkt->data);
+    int r = ZbPack_Decode(&n->dec, pkt->data, len, zn_on_sample, n);
+    zn_stats.lost += n->dec.stats.lost - lost;
+    if (r < 0)
+    {
+        zn_stats.errors++;
+        ret = 1;
+    }
+    else
+    {
+        zn_stats.samples += (uint32_t)r;
+    }
+    osKernelUnlock();
+    return ret;
+}
+
+bool ZbNet_Find(uint16_t addr, ZbNet_Node_t *out)
+{
+    osKernelLock();
+    const ZbNet_Node_t *n = zn_lookup(addr, false);
+    if (n && out) *out = *n;
+    osKernelUnlock();
+    return n != NULL;
+}
+
+bool ZbNet_Get(uint16_t index, ZbNet_Node_t *out)
+{
+    bool ok = false;
+
+    osKernelLock();
+    if (index < zn_count)
+    {
+        if (out) *out = zn_node[index];
+        ok = true;
+    }
+    osKernelUnlock();
+    return ok;
+}
+
+void ZbNet_GetStats(ZbNet_Stats_t *stats)
+{
+    if (stats == NULL) return;
+    osKernelLock();
+    *stats = zn_stats;
+    osKernelUnlock();
+}
+
+int ZbNet_FormatNode(const ZbNet_Node_t *n, uint32_t now, char *out, uint16_t size)
+{
+    Fmt_t f;
+
+    Fmt_Init(&f, out, size);
+    Fmt_Hex(&f, n->addr, 4);
+    Fmt_Str(&f, " pk:");
+    Fmt_U32(&f, n->packets, 0, ' ');
+    Fmt_Str(&f, " lost:");
+    Fmt_U32(&f, n->dec.stats.lost, 0, ' ');
+    Fmt_Str(&f, " err:");
+    Fmt_U32(&f, n->dec.stats.errors, 0, ' ');
+    Fmt_Char(&f, ' ');
+    Fmt_U32(&f, (now - n->last_rx) / 1000U, 0, ' ');
+    Fmt_Char(&f, 's');
+
+    for (uint8_t ch = 0; ch < ZBPACK_MAX_CH; ch++)
+    {
+        if (!(n->mask & (1U << ch))) continue;
+        Fmt_Char(&f, ' ');
+        Fmt_I32(&f, n->value[ch], 0, ' ');
+    }
+    return f.len;
+}
+
+void ZbNet_Draw(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    char line[80];
+    ZbNet_Stats_t st;
+    ZbNet_Node_t n;
+
+    ZbNet_GetStats(&st);
+    if (st.nodes == 0 || h < ZN_ROW_H) return;
+
+    uint32_t now = osKernelGetTickCount();
+    uint16_t rows = (uint16_t)(h / ZN_ROW_H - 1U);
+
+    lcd_fill(x, y, x + w - 1, y + h - 1, WHITE);
+    Fmt_t f;
+    Fmt_Init(&f, line, sizeof(line));
+    Fmt_Str(&f, "Nodes:");
+    Fmt_U32(&f, st.nodes, 0, ' ');
+    Fmt_Str(&f, " Pkt:");
+    Fmt_U32(&f, st.packets, 0, ' ');
+    Fmt_Str(&f, " Lost:");
+    Fmt_U32(&f, st.lost, 0, ' ');
+    Fmt_Str(&f, " Err:");
+    Fmt_U32(&f, st.errors, 0, ' ');
+    Fmt_Str(&f, " Full:");
+    Fmt_U32(&f, st.table_full, 0, ' ');
+    lcd_show_string(x, y, w, ZN_ROW_H, 16, line, DARKBLUE);
+
+    if (rows == 0) return;
+    if ((uint32_t)zn_page * rows >= st.nodes) zn_page = 0;
+    for (uint16_t r = 0; r < rows; r++)
+    {
+        if (!ZbNet_Get((uint16_t)(zn_page * rows + r), &n)) break;
+        ZbNet_FormatNode(&n, now, line, sizeof(line));
+        lcd_show_string(x, (uint16_t)(y + (r + 1U) * ZN_ROW_H), w, ZN_ROW_H, 16, line,
+                        n.dec.synced ? BLACK : RED);
+    }
+    zn_page++;
+}
+
+static uint8_t zn_put_le(uint8_t *p, uint32_t v, uint8_t bytes)
+{
+    for (uint8_t k = 0; k < bytes; k++) p[k] = (uint8_t)(v >> (8 * k));
+    return bytes;
+}
+
+uint16_t ZbNet_Export(uint8_t *out, uint16_t size, uint16_t *cursor, uint32_t now)
+{
+    uint16_t len = 0;
+    ZbNet_Node_t n;
+
+    if (out == NULL || cursor == NULL) return 0;
+
+    while (ZbNet_Get(*cursor, &n))
+    {
+        uint8_t nch = 0;
+        for (uint8_t ch = 0; ch < ZBPACK_MAX_CH; ch++) nch += (n.mask >> ch) & 1U;
+        if (len + ZBNET_EXPORT_HDR + 4U * nch > size) break;
+
+        uint8_t *p = &out[len];
+        p += zn_put_le(p, n.addr, 2);
+        *p++ = n.mask;
+        *p++ = (uint8_t)(n.dec.stats.lost > 0xFFU ? 0xFFU : n.dec.stats.lost);
+        p += zn_put_le(p, now - n.last_rx, 4);
+        p += zn_put_le(p, n.packets, 4);
+        p += zn_put_le(p, n.dec.stats.samples, 4);
+        for (uint8_t ch = 0; ch < ZBPACK_MAX_CH; ch++)
+            if (n.mask & (1U << ch)) p += zn_put_le(p, (uint32_t)n.value[ch], 4);
+
+        len = (uint16_t)(p - out);
+        (*cursor)++;
+    }
+    return len;
+}
+
+void ZbNetTask(void *argument)
+{
+    DL_Packet_t *pkt;
+    UartRx_Port_t port = argument ? *(const UartRx_Port_t *)argument : ZigBee_DEFAULT_PORT;
+
+    ZigBee_InitPort(port);
+
+    for (;;)
+    {
+        if (ZigBee_GetPacket(&pkt, osWaitForever) != DL_OK)
+        {
+            osDelay(100);   /* 接收池未建立 */
+            continue;
+        }
+        ZbNet_Input(pkt, osKernelGetTickCount());
+        ZigBee_ReleasePacket(pkt);
+    }
+}
@@ -0,0 +1,201 @@
+/**
+ * @file    zbpack.c
+ * @brief   ZigBee 遥测载荷编解码实现
+ *
+ * 差值按 32 位无符号回绕计算，任意 int32 输入都能无损还原。
+ * 传感器读数变化缓慢，差值通常落在 ±63 之内，每个通道只占 1 字节。
+ */
+#include "zbpack.h"
+#include <string.h>
+
+static uint8_t zbp_put_uvar(uint8_t *p, uint32_t v)
+{
+    uint8_t n = 0;
+    while (v >= 0x80U)
+    {
+        p[n++] = (uint8_t)(v | 0x80U);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+/* 读 varint，越界或超过 5 字节返回 false */
+static bool zbp_get_uvar(const uint8_t *p, uint16_t len, uint16_t *pos, uint32_t *v)
+{
+    uint32_t x = 0;
+    uint8_t shift = 0, c;
+
+    do {
+        if (*pos >= len || shift > 28U) return false;
+        c = p[(*pos)++];
+        x |= (uint32_t)(c & 0x7FU) << shift;
+        shift += 7;
+    } while (c & 0x80U);
+    *v = x;
+    return true;
+}
+
+static inline uint32_t zbp_zigzag(uint32_t d)
+{
+    return (d << 1) ^ (uint32_t)-(d >> 31);
+}
+
+static inline uint32_t zbp_unzigzag(uint32_t z)
+{
+    return (z >> 1) ^ (uint32_t)-(z & 1U);
+}
+
+void ZbPack_EncInit(ZbPack_Enc_t *e, uint8_t key_interval)
+{
+    memset(e, 0, sizeof(*e));
+    e->key_interval = key_interval;
+    e->force_key = 1;
+}
+
+void ZbPack_ForceKey(ZbPack_Enc_t *e)
+{
+    e->force_key = 1;
+}
+
+void ZbPack_Begin(ZbPack_Enc_t *e, uint8_t *buf, uint16_t size)
+{
+    uint8_t key = e->force_key || (e->key_interval && e->since_key >= e->key_interval);
+
+    e->buf = buf;
+    e->size = size;
+    e->count = 0;
+    if (key)
+    {
+        e->w_tick = 0;
+        memset(e->w_prev, 0, sizeof(e->w_prev));
+    }
+    else
+    {
+        e->w_tick = e->last_tick;
+        memcpy(e->w_prev, e->prev, sizeof(e->w_prev));
+    }
+    buf[0] = (uint8_t)((ZBPACK_VERSION << 4) | (key ? ZBPACK_FLAG_KEY : 0U));
+    buf[1] = e->seq;
+    buf[2] = 0;
+    e->len = ZBPACK_HDR_LEN;
+}
+
+bool ZbPack_Add(ZbPack_Enc_t *e, const ZbPack_Sample_t *s)
+{
+    uint8_t tmp[ZBPACK_SAMPLE_MAX];
+    uint8_t n;
+
+    if (e->count == 0xFF) return false;
+
+    n = zbp_put_uvar(tmp, s->tick - e->w_tick);
+    tmp[n++] = s->mask;
+    for (uint8_t ch = 0; ch < ZBPACK_MAX_CH; ch++)
+    {
+        if (!(s->mask & (1U << ch))) continue;
+        n += zbp_put_uvar(&tmp[n], zbp_zigzag((uint32_t)s->v[ch] - (uint32_t)e->w_prev[ch]));
+    }
+    if (e->len + n > e->size) return false;
+
+    memcpy(&e->buf[e->len], tmp, n);
+    e->len += n;
+    e->buf[2] = ++e->count;
+    e->w_tick = s->tick;
+    for (uint8_t ch = 0; ch < ZBPACK_MAX_CH; ch++)
+        if (s->mask & (1U << ch)) e->w_prev[ch] = s->v[ch];
+    return true;
+}
+
+uint16_t ZbPack_End(ZbPack_Enc_t *e)
+{
+    if (e->count == 0) return 0;
+
+    if (e->buf[0] & ZBPACK_FLAG_KEY)
+    {
+        e->since_key = 0;
+        e->force_key = 0;
+    }
+    e->since_key++;
+    e->seq++;
+    e->last_tick = e->w_tick;
+    memcpy(e->prev, e->w_prev, sizeof(e->prev));
+    return e->len;
+}
+
+void ZbPack_DecInit(ZbPack_Dec_t *d)
+{
+    memset(d, 0, sizeof(*d));
+}
+
+int ZbPack_Decode(ZbPack_Dec_t *d, const uint8_t *data, uint16_t len, zbpack_sample_cb cb, void *ctx)
+{
+    uint16_t pos = 0;
+    int total = 0;
+
+    while (pos < len)
+    {
+        if ((uint16_t)(len - pos) < ZBPACK_HDR_LEN || (data[pos] >> 4) != ZBPACK_VERSION) goto bad;
+
+        uint8_t key = data[pos] & ZBPACK_FLAG_KEY;
+        uint8_t seq = data[pos + 1];
+        uint8_t count = data[pos + 2];
+        pos += ZBPACK_HDR_LEN;
+
+        if (d->synced && seq != d->next_seq)
+        {
+            d->stats.lost += (uint8_t)(seq - d->next_seq);
+            d->synced = 0;
+        }
+        d->next_seq = (uint8_t)(seq + 1U);
+
+        /* 失步时差分帧只解析结构以找到下一帧 */
+        uint8_t use = key || d->synced;
+        ZbPack_Sample_t s;
+        if (key)
+        {
+            d->last_tick = 0;
+            memset(d->prev, 0, sizeof(d->prev));
+            d->stats.keys++;
+        }
+        s.tick = d->last_tick;
+        memcpy(s.v, d->prev, sizeof(s.v));
+
+        for (uint8_t i = 0; i < count; i++)
+        {
+            uint32_t dt, z;
+            if (!zbp_get_uvar(data, len, &pos, &dt) || pos >= len) goto bad;
+            s.tick += dt;
+            s.mask = data[pos++];
+            for (uint8_t ch = 0; ch < ZBPACK_MAX_CH; ch++)
+            {
+                if (!(s.mask & (1U << ch))) continue;
+                if (!zbp_get_uvar(data, len, &pos, &z)) goto bad;
+                s.v[ch] = (int32_t)((uint32_t)s.v[ch] + zbp_unzigzag(z));
+            }
+            if (use)
+            {
+                d->stats.samples++;
+                total++;
+                if (cb) cb(&s, ctx);
+            }
+        }
+
+        if (use)
+        {
+            d->synced = 1;
+            d->last_tick = s.tick;
+            memcpy(d->prev, s.v, sizeof(d->prev));
+            d->stats.frames++;
+        }
+        else
+        {
+            d->stats.skipped++;
+        }
+    }
+    return total;
+
+bad:
+    d->stats.errors++;
+    d->synced = 0;
+    return -1;
+}
@@ -1,161 +1,93 @@
 #include "zigbee.h"
+#include "serial.h"
+#include "zbframe.h"
+#include "fmt.h"
+#include "cmsis_os2.h"
 #include <string.h>
-#include <stdio.h>
 
-#define ZigBee_MAX_FRAME      128U
+#define ZigBee_MAX_FRAME      ZBFRAME_MAX_LEN
 #define ZigBee_TX_BUF_SIZE    ZigBee_MAX_FRAME
-#define ZigBee_RX_BUF_SIZE    ZigBee_MAX_FRAME
+#define ZigBee_MAX_PAYLOAD    ZBFRAME_MAX_PAYLOAD
 
 static uint8_t tx_buf[ZigBee_TX_BUF_SIZE];
-static uint8_t rx_buf[ZigBee_RX_BUF_SIZE];
-static uint8_t rx_frame_ready = 0;
-static uint16_t rx_len = 0;
-
-/* 单字节中断接收暂存 */
-static uint8_t rx_byte_it;
 
 static uint8_t *frame_ptr = NULL;
 static uint16_t frame_len = 0;
 
-typedef enum {
-    RX_STATE_IDLE = 0,
-    RX_STATE_FRAME
-} RX_State_t;
-
-static RX_State_t rx_state = RX_STATE_IDLE;
+/* 接收：中断中逐段喂入 zbframe 流式解析器，完整的包经内存池槽位放入队列 */
+static osMemoryPoolId_t zb_rx_pool = NULL;
+static osMessageQueueId_t zb_rx_queue = NULL;
 
-static inline void rx_reset(void)
+static DL_Packet_t *zb_pool_alloc(void)
 {
-    rx_state = RX_STATE_IDLE;
-    rx_len = 0;
-    rx_frame_ready = 0;
+    return (DL_Packet_t *)osMemoryPoolAlloc(zb_rx_pool, 0);
 }
 
-void ZigBee_InitIT(void)
+static int zb_queue_post(DL_Packet_t *pkt)
 {
-    rx_reset();
-    if (ZigBee_DEFAULT_UART != NULL) {
-        HAL_UART_Receive_IT(ZigBee_DEFAULT_UART, &rx_byte_it, 1);
-        device_on_uart2 = 3; // 标记 UART2 连接了 ZigBee
-    }
+    return (osMessageQueuePut(zb_rx_queue, &pkt, 0, 0) == osOK) ? 0 : 1;
 }
 
-/**
- * @brief  ZigBee UART 接收完成回调（需在 HAL_UART_RxCpltCallback 中调用）
- *         处理收到的字节并重新启动中断接收
- */
-void ZigBee_UART_RxCpltCallback(void)
-{
-    if (rx_frame_ready) {
-        return;
-    }
+static ZbFrame_Parser_t zb_rx = { .alloc = zb_pool_alloc, .post = zb_queue_post };
 
-    switch (rx_state) {
-    case RX_STATE_IDLE:
-        if (rx_byte_it == 0xFE) {
-            rx_len = 0U;
-            rx_buf[rx_len++] = rx_byte_it;
-            rx_state = RX_STATE_FRAME;
-        }
-        break;
-
-    case RX_STATE_FRAME:
-        if (rx_len < ZigBee_RX_BUF_SIZE) {
-            rx_buf[rx_len++] = rx_byte_it;
-            if (rx_byte_it == 0xFF) {
-                /* 收到包尾，标记帧就绪 */
-                /* 注意：因为数据中的 FF 必被转义为 FE FD，所以 FF 只能是包尾 */
-                rx_frame_ready = 1U;
-                rx_state = RX_STATE_IDLE;
-            }
-        } else {
-            rx_reset(); // 溢出复位
-        }
-        break;
+static UartRx_Port_t zb_port = ZigBee_DEFAULT_PORT;   /* 当前挂接的端口 */
 
-    default:
-        rx_reset();
-        break;
-    }
-    HAL_UART_Receive_IT(ZigBee_DEFAULT_UART, &rx_byte_it, 1);
-}
+static void zb_attach(UartRx_Port_t port, void *ctx);
+static void zb_detach(UartRx_Port_t port, void *ctx);
+static void zb_on_rx(UartRx_Port_t port, void *ctx, const uint8_t *data, uint16_t len);
+static void zb_on_tx_done(UartRx_Port_t port, void *ctx, uint32_t sent);
+
+const Serial_Protocol_t ZigBee_Protocol = {
+    .name    = "zigbee",
+    .attach  = zb_attach,
+    .detach  = zb_detach,
+    .rx      = zb_on_rx,
+    .tx_done = zb_on_tx_done,
+};
 
-static uint8_t calc_len(uint16_t payload_len)
+void ZigBee_InitIT(void)
 {
-    return (uint8_t)(4U + payload_len);
+    ZigBee_InitPort(ZigBee_DEFAULT_PORT);
 }
 
-static DL_Status_t append_byte(uint8_t **ptr, uint16_t *len,
-                               uint8_t byte)
+int ZigBee_InitPort(UartRx_Port_t port)
 {
-    if ((*len) >= ZigBee_MAX_FRAME) {
-        return DL_ERROR;
+    if (zb_rx_pool == NULL) {
+        zb_rx_pool = osMemoryPoolNew(ZigBee_RX_POOL_LEN, sizeof(DL_Packet_t), NULL);
     }
-
-    **ptr = byte;
-    (*ptr)++;
-    (*len)++;
-    return DL_OK;
+    if (zb_rx_queue == NULL) {
+        zb_rx_queue = osMessageQueueNew(ZigBee_RX_POOL_LEN, sizeof(DL_Packet_t *), NULL);
+    }
+    if (zb_rx_pool == NULL || zb_rx_queue == NULL) {
+        return 1;
+    }
+    return Serial_Attach(port, &ZigBee_Protocol, NULL) != 0;
 }
 
-/* 
- * 转义规则 (根据图片):
- * FF -> FE FD
- * FE -> FE FC
- */
-static DL_Status_t append_escaped(uint8_t **ptr, uint16_t *len,
-                                  uint8_t byte)
+/* 接收字节段（中断上下文） */
+static void zb_on_rx(UartRx_Port_t port, void *ctx, const uint8_t *data, uint16_t len)
 {
-    if (byte == 0xFF) {
-        if (append_byte(ptr, len, 0xFE) != DL_OK) return DL_ERROR;
-        if (append_byte(ptr, len, 0xFD) != DL_OK) return DL_ERROR;
-    } else if (byte == 0xFE) {
-        if (append_byte(ptr, len, 0xFE) != DL_OK) return DL_ERROR;
-        if (append_byte(ptr, len, 0xFC) != DL_OK) return DL_ERROR;
-    } else {
-        if (append_byte(ptr, len, byte) != DL_OK) return DL_ERROR;
-    }
-    return DL_OK;
+    (void)port;
+    (void)ctx;
+    ZbFrame_Feed(&zb_rx, data, len);
 }
 
 DL_Status_t ZigBee_BuildFrame(uint8_t src, uint8_t dst, uint16_t addr,
                                const uint8_t *payload, uint16_t payload_len,
                                uint8_t **frame_out, uint16_t *frame_len_out)
 {
-    if (payload_len > (ZigBee_MAX_FRAME - 10U)) { // 预留足够的转义空间
+    if (payload_len > ZigBee_TX_PAYLOAD_MAX) { // 预留足够的转义空间
         return DL_ERROR;
     }
     if ((frame_out == NULL) || (frame_len_out == NULL)) {
         return DL_INVALID;
     }
 
-    uint8_t *p = tx_buf;
     uint16_t len = 0;
-
-    /* 1. 包头 FE */
-    if (append_byte(&p, &len, 0xFE) != DL_OK) return DL_ERROR;
-    
-    /* 2. 长度 (数据长度+4), 不转义 */
-    if (append_byte(&p, &len, calc_len(payload_len)) != DL_OK) return DL_ERROR;
-    
-    /* 3. 源端口 (转义) */
-    if (append_escaped(&p, &len, src) != DL_OK) return DL_ERROR;
-    
-    /* 4. 目的端口 (转义) */
-    if (append_escaped(&p, &len, dst) != DL_OK) return DL_ERROR;
-    
-    /* 5. 远程地址 (小端, 转义) */
-    if (append_escaped(&p, &len, (uint8_t)(addr & 0xFFU)) != DL_OK) return DL_ERROR;
-    if (append_escaped(&p, &len, (uint8_t)((addr >> 8) & 0xFFU)) != DL_OK) return DL_ERROR;
-
-    /* 6. 数据 (转义) */
-    for (uint16_t i = 0; i < payload_len; ++i) {
-        if (append_escaped(&p, &len, payload[i]) != DL_OK) return DL_ERROR;
+    if (ZbFrame_Encode(tx_buf, src, dst, addr, payload, payload_len, &len) != DL_OK) {
+        return DL_ERROR;
     }
 
-    /* 7. 包尾 FF */
-    if (append_byte(&p, &len, 0xFF) != DL_OK) return DL_ERROR;
-
     frame_ptr = tx_buf;
     frame_len = len;
     *frame_out = tx_buf;
@@ -163,185 +95,364 @@ DL_Status_t ZigBee_BuildFrame(uint8_t src, uint8_t dst, uint16_t addr,
     return DL_OK;
 }
 
-DL_Status_t ZigBee_SendPacket(uint8_t src, uint8_t dst, uint16_t addr,
-                               const uint8_t *payload, uint16_t payload_len)
+/* ================= DMA 发送队列 ================= */
+
+/*
+ * 发送帧缓冲来自固定池，按通道（告警 / 批量）排成两条 FIFO，告警优先。
+ * 载荷以原始形式排队，在启动 DMA 前才封包到专用的 DMA 缓冲，
+ * 因此尚未发出的帧可以继续合并同一 (src, dst, addr) 的后续小载荷。
+ * 同一时刻只有一帧在发送，完成中断中回调各载荷的完成函数并启动下一帧。
+ */
+typedef struct zb_txf {
+    struct zb_txf *next;
+    uint8_t  src;
+    uint8_t  dst;
+    uint16_t addr;
+    uint16_t len;                               /* 原始载荷长度 */
+    uint16_t enc_len;                           /* 封包后整帧长度 */
+    uint8_t  parts;                             /* 已合并的载荷数 */
+    zigbee_tx_cb_t cb[ZigBee_TX_MAX_PARTS];
+    void    *ctx[ZigBee_TX_MAX_PARTS];
+    uint8_t  payload[ZigBee_TX_PAYLOAD_MAX];
+} zb_txf_t;
+
+static zb_txf_t zb_txf_pool[ZigBee_TX_POOL_LEN];
+static zb_txf_t *zb_tx_free = NULL;
+static zb_txf_t *zb_tx_head[ZB_LANE_NUM];
+static zb_txf_t *zb_tx_tail[ZB_LANE_NUM];
+static zb_txf_t *zb_tx_cur = NULL;             /* 正在发送的帧（zb_tx_end 有效后才发布） */
+static uint8_t zb_tx_busy = 0;                 /* 已取出一帧，直到该帧结束 */
+static uint8_t zb_tx_ready = 0;
+static uint8_t zb_tx_pool_ok = 0;
+static uint32_t zb_tx_end;                     /* 当前帧发完时端口的累计发送字节数 */
+static uint32_t zb_tx_gen = 0;                 /* 每发布一帧加一，结束时据此确认仍是同一帧 */
+static uint8_t zb_tx_enc_buf[ZigBee_MAX_FRAME];
+static ZigBee_TxStats_t zb_tx_stats;
+
+static uint32_t zb_lock(void)
 {
-    uint8_t *frame = NULL;
-    uint16_t len = 0;
-    DL_Status_t st = ZigBee_BuildFrame(src, dst, addr, payload, payload_len,
-                                        &frame, &len);
-    if (st != DL_OK) {
-        return st;
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    return pm;
+}
+
+static void zb_unlock(uint32_t pm)
+{
+    __set_PRIMASK(pm);
+}
+
+/* 转义后的字节数 */
+static uint16_t zb_esc_len(const uint8_t *data, uint16_t n)
+{
+    uint16_t len = n;
+    for (uint16_t i = 0; i < n; i++) {
+        if (data[i] >= 0xFEU) len++;
     }
+    return len;
+}
 
-    if (HAL_UART_Transmit(ZigBee_DEFAULT_UART, frame, len, 1000U) != HAL_OK) {
-        return DL_ERROR;
+static void zb_tx_pool_init(void)
+{
+    zb_tx_free = NULL;
+    for (int i = (int)ZigBee_TX_POOL_LEN - 1; i >= 0; i--) {
+        zb_txf_pool[i].next = zb_tx_free;
+        zb_tx_free = &zb_txf_pool[i];
     }
-    return DL_OK;
 }
 
-DL_Status_t ZigBee_SendFrameIT(UART_HandleTypeDef *huart,
-                                const uint8_t *frame,
-                                uint16_t length)
+static void zb_tx_kick(void);
+static void zb_tx_finish(uint32_t gen, DL_Status_t st);
+static void zb_tx_done(DL_Status_t st);
+
+static void zb_attach(UartRx_Port_t port, void *ctx)
 {
-    if ((frame == NULL) || (length == 0U)) {
-        return DL_ERROR;
+    (void)ctx;
+    zb_port = port;
+    ZbFrame_Reset(&zb_rx);
+    if (!zb_tx_pool_ok) {
+        zb_tx_pool_init();
+        zb_tx_pool_ok = 1;
     }
+    zb_tx_ready = 1;
+    zb_tx_kick();
+}
 
-    if (huart == NULL) {
-        huart = ZigBee_DEFAULT_UART;
+static void zb_detach(UartRx_Port_t port, void *ctx)
+{
+    (void)port;
+    (void)ctx;
+    zb_tx_ready = 0;
+    /* 已写入端口发送缓冲的帧仍会发出，但不再能确认 */
+    zb_tx_done(DL_ERROR);
+}
+
+/* 结束第 gen 帧（若仍是当前帧）：先摘下当前帧，逐个回调后归还缓冲，再启动下一帧。
+   摘下在临界区内完成，中断与任务同时判断到帧结束时只有一方执行 */
+static void zb_tx_finish(uint32_t gen, DL_Status_t st)
+{
+    uint32_t pm = zb_lock();
+    zb_txf_t *f = zb_tx_cur;
+
+    if (f == NULL || gen != zb_tx_gen) {
+        zb_unlock(pm);
+        return;
     }
+    zb_tx_cur = NULL;
+    zb_unlock(pm);
 
-    if (huart == NULL) {
-        return DL_INVALID;
+    for (uint8_t i = 0; i < f->parts; i++) {
+        if (f->cb[i]) f->cb[i](st, f->ctx[i]);
     }
 
-    if (HAL_UART_Transmit_IT(huart, (uint8_t *)frame, length) != HAL_OK) {
-        return DL_ERROR;
+    pm = zb_lock();
+    if (st == DL_OK) zb_tx_stats.frames++;
+    else zb_tx_stats.errors++;
+    f->next = zb_tx_free;
+    zb_tx_free = f;
+    zb_tx_busy = 0;
+    zb_unlock(pm);
+
+    zb_tx_kick();
+}
+
+/* 结束当前帧 */
+static void zb_tx_done(DL_Status_t st)
+{
+    zb_tx_finish(zb_tx_gen, st);
+}
+
+static void zb_tx_kick(void)
+{
+    zb_txf_t *f = NULL;
+    uint16_t len = 0;
+    uint32_t end = 0;
+    uint32_t gen;
+    int err, sent;
+
+    uint32_t pm = zb_lock();
+    if (zb_tx_ready && !zb_tx_busy) {
+        for (int l = 0; l < (int)ZB_LANE_NUM && f == NULL; l++) {
+            f = zb_tx_head[l];
+            if (f) {
+                zb_tx_head[l] = f->next;
+                if (zb_tx_head[l] == NULL) zb_tx_tail[l] = NULL;
+            }
+        }
+        if (f) zb_tx_busy = 1;
     }
+    zb_unlock(pm);
 
-    return DL_OK;
+    if (f == NULL) {
+        return;
+    }
+    err = (ZbFrame_Encode(zb_tx_enc_buf, f->src, f->dst, f->addr, f->payload, f->len, &len) != DL_OK);
+
+    /*
+     * Serial_Write 在临界区外调用（其中会启动 DMA、可能写日志）。写入后才一起发布
+     * zb_tx_end / zb_tx_cur：此前到来的发送完成中断看到 zb_tx_cur == NULL 而忽略，
+     * 不会拿上一帧的 zb_tx_end 把本帧提前结束；若本帧在发布前已经全部发出，
+     * 发布时比较端口的累计发送字节数补上结束。
+     */
+    if (!err) err = (!zb_tx_ready || Serial_Write(zb_port, zb_tx_enc_buf, len, &end) != 0);
+
+    pm = zb_lock();
+    zb_tx_end = end;
+    zb_tx_cur = f;
+    gen = ++zb_tx_gen;
+    sent = !err && (int32_t)(Serial_TxSent(zb_port) - end) >= 0;
+    zb_unlock(pm);
+
+    if (err) {
+        zb_tx_finish(gen, DL_ERROR);
+    } else if (sent) {
+        zb_tx_finish(gen, DL_OK);
+    }
 }
 
-/* 解包函数：处理转义并校验 */
-static DL_Status_t dl_extract_packet(const uint8_t *frame,
-                                     uint16_t length,
-                                     DL_Packet_t *pkt)
+DL_Status_t ZigBee_Submit(ZigBee_Lane_t lane, uint8_t src, uint8_t dst, uint16_t addr,
+                          const uint8_t *payload, uint16_t payload_len,
+                          zigbee_tx_cb_t cb, void *ctx)
 {
-    if ((frame == NULL) || (length < 4U) || (pkt == NULL)) {
+    if (lane >= ZB_LANE_NUM || (payload == NULL && payload_len > 0U)) {
         return DL_INVALID;
     }
-
-    /* 校验包头包尾 */
-    if (frame[0] != 0xFE || frame[length - 1U] != 0xFF) {
+    if (!zb_tx_ready) {
+        return DL_ERROR;
+    }
+    if (payload_len > ZigBee_TX_PAYLOAD_MAX) {
         return DL_ERROR;
     }
 
-    /* 获取声明的长度 (DataLen + 4) */
-    uint8_t declared_len = frame[1];
-
-    /* 开始解码 (跳过 FE 和 Length) */
-    uint16_t idx = 2U;
-    uint8_t decoded_buf[128];
-    uint16_t decoded_cnt = 0;
+    uint16_t add_enc = zb_esc_len(payload, payload_len);
+    uint8_t hdr[4] = { src, dst, (uint8_t)(addr & 0xFFU), (uint8_t)(addr >> 8) };
+    uint16_t base_enc = (uint16_t)(3U + zb_esc_len(hdr, 4));   /* FE + LEN + 头 + FF */
 
-    while (idx < (length - 1U)) {
-        uint8_t b = frame[idx++];
+    if (base_enc + add_enc > ZigBee_MAX_FRAME) {
+        return DL_ERROR;
+    }
 
-        if (b == 0xFE) {
-            /* 处理转义 */
-            if (idx >= (length - 1U)) return DL_ERROR; // 转义符后无数据
-            uint8_t next = frame[idx++];
-            if (next == 0xFD) {
-                b = 0xFF;
-            } else if (next == 0xFC) {
-                b = 0xFE;
-            } else {
-                return DL_ERROR; // 无效转义
-            }
+    uint32_t pm = zb_lock();
+    zb_tx_stats.submitted++;
+
+    /* 合并到同一通道中尚未发送、目标相同且放得下的帧 */
+    for (zb_txf_t *f = zb_tx_head[lane]; f != NULL; f = f->next) {
+        if (f->src == src && f->dst == dst && f->addr == addr
+            && f->parts < ZigBee_TX_MAX_PARTS
+            && f->len + payload_len <= ZigBee_TX_PAYLOAD_MAX
+            && f->enc_len + add_enc <= ZigBee_MAX_FRAME) {
+            memcpy(&f->payload[f->len], payload, payload_len);
+            f->len += payload_len;
+            f->enc_len += add_enc;
+            f->cb[f->parts] = cb;
+            f->ctx[f->parts] = ctx;
+            f->parts++;
+            zb_tx_stats.coalesced++;
+            zb_unlock(pm);
+            zb_tx_kick();
+            return DL_OK;
         }
-        /* 注意：FF 不应出现在此处，因为 FF 是包尾，且数据中的 FF 已被转义 */
+    }
 
-        if (decoded_cnt < sizeof(decoded_buf)) {
-            decoded_buf[decoded_cnt++] = b;
-        } else {
-            return DL_ERROR; // 缓冲区溢出
-        }
+    zb_txf_t *f = zb_tx_free;
+    if (f == NULL) {
+        zb_tx_stats.no_buf++;
+        zb_unlock(pm);
+        return DL_BUSY;
     }
+    zb_tx_free = f->next;
+    zb_unlock(pm);
+
+    f->next = NULL;
+    f->src = src;
+    f->dst = dst;
+    f->addr = addr;
+    f->len = payload_len;
+    f->enc_len = (uint16_t)(base_enc + add_enc);
+    f->parts = 1;
+    f->cb[0] = cb;
+    f->ctx[0] = ctx;
+    if (payload_len) memcpy(f->payload, payload, payload_len);
+
+    pm = zb_lock();
+    if (zb_tx_tail[lane]) zb_tx_tail[lane]->next = f;
+    else zb_tx_head[lane] = f;
+    zb_tx_tail[lane] = f;
+    zb_unlock(pm);
+
+    zb_tx_kick();
+    return DL_OK;
+}
 
-    /* 校验解码后的长度是否符合声明 */
-    if (decoded_cnt != declared_len) {
+/* 端口一段发送完成（中断上下文），当前帧最后一个字节已发出则结束该帧 */
+static void zb_on_tx_done(UartRx_Port_t port, void *ctx, uint32_t sent)
+{
+    (void)port;
+    (void)ctx;
+    if (zb_tx_cur != NULL && (int32_t)(sent - zb_tx_end) >= 0) {
+        zb_tx_done(DL_OK);
+    }
+}
+
+void ZigBee_GetTxStats(ZigBee_TxStats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    uint32_t pm = zb_lock();
+    *stats = zb_tx_stats;
+    zb_unlock(pm);
+}
+
+DL_Status_t ZigBee_SendPacket(uint8_t src, uint8_t dst, uint16_t addr,
+                               const uint8_t *payload, uint16_t payload_len)
+{
+    return ZigBee_Submit(ZB_LANE_BULK, src, dst, addr, payload, payload_len, NULL, NULL);
+}
+
+DL_Status_t ZigBee_SendFrameIT(UART_HandleTypeDef *huart,
+                                const uint8_t *frame,
+                                uint16_t length)
+{
+    if ((frame == NULL) || (length == 0U)) {
         return DL_ERROR;
     }
-    if (decoded_cnt < 4) {
-        return DL_ERROR; // 至少包含 Src, Dst, AddrL, AddrH
+
+    int port = (huart == NULL) ? (int)zb_port : UartRx_PortOf(huart);
+    if (port < 0) {
+        return DL_INVALID;
     }
 
-    /* 填充结构体 */
-    pkt->src = decoded_buf[0];
-    pkt->dst = decoded_buf[1];
-    pkt->addr = (uint16_t)decoded_buf[2] | ((uint16_t)decoded_buf[3] << 8);
-    
-    pkt->data_len = decoded_cnt - 4;
-    if (pkt->data_len > 0) {
-        memcpy(pkt->data, &decoded_buf[4], pkt->data_len);
+    /* 复制进端口发送缓冲，调用返回后 frame 即可复用 */
+    if (Serial_Write((UartRx_Port_t)port, frame, length, NULL) != 0) {
+        return DL_BUSY;
     }
 
     return DL_OK;
 }
 
-DL_Status_t ZigBee_RecvPacket(DL_Packet_t *pkt, uint32_t timeout_ms)
+DL_Status_t ZigBee_GetPacket(DL_Packet_t **pkt, uint32_t timeout_ms)
 {
     if (pkt == NULL) {
         return DL_INVALID;
     }
+    if (zb_rx_queue == NULL) {
+        return DL_ERROR;
+    }
+    if (osMessageQueueGet(zb_rx_queue, pkt, NULL, timeout_ms) != osOK) {
+        return DL_TIMEOUT;
+    }
+    return DL_OK;
+}
 
-    uint32_t start = HAL_GetTick();
-    uint8_t buf[ZigBee_MAX_FRAME];
-    uint16_t len = 0U;
-
-    rx_reset();
-
-    while ((HAL_GetTick() - start) < timeout_ms) {
-        if (HAL_UART_Receive(ZigBee_DEFAULT_UART, buf + len, 1U, 1U) == HAL_OK) {
-            uint8_t byte = buf[len];
-
-            if (rx_state == RX_STATE_IDLE) {
-                if (byte == 0xFE) {
-                    len = 0;
-                    buf[len++] = byte;
-                    rx_state = RX_STATE_FRAME;
-                }
-            } else if (rx_state == RX_STATE_FRAME) {
-                if (len < ZigBee_MAX_FRAME) {
-                    buf[len++] = byte;
-                    if (byte == 0xFF) {
-                        /* 收到包尾，进行解包 */
-                        DL_Status_t st = dl_extract_packet(buf, len, pkt);
-                        rx_reset();
-                        return st;
-                    }
-                } else {
-                    rx_reset(); // 超长复位
-                }
-            }
-        }
+void ZigBee_ReleasePacket(DL_Packet_t *pkt)
+{
+    if (pkt != NULL && zb_rx_pool != NULL) {
+        osMemoryPoolFree(zb_rx_pool, pkt);
+    }
+}
+
+DL_Status_t ZigBee_RecvPacket(DL_Packet_t *pkt, uint32_t timeout_ms)
+{
+    DL_Packet_t *rx;
+
+    if (pkt == NULL) {
+        return DL_INVALID;
     }
 
-    rx_reset();
-    return DL_TIMEOUT;
+    DL_Status_t st = ZigBee_GetPacket(&rx, timeout_ms);
+    if (st != DL_OK) {
+        return st;
+    }
+    pkt->addr = rx->addr;
+    pkt->src = rx->src;
+    pkt->dst = rx->dst;
+    pkt->data_len = rx->data_len;
+    memcpy(pkt->data, rx->data, rx->data_len);
+    ZigBee_ReleasePacket(rx);
+    return DL_OK;
 }
 
 uint8_t ZigBee_IsRxFrameReady(void)
 {
-    return rx_frame_ready;
+    return (zb_rx_queue != NULL && osMessageQueueGetCount(zb_rx_queue) > 0U) ? 1U : 0U;
 }
 
-uint16_t ZigBee_GetRxFrame(uint8_t *buf, uint16_t buf_len)
+void ZigBee_GetRxStats(ZigBee_RxStats_t *stats)
 {
-    if (!rx_frame_ready || buf == NULL) {
-        return 0;
+    if (stats == NULL) {
+        return;
     }
-
-    uint16_t copy_len = (rx_len < buf_len) ? rx_len : buf_len;
-    memcpy(buf, rx_buf, copy_len);
-    rx_reset();
-    return copy_len;
+    __disable_irq();
+    *stats = zb_rx.stats;
+    __enable_irq();
 }
 
 /* 将字节数组转成十六进制字符串，如 "FE 08 91 90 ..." */
 void bytes_to_hex_str(const uint8_t *buf, uint16_t len, char *out, uint16_t out_size)
 {
-    uint16_t pos = 0;
-    for (uint16_t i = 0; i < len; ++i) {
-        if (pos + 3 >= out_size) break;
-        int n = snprintf(&out[pos], out_size - pos, "%02X", buf[i]);
-        pos += (uint16_t)n;
-        if (i != len - 1 && pos + 1 < out_size) {
-            out[pos++] = ' ';
-        }
-    }
-    if (pos < out_size) out[pos] = '\0';
+    Fmt_t f;
+    Fmt_Init(&f, out, out_size);
+    Fmt_HexBytes(&f, buf, len, ' ');
 }
 
 
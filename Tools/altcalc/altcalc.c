@@ -0,0 +1,81 @@
+/**
+ * @file    altcalc.c
+ * @brief   上位机：用目标板同一份 altitude.c 校验查表高度计算的精度
+ *
+ * 编译：gcc -O2 -I../../Core/Inc -o altcalc altcalc.c ../../Core/Src/altitude.c -lm
+ * 用法：altcalc
+ *
+ * 在几个典型海平面气压下运行 Altitude_Test（与目标板 Altitude_Test(DWT_GetCycles, ...)
+ * 是同一个函数），再检查边界：表范围外回退到 powf、非正海平面气压恢复默认值、
+ * 表内相邻气压结果单调。主机上计时单位为纳秒，只作相对比较。全部通过返回 0。
+ */
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include "altitude.h"
+#include "config.h"
+
+/* altitude.c 的 Altitude_LoadSeaLevel 引用参数区，上位机不链接 config.c */
+SysConfig_t g_config;
+
+static uint32_t ac_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec);
+}
+
+static double ac_ref(double p, double p0)
+{
+    return 44330.0 * (1.0 - pow(p / p0, 0.19029495718363465));
+}
+
+static int ac_edges(void)
+{
+    int fail = 0;
+
+    Altitude_SetSeaLevel(0.0f);
+    if (Altitude_GetSeaLevel() != 101325.0f) { printf("  sea level 0 not reset\n"); fail = 1; }
+    Altitude_SetSeaLevel(NAN);
+    if (Altitude_GetSeaLevel() != 101325.0f) { printf("  sea level NaN not reset\n"); fail = 1; }
+
+    /* 表范围外（p/p0 < 0.25 或 >= 1.25）回退到 powf */
+    const float outside[] = { 10000.0f, 20000.0f, 130000.0f };
+    for (unsigned i = 0; i < sizeof(outside) / sizeof(outside[0]); i++)
+    {
+        double ref = ac_ref(outside[i], 101325.0);
+        float a = Altitude_Calc(outside[i]);
+        if (fabs(a - ref) > 0.5) { printf("  fallback %.0f Pa: %.3f vs %.3f\n", outside[i], a, ref); fail = 1; }
+    }
+    if (Altitude_Calc(0.0f) != 0.0f) { printf("  0 Pa not 0 m\n"); fail = 1; }
+
+    /* 表内单调递减（插值节点两侧不应出现回跳） */
+    float prev = Altitude_Calc(26000.0f);
+    for (float p = 26001.0f; p < 126000.0f; p += 1.0f)
+    {
+        float a = Altitude_Calc(p);
+        if (a > prev) { printf("  not monotonic at %.0f Pa\n", p); fail = 1; break; }
+        prev = a;
+    }
+    return fail;
+}
+
+int main(void)
+{
+    const float sea[] = { 101325.0f, 95000.0f, 103500.0f };
+    int fail = 0;
+
+    for (unsigned i = 0; i < sizeof(sea) / sizeof(sea[0]); i++)
+    {
+        Altitude_Bench_t b;
+        Altitude_SetSeaLevel(sea[i]);
+        uint8_t r = Altitude_Test(ac_ns, &b);
+        printf("p0 %6.0f Pa: table err %.4f m (%u ns), powf err %.4f m (%u ns)%s\n",
+               sea[i], b.max_err_m, b.cycles_fast, b.max_err_powf_m, b.cycles_powf, r ? "  FAIL" : "");
+        fail |= r;
+    }
+
+    fail |= ac_edges();
+    printf(fail ? "FAIL\n" : "PASS\n");
+    return fail;
+}
@@ -0,0 +1,72 @@
+/**
+ * @file    bmpcomp.c
+ * @brief   上位机：用目标板同一份 bmp280_comp.c 校验三种补偿实现并比较误差
+ *
+ * 编译：gcc -O2 -I../../Core/Inc -o bmpcomp bmpcomp.c ../../Core/Src/bmp280_comp.c -lm
+ * 用法：bmpcomp
+ *
+ * 与目标板 BMP280_CompTest(DWT_GetCycles, ...) 是同一个函数：数据手册参考向量，
+ * 再在工作温度 / 气压量程内以 INT64 实现为基准扫描 INT32、FLOAT 的最大误差。
+ * 另外检查几个边界：校准参数 dig_P1 = 0 时不除零、温度结果三种实现一致。
+ * 主机上计时单位为纳秒，只作相对比较。全部通过返回 0。
+ */
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include "bmp280_comp.h"
+
+static uint32_t bc_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec);
+}
+
+static int bc_edges(void)
+{
+    /* 数据手册示例参数，dig_P1 置 0 模拟读坏的校准区 */
+    bmp280_calib_t c = { 27504, 26435, -1000, 0, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000 };
+    int32_t tf64, tf32;
+    float tff;
+
+    if (BMP280_CompPressInt64(&c, 415148, 128422) != 0.0f) return 1;
+    if (BMP280_CompPressInt32(&c, 415148, 128422) != 0U) return 1;
+    if (BMP280_CompPressFloat(&c, 415148, 128422.0f) != 0.0f) return 1;
+
+    /* 温度：整数两种实现逐位一致，浮点在 0.01 degC 以内 */
+    c.dig_P1 = 36477;
+    for (int32_t adc_T = 400000; adc_T < 600000; adc_T += 97)
+    {
+        int32_t t64 = BMP280_CompTempInt64(&c, adc_T, &tf64);
+        int32_t t32 = BMP280_CompTempInt32(&c, adc_T, &tf32);
+        float   tfl = BMP280_CompTempFloat(&c, adc_T, &tff);
+
+        if (t64 != t32 || tf64 != tf32) return 2;
+        if (fabsf(tfl - t64 / 100.0f) > 0.011f) return 2;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    static const char *const name[BMP280_COMP_NUM] = { "INT64", "INT32", "FLOAT" };
+    BMP280_CompBench_t b = {0};
+    int r = BMP280_CompTest(bc_ns, &b);
+
+    printf("%u samples\n", b.samples);
+    for (int i = 0; i < BMP280_COMP_NUM; i++)
+        printf("  %-6s max err %.3f Pa, %u ns\n", name[i], b.max_err_pa[i], b.cycles[i]);
+    if (r != 0)
+    {
+        printf("FAIL: BMP280_CompTest returned %d\n", r);
+        return 1;
+    }
+    r = bc_edges();
+    if (r != 0)
+    {
+        printf("FAIL: edge case %d\n", r);
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
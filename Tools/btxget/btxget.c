@@ -0,0 +1,336 @@
+/**
+ * @file    btxget.c
+ * @brief   上位机：经蓝牙串口（rfcomm）从目标板下载 W25Q128 上的一段数据（btxfer.h 协议）
+ *
+ * 编译：gcc -O2 -I../../Core/Inc -o btxget btxget.c ../../Core/Src/tlmcodec.c
+ * 用法：btxget [-b 波特率] -a 地址 -n 长度 -o 输出文件 /dev/rfcomm0
+ *
+ * 收到的块直接写到输出文件的对应偏移；每 BG_ACK_EVERY 块、发现缺块或空闲 BG_ACK_MS 时回 ACK。
+ * 串口断开（读写出错）后每秒尝试重新打开，重连后用已连续收到的块数作为 from 续传；
+ * 连接还在但 BG_OPEN_MS 内没有收到数据（目标板已暂停）时同样重新 OPEN。
+ * 结束时打印有效吞吐与串口理论带宽（波特率 / 10）之比。
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "tlmcodec.h"
+#include "btxfer.h"
+
+#define BG_ACK_EVERY     8U
+#define BG_ACK_MS        30U
+#define BG_KEEPALIVE_MS  500U
+#define BG_OPEN_MS       2000U
+#define BG_DONE_WAIT_MS  1500U
+
+typedef struct {
+    const char *dev;
+    uint32_t baud;
+    uint32_t addr, len;
+    int fd;                 /* 串口，-1 = 未连接 */
+    int out;                /* 输出文件 */
+    uint8_t sess;
+    uint8_t have_info;
+    uint32_t chunks;
+    uint8_t *got;
+    uint32_t base;
+    uint32_t new_since_ack;
+    uint32_t last_ack, last_rx, open_at;
+    uint32_t received, dup, reconnects, retx;
+    uint8_t done;
+    Tlm_Decoder_t dec;
+} bg_t;
+
+static bg_t bg;
+
+/* 发送一帧控制帧，测试时可替换 */
+static int bg_tty_write(const uint8_t *p, uint16_t n)
+{
+    return bg.fd >= 0 && write(bg.fd, p, n) == (ssize_t)n ? 0 : -1;
+}
+static int (*bg_out)(const uint8_t *p, uint16_t n) = bg_tty_write;
+
+static uint32_t bg_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000U + ts.tv_nsec / 1000000U);
+}
+
+static void bg_put_le(uint8_t *p, uint32_t v, int n)
+{
+    for (int i = 0; i < n; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t bg_get_le(const uint8_t *p, int n)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < n; i++) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+static void bg_send(uint8_t *frame, uint16_t len)
+{
+    uint8_t out[TLM_COBS_MAX];
+    uint16_t n = Tlm_FrameEncode(frame, len, NULL, out, sizeof(out));
+    if (n) bg_out(out, n);
+}
+
+static void bg_send_open(uint32_t now)
+{
+    uint8_t f[32] __attribute__((aligned(4)));
+
+    f[0] = BTX_T_OPEN;
+    f[1] = BTX_SRC_FLASH;
+    bg_put_le(&f[2], bg.addr, 4);
+    bg_put_le(&f[6], bg.len, 4);
+    bg_put_le(&f[10], bg.base, 4);
+    bg_send(f, 14);
+    bg.have_info = 0;
+    bg.open_at = now;
+}
+
+static void bg_send_ack(uint32_t now)
+{
+    uint8_t f[16] __attribute__((aligned(4)));
+    uint32_t map = 0;
+
+    for (uint32_t i = 0; i < 32U && bg.base + 1U + i < bg.chunks; i++)
+        if (bg.got[bg.base + 1U + i]) map |= 1UL << i;
+
+    f[0] = BTX_T_ACK;
+    f[1] = bg.sess;
+    bg_put_le(&f[2], bg.base, 4);
+    bg_put_le(&f[6], map, 4);
+    bg_send(f, 10);
+    bg.last_ack = now;
+    bg.new_since_ack = 0;
+}
+
+static void bg_send_close(void)
+{
+    uint8_t f[8] __attribute__((aligned(4)));
+
+    f[0] = BTX_T_CLOSE;
+    f[1] = bg.sess;
+    bg_send(f, 2);
+}
+
+static void bg_on_frame(const uint8_t *p, uint16_t len, void *ctx)
+{
+    uint32_t now = bg_ms();
+    (void)ctx;
+
+    switch (p[0])
+    {
+    case BTX_T_INFO:
+        if (len < 14U) break;
+        if (p[2] != BTX_ST_OK)
+        {
+            fprintf(stderr, "target rejected the range (status %u)\n", p[2]);
+            exit(1);
+        }
+        if (bg_get_le(&p[4], 2) != BTX_CHUNK || (bg.got && bg_get_le(&p[6], 4) != bg.chunks))
+        {
+            fprintf(stderr, "chunk layout mismatch\n");
+            exit(1);
+        }
+        if (!bg.got)
+        {
+            bg.chunks = bg_get_le(&p[6], 4);
+            bg.got = calloc(bg.chunks + 1U, 1);
+        }
+        bg.sess = p[1];
+        bg.have_info = 1;
+        bg.last_rx = now;
+        break;
+
+    case BTX_T_DATA:
+    {
+        uint32_t idx = bg_get_le(&p[2], 4);
+        uint32_t n = len - BTX_DATA_HDR;
+
+        if (!bg.have_info || p[1] != bg.sess || idx >= bg.chunks) break;
+        bg.last_rx = now;
+        if (bg.got[idx])
+        {
+            bg.dup++;
+            break;
+        }
+        if (pwrite(bg.out, &p[BTX_DATA_HDR], n, (off_t)idx * BTX_CHUNK) != (ssize_t)n)
+        {
+            perror("write");
+            exit(1);
+        }
+        bg.got[idx] = 1;
+        bg.received += n;
+        bg.new_since_ack++;
+        /* 缺块：立即 ACK，让目标板尽快重传 */
+        if (idx != bg.base) bg.new_since_ack = BG_ACK_EVERY;
+        while (bg.base < bg.chunks && bg.got[bg.base]) bg.base++;
+        break;
+    }
+
+    case BTX_T_DONE:
+        if (len >= 10U && p[1] == bg.sess)
+        {
+            bg.retx = bg_get_le(&p[6], 4);
+            bg.done = 1;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+static speed_t bg_speed(uint32_t baud)
+{
+    switch (baud)
+    {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 230400: return B230400;
+    default: return B115200;
+    }
+}
+
+static int bg_open_tty(void)
+{
+    struct termios tio;
+    int fd = open(bg.dev, O_RDWR | O_NOCTTY | O_NONBLOCK);
+
+    if (fd < 0) return -1;
+    if (tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, bg_speed(bg.baud));
+        cfsetospeed(&tio, bg_speed(bg.baud));
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    return fd;
+}
+
+/* 推进一步：超时重发 OPEN、按策略回 ACK。返回 1 表示下载完成 */
+static int bg_tick(uint32_t now)
+{
+    if (bg.fd < 0) return 0;
+    if (!bg.have_info)
+    {
+        if (now - bg.open_at >= BG_OPEN_MS) bg_send_open(now);
+        return 0;
+    }
+    if (bg.base == bg.chunks)
+    {
+        if (bg.new_since_ack) bg_send_ack(now);
+        if (bg.done || now - bg.last_ack >= BG_DONE_WAIT_MS)
+        {
+            bg_send_close();
+            return 1;
+        }
+        return 0;
+    }
+    /* 目标板暂停（长时间没收到 ACK）后不再发数据，重新 OPEN 续传 */
+    if (now - bg.last_rx >= BG_OPEN_MS)
+    {
+        bg_send_open(now);
+        return 0;
+    }
+    if (bg.new_since_ack >= BG_ACK_EVERY || (bg.new_since_ack && now - bg.last_ack >= BG_ACK_MS) ||
+        now - bg.last_ack >= BG_KEEPALIVE_MS)
+        bg_send_ack(now);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *outname = NULL;
+    uint32_t t0, last_try = 0, shown = 0;
+    int opt;
+
+    bg.baud = 115200;
+    bg.fd = -1;
+    while ((opt = getopt(argc, argv, "b:a:n:o:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'b': bg.baud = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'a': bg.addr = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'n': bg.len = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'o': outname = optarg; break;
+        default: break;
+        }
+    }
+    if (optind >= argc || !outname || bg.len == 0)
+    {
+        fprintf(stderr, "usage: %s [-b baud] -a addr -n len -o out.bin /dev/rfcomm0\n", argv[0]);
+        return 2;
+    }
+    bg.dev = argv[optind];
+    bg.out = open(outname, O_WRONLY | O_CREAT, 0644);
+    if (bg.out < 0)
+    {
+        perror(outname);
+        return 1;
+    }
+    Tlm_DecoderInit(&bg.dec);
+    Tlm_DecoderOnFrame(&bg.dec, bg_on_frame, NULL);
+
+    t0 = bg_ms();
+    for (;;)
+    {
+        uint32_t now = bg_ms();
+
+        if (bg.fd < 0)
+        {
+            if (now - last_try < 1000U && last_try) { usleep(50000); continue; }
+            last_try = now;
+            bg.fd = bg_open_tty();
+            if (bg.fd < 0) continue;
+            if (bg.got) bg.reconnects++;
+            Tlm_DecoderInit(&bg.dec);
+            Tlm_DecoderOnFrame(&bg.dec, bg_on_frame, NULL);
+            bg_send_open(now);
+        }
+
+        struct pollfd pfd = { .fd = bg.fd, .events = POLLIN };
+        int r = poll(&pfd, 1, 10);
+        if (r > 0)
+        {
+            uint8_t buf[1024];
+            ssize_t n = read(bg.fd, buf, sizeof(buf));
+            if (n > 0)
+            {
+                Tlm_DecoderFeed(&bg.dec, buf, (uint32_t)n, NULL, NULL);
+            }
+            else if (n == 0 || (errno != EAGAIN && errno != EINTR) || (pfd.revents & (POLLHUP | POLLERR)))
+            {
+                fprintf(stderr, "link lost at chunk %u/%u, reconnecting\n", bg.base, bg.chunks);
+                close(bg.fd);
+                bg.fd = -1;
+                continue;
+            }
+        }
+        if (bg_tick(bg_ms())) break;
+        if (bg.chunks && bg.base / 64U != shown)
+        {
+            shown = bg.base / 64U;
+            fprintf(stderr, "\r%u/%u", bg.base, bg.chunks);
+        }
+    }
+
+    double sec = (bg_ms() - t0) / 1000.0;
+    double rate = bg.received / sec;
+    printf("\n%u bytes in %.1f s: %.0f B/s, %.1f%% of %u baud, retransmits %u, duplicates %u, reconnects %u\n",
+           bg.received, sec, rate, 100.0 * rate / (bg.baud / 10.0), bg.baud, bg.retx, bg.dup, bg.reconnects);
+    close(bg.fd);
+    close(bg.out);
+    return 0;
+}
@@ -0,0 +1,222 @@
+/**
+ * @file    dlogdump.c
+ * @brief   上位机：把 USART1 上的 COBS 帧流还原为日志文本（及遥测样本）
+ *
+ * 编译：gcc -O2 -I../../Core/Inc -o dlogdump dlogdump.c ../../Core/Src/tlmcodec.c
+ * 用法：dlogdump build/<工程名>.dlogfmt [capture.bin]   不给 capture 时从标准输入读取
+ *       -t 同时打印遥测样本
+ *
+ * .dlogfmt 为构建后 objcopy 提取的 .dlog_fmt 段，日志记录中的 ID 即格式串在其中的偏移。
+ * 必须与产生该数据流的固件来自同一次构建，否则文本会错位。
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tlmcodec.h"
+
+#define DD_COMMIT   0x80000000U
+
+static char *dd_fmt;
+static long dd_fmt_len;
+static int dd_show_tlm;
+
+static uint16_t dd_next_seq;
+static int dd_has_seq;
+static uint32_t dd_dropped;
+static uint32_t dd_records, dd_lost_frames, dd_bad;
+
+static const char *dd_level[] = { "E", "W", "I", "D" };
+
+static uint32_t dd_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static float dd_float(uint32_t u)
+{
+    union { uint32_t u; float f; } v = { u };
+    return v.f;
+}
+
+/* 按格式串逐个转换说明输出参数，参数均为 32 位 */
+static void dd_print(const char *fmt, const uint32_t *args, uint32_t nargs)
+{
+    uint32_t a = 0;
+    char spec[32];
+
+    while (*fmt)
+    {
+        if (*fmt != '%')
+        {
+            putchar(*fmt++);
+            continue;
+        }
+        if (fmt[1] == '%')
+        {
+            putchar('%');
+            fmt += 2;
+            continue;
+        }
+
+        /* 复制标志/宽度/精度，去掉长度修饰符 */
+        size_t n = 0;
+        spec[n++] = *fmt++;
+        while (*fmt && strchr("-+ #0123456789.", *fmt) && n < sizeof(spec) - 2) spec[n++] = *fmt++;
+        while (*fmt && strchr("hlLjzt", *fmt)) fmt++;
+        char conv = *fmt;
+        if (conv == '\0') break;
+        fmt++;
+
+        uint32_t v = (a < nargs) ? args[a++] : 0U;
+        switch (conv)
+        {
+        case 'd': case 'i':
+            spec[n++] = 'd'; spec[n] = '\0';
+            printf(spec, (int)(int32_t)v);
+            break;
+        case 'u': case 'x': case 'X': case 'o': case 'c':
+            spec[n++] = conv; spec[n] = '\0';
+            printf(spec, (unsigned)v);
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+            spec[n++] = conv; spec[n] = '\0';
+            printf(spec, (double)dd_float(v));
+            break;
+        default:   /* %s、%p 等：目标板地址，原样输出 */
+            printf("<0x%08X>", (unsigned)v);
+            break;
+        }
+    }
+    putchar('\n');
+}
+
+static void dd_on_frame(const uint8_t *p, uint16_t len, void *ctx)
+{
+    (void)ctx;
+
+    if (p[0] != TLM_REC_LOG || len < TLM_LOG_HDR_LEN || p[1] != TLM_LOG_VERSION)
+    {
+        dd_bad++;
+        return;
+    }
+
+    uint16_t seq = (uint16_t)(p[2] | (p[3] << 8));
+    if (dd_has_seq && seq != dd_next_seq)
+    {
+        uint16_t gap = (uint16_t)(seq - dd_next_seq);
+        dd_lost_frames += gap;
+        printf("-- %u log frame(s) lost --\n", gap);
+    }
+    dd_next_seq = (uint16_t)(seq + 1U);
+    dd_has_seq = 1;
+
+    uint32_t dropped = dd_le32(&p[4]);
+    if (dropped != dd_dropped)
+    {
+        printf("-- %u record(s) dropped on target (total %u) --\n", dropped - dd_dropped, dropped);
+        dd_dropped = dropped;
+    }
+
+    uint16_t pos = TLM_LOG_HDR_LEN;
+    while (pos + 8U <= len)
+    {
+        uint32_t hdr = dd_le32(&p[pos]);
+        uint32_t tick = dd_le32(&p[pos + 4]);
+        uint32_t nargs = (hdr >> 24) & 0xFU;
+        uint32_t id = hdr & 0xFFFFU;
+        uint32_t args[15];
+
+        if (!(hdr & DD_COMMIT) || pos + 8U + nargs * 4U > len)
+        {
+            dd_bad++;
+            return;
+        }
+        for (uint32_t i = 0; i < nargs; i++) args[i] = dd_le32(&p[pos + 8U + i * 4U]);
+        pos = (uint16_t)(pos + 8U + nargs * 4U);
+
+        printf("%10.3f %s ", tick / 1000.0, dd_level[(hdr >> 28) & 3U]);
+        if ((long)id < dd_fmt_len) dd_print(&dd_fmt[id], args, nargs);
+        else printf("<unknown id %u>\n", id);
+        dd_records++;
+    }
+}
+
+static void dd_on_sample(const Tlm_Sample_t *s, void *ctx)
+{
+    (void)ctx;
+    if (!dd_show_tlm) return;
+
+    printf("%10.3f T ", s->tick / 1000.0);
+    for (int f = 0; f < SNAP_FIELD_NUM; f++)
+    {
+        if (s->valid & (1U << f)) printf(" %d=%.2f", f, s->value[f]);
+    }
+    if (s->error) printf(" err=0x%02X", s->error);
+    putchar('\n');
+}
+
+static char *dd_load(const char *path, long *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return NULL;
+
+    fseek(f, 0, SEEK_END);
+    *len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buf = malloc((size_t)*len + 1U);
+    if (buf && fread(buf, 1, (size_t)*len, f) != (size_t)*len)
+    {
+        free(buf);
+        buf = NULL;
+    }
+    if (buf) buf[*len] = '\0';
+    fclose(f);
+    return buf;
+}
+
+int main(int argc, char **argv)
+{
+    static Tlm_Decoder_t dec;
+    uint8_t chunk[512];
+    size_t n;
+    int argi = 1;
+
+    if (argi < argc && strcmp(argv[argi], "-t") == 0)
+    {
+        dd_show_tlm = 1;
+        argi++;
+    }
+    if (argi >= argc)
+    {
+        fprintf(stderr, "usage: %s [-t] firmware.dlogfmt [capture.bin]\n", argv[0]);
+        return 2;
+    }
+
+    dd_fmt = dd_load(argv[argi], &dd_fmt_len);
+    if (dd_fmt == NULL)
+    {
+        fprintf(stderr, "cannot read %s\n", argv[argi]);
+        return 1;
+    }
+
+    FILE *in = stdin;
+    if (argi + 1 < argc && (in = fopen(argv[argi + 1], "rb")) == NULL)
+    {
+        fprintf(stderr, "cannot read %s\n", argv[argi + 1]);
+        return 1;
+    }
+
+    Tlm_DecoderInit(&dec);
+    Tlm_DecoderOnFrame(&dec, dd_on_frame, NULL);
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+    {
+        Tlm_DecoderFeed(&dec, chunk, (uint32_t)n, dd_on_sample, NULL);
+        fflush(stdout);
+    }
+
+    fprintf(stderr, "records %u, dropped on target %u, log frames lost %u, bad %u, "
+            "crc err %u, cobs err %u, telemetry frames %u\n",
+            dd_records, dd_dropped, dd_lost_frames, dd_bad,
+            dec.stats.crc_err, dec.stats.cobs_err, dec.stats.frames);
+    return 0;
+}
@@ -0,0 +1,538 @@
+/**
+ * @file    isotpbench.c
+ * @brief   上位机：用目标板同一份 isotp.c 测试 ISO-TP 的正确性、吞吐与时序
+ *
+ * 编译：gcc -O2 -I../../Core/Inc -o isotpbench isotpbench.c ../../Core/Src/isotp.c
+ * 用法：isotpbench [-b 位速率]    内置虚拟 CAN 总线（默认 437500，与 CAN1 配置相同）
+ *       isotpbench -i vcan0       经 Linux SocketCAN 虚拟接口实时收发
+ *                                 （modprobe vcan; ip link add dev vcan0 type vcan; ip link set up vcan0）
+ *
+ * 两个节点 A（目标板侧，接收 0x6E0+k、发送 0x6E8+k）与 B（测试仪侧，ID 相反）各有
+ * 若干会话，每个节点的发送队列深度与目标板相同（CANNODE_TXQ_LEN + 3 个邮箱），按 ID 排序。
+ * 虚拟总线按实际位数（含位填充、CRC、帧间隔）计算每帧时长并做 ID 仲裁，
+ * 时间为仿真时间，结果与主机速度无关；vcan 模式为墙上时间，反映协议栈本身的开销。
+ * 每个场景校验收到的数据与发出的完全一致，并报告吞吐、总线占用与流控帧数；
+ * 最后是出错场景（丢帧、对端不应答、接收缓冲不足），检查返回的错误码。
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "isotp.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#endif
+
+#define IB_MAX_SESS     4
+#define IB_QLEN         19          /* 16 级软件队列 + 3 个邮箱 */
+#define IB_ID_A_RX      0x6E0U
+#define IB_ID_A_TX      0x6E8U
+#define IB_LIMIT_US     60000000U   /* 单个场景的仿真时间上限 */
+
+typedef struct {
+    uint32_t id;
+    uint8_t  d[8];
+} ib_frame_t;
+
+typedef struct ib_node {
+    ib_frame_t q[IB_QLEN];
+    int n;
+    int fd;                               /* vcan 模式的套接字 */
+    IsoTp_Link_t link[IB_MAX_SESS];
+    IsoTp_Config_t cfg[IB_MAX_SESS];
+} ib_node_t;
+
+/* 一个会话上的一次传输 */
+typedef struct {
+    uint8_t *src, *dst;
+    uint32_t len, seg;                    /* seg 非 0 时两端都按 seg 字节分段流式处理 */
+    uint32_t tx_off, rx_off;
+    int tx_res, rx_res;                   /* -1 = 未结束 */
+    uint32_t rx_len;
+    uint64_t t_end;
+} ib_xfer_t;
+
+static ib_node_t ib_a, ib_b;
+static ib_xfer_t ib_x[2][IB_MAX_SESS];    /* [0] A→B，[1] B→A */
+static uint64_t ib_now_ns;
+static uint32_t ib_bitrate = 437500;
+static int ib_vcan = 0;
+static uint32_t ib_frames, ib_fc_frames, ib_drop_at, ib_seen;
+static uint64_t ib_busy_ns;
+static int ib_mute_b;                     /* B 不发送任何帧 */
+
+static uint32_t ib_us(void)
+{
+    return (uint32_t)(ib_now_ns / 1000U);
+}
+
+static uint64_t ib_wall_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+}
+
+/* ---- 虚拟总线 ---- */
+
+/* 标准帧的位数：SOF..CRC 按位填充规则计数，再加 CRC 界定、ACK、EOF 与帧间隔 13 位 */
+static uint32_t ib_frame_bits(const ib_frame_t *f)
+{
+    uint8_t bits[128];
+    int n = 0;
+    uint16_t crc = 0;
+
+    bits[n++] = 0;
+    for (int i = 10; i >= 0; i--) bits[n++] = (f->id >> i) & 1U;
+    bits[n++] = 0; bits[n++] = 0; bits[n++] = 0;          /* RTR IDE r0 */
+    for (int i = 3; i >= 0; i--) bits[n++] = (8U >> i) & 1U;
+    for (int k = 0; k < 8; k++)
+        for (int i = 7; i >= 0; i--) bits[n++] = (f->d[k] >> i) & 1U;
+    for (int i = 0; i < n; i++)
+    {
+        uint16_t nxt = (uint16_t)(bits[i] ^ ((crc >> 14) & 1U));
+        crc = (uint16_t)((crc << 1) & 0x7FFFU);
+        if (nxt) crc ^= 0x4599U;
+    }
+    for (int i = 14; i >= 0; i--) bits[n++] = (crc >> i) & 1U;
+
+    uint32_t total = (uint32_t)n, run = 1;
+    uint8_t last = bits[0];
+    for (int i = 1; i < n; i++)
+    {
+        if (bits[i] == last) run++;
+        else { last = bits[i]; run = 1; }
+        if (run == 5)
+        {
+            total++;                   /* 填充位与前一位相反，开始新的一段 */
+            last ^= 1U;
+            run = 1;
+        }
+    }
+    return total + 13U;
+}
+
+static int ib_can_tx(void *ctx, uint32_t id, const uint8_t *data, uint8_t len)
+{
+    ib_node_t *nd = (ib_node_t *)ctx;
+
+    if (nd == &ib_b && ib_mute_b) return 0;
+#ifdef __linux__
+    if (ib_vcan)
+    {
+        struct can_frame cf = { .can_id = id, .can_dlc = len };
+        memcpy(cf.data, data, len);
+        return write(nd->fd, &cf, sizeof(cf)) == (ssize_t)sizeof(cf) ? 0 : 1;
+    }
+#endif
+    if (nd->n == IB_QLEN) return 1;
+
+    int pos = nd->n;
+    while (pos > 1 && nd->q[pos - 1].id > id) pos--;   /* q[0] 可能正在发送，不参与排序 */
+    memmove(&nd->q[pos + 1], &nd->q[pos], (size_t)(nd->n - pos) * sizeof(ib_frame_t));
+    nd->q[pos].id = id;
+    memcpy(nd->q[pos].d, data, len);
+    nd->n++;
+    return 0;
+}
+
+static void ib_deliver(ib_node_t *to, uint32_t id, const uint8_t *d)
+{
+    ib_frames++;
+    if ((d[0] & 0xF0U) == 0x30U) ib_fc_frames++;
+    if (ib_drop_at && ++ib_seen == ib_drop_at) return;
+
+    for (int k = 0; k < IB_MAX_SESS; k++)
+        if (to->cfg[k].rx_id == id) IsoTp_OnFrame(&to->link[k], d, 8, ib_us());
+}
+
+/* ---- 传输回调 ---- */
+
+static ib_xfer_t *ib_xfer_of(IsoTp_Link_t *l, int rx)
+{
+    int side = (l >= ib_a.link && l < ib_a.link + IB_MAX_SESS) ? 0 : 1;
+    int k = (int)(l - (side ? ib_b.link : ib_a.link));
+    return &ib_x[rx ? 1 - side : side][k];
+}
+
+static bool ib_tx_seg(IsoTp_Link_t *l, const uint8_t *done, uint32_t n, uint8_t **next, uint32_t *size)
+{
+    ib_xfer_t *x = ib_xfer_of(l, 0);
+    (void)done;
+
+    x->tx_off += n;
+    if (x->tx_off >= x->len) return false;
+    *next = &x->src[x->tx_off];
+    *size = x->len - x->tx_off < x->seg ? x->len - x->tx_off : x->seg;
+    return true;
+}
+
+static bool ib_rx_seg(IsoTp_Link_t *l, const uint8_t *done, uint32_t n, uint8_t **next, uint32_t *size)
+{
+    ib_xfer_t *x = ib_xfer_of(l, 1);
+
+    /* 接收方把写满的段“提交”到 dst 的对应位置，然后复用 rx 缓冲 */
+    memcpy(&x->dst[x->rx_off], done, n);
+    x->rx_off += n;
+    *next = (uint8_t *)done;
+    *size = x->seg;
+    return true;
+}
+
+static void ib_tx_done(IsoTp_Link_t *l, isotp_result_t r, uint32_t len)
+{
+    ib_xfer_t *x = ib_xfer_of(l, 0);
+    (void)len;
+    x->tx_res = r;
+}
+
+static void ib_rx_done(IsoTp_Link_t *l, isotp_result_t r, uint32_t len)
+{
+    ib_xfer_t *x = ib_xfer_of(l, 1);
+
+    if (x->seg && r == ISOTP_OK) memcpy(&x->dst[x->rx_off], l->rx_buf, len - x->rx_off);
+    x->rx_res = r;
+    x->rx_len = len;
+    x->t_end = ib_now_ns;
+}
+
+/* ---- 场景 ---- */
+
+typedef struct {
+    const char *name;
+    int sess;             /* 会话数 */
+    int both;             /* 1 = 每个会话两个方向同时传输 */
+    uint32_t len;
+    uint32_t seg;         /* 流式分段大小，0 = 整块缓冲 */
+    uint8_t bs, stmin;    /* 接收方通告 */
+} ib_case_t;
+
+static void ib_setup(const ib_case_t *c)
+{
+    static uint8_t rxbuf[2][IB_MAX_SESS][512];
+    ib_node_t *nodes[2] = { &ib_a, &ib_b };
+
+    ib_frames = ib_fc_frames = ib_seen = 0;
+    ib_busy_ns = 0;
+    ib_now_ns = 0;
+    ib_a.n = ib_b.n = 0;
+
+    for (int s = 0; s < 2; s++)
+    {
+        ib_node_t *nd = nodes[s];
+        for (int k = 0; k < IB_MAX_SESS; k++)
+        {
+            IsoTp_Config_t *cf = &nd->cfg[k];
+            cf->tx_id = (s == 0 ? IB_ID_A_TX : IB_ID_A_RX) + (uint32_t)k;
+            cf->rx_id = (s == 0 ? IB_ID_A_RX : IB_ID_A_TX) + (uint32_t)k;
+            cf->bs = c->bs;
+            cf->stmin = c->stmin;
+            cf->can_tx = ib_can_tx;
+            cf->can_ctx = nd;
+            cf->tx_seg = ib_tx_seg;
+            cf->rx_seg = c->seg ? ib_rx_seg : NULL;
+            cf->tx_done = ib_tx_done;
+            cf->rx_done = ib_rx_done;
+            IsoTp_Init(&nd->link[k], cf);
+
+            ib_xfer_t *x = &ib_x[s][k];
+            free(x->src);
+            free(x->dst);
+            memset(x, 0, sizeof(*x));
+            x->tx_res = x->rx_res = -1;
+            x->len = c->len;
+            x->seg = c->seg;
+            x->src = malloc(c->len);
+            x->dst = calloc(1, c->len);
+            for (uint32_t i = 0; i < c->len; i++) x->src[i] = (uint8_t)(i * 31U + (uint32_t)k * 7U + (uint32_t)s * 101U + (i >> 8));
+
+            /* 接收方：流式时用 512 字节以内的小缓冲反复写 */
+            if (c->seg) IsoTp_SetRxBuffer(&nd->link[k], rxbuf[s][k], c->seg);
+        }
+    }
+    /* 否则直接写入 dst，dst 在两侧都分配完后再绑定（A 的接收对应 B→A 的传输） */
+    if (!c->seg)
+        for (int s = 0; s < 2; s++)
+            for (int k = 0; k < IB_MAX_SESS; k++)
+                IsoTp_SetRxBuffer(&nodes[s]->link[k], ib_x[1 - s][k].dst, ib_x[1 - s][k].len);
+}
+
+static bool ib_active(const ib_case_t *c, int dir, int k)
+{
+    return k < c->sess && (dir == 0 || c->both);
+}
+
+static bool ib_all_done(const ib_case_t *c)
+{
+    for (int dir = 0; dir < 2; dir++)
+        for (int k = 0; k < c->sess; k++)
+            if (ib_active(c, dir, k) && (ib_x[dir][k].tx_res < 0 || (!ib_mute_b && ib_x[dir][k].rx_res < 0 && ib_x[dir][k].tx_res == ISOTP_OK)))
+                return false;
+    return true;
+}
+
+static void ib_poll_all(void)
+{
+    for (int k = 0; k < IB_MAX_SESS; k++)
+    {
+        IsoTp_Poll(&ib_a.link[k], ib_us());
+        IsoTp_Poll(&ib_b.link[k], ib_us());
+    }
+}
+
+static uint32_t ib_next_event(void)
+{
+    uint32_t ev = ISOTP_NO_EVENT;
+    for (int k = 0; k < IB_MAX_SESS; k++)
+    {
+        uint32_t a = IsoTp_NextEvent(&ib_a.link[k], ib_us());
+        uint32_t b = IsoTp_NextEvent(&ib_b.link[k], ib_us());
+        if (a && a < ev) ev = a;
+        if (b && b < ev) ev = b;
+    }
+    return ev;
+}
+
+static void ib_run_sim(const ib_case_t *c)
+{
+    int busy = 0;
+    ib_node_t *sender = NULL;
+    uint64_t end = 0;
+
+    while (!ib_all_done(c) && ib_now_ns < (uint64_t)IB_LIMIT_US * 1000U)
+    {
+        ib_poll_all();
+
+        if (!busy)
+        {
+            /* 仲裁：两节点队首中 ID 最小者获得总线 */
+            sender = NULL;
+            if (ib_a.n) sender = &ib_a;
+            if (ib_b.n && (!sender || ib_b.q[0].id < sender->q[0].id)) sender = &ib_b;
+            if (sender)
+            {
+                uint64_t t = (uint64_t)ib_frame_bits(&sender->q[0]) * 1000000000U / ib_bitrate;
+                busy = 1;
+                end = ib_now_ns + t;
+                ib_busy_ns += t;
+            }
+        }
+
+        uint64_t next = busy ? end : UINT64_MAX;
+        uint32_t ev = ib_next_event();
+        if (ev != ISOTP_NO_EVENT && ib_now_ns + (uint64_t)ev * 1000U < next) next = ib_now_ns + (uint64_t)ev * 1000U;
+        if (next == UINT64_MAX) break;
+        ib_now_ns = next;
+
+        if (busy && ib_now_ns >= end)
+        {
+            ib_frame_t f = sender->q[0];
+            sender->n--;
+            memmove(&sender->q[0], &sender->q[1], (size_t)sender->n * sizeof(ib_frame_t));
+            busy = 0;
+            ib_deliver(sender == &ib_a ? &ib_b : &ib_a, f.id, f.d);
+        }
+    }
+}
+
+#ifdef __linux__
+static int ib_open(const char *ifname, uint32_t rx_id)
+{
+    struct sockaddr_can addr = {0};
+    struct ifreq ifr;
+    struct can_filter flt = { .can_id = rx_id, .can_mask = 0x7FCU | CAN_EFF_FLAG };
+    int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+
+    if (fd < 0) return -1;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+    if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0) { close(fd); return -1; }
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, &flt, sizeof(flt));
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) { close(fd); return -1; }
+    return fd;
+}
+
+static void ib_run_vcan(const ib_case_t *c)
+{
+    uint64_t t0 = ib_wall_ns();
+    struct pollfd pfd[2] = { { .fd = ib_a.fd, .events = POLLIN }, { .fd = ib_b.fd, .events = POLLIN } };
+    ib_node_t *nodes[2] = { &ib_a, &ib_b };
+
+    while (!ib_all_done(c) && ib_now_ns < (uint64_t)IB_LIMIT_US * 1000U)
+    {
+        ib_now_ns = ib_wall_ns() - t0;
+        ib_poll_all();
+
+        uint32_t ev = ib_next_event();
+        int timeout = ev == ISOTP_NO_EVENT ? 10 : (int)(ev / 1000U);
+        if (poll(pfd, 2, timeout > 10 ? 10 : timeout) <= 0) continue;
+
+        ib_now_ns = ib_wall_ns() - t0;
+        for (int s = 0; s < 2; s++)
+        {
+            struct can_frame cf;
+            while (read(nodes[s]->fd, &cf, sizeof(cf)) == (ssize_t)sizeof(cf))
+            {
+                ib_frames++;
+                if ((cf.data[0] & 0xF0U) == 0x30U) ib_fc_frames++;
+                for (int k = 0; k < IB_MAX_SESS; k++)
+                    if (nodes[s]->cfg[k].rx_id == (cf.can_id & CAN_SFF_MASK))
+                        IsoTp_OnFrame(&nodes[s]->link[k], cf.data, cf.can_dlc, ib_us());
+            }
+        }
+    }
+}
+#endif
+
+static int ib_case(const ib_case_t *c)
+{
+    int ok = 1;
+    uint64_t bytes = 0, t_last = 0;
+
+    ib_setup(c);
+    for (int dir = 0; dir < 2; dir++)
+        for (int k = 0; k < c->sess; k++)
+        {
+            if (!ib_active(c, dir, k)) continue;
+            ib_xfer_t *x = &ib_x[dir][k];
+            uint32_t first = c->seg && c->seg < c->len ? c->seg : c->len;
+            if (IsoTp_Send(dir == 0 ? &ib_a.link[k] : &ib_b.link[k], x->src, first, c->len, ib_us()) != ISOTP_OK) ok = 0;
+        }
+
+#ifdef __linux__
+    if (ib_vcan) ib_run_vcan(c);
+    else
+#endif
+    ib_run_sim(c);
+
+    for (int dir = 0; dir < 2; dir++)
+        for (int k = 0; k < c->sess; k++)
+        {
+            if (!ib_active(c, dir, k)) continue;
+            ib_xfer_t *x = &ib_x[dir][k];
+            if (x->tx_res != ISOTP_OK || x->rx_res != ISOTP_OK || x->rx_len != c->len || memcmp(x->src, x->dst, c->len) != 0)
+            {
+                printf("  session %d dir %d: tx=%d rx=%d len=%u\n", k, dir, x->tx_res, x->rx_res, x->rx_len);
+                ok = 0;
+            }
+            bytes += c->len;
+            if (x->t_end > t_last) t_last = x->t_end;
+        }
+
+    double sec = (double)t_last / 1e9;
+    printf("%-34s %s %8.1f ms %7.2f KB/s  frames %6u  fc %4u",
+           c->name, ok ? "PASS" : "FAIL", sec * 1e3, sec > 0 ? (double)bytes / 1024.0 / sec : 0.0, ib_frames, ib_fc_frames);
+    if (!ib_vcan) printf("  bus %5.1f%%", t_last ? 100.0 * (double)ib_busy_ns / (double)t_last : 0.0);
+    printf("\n");
+    return ok;
+}
+
+/* 出错场景：返回实际得到的错误码 */
+static int ib_fault(const char *name, const ib_case_t *c, int expect_tx, int expect_rx)
+{
+    ib_setup(c);
+    if (expect_rx == ISOTP_ERR_OVERFLOW)
+        for (int k = 0; k < IB_MAX_SESS; k++) IsoTp_SetRxBuffer(&ib_b.link[k], ib_x[0][k].dst, c->len / 2U);
+    IsoTp_Send(&ib_a.link[0], ib_x[0][0].src, c->len, c->len, ib_us());
+
+    /* 先跑到发送结束，再让时间越过接收方超时 */
+    for (int i = 0; i < 2 && !ib_vcan; i++)
+    {
+        ib_run_sim(c);
+        ib_now_ns += (uint64_t)ISOTP_N_CR_US * 1000U + 1000U;
+        ib_poll_all();
+    }
+
+    int ok = ib_x[0][0].tx_res == expect_tx && ib_x[0][0].rx_res == expect_rx;
+    printf("%-34s %s tx=%d rx=%d (expect %d/%d)\n", name, ok ? "PASS" : "FAIL",
+           ib_x[0][0].tx_res, ib_x[0][0].rx_res, expect_tx, expect_rx);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    const char *ifname = NULL;
+    int pass = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-b") && i + 1 < argc) ib_bitrate = (uint32_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc) ifname = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [-b bitrate] [-i vcan0]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (ifname)
+    {
+#ifdef __linux__
+        ib_a.fd = ib_open(ifname, IB_ID_A_RX);
+        ib_b.fd = ib_open(ifname, IB_ID_A_TX);
+        if (ib_a.fd < 0 || ib_b.fd < 0)
+        {
+            fprintf(stderr, "cannot open %s: %s\n", ifname, strerror(errno));
+            return 2;
+        }
+        ib_vcan = 1;
+        printf("SocketCAN %s (wall clock)\n", ifname);
+#else
+        fprintf(stderr, "SocketCAN needs Linux\n");
+        return 2;
+#endif
+    }
+    else
+    {
+        /* 8 字节连续帧的理想吞吐：7 字节载荷 / 平均帧时长 */
+        ib_frame_t f = { .id = IB_ID_A_TX };
+        uint64_t bits = 0;
+        for (int i = 0; i < 256; i++)
+        {
+            f.d[0] = (uint8_t)(0x20U | (i & 15));
+            for (int k = 1; k < 8; k++) f.d[k] = (uint8_t)(i * 31 + k * 7);
+            bits += ib_frame_bits(&f);
+        }
+        printf("virtual bus %u bit/s, CF %.1f bits avg, ideal %.2f KB/s\n", ib_bitrate,
+               (double)bits / 256.0, 7.0 * ib_bitrate / ((double)bits / 256.0) / 1024.0);
+    }
+
+    static const ib_case_t cases[] = {
+        { "single frame",                    1, 0, 7,      0,   0,  0    },
+        { "4095 B, BS 0, STmin 0",           1, 0, 4095,   0,   0,  0    },
+        { "4095 B, BS 8, STmin 0",           1, 0, 4095,   0,   8,  0    },
+        { "4095 B, BS 16, STmin 500us",      1, 0, 4095,   0,   16, 0xF5 },
+        { "4095 B, BS 16, STmin 1ms",        1, 0, 4095,   0,   16, 1    },
+        { "3 sessions x 2 dirs, 4000 B",     3, 1, 4000,   0,   16, 0    },
+        { "100 KB streamed, 256 B segments", 1, 0, 102400, 256, 16, 0    },
+        /* 总线饱和时 ID 大的会话会被持续压住直到超时（CAN 严格优先级），多会话并发需要对端用 STmin 限速 */
+        { "4 sessions x 2 dirs, 20 KB, 3ms", 4, 1, 20480,  500, 8,  3    },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) pass &= ib_case(&cases[i]);
+
+    if (!ib_vcan)
+    {
+        const ib_case_t fc = { "fault", 1, 0, 1000, 0, 8, 0 };
+
+        ib_drop_at = 15;                  /* 第二个块中间的连续帧 */
+        pass &= ib_fault("lost consecutive frame", &fc, ISOTP_ERR_TIMEOUT_BS, ISOTP_ERR_WRONG_SN);
+        ib_drop_at = 0;
+        ib_mute_b = 1;
+        pass &= ib_fault("no flow control", &fc, ISOTP_ERR_TIMEOUT_BS, ISOTP_ERR_TIMEOUT_CR);
+        ib_mute_b = 0;
+        pass &= ib_fault("receiver buffer too small", &fc, ISOTP_ERR_OVERFLOW, ISOTP_ERR_OVERFLOW);
+    }
+
+    printf(pass ? "PASS\n" : "FAIL\n");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,314 @@
+/**
+ * @file    tlmloop.c
+ * @brief   上位机：用目标板同一份 tlmcodec.c 做 COBS + CRC32 编解码回环测试
+ *
+ * 编译：gcc -O2 -I../../Core/Inc -o tlmloop tlmloop.c ../../Core/Src/tlmcodec.c -lm
+ * 用法：tlmloop [seed]
+ *
+ * 依次检查：
+ *   1. Tlm_Crc32 与逐位实现的 STM32 CRC 外设算法一致（含长度非 4 倍数的补 0）；
+ *   2. COBS 在全 0、无 0、254/255 字节游程等边界上编解码可逆，非法输入被拒绝；
+ *   3. 随机样本批量编码 → 按随机长度分段送入解码器，样本逐个与原值比对
+ *      （定点量化误差不超过半个分辨率）；
+ *   4. 其他类型帧（TLM_REC_LOG）经 frame_cb 原样交出；
+ *   5. 去掉一帧按序号计入 lost，改一个字节被 CRC/COBS 检出且下一帧重新同步。
+ * 全部通过返回 0。
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "tlmcodec.h"
+
+#define TL_SAMPLES    2560U
+#define TL_STREAM     (TL_SAMPLES * (TLM_SAMPLE_MAX + TLM_HDR_LEN + TLM_CRC_LEN + 2U))
+
+static int tl_fail;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("FAIL %s:%d ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); tl_fail++; } } while (0)
+
+/* 各字段的分辨率与量程，与 tlmcodec.c 的 tlm_field 表一致 */
+static const float tl_res[SNAP_FIELD_NUM] = { 0.01f, 0.01f, 0.01f, 0.1f, 0.1f, 0.1f, 0.1f };
+static const float tl_lo[SNAP_FIELD_NUM]  = { -40.0f, -40.0f, 0.0f, 0.0f, 30000.0f, -500.0f, 2.0f };
+static const float tl_hi[SNAP_FIELD_NUM]  = { 85.0f, 85.0f, 100.0f, 65000.0f, 110000.0f, 3000.0f, 450.0f };
+
+static uint8_t tl_stream[TL_STREAM];
+static Tlm_Sample_t tl_ref[TL_SAMPLES];
+static Tlm_Batch_t tl_batch;
+static Tlm_Decoder_t tl_dec;
+
+/* 逐位参考实现：按小端 32 位字输入、高位先行 */
+static uint32_t tl_crc_ref(const uint8_t *data, uint32_t len)
+{
+    uint32_t crc = 0xFFFFFFFFU;
+
+    for (uint32_t i = 0; i < len; i += 4)
+    {
+        uint32_t w = 0;
+        for (uint32_t k = 0; k < 4 && i + k < len; k++) w |= (uint32_t)data[i + k] << (8 * k);
+        crc ^= w;
+        for (int b = 0; b < 32; b++) crc = (crc & 0x80000000U) ? (crc << 1) ^ 0x04C11DB7U : crc << 1;
+    }
+    return crc;
+}
+
+static uint32_t tl_rand(void)
+{
+    return (uint32_t)rand() << 16 ^ (uint32_t)rand();
+}
+
+static float tl_uniform(float lo, float hi)
+{
+    return lo + (hi - lo) * (float)(tl_rand() & 0xFFFFU) / 65535.0f;
+}
+
+static void test_crc(void)
+{
+    uint8_t buf[64];
+
+    for (uint32_t i = 0; i < sizeof(buf); i++) buf[i] = (uint8_t)tl_rand();
+    for (uint32_t len = 0; len <= sizeof(buf); len++)
+        CHECK(Tlm_Crc32(buf, len) == tl_crc_ref(buf, len), "crc len=%u", len);
+
+    /* 补 0 语义：长度不足 4 的倍数时等同于显式补 0 */
+    uint8_t pad[8] = { 1, 2, 3, 4, 5, 0, 0, 0 };
+    CHECK(Tlm_Crc32(pad, 5) == Tlm_Crc32(pad, 8), "crc pad");
+}
+
+static void cobs_round(const uint8_t *in, uint16_t len, const char *what)
+{
+    uint8_t enc[TLM_COBS_MAX * 2], dec[TLM_FRAME_MAX * 2];
+    uint16_t n = Tlm_CobsEncode(in, len, enc);
+
+    CHECK(n <= len + len / 254U + 1U, "cobs %s: encoded %u > bound", what, n);
+    CHECK(memchr(enc, 0, n) == NULL, "cobs %s: zero in output", what);
+
+    int m = Tlm_CobsDecode(enc, n, dec, sizeof(dec));
+    CHECK(m == (int)len && memcmp(dec, in, len) == 0, "cobs %s: decode %d != %u", what, m, len);
+    if (len) CHECK(Tlm_CobsDecode(enc, n, dec, (uint16_t)(len - 1U)) < 0, "cobs %s: out_size not enforced", what);
+}
+
+static void test_cobs(void)
+{
+    uint8_t buf[TLM_FRAME_MAX * 2];
+    uint16_t lens[] = { 1, 2, 253, 254, 255, 256, 300, 480 };
+
+    for (unsigned i = 0; i < sizeof(lens) / sizeof(lens[0]); i++)
+    {
+        memset(buf, 0, lens[i]);
+        cobs_round(buf, lens[i], "zeros");
+        memset(buf, 0x11, lens[i]);
+        cobs_round(buf, lens[i], "no-zero");
+        for (uint16_t k = 0; k < lens[i]; k++) buf[k] = (uint8_t)(tl_rand() % 3U ? tl_rand() : 0);
+        cobs_round(buf, lens[i], "random");
+    }
+
+    /* 非法输入：码字指向末尾之外、中间出现 0 */
+    uint8_t bad1[] = { 0x05, 0x01, 0x02 };
+    uint8_t bad2[] = { 0x03, 0x01, 0x00, 0x01 };
+    uint8_t out[16];
+    CHECK(Tlm_CobsDecode(bad1, sizeof(bad1), out, sizeof(out)) < 0, "cobs overrun accepted");
+    CHECK(Tlm_CobsDecode(bad2, sizeof(bad2), out, sizeof(out)) < 0, "cobs embedded zero accepted");
+}
+
+static void make_sample(uint32_t i, uint32_t *tick, Tlm_Sample_t *s)
+{
+    memset(s, 0, sizeof(*s));
+    /* 时刻差覆盖 1~3 字节的 varint */
+    uint32_t r = tl_rand() % 16U;
+    *tick += r == 0 ? 20000U + tl_rand() % 100000U : r < 4 ? 200U + tl_rand() % 800U : tl_rand() % 120U;
+    s->tick = *tick;
+    s->valid = (uint8_t)(tl_rand() & 0x7FU);
+    if (i % 7U == 0) s->error = (uint8_t)(tl_rand() & 0x7FU & ~s->valid);
+    for (uint8_t f = 0; f < SNAP_FIELD_NUM; f++)
+        if (s->valid & (1U << f)) s->value[f] = tl_uniform(tl_lo[f], tl_hi[f]);
+}
+
+/* 编码 TL_SAMPLES 个样本，skip 号帧不写入输出（模拟丢帧），返回字节流长度，*frames 为编出的帧数 */
+static uint32_t encode_stream(uint16_t seq0, int skip, uint32_t *frames)
+{
+    uint32_t len = 0, i = 0, tick = 1000;
+    uint16_t seq = seq0;
+
+    for (uint32_t k = 0; k < TL_SAMPLES; k++) make_sample(k, &tick, &tl_ref[k]);
+
+    *frames = 0;
+    while (i < TL_SAMPLES)
+    {
+        Tlm_BatchBegin(&tl_batch, seq, tl_ref[i].tick);
+        while (i < TL_SAMPLES && Tlm_BatchAdd(&tl_batch, &tl_ref[i])) i++;
+
+        uint8_t out[TLM_COBS_MAX];
+        uint16_t n = Tlm_BatchFinish(&tl_batch, NULL, out, sizeof(out));
+        CHECK(n > 0 && n <= TLM_COBS_MAX && out[n - 1] == 0, "finish seq=%u n=%u", seq, n);
+        CHECK(memchr(out, 0, n - 1U) == NULL, "zero inside frame seq=%u", seq);
+        CHECK(len + n <= sizeof(tl_stream), "stream buffer too small");
+        if ((int)*frames != skip && len + n <= sizeof(tl_stream))
+        {
+            memcpy(&tl_stream[len], out, n);
+            len += n;
+        }
+        (*frames)++;
+        seq++;
+    }
+    return len;
+}
+
+typedef struct {
+    uint32_t n;
+    uint32_t first;   /* 第一个期望样本的下标 */
+    uint32_t bad;
+    float    max_err[SNAP_FIELD_NUM];
+} tl_check_t;
+
+static void check_cb(const Tlm_Sample_t *s, void *ctx)
+{
+    tl_check_t *c = (tl_check_t *)ctx;
+    uint32_t k = c->first + c->n++;
+
+    if (k >= TL_SAMPLES)
+    {
+        c->bad++;
+        return;
+    }
+    const Tlm_Sample_t *r = &tl_ref[k];
+    if (s->tick != r->tick || s->valid != r->valid || s->error != r->error)
+    {
+        if (c->bad++ == 0) printf("  sample %u: tick %u/%u valid %02x/%02x err %02x/%02x\n",
+                                  k, s->tick, r->tick, s->valid, r->valid, s->error, r->error);
+        return;
+    }
+    for (uint8_t f = 0; f < SNAP_FIELD_NUM; f++)
+    {
+        if (!(r->valid & (1U << f))) continue;
+        float d = fabsf(s->value[f] - r->value[f]);
+        if (d > c->max_err[f]) c->max_err[f] = d;
+    }
+}
+
+static void test_loopback(void)
+{
+    uint32_t frames;
+    uint32_t len = encode_stream(0xFFF0U, -1, &frames);   /* 序号跨越 0xFFFF 回绕 */
+    tl_check_t chk = {0};
+
+    /* 按 1~97 字节的随机长度分段送入，覆盖帧跨段与分隔符落在段首/段尾 */
+    Tlm_DecoderInit(&tl_dec);
+    for (uint32_t pos = 0; pos < len; )
+    {
+        uint32_t n = 1U + tl_rand() % 97U;
+        if (n > len - pos) n = len - pos;
+        Tlm_DecoderFeed(&tl_dec, &tl_stream[pos], n, check_cb, &chk);
+        pos += n;
+    }
+
+    const Tlm_DecStats_t *st = &tl_dec.stats;
+    printf("loopback: %u samples in %u frames, %u bytes (%.2f B/sample)\n",
+           TL_SAMPLES, frames, len, (double)len / TL_SAMPLES);
+    CHECK(chk.bad == 0 && chk.n == TL_SAMPLES, "loopback: %u/%u samples, %u bad", chk.n, TL_SAMPLES, chk.bad);
+    CHECK(st->frames == frames && st->samples == TL_SAMPLES, "loopback: frames %u/%u", st->frames, frames);
+    CHECK(st->lost == 0 && st->crc_err == 0 && st->cobs_err == 0 && st->schema_err == 0,
+          "loopback: lost=%u crc=%u cobs=%u schema=%u", st->lost, st->crc_err, st->cobs_err, st->schema_err);
+    for (uint8_t f = 0; f < SNAP_FIELD_NUM; f++)
+        CHECK(chk.max_err[f] <= tl_res[f] * 0.5f + tl_hi[f] * 1e-6f,
+              "field %u: max err %g > %g", f, chk.max_err[f], tl_res[f] * 0.5f);
+}
+
+typedef struct {
+    uint32_t n;
+    uint8_t  buf[TLM_FRAME_MAX];
+    uint16_t len;
+} tl_frame_t;
+
+static void frame_cb(const uint8_t *frame, uint16_t len, void *ctx)
+{
+    tl_frame_t *c = (tl_frame_t *)ctx;
+    c->n++;
+    c->len = len;
+    memcpy(c->buf, frame, len);
+}
+
+static void test_other_frame(void)
+{
+    uint8_t buf[64] __attribute__((aligned(4)));
+    uint8_t out[TLM_COBS_MAX];
+    tl_frame_t got = {0};
+
+    buf[0] = TLM_REC_LOG;
+    buf[1] = TLM_LOG_VERSION;
+    for (uint16_t i = 2; i < 27; i++) buf[i] = (uint8_t)(i & 3U ? i : 0);
+    uint8_t ref[27];
+    memcpy(ref, buf, sizeof(ref));
+
+    uint16_t n = Tlm_FrameEncode(buf, 27, NULL, out, sizeof(out));
+    CHECK(n > 0, "log frame encode");
+
+    Tlm_DecoderInit(&tl_dec);
+    Tlm_DecoderFeed(&tl_dec, out, n, NULL, NULL);
+    CHECK(tl_dec.stats.schema_err == 1, "log frame without handler should count as schema_err");
+
+    Tlm_DecoderInit(&tl_dec);
+    Tlm_DecoderOnFrame(&tl_dec, frame_cb, &got);
+    Tlm_DecoderFeed(&tl_dec, out, n, NULL, NULL);
+    CHECK(got.n == 1 && got.len == sizeof(ref) && memcmp(got.buf, ref, sizeof(ref)) == 0, "log frame passthrough");
+    CHECK(tl_dec.stats.frames == 0 && tl_dec.stats.schema_err == 0, "log frame stats");
+}
+
+static void test_loss_and_corruption(void)
+{
+    uint32_t frames;
+    uint32_t len = encode_stream(100, 5, &frames);
+
+    /* 第 5 帧未写入流：按序号计 1 帧丢失 */
+    Tlm_DecoderInit(&tl_dec);
+    Tlm_DecoderFeed(&tl_dec, tl_stream, len, NULL, NULL);
+    CHECK(tl_dec.stats.lost == 1 && tl_dec.stats.frames == frames - 1U, "lost=%u frames=%u/%u",
+          tl_dec.stats.lost, tl_dec.stats.frames, frames - 1U);
+
+    /* 逐个位置改一个字节（非 0 改为非 0），应只损失所在的一帧 */
+    len = encode_stream(0, -1, &frames);
+    uint32_t detected = 0, tried = 0;
+    for (uint32_t pos = 0; pos < len; pos += 1U + tl_rand() % 13U)
+    {
+        uint8_t old = tl_stream[pos];
+        if (old == 0) continue;
+        tl_stream[pos] = old == 0xFFU ? 0x01U : (uint8_t)(old + 1U);
+
+        Tlm_DecoderInit(&tl_dec);
+        Tlm_DecoderFeed(&tl_dec, tl_stream, len, NULL, NULL);
+        const Tlm_DecStats_t *st = &tl_dec.stats;
+        tried++;
+        if (st->crc_err + st->cobs_err + st->schema_err == 1 && st->frames == frames - 1U) detected++;
+        else if (tried - detected <= 3)
+            printf("  corrupt @%u: frames=%u crc=%u cobs=%u schema=%u\n",
+                   pos, st->frames, st->crc_err, st->cobs_err, st->schema_err);
+        tl_stream[pos] = old;
+    }
+    printf("corruption: %u/%u single-byte errors detected with resync\n", detected, tried);
+    CHECK(tried > 0 && detected == tried, "corruption: %u of %u not detected", tried - detected, tried);
+
+    /* 丢掉一个分隔符：两帧合并成一帧，校验失败，后续帧正常 */
+    uint32_t z = 0;
+    while (z < len && tl_stream[z] != 0) z++;
+    Tlm_DecoderInit(&tl_dec);
+    Tlm_DecoderFeed(&tl_dec, tl_stream, z, NULL, NULL);
+    Tlm_DecoderFeed(&tl_dec, &tl_stream[z + 1U], len - z - 1U, NULL, NULL);
+    CHECK(tl_dec.stats.frames == frames - 2U && tl_dec.stats.crc_err + tl_dec.stats.cobs_err == 1,
+          "missing delimiter: frames=%u/%u", tl_dec.stats.frames, frames - 2U);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned seed = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 0) : 1U;
+    srand(seed);
+    printf("seed %u\n", seed);
+
+    test_crc();
+    test_cobs();
+    test_loopback();
+    test_other_frame();
+    test_loss_and_corruption();
+
+    printf("%s (%d failures)\n", tl_fail ? "FAIL" : "PASS", tl_fail);
+    return tl_fail ? 1 : 0;
+}
@@ -0,0 +1,338 @@
+/**
+ * @file    zbbench.c
+ * @brief   上位机：ZigBee 帧流式解析器的功能测试与基准（与目标板同一份 zbframe.c）
+ *
+ * 编译：gcc -O2 -I../../Core/Inc -o zbbench zbbench.c ../../Core/Src/zbframe.c
+ * 用法：zbbench [重复次数]
+ *
+ * 功能测试：任意切分喂入、帧间垃圾、非法转义、长度不符、超长、槽位耗尽、队列满、
+ * 截断帧后的重新同步、封包超长与头部字段取值的往返。
+ * 基准：同一测试流分别用流式解析与原方案（逐字节收集整帧、复制、再解码）处理，
+ * 比较结果与耗时（纳秒）。全部通过返回 0。
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "zbframe.h"
+
+#define ZB_FRAMES   8U
+#define ZB_STREAM   (ZB_FRAMES * ZBFRAME_MAX_LEN + 64U)
+
+static int zb_fail;
+
+static void zb_check(int ok, const char *what)
+{
+    if (!ok) {
+        printf("  FAIL: %s\n", what);
+        zb_fail = 1;
+    }
+}
+
+static uint32_t zb_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec);
+}
+
+/* ---------------- 解析器的槽位与交付 ---------------- */
+
+static DL_Packet_t zb_out[ZB_FRAMES * 2U];
+static uint32_t zb_n;          /* 已交付数 */
+static uint32_t zb_slots;      /* 允许分配的槽位数 */
+static uint32_t zb_allocs;
+static int zb_post_fail;       /* 置位时模拟队列满 */
+
+static DL_Packet_t *zb_alloc(void)
+{
+    if (zb_allocs >= zb_slots) return NULL;
+    return &zb_out[zb_allocs++];
+}
+
+static int zb_post(DL_Packet_t *pkt)
+{
+    (void)pkt;
+    if (zb_post_fail) return 1;
+    zb_n++;
+    return 0;
+}
+
+static void zb_parser_init(ZbFrame_Parser_t *p, uint32_t slots)
+{
+    memset(p, 0, sizeof(*p));
+    p->alloc = zb_alloc;
+    p->post = zb_post;
+    zb_n = 0;
+    zb_allocs = 0;
+    zb_slots = slots;
+    zb_post_fail = 0;
+}
+
+/* ---------------- 测试流 ---------------- */
+
+static uint8_t zb_stream[ZB_STREAM];
+static DL_Packet_t zb_ref[ZB_FRAMES];
+
+/* 长度各异、数据中含 FE/FF 需要转义，返回流长度 */
+static uint16_t zb_make_stream(void)
+{
+    uint16_t len = 0;
+
+    for (uint8_t f = 0; f < ZB_FRAMES; f++) {
+        DL_Packet_t *r = &zb_ref[f];
+        uint16_t flen;
+
+        r->src = 0x91;
+        r->dst = (uint8_t)(0x90 + f);
+        r->addr = (uint16_t)(0xFEFFU - f);
+        r->data_len = (uint16_t)(8U + f * 11U);
+        for (uint16_t j = 0; j < r->data_len; j++) {
+            r->data[j] = (uint8_t)(f * 37U + j * 11U + ((j % 13U) == 0 ? 0xFEU : 0U));
+        }
+        if (ZbFrame_Encode(&zb_stream[len], r->src, r->dst, r->addr, r->data, r->data_len, &flen) != DL_OK) {
+            return 0;
+        }
+        len += flen;
+    }
+    return len;
+}
+
+static int zb_same(const DL_Packet_t *a, const DL_Packet_t *b)
+{
+    return a->src == b->src && a->dst == b->dst && a->addr == b->addr
+        && a->data_len == b->data_len && memcmp(a->data, b->data, a->data_len) == 0;
+}
+
+/* 交付的包与参考逐个比较（槽位按分配顺序使用，交付顺序相同） */
+static int zb_match(const DL_Packet_t *ref, uint32_t n)
+{
+    if (zb_n != n) return 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (!zb_same(&zb_out[i], &ref[i])) return 0;
+    }
+    return 1;
+}
+
+/* ---------------- 原方案（基准对照） ---------------- */
+
+/* 原 zigbee.c 的整帧解包：处理转义并校验 */
+static DL_Status_t zb_legacy_extract(const uint8_t *frame, uint16_t length, DL_Packet_t *pkt)
+{
+    uint8_t decoded[128];
+    uint16_t cnt = 0, idx = 2U;
+
+    if (length < 4U || frame[0] != 0xFE || frame[length - 1U] != 0xFF) return DL_ERROR;
+
+    while (idx < (length - 1U)) {
+        uint8_t b = frame[idx++];
+        if (b == 0xFE) {
+            if (idx >= (length - 1U)) return DL_ERROR;
+            uint8_t next = frame[idx++];
+            if (next == 0xFD)      b = 0xFF;
+            else if (next == 0xFC) b = 0xFE;
+            else                   return DL_ERROR;
+        }
+        if (cnt >= sizeof(decoded)) return DL_ERROR;
+        decoded[cnt++] = b;
+    }
+    if (cnt != frame[1] || cnt < 4U) return DL_ERROR;
+
+    pkt->src = decoded[0];
+    pkt->dst = decoded[1];
+    pkt->addr = (uint16_t)decoded[2] | ((uint16_t)decoded[3] << 8);
+    pkt->data_len = cnt - 4U;
+    memcpy(pkt->data, &decoded[4], pkt->data_len);
+    return DL_OK;
+}
+
+/* 原方案：逐字节收集整帧到缓冲，收到包尾后复制并再解码 */
+static uint8_t zb_legacy_decode(const uint8_t *stream, uint16_t len, DL_Packet_t *out, uint8_t max)
+{
+    uint8_t raw[ZBFRAME_MAX_LEN];
+    uint8_t frame[ZBFRAME_MAX_LEN];
+    uint16_t rlen = 0;
+    uint8_t in_frame = 0, n = 0;
+
+    for (uint16_t i = 0; i < len && n < max; i++) {
+        uint8_t byte = stream[i];
+        if (!in_frame) {
+            if (byte == 0xFE) {
+                rlen = 0;
+                raw[rlen++] = byte;
+                in_frame = 1;
+            }
+        } else if (rlen < ZBFRAME_MAX_LEN) {
+            raw[rlen++] = byte;
+            if (byte == 0xFF) {
+                memcpy(frame, raw, rlen);
+                if (zb_legacy_extract(frame, rlen, &out[n]) == DL_OK) n++;
+                in_frame = 0;
+            }
+        } else {
+            in_frame = 0;
+        }
+    }
+    return n;
+}
+
+/* ---------------- 功能测试 ---------------- */
+
+static void zb_test_chunks(uint16_t len)
+{
+    ZbFrame_Parser_t p;
+
+    /* 切分长度 1..17 覆盖包头、长度、转义对被拆开的所有位置 */
+    for (uint16_t chunk = 1; chunk <= 17U; chunk++) {
+        zb_parser_init(&p, ZB_FRAMES);
+        for (uint16_t i = 0; i < len; i += chunk) {
+            ZbFrame_Feed(&p, &zb_stream[i], (uint16_t)(len - i < chunk ? len - i : chunk));
+        }
+        if (!zb_match(zb_ref, ZB_FRAMES) || p.stats.frames != ZB_FRAMES || p.stats.bytes != len) {
+            printf("  chunk %u\n", chunk);
+            zb_check(0, "split feeding");
+            return;
+        }
+    }
+}
+
+/* 出错的字节序列之后紧跟一个好帧，好帧必须照常收到 */
+static void zb_test_bad(const char *what, const uint8_t *bad, uint16_t blen)
+{
+    ZbFrame_Parser_t p;
+    uint8_t buf[64 + ZBFRAME_MAX_LEN];
+    uint16_t flen;
+
+    memcpy(buf, bad, blen);
+    ZbFrame_Encode(&buf[blen], zb_ref[0].src, zb_ref[0].dst, zb_ref[0].addr,
+                   zb_ref[0].data, zb_ref[0].data_len, &flen);
+    zb_parser_init(&p, 2);
+    ZbFrame_Feed(&p, buf, (uint16_t)(blen + flen));
+    if (!zb_match(zb_ref, 1)) {
+        printf("  %s\n", what);
+        zb_check(0, "good frame after a bad one");
+    }
+}
+
+static void zb_test_errors(void)
+{
+    ZbFrame_Parser_t p;
+    uint8_t buf[256];
+    uint16_t n;
+
+    /* 帧前与帧间垃圾（不含 FE）被忽略 */
+    static const uint8_t junk[] = { 0x00, 0x55, 0xFF, 0x12, 0xFF };
+    zb_test_bad("leading junk", junk, sizeof(junk));
+
+    /* 非法转义 FE 00：本帧丢弃并计 esc_err */
+    static const uint8_t esc[] = { 0xFE, 0x06, 0x01, 0x02, 0x03, 0x04, 0xFE, 0x00, 0x05, 0xFF };
+    zb_test_bad("bad escape", esc, sizeof(esc));
+    zb_parser_init(&p, 1);
+    ZbFrame_Feed(&p, esc, sizeof(esc));
+    zb_check(p.stats.esc_err == 1 && p.stats.frames == 0, "bad escape counted");
+
+    /* 声明长度大于实际：len_err */
+    static const uint8_t shortf[] = { 0xFE, 0x08, 0x01, 0x02, 0x03, 0x04, 0x05, 0xFF };
+    zb_test_bad("short frame", shortf, sizeof(shortf));
+    zb_parser_init(&p, 1);
+    ZbFrame_Feed(&p, shortf, sizeof(shortf));
+    zb_check(p.stats.len_err == 1 && p.stats.frames == 0, "length mismatch counted");
+
+    /* 声明长度小于实际：overflow，跳到包尾 */
+    static const uint8_t longf[] = { 0xFE, 0x04, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xFF };
+    zb_test_bad("long frame", longf, sizeof(longf));
+    zb_parser_init(&p, 1);
+    ZbFrame_Feed(&p, longf, sizeof(longf));
+    zb_check(p.stats.overflow == 1 && p.stats.frames == 0, "overflow counted");
+
+    /* 非法长度字节 */
+    static const uint8_t badlen[] = { 0xFE, 0x02, 0xFF, 0xFE, 0xF0, 0xFF };
+    zb_test_bad("bad length", badlen, sizeof(badlen));
+    zb_parser_init(&p, 1);
+    ZbFrame_Feed(&p, badlen, sizeof(badlen));
+    zb_check(p.stats.len_err == 2, "bad length counted");
+
+    /* 槽位耗尽：丢弃并计 no_slot，有槽位后恢复 */
+    zb_parser_init(&p, 0);
+    ZbFrame_Encode(buf, 1, 2, 3, (const uint8_t *)"abc", 3, &n);
+    ZbFrame_Feed(&p, buf, n);
+    zb_check(p.stats.no_slot == 1 && zb_n == 0, "no slot counted");
+    zb_slots = 1;
+    ZbFrame_Feed(&p, buf, n);
+    zb_check(zb_n == 1 && zb_out[0].data_len == 3 && memcmp(zb_out[0].data, "abc", 3) == 0, "recover after no slot");
+
+    /* 队列满：丢弃本帧，槽位留给下一帧（不再分配） */
+    zb_parser_init(&p, 1);
+    zb_post_fail = 1;
+    ZbFrame_Feed(&p, buf, n);
+    zb_check(p.stats.queue_full == 1 && zb_allocs == 1, "queue full counted");
+    zb_post_fail = 0;
+    ZbFrame_Feed(&p, buf, n);
+    zb_check(zb_n == 1 && zb_allocs == 1, "slot reused after queue full");
+
+    /* 截断帧（缺包尾）：下一帧的 FE 被当作转义，丢到其包尾为止，再下一帧恢复 */
+    zb_parser_init(&p, 4);
+    static const uint8_t cut[] = { 0xFE, 0x08, 0x01, 0x02, 0x03 };
+    ZbFrame_Feed(&p, cut, sizeof(cut));
+    ZbFrame_Feed(&p, buf, n);
+    ZbFrame_Feed(&p, buf, n);
+    zb_check(zb_n == 1 && p.stats.esc_err == 1, "resync after truncated frame");
+
+    /* 封包：转义后超过 ZBFRAME_MAX_LEN 报错；头部字段任意取值往返一致 */
+    memset(buf, 0xFF, 120);
+    zb_check(ZbFrame_Encode(buf + 128, 0, 0, 0, buf, 120, &n) == DL_ERROR, "oversize encode rejected");
+
+    static const uint8_t hv[] = { 0x00, 0xFE, 0xFF, 0xFD, 0xFC, 0x7F };
+    for (unsigned i = 0; i < sizeof(hv); i++) {
+        DL_Packet_t ref = { .addr = (uint16_t)(hv[i] | (hv[(i + 1) % sizeof(hv)] << 8)),
+                            .src = hv[i], .dst = hv[(i + 2) % sizeof(hv)], .data_len = 0 };
+        zb_parser_init(&p, 1);
+        ZbFrame_Encode(buf, ref.src, ref.dst, ref.addr, NULL, 0, &n);
+        ZbFrame_Feed(&p, buf, n);
+        if (!zb_match(&ref, 1)) {
+            zb_check(0, "header round trip");
+            break;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int reps = argc > 1 ? atoi(argv[1]) : 1000;
+    uint16_t len = zb_make_stream();
+    uint64_t stream_ns = 0, legacy_ns = 0;
+    static DL_Packet_t legacy[ZB_FRAMES];
+
+    if (len == 0) {
+        printf("FAIL: test stream\n");
+        return 1;
+    }
+
+    zb_test_chunks(len);
+    zb_test_errors();
+
+    for (int r = 0; r < reps; r++) {
+        ZbFrame_Parser_t p;
+        zb_parser_init(&p, ZB_FRAMES);
+        uint32_t t0 = zb_ns();
+        ZbFrame_Feed(&p, zb_stream, len);
+        uint32_t t1 = zb_ns();
+        uint8_t nref = zb_legacy_decode(zb_stream, len, legacy, ZB_FRAMES);
+        uint32_t t2 = zb_ns();
+        stream_ns += t1 - t0;
+        legacy_ns += t2 - t1;
+        if (r == 0) {
+            zb_check(zb_match(zb_ref, ZB_FRAMES), "stream parser output");
+            for (uint8_t f = 0; f < nref; f++) {
+                if (!zb_same(&legacy[f], &zb_ref[f])) zb_check(0, "legacy decoder output");
+            }
+            zb_check(nref == ZB_FRAMES, "legacy frame count");
+        }
+    }
+
+    printf("%u frames, %u bytes x %d\n", ZB_FRAMES, len, reps);
+    printf("stream  %8.1f ns/run\n", (double)stream_ns / reps);
+    printf("legacy  %8.1f ns/run  (%.2fx)\n", (double)legacy_ns / reps, (double)legacy_ns / (double)stream_ns);
+    printf(zb_fail ? "FAIL\n" : "PASS\n");
+    return zb_fail;
+}
@@ -0,0 +1,271 @@
+/**
+ * @file    zbpackbench.c
+ * @brief   上位机：ZigBee 遥测载荷编码 zbpack 与原 ZigBee_Load_Data 的对比基准及功能测试
+ *
+ * 编译：gcc -O2 -I../../Core/Inc -o zbpackbench zbpackbench.c ../../Core/Src/zbpack.c
+ * 用法：zbpackbench [重复次数]
+ *
+ * 基准：同一组 7 通道读数（100ms 一个）分别用 zbpack（批量 + 差分 varint，每帧装满
+ * ZigBee 单帧载荷上限）与原方案（每帧一个读数，逐通道拆成百进制字节）编码，比较载荷
+ * 字节数、帧数与耗时（纳秒），并用 zbpack 解码器逐帧核对。
+ * 功能测试：负数与 int32 极值往返、丢失差分帧后失步直到下一个关键帧、ForceKey 立即恢复、
+ * 截断载荷报错。全部通过返回 0。
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "zbpack.h"
+
+#define ZP_PAYLOAD_MAX   118U    /* zigbee.h 的 ZigBee_TX_PAYLOAD_MAX，该头文件依赖 HAL */
+#define ZP_FRAME_HDR     7U      /* 每帧 FE LEN src dst addr(2) ... FF，转义前 */
+#define ZP_SAMPLES       64U
+#define ZP_CH            7U
+#define ZP_FRAMES        16U
+
+static int zp_fail;
+
+static void zp_check(int ok, const char *what)
+{
+    if (!ok) {
+        printf("  FAIL: %s\n", what);
+        zp_fail = 1;
+    }
+}
+
+static uint32_t zp_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec);
+}
+
+/* 原方案，与 zigbee.c 中的 ZigBee_Load_Data 相同：1 字节位数 + 百进制各位，低位在前 */
+static int zp_legacy_load(uint8_t *content, uint8_t content_p, int data)
+{
+    if (data > 0) {
+        uint8_t part = 1;
+        content_p++;
+        while (data > 99) {
+            content[content_p] = data % 100;
+            content_p++;
+            data = data / 100;
+            part++;
+        }
+        content[content_p] = data;
+        content[content_p - part] = part;
+        return 0;
+    }
+    return -1;
+}
+
+/* ---------------- 测试数据 ---------------- */
+
+static ZbPack_Sample_t zp_src[ZP_SAMPLES];
+
+/* 100ms 一个完整读数（7 个通道，定点整数），数值缓慢变化；
+   原方案只接受正数，基准数据所有通道取正值 */
+static void zp_gen(void)
+{
+    for (uint32_t k = 0; k < ZP_SAMPLES; k++) {
+        ZbPack_Sample_t *s = &zp_src[k];
+        memset(s, 0, sizeof(*s));
+        s->tick = 5000U + k * 100U + (k % 3U);
+        s->mask = (uint8_t)((1U << ZP_CH) - 1U);
+        s->v[0] = 2531 + (int32_t)(k % 5U) - 2;           /* T1 0.01℃ */
+        s->v[1] = 2498 + (int32_t)(k / 8U);               /* T2 0.01℃ */
+        s->v[2] = 4512 - (int32_t)(k * 3U);               /* H 0.01%RH */
+        s->v[3] = 3020 + (int32_t)((k * 7U) % 40U);       /* L 0.1 lux */
+        s->v[4] = 1013253 + (int32_t)(k % 9U) * 4 - 16;   /* P 0.1 Pa */
+        s->v[5] = 123 + (int32_t)(k % 2U);                /* A 0.1 m */
+        s->v[6] = 500 + (int32_t)((k * 37U) % 300U);      /* D 0.1 cm，变化最剧烈 */
+    }
+}
+
+/* 解码回调：与期望序列逐个比对 */
+typedef struct {
+    const ZbPack_Sample_t *ref;
+    uint32_t n;
+    uint32_t max;
+    int bad;
+} zp_expect_t;
+
+static void zp_cb(const ZbPack_Sample_t *s, void *ctx)
+{
+    zp_expect_t *e = (zp_expect_t *)ctx;
+    if (e->n >= e->max) {
+        e->bad = 1;
+        return;
+    }
+    const ZbPack_Sample_t *r = &e->ref[e->n++];
+    if (s->tick != r->tick || s->mask != r->mask) {
+        e->bad = 1;
+        return;
+    }
+    for (uint8_t c = 0; c < ZBPACK_MAX_CH; c++) {
+        if ((r->mask & (1U << c)) && s->v[c] != r->v[c]) e->bad = 1;
+    }
+}
+
+/* 每帧装满 size 字节，返回帧数，offs[f]..offs[f+1] 为第 f 帧 */
+static uint8_t zp_encode(ZbPack_Enc_t *enc, const ZbPack_Sample_t *src, uint32_t n,
+                         uint8_t *out, uint16_t size, uint16_t *offs, uint8_t max_frames)
+{
+    uint32_t i = 0, bytes = 0;
+    uint8_t frames = 0;
+
+    offs[0] = 0;
+    while (i < n) {
+        if (frames >= max_frames) return 0;
+        ZbPack_Begin(enc, &out[bytes], size);
+        while (i < n && ZbPack_Add(enc, &src[i])) i++;
+        uint16_t len = ZbPack_End(enc);
+        if (len == 0) return 0;
+        bytes += len;
+        offs[++frames] = (uint16_t)bytes;
+    }
+    return frames;
+}
+
+/* ---------------- 功能测试 ---------------- */
+
+static void zp_test_extremes(void)
+{
+    static const int32_t vals[] = { 0, -1, 1, -64, 63, 64, -65, 0x7FFFFFFF, (int32_t)0x80000000, -1013253 };
+    ZbPack_Sample_t s[sizeof(vals) / sizeof(vals[0])];
+    uint8_t buf[ZP_FRAMES * ZP_PAYLOAD_MAX];
+    uint16_t offs[ZP_FRAMES + 1];
+    ZbPack_Enc_t enc;
+    ZbPack_Dec_t dec;
+    const uint32_t n = sizeof(vals) / sizeof(vals[0]);
+
+    for (uint32_t k = 0; k < n; k++) {
+        memset(&s[k], 0, sizeof(s[k]));
+        s[k].tick = k ? s[k - 1].tick + (k == 5 ? 0x7FFFFFFFU : 7U) : 0xFFFFFFF0U;   /* 含时刻回绕 */
+        s[k].mask = (uint8_t)(k % 2U ? 0xFFU : 0x55U);
+        for (uint8_t c = 0; c < ZBPACK_MAX_CH; c++) s[k].v[c] = vals[(k + c) % n];
+    }
+
+    ZbPack_EncInit(&enc, 4);
+    uint8_t frames = zp_encode(&enc, s, n, buf, ZP_PAYLOAD_MAX, offs, ZP_FRAMES);
+    zp_check(frames > 0, "extremes: encode");
+
+    zp_expect_t e = { s, 0, n, 0 };
+    ZbPack_DecInit(&dec);
+    for (uint8_t f = 0; f < frames; f++) {
+        if (ZbPack_Decode(&dec, &buf[offs[f]], (uint16_t)(offs[f + 1] - offs[f]), zp_cb, &e) < 0) e.bad = 1;
+    }
+    zp_check(!e.bad && e.n == n, "extremes: round trip");
+}
+
+static void zp_test_loss(void)
+{
+    uint8_t buf[ZP_FRAMES * 40U];
+    uint16_t offs[ZP_FRAMES + 1];
+    ZbPack_Enc_t enc;
+    ZbPack_Dec_t dec;
+
+    /* 小帧（关键帧 1 个样本，差分帧 2 个），关键帧间隔 4 */
+    ZbPack_EncInit(&enc, 4);
+    uint8_t frames = zp_encode(&enc, zp_src, 24, buf, 24, offs, ZP_FRAMES);
+    zp_check(frames >= 9, "loss: enough frames");
+    if (frames < 9) return;
+
+    /* 丢第 1 帧（差分帧）：第 2、3 帧应被丢弃，第 4 帧（关键帧）起恢复 */
+    zp_expect_t e = { zp_src, 0, ZP_SAMPLES, 0 };
+    ZbPack_DecInit(&dec);
+    ZbPack_Decode(&dec, &buf[offs[0]], (uint16_t)(offs[1] - offs[0]), zp_cb, &e);
+    uint32_t first = e.n;
+    for (uint8_t f = 2; f < frames; f++) {
+        ZbPack_Decode(&dec, &buf[offs[f]], (uint16_t)(offs[f + 1] - offs[f]), NULL, NULL);
+    }
+    zp_check(first > 0 && !e.bad, "loss: first key frame decoded");
+    zp_check(dec.stats.lost == 1, "loss: lost counted");
+    zp_check(dec.stats.skipped == 2, "loss: delta frames skipped until key");
+    zp_check(dec.stats.frames == (uint32_t)frames - 3U, "loss: resync at key frame");
+
+    /* ForceKey：丢帧后下一帧立即为关键帧，解码器不再失步 */
+    ZbPack_EncInit(&enc, 0);
+    ZbPack_DecInit(&dec);
+    uint32_t i = 0;
+    uint8_t tmp[40];
+    for (uint8_t f = 0; f < 6 && i < ZP_SAMPLES; f++) {
+        ZbPack_Begin(&enc, tmp, sizeof(tmp));
+        while (i < ZP_SAMPLES && ZbPack_Add(&enc, &zp_src[i])) i++;
+        uint16_t len = ZbPack_End(&enc);
+        if (f == 2) {
+            ZbPack_ForceKey(&enc);   /* 模拟发送失败 */
+            continue;
+        }
+        ZbPack_Decode(&dec, tmp, len, NULL, NULL);
+    }
+    zp_check(dec.stats.skipped == 0 && dec.stats.frames == 5 && dec.stats.keys == 2, "force key: resync");
+
+    /* 截断的载荷报错 */
+    ZbPack_EncInit(&enc, 0);
+    ZbPack_DecInit(&dec);
+    ZbPack_Begin(&enc, tmp, sizeof(tmp));
+    ZbPack_Add(&enc, &zp_src[0]);
+    uint16_t len = ZbPack_End(&enc);
+    zp_check(ZbPack_Decode(&dec, tmp, (uint16_t)(len - 1U), NULL, NULL) < 0, "truncated payload rejected");
+}
+
+/* ---------------- 基准 ---------------- */
+
+int main(int argc, char **argv)
+{
+    int reps = argc > 1 ? atoi(argv[1]) : 1000;
+    static uint8_t pack[ZP_FRAMES * ZP_PAYLOAD_MAX];
+    uint8_t legacy[ZP_PAYLOAD_MAX];
+    uint16_t offs[ZP_FRAMES + 1];
+    uint32_t legacy_bytes = 0;
+    uint64_t pack_ns = 0, legacy_ns = 0;
+    uint8_t frames = 0;
+    ZbPack_Enc_t enc;
+    ZbPack_Dec_t dec;
+
+    zp_gen();
+    zp_test_extremes();
+    zp_test_loss();
+
+    for (int r = 0; r < reps; r++) {
+        /* zbpack：每帧装满单帧载荷上限，16 帧一个关键帧 */
+        uint32_t t0 = zp_ns();
+        ZbPack_EncInit(&enc, 16);
+        frames = zp_encode(&enc, zp_src, ZP_SAMPLES, pack, ZP_PAYLOAD_MAX, offs, ZP_FRAMES);
+        uint32_t t1 = zp_ns();
+
+        /* 原方案：每帧一个读数 */
+        legacy_bytes = 0;
+        for (uint32_t i = 0; i < ZP_SAMPLES; i++) {
+            uint8_t pos = 0;
+            for (uint8_t ch = 0; ch < ZP_CH; ch++) {
+                if (zp_legacy_load(legacy, pos, zp_src[i].v[ch]) != 0) zp_fail = 1;
+                pos += (uint8_t)(1U + legacy[pos]);
+            }
+            legacy_bytes += pos;
+        }
+        uint32_t t2 = zp_ns();
+
+        pack_ns += t1 - t0;
+        legacy_ns += t2 - t1;
+    }
+    zp_check(frames > 0, "bench: encode");
+
+    /* 协调器侧逐帧解码核对 */
+    zp_expect_t e = { zp_src, 0, ZP_SAMPLES, 0 };
+    ZbPack_DecInit(&dec);
+    for (uint8_t f = 0; f < frames; f++) {
+        if (ZbPack_Decode(&dec, &pack[offs[f]], (uint16_t)(offs[f + 1] - offs[f]), zp_cb, &e) < 0) e.bad = 1;
+    }
+    zp_check(!e.bad && e.n == ZP_SAMPLES, "bench: decode matches source");
+
+    uint32_t pack_bytes = offs[frames];
+    printf("%u samples x %u channels\n", ZP_SAMPLES, ZP_CH);
+    printf("zbpack  %4u B payload in %2u frames (%4u B on air)  %8.1f ns\n",
+           pack_bytes, frames, pack_bytes + frames * ZP_FRAME_HDR, (double)pack_ns / reps);
+    printf("legacy  %4u B payload in %2u frames (%4u B on air)  %8.1f ns\n",
+           legacy_bytes, ZP_SAMPLES, legacy_bytes + ZP_SAMPLES * ZP_FRAME_HDR, (double)legacy_ns / reps);
+    printf(zp_fail ? "FAIL\n" : "PASS\n");
+    return zp_fail;
+}